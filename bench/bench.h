@@ -0,0 +1,58 @@
+/** @file   bench.h
+ *  @brief  ベンチマーク共通の補助機能.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_BENCH_H__
+#define __HFSM_BENCH_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+
+/**
+ *  単調増加時計の現在値をナノ秒で取得する.
+ *
+ *  @return 現在値 (ナノ秒) が返る.
+ */
+static inline uint64_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ *  計測結果の見出しを出力する.
+ *
+ *  @param  [in]    title   ベンチマークの名前.
+ *  @param  [in]    unit    1 件あたりの単位の名前.
+ */
+static inline void bench_header(const char *title, const char *unit)
+{
+    printf("# %s\n", title);
+    printf("%10s %14s %14s\n", "n", "total[us]", unit);
+}
+
+/**
+ *  計測結果を 1 行出力する.
+ *
+ *  @param  [in]    n       要素数.
+ *  @param  [in]    elapsed 経過時間 (ナノ秒).
+ *  @param  [in]    count   1 件あたりの時間を求める際の件数.
+ */
+static inline void bench_report(size_t n, uint64_t elapsed, size_t count)
+{
+    printf("%10zu %14.1f %14.1f\n",
+           n,
+           (double)elapsed / 1000.0,
+           (count > 0) ? (double)elapsed / (double)count : 0.0);
+}
+
+#endif /* __HFSM_BENCH_H__ */
@@ -0,0 +1,234 @@
+/** @file   cqueue.c
+ *  @brief  並行キューのベンチマーク.
+ *
+ *  生産者スレッドと消費者スレッドの間で要素を受け渡すスループットを,
+ *  @ref CQUEUE の単一生産者/単一消費者と複数生産者/複数消費者, および
+ *  mutex で保護した @ref QUEUE で比べる. 全スレッドを同時に開始し,
+ *  すべての要素が取り出されるまでの時間から 1 要素あたりの時間を求める.
+ *  揺らぎを除くため, 繰り返しのうち最短の時間をとる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "collections.h"
+#include "bench.h"
+
+/**
+ *  計測の繰り返し回数.
+ */
+#define ROUNDS (3)
+
+/**
+ *  1 回の計測で受け渡す要素数の合計.
+ */
+#define OPERATIONS (1000000)
+
+/**
+ *  キューの容量.
+ */
+#define CAPACITY (1024)
+
+/**
+ *  スレッドの最大数.
+ */
+#define THREADS_MAX (8)
+
+/**
+ *  受け渡しの方式.
+ */
+enum kind {
+    KIND_MUTEX, /**< mutex で保護した QUEUE. */
+    KIND_SPSC,  /**< CQUEUE_SPSC. */
+    KIND_MPMC   /**< CQUEUE_MPMC. */
+};
+
+/**
+ *  計測の共有データ.
+ */
+struct bench {
+    enum kind kind;             /**< 受け渡しの方式. */
+    QUEUE que;                  /**< KIND_MUTEX のキュー. */
+    pthread_mutex_t lock;       /**< KIND_MUTEX のキューの排他. */
+    CQUEUE cque;                /**< KIND_SPSC, KIND_MPMC のキュー. */
+    size_t per_producer;        /**< 生産者 1 つあたりの要素数. */
+    _Atomic size_t remaining;   /**< 取り出されていない要素数. */
+    _Atomic int ready;          /**< 開始を待っているスレッドの数. */
+    _Atomic uint64_t sum;       /**< 取り出した値の合計. */
+};
+
+/**
+ *  要素を 1 つ積める.
+ *
+ *  @param  [in,out]    b       計測の共有データ.
+ *  @param  [in]        value   積める値.
+ *  @return 成功時は 0 が, 満杯の場合は -1 が返る.
+ */
+static int put(struct bench *b, uint64_t value)
+{
+    int ret;
+
+    if (b->kind != KIND_MUTEX) {
+        return cqueue_enq(b->cque, &value);
+    }
+    pthread_mutex_lock(&b->lock);
+    ret = (queue_enq(b->que, &value) != NULL) ? 0 : -1;
+    pthread_mutex_unlock(&b->lock);
+
+    return ret;
+}
+
+/**
+ *  要素を 1 つ取り出す.
+ *
+ *  @param  [in,out]    b       計測の共有データ.
+ *  @param  [out]       value   取り出した値.
+ *  @return 成功時は 0 が, 空の場合は -1 が返る.
+ */
+static int take(struct bench *b, uint64_t *value)
+{
+    int ret;
+
+    if (b->kind != KIND_MUTEX) {
+        return cqueue_deq(b->cque, value);
+    }
+    pthread_mutex_lock(&b->lock);
+    ret = (queue_deq(b->que, value) >= 0) ? 0 : -1;
+    pthread_mutex_unlock(&b->lock);
+
+    return ret;
+}
+
+/**
+ *  全スレッドがそろうまで待つ.
+ */
+static void rendezvous(struct bench *b)
+{
+    atomic_fetch_sub(&b->ready, 1);
+    while (atomic_load(&b->ready) > 0) {
+        sched_yield();
+    }
+}
+
+static void *producer(void *arg)
+{
+    struct bench *b = arg;
+
+    rendezvous(b);
+    for (uint64_t i = 0; i < b->per_producer; ++i) {
+        while (put(b, i) != 0) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    struct bench *b = arg;
+    uint64_t sum = 0;
+    uint64_t value;
+
+    rendezvous(b);
+    while (atomic_load_explicit(&b->remaining, memory_order_relaxed) > 0) {
+        if (take(b, &value) == 0) {
+            sum += value;
+            atomic_fetch_sub_explicit(&b->remaining, 1, memory_order_relaxed);
+        } else {
+            sched_yield();
+        }
+    }
+    atomic_fetch_add(&b->sum, sum);
+
+    return NULL;
+}
+
+/**
+ *  @c producers 個の生産者と @c consumers 個の消費者で受け渡す時間を計測する.
+ *
+ *  @param  [in]    kind        受け渡しの方式.
+ *  @param  [in]    producers   生産者スレッドの数.
+ *  @param  [in]    consumers   消費者スレッドの数.
+ *  @return 成功時は, 1 要素あたりの時間 (ナノ秒) が返る.
+ *          失敗時は, 負の値が返る.
+ */
+static double measure(enum kind kind, int producers, int consumers)
+{
+    struct bench b = {
+        .kind = kind,
+        .per_producer = OPERATIONS / producers
+    };
+    pthread_t threads[THREADS_MAX];
+    uint64_t best = UINT64_MAX;
+    size_t total = b.per_producer * producers;
+
+    b.que = queue_init(sizeof(uint64_t), CAPACITY);
+    b.cque = cqueue_init(sizeof(uint64_t), CAPACITY, (kind == KIND_SPSC) ? CQUEUE_SPSC : CQUEUE_MPMC);
+    pthread_mutex_init(&b.lock, NULL);
+    if ((b.que == NULL) || (b.cque == NULL)) {
+        return -1.0;
+    }
+
+    for (int r = 0; r < ROUNDS; ++r) {
+        atomic_store(&b.remaining, total);
+        atomic_store(&b.ready, producers + consumers + 1);
+        atomic_store(&b.sum, 0);
+        for (int i = 0; i < producers + consumers; ++i) {
+            pthread_create(&threads[i], NULL, (i < producers) ? producer : consumer, &b);
+        }
+        rendezvous(&b);
+        uint64_t start = bench_now();
+        for (int i = 0; i < producers + consumers; ++i) {
+            pthread_join(threads[i], NULL);
+        }
+        uint64_t elapsed = bench_now() - start;
+        if (atomic_load(&b.sum) != (uint64_t)producers * (b.per_producer * (b.per_producer - 1) / 2)) {
+            fprintf(stderr, "lost elements\n");
+            return -1.0;
+        }
+        best = (elapsed < best) ? elapsed : best;
+    }
+
+    pthread_mutex_destroy(&b.lock);
+    cqueue_release(b.cque);
+    queue_release(b.que);
+
+    return (double)best / (double)total;
+}
+
+int main(void)
+{
+    const int pairs[][2] = {{1, 1}, {2, 2}, {4, 4}};
+
+    printf("# hand over one 8-byte element between threads\n");
+    printf("%10s %14s %14s %14s\n", "threads", "mutex[ns]", "spsc[ns]", "mpmc[ns]");
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); ++i) {
+        int p = pairs[i][0], c = pairs[i][1];
+        double mutex_ns = measure(KIND_MUTEX, p, c);
+        double spsc_ns = (p == 1) ? measure(KIND_SPSC, p, c) : 0.0;
+        double mpmc_ns = measure(KIND_MPMC, p, c);
+        char label[16];
+
+        if ((mutex_ns < 0.0) || (spsc_ns < 0.0) || (mpmc_ns < 0.0)) {
+            return EXIT_FAILURE;
+        }
+        snprintf(label, sizeof(label), "%dP/%dC", p, c);
+        if (p == 1) {
+            printf("%10s %14.1f %14.1f %14.1f\n", label, mutex_ns, spsc_ns, mpmc_ns);
+        } else {
+            printf("%10s %14.1f %14s %14.1f\n", label, mutex_ns, "-", mpmc_ns);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+/** @file   dump.c
+ *  @brief  状態遷移のダンプのベンチマーク.
+ *
+ *  状態数を倍々に増やした定義を生成し, @ref fsm_dump_state_transition の
+ *  処理時間を計測する.
+ *  状態あたりの時間がほぼ一定であれば, 線形時間で処理できている.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hfsm.h"
+#include "bench.h"
+
+/**
+ *  コンポジット状態あたりの状態数 (コンポジット状態自身を含む).
+ */
+#define GROUP_SIZE (16)
+
+/**
+ *  計測の繰り返し回数.
+ */
+#define REPEAT (5)
+
+FSM_EVENT(event_next);
+FSM_EVENT(event_jump);
+
+/**
+ *  生成した状態遷移定義.
+ */
+struct chart_def {
+    struct fsm_state_variable *variables; /**< 状態変数の配列. */
+    struct fsm_state *states;             /**< 状態の配列. */
+    struct fsm_rels *rels;                /**< 状態の関係性. */
+    struct fsm_trans *corresps;           /**< 遷移の対応表. */
+};
+
+/**
+ *  ダンプした多分木の要素数.
+ */
+static ssize_t dumped;
+
+/**
+ *  ダンプのハンドラ.
+ *
+ *  @param  [in]    tree    状態の多分木.
+ */
+static void count_handler(TREE tree)
+{
+    dumped = tree_count(tree);
+}
+
+/**
+ *  @c n 個の状態を持つ定義を生成する.
+ *
+ *  @c GROUP_SIZE 個毎に先頭の状態をコンポジット状態とし, 残りをその子とする.
+ *  各状態は次の状態と 7 倍した位置の状態へ遷移する.
+ *
+ *  @param  [out]   def 生成した定義.
+ *  @param  [in]    n   状態の数.
+ *  @return 成功時は, 0 が返る. 失敗時は, -1 が返る.
+ */
+static int chart_def_init(struct chart_def *def, size_t n)
+{
+    size_t nrels = 0;
+
+    def->variables = calloc(n, sizeof(*def->variables));
+    def->states = calloc(n, sizeof(*def->states));
+    def->rels = calloc(n + 1, sizeof(*def->rels));
+    def->corresps = calloc((n * 2) + 2, sizeof(*def->corresps));
+    if ((def->variables == NULL) || (def->states == NULL)
+        || (def->rels == NULL) || (def->corresps == NULL)) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        def->states[i].name = "generated";
+        def->states[i].variable = &def->variables[i];
+        if ((i % GROUP_SIZE) != 0) {
+            size_t parent = i - (i % GROUP_SIZE);
+            def->rels[nrels++] = (struct fsm_rels)FSM_RELS_HELPER(&def->states[i],
+                                                                  &def->states[parent],
+                                                                  (i % GROUP_SIZE) == 1);
+        }
+    }
+
+    def->corresps[0] = (struct fsm_trans)FSM_TRANS_HELPER(state_start, event_null,
+                                                          NULL, NULL, &def->states[1]);
+    for (size_t i = 0; i < n; ++i) {
+        def->corresps[(i * 2) + 1] =
+            (struct fsm_trans)FSM_TRANS_HELPER(&def->states[i], event_next,
+                                               NULL, NULL, &def->states[(i + 1) % n]);
+        def->corresps[(i * 2) + 2] =
+            (struct fsm_trans)FSM_TRANS_HELPER(&def->states[i], event_jump,
+                                               NULL, NULL, &def->states[(i * 7) % n]);
+    }
+
+    return 0;
+}
+
+/**
+ *  生成した定義を解放する.
+ *
+ *  @param  [in,out]    def 生成した定義.
+ */
+static void chart_def_release(struct chart_def *def)
+{
+    free(def->corresps);
+    free(def->rels);
+    free(def->states);
+    free(def->variables);
+}
+
+int main(int argc, char **argv)
+{
+    size_t max = (argc > 1) ? strtoul(argv[1], NULL, 0) : 32768;
+
+    bench_header("fsm_dump_state_transition", "per state[ns]");
+    for (size_t n = 1024; n <= max; n *= 2) {
+        struct chart_def def;
+        uint64_t best = UINT64_MAX;
+
+        if (chart_def_init(&def, n) != 0) {
+            fprintf(stderr, "failed to generate %zu states\n", n);
+            chart_def_release(&def);
+            return EXIT_FAILURE;
+        }
+        struct fsm *machine = fsm_init(def.rels, def.corresps);
+        if (machine == NULL) {
+            chart_def_release(&def);
+            return EXIT_FAILURE;
+        }
+
+        for (int i = 0; i < REPEAT; ++i) {
+            uint64_t start = bench_now();
+            fsm_dump_state_transition(machine, count_handler);
+            uint64_t elapsed = bench_now() - start;
+            if (elapsed < best) {
+                best = elapsed;
+            }
+        }
+        if (dumped != (ssize_t)n + 1) {
+            fprintf(stderr, "dumped %zd states, expected %zu\n", dumped, n + 1);
+        }
+        bench_report(n, best, n);
+
+        fsm_term(machine);
+        chart_def_release(&def);
+    }
+
+    return EXIT_SUCCESS;
+}
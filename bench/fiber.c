@@ -0,0 +1,69 @@
+/** @file   fiber.c
+ *  @brief  ファイバの do アクティビティのベンチマーク.
+ *
+ *  多数の状態マシンのファイバ状態を 1 つのスレッドで順に更新し,
+ *  do アクティビティ 1 回の再開あたりの時間を計測する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hfsm.h"
+#include "bench.h"
+
+/**
+ *  状態マシン毎の更新回数.
+ */
+#define ROUNDS (16)
+
+static void activity_exec(struct fsm *machine, void *data)
+{
+    while (!fsm_yield(machine)) {
+    }
+}
+FSM_FIBER_STATE(state_working, NULL, NULL, activity_exec, NULL);
+
+int main(int argc, char **argv)
+{
+    size_t max = (argc > 1) ? strtoul(argv[1], NULL, 0) : 16384;
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_working),
+        FSM_TRANS_TERMINATOR
+    };
+
+    bench_header("fsm_update resuming fiber activities", "per resume[ns]");
+    for (size_t n = 1024; n <= max; n *= 4) {
+        struct fsm **machines = calloc(n, sizeof(struct fsm *));
+        if (machines == NULL) {
+            return EXIT_FAILURE;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            machines[i] = fsm_init(NULL, corresps);
+            if (machines[i] == NULL) {
+                return EXIT_FAILURE;
+            }
+            /* ファイバの確保と開始は計測から除く. */
+            fsm_update(machines[i]);
+        }
+
+        uint64_t start = bench_now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            for (size_t i = 0; i < n; ++i) {
+                fsm_update(machines[i]);
+            }
+        }
+        bench_report(n, bench_now() - start, n * ROUNDS);
+
+        for (size_t i = 0; i < n; ++i) {
+            fsm_term(machines[i]);
+        }
+        free(machines);
+    }
+
+    return EXIT_SUCCESS;
+}
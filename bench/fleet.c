@@ -0,0 +1,144 @@
+/** @file   fleet.c
+ *  @brief  フリートのベンチマーク.
+ *
+ *  環状に遷移する定義について, インスタンス 1 つあたりの遷移の時間を,
+ *  個別の状態マシンの @ref fsm_transition と, フリートの各処理方式で計測する.
+ *  揺らぎを除くため, 繰り返しのうち最短の時間をとる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "hfsm.h"
+#include "fleet.h"
+#include "bench.h"
+
+/**
+ *  環状に並べる状態の数.
+ */
+#define RING_SIZE (16)
+
+/**
+ *  フリートのインスタンスの数.
+ */
+#define FLEET_COUNT (1000 * 1000)
+
+/**
+ *  個別の状態マシンの数.
+ */
+#define MACHINE_COUNT (100 * 1000)
+
+/**
+ *  計測の繰り返しの回数.
+ */
+#define ROUNDS (10)
+
+FSM_EVENT(event_next);
+FSM_EVENT(event_back);
+
+/**
+ *  フリートの遷移の時間を計測する.
+ *
+ *  @param  [in]    title   計測の名前.
+ *  @param  [in]    fleet   フリート.
+ *  @param  [in]    kernel  遷移の処理方式.
+ *  @param  [in]    events  インスタンス毎のイベントの番号. (NULL の場合は全インスタンスに同じイベント)
+ */
+static void measure_fleet(const char *title,
+                          struct fsm_fleet *fleet,
+                          enum fsm_fleet_kernel kernel,
+                          const int32_t *events)
+{
+    uint64_t best = UINT64_MAX;
+
+    if (fsm_fleet_set_kernel(fleet, kernel) != 0) {
+        printf("%-28s %10s\n", title, "n/a");
+        return;
+    }
+    for (int r = 0; r < ROUNDS; ++r) {
+        uint64_t start = bench_now();
+        if (events != NULL) {
+            fsm_fleet_dispatch_each(fleet, events);
+        } else {
+            fsm_fleet_dispatch(fleet, event_next);
+        }
+        uint64_t elapsed = bench_now() - start;
+        best = (elapsed < best) ? elapsed : best;
+    }
+    printf("%-28s %10.2f ns/instance\n", title, (double)best / FLEET_COUNT);
+}
+
+int main(void)
+{
+    static struct fsm_state_variable variables[RING_SIZE];
+    static struct fsm_state states[RING_SIZE];
+    static struct fsm_trans corresps[2 * RING_SIZE + 2];
+    static char names[RING_SIZE][16];
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < RING_SIZE; ++i) {
+        snprintf(names[i], sizeof(names[i]), "ring%d", i);
+        states[i].name = names[i];
+        states[i].variable = &variables[i];
+    }
+    corresps[0] = (struct fsm_trans)FSM_TRANS_HELPER(state_start, event_null,
+                                                     NULL, NULL, &states[0]);
+    for (int i = 0; i < RING_SIZE; ++i) {
+        corresps[2 * i + 1] = (struct fsm_trans)FSM_TRANS_HELPER(&states[i], event_next, NULL, NULL,
+                                                                 &states[(i + 1) % RING_SIZE]);
+        corresps[2 * i + 2] = (struct fsm_trans)FSM_TRANS_HELPER(&states[i], event_back, NULL, NULL,
+                                                                 &states[(i + RING_SIZE - 1) % RING_SIZE]);
+    }
+
+    struct fsm_table *table = fsm_table_compile(corresps, NULL, NULL);
+    struct fsm **machines = calloc(MACHINE_COUNT, sizeof(struct fsm *));
+    struct fsm_fleet *fleet = fsm_fleet_init(NULL, corresps, FLEET_COUNT, NULL, 0);
+    int32_t *events = malloc(FLEET_COUNT * sizeof(int32_t));
+    if ((table == NULL) || (machines == NULL) || (fleet == NULL) || (events == NULL)) {
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < MACHINE_COUNT; ++i) {
+        machines[i] = fsm_init_table(NULL, table);
+        if (machines[i] == NULL) {
+            return EXIT_FAILURE;
+        }
+    }
+    int32_t next = fsm_fleet_event_id(fleet, event_next);
+    int32_t back = fsm_fleet_event_id(fleet, event_back);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < FLEET_COUNT; ++i) {
+        seed = seed * 1103515245 + 12345;
+        events[i] = (seed >> 16) % 3 == 0 ? back : next;
+    }
+
+    printf("# transition of %d-state ring machines\n", RING_SIZE);
+    for (int r = 0; r < ROUNDS; ++r) {
+        uint64_t start = bench_now();
+        for (size_t i = 0; i < MACHINE_COUNT; ++i) {
+            fsm_transition(machines[i], event_next);
+        }
+        uint64_t elapsed = bench_now() - start;
+        best = (elapsed < best) ? elapsed : best;
+    }
+    printf("%-28s %10.2f ns/instance\n", "fsm_transition", (double)best / MACHINE_COUNT);
+    measure_fleet("fleet dispatch (scalar)", fleet, FSM_FLEET_SCALAR, NULL);
+    measure_fleet("fleet dispatch (avx2)", fleet, FSM_FLEET_AVX2, NULL);
+    measure_fleet("fleet dispatch_each (scalar)", fleet, FSM_FLEET_SCALAR, events);
+    measure_fleet("fleet dispatch_each (avx2)", fleet, FSM_FLEET_AVX2, events);
+
+    for (size_t i = 0; i < MACHINE_COUNT; ++i) {
+        fsm_term(machines[i]);
+    }
+    free(machines);
+    free(events);
+    fsm_fleet_term(fleet);
+    fsm_table_release(table);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/** @file   group.c
+ *  @brief  グループへの一斉配信のベンチマーク.
+ *
+ *  一部の状態マシンのみが処理できるイベントを, 全状態マシンへの
+ *  @ref fsm_transition で配る場合と, @ref fsm_group_broadcast で配る場合について,
+ *  1 回の配信あたりの時間を計測する. 揺らぎを除くため, 繰り返しのうち最短の時間をとる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "hfsm.h"
+#include "group.h"
+#include "bench.h"
+
+/**
+ *  計測する配信の回数.
+ */
+#define ROUNDS (20)
+
+FSM_STATE(state_idle, NULL, NULL, NULL, NULL);
+FSM_STATE(state_busy, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_busy);
+FSM_EVENT(event_ping);
+
+/**
+ *  @c nmachines の状態マシンのうち @c percent % が処理できるイベントの配信時間を計測する.
+ *
+ *  @param  [in]    corresps    状態遷移の対応表.
+ *  @param  [in]    nmachines   状態マシンの数.
+ *  @param  [in]    percent     イベントを処理できる状態マシンの割合.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返る.
+ */
+static int measure(const struct fsm_trans *corresps, size_t nmachines, int percent)
+{
+    struct fsm_table *table = fsm_table_compile(corresps, NULL, NULL);
+    struct fsm_group *group = fsm_group_init(NULL, corresps);
+    struct fsm **machines = calloc(nmachines, sizeof(struct fsm *));
+    uint64_t start, elapsed, all_ns = UINT64_MAX, group_ns = UINT64_MAX;
+    ssize_t delivered = 0;
+    int ret = -1;
+
+    if ((table == NULL) || (group == NULL) || (machines == NULL)) {
+        goto out;
+    }
+    for (size_t i = 0; i < nmachines; ++i) {
+        machines[i] = fsm_init_table(NULL, table);
+        if (machines[i] == NULL) {
+            goto out;
+        }
+        /* 処理できる状態マシンをばらけさせる. */
+        if ((i * percent) % 100 < (size_t)percent) {
+            fsm_transition(machines[i], event_busy);
+        }
+        if (fsm_group_join(group, machines[i]) != 0) {
+            if (errno == ENOTSUP) {
+                printf("observers are compiled out (OBSERVER=0)\n");
+                ret = 0;
+            }
+            goto out;
+        }
+    }
+
+    for (int r = 0; r < ROUNDS; ++r) {
+        start = bench_now();
+        for (size_t i = 0; i < nmachines; ++i) {
+            fsm_transition(machines[i], event_ping);
+        }
+        elapsed = bench_now() - start;
+        all_ns = (elapsed < all_ns) ? elapsed : all_ns;
+
+        start = bench_now();
+        delivered = fsm_group_broadcast(group, event_ping);
+        elapsed = bench_now() - start;
+        group_ns = (elapsed < group_ns) ? elapsed : group_ns;
+    }
+
+    printf("%10zu %7d%% %10zd %14.1f %14.1f\n",
+           nmachines, percent, delivered,
+           (double)all_ns / 1000.0, (double)group_ns / 1000.0);
+    ret = 0;
+
+out:
+    if (machines != NULL) {
+        for (size_t i = 0; i < nmachines; ++i) {
+            if (machines[i] != NULL) {
+                fsm_group_leave(group, machines[i]);
+                fsm_term(machines[i]);
+            }
+        }
+    }
+    free(machines);
+    fsm_group_term(group);
+    fsm_table_release(table);
+
+    return ret;
+}
+
+int main(void)
+{
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_idle),
+        FSM_TRANS_HELPER(state_idle, event_busy, NULL, NULL, state_busy),
+        FSM_TRANS_HELPER(state_busy, event_ping, NULL, NULL, NULL),
+        FSM_TRANS_TERMINATOR
+    };
+    const size_t sizes[] = {1000, 10000, 100000};
+    const int percents[] = {1, 10, 100};
+
+    printf("# broadcast to machines that can handle the event\n");
+    printf("%10s %8s %10s %14s %14s\n", "machines", "handle", "delivered", "all[us]", "group[us]");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        for (size_t j = 0; j < sizeof(percents) / sizeof(percents[0]); ++j) {
+            if (measure(corresps, sizes[i], percents[j]) != 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+/** @file   journal.c
+ *  @brief  イベントの記録と再生のベンチマーク.
+ *
+ *  環状に遷移する定義でイベントを記録し, 記録と再生の 1 件あたりの時間を
+ *  計測する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "hfsm.h"
+#include "journal.h"
+#include "bench.h"
+
+/**
+ *  環状に並べる状態の数.
+ */
+#define RING_SIZE (16)
+
+FSM_EVENT(event_next);
+
+int main(int argc, char **argv)
+{
+    static struct fsm_state_variable variables[RING_SIZE];
+    static struct fsm_state states[RING_SIZE];
+    static struct fsm_trans corresps[RING_SIZE + 2];
+    size_t events = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000000;
+    char path[] = "/tmp/hfsm_bench_journal_XXXXXX";
+    struct fsm_replay_stats stats;
+    uint64_t payload = 0;
+    uint64_t start, recorded, replayed;
+
+    for (int i = 0; i < RING_SIZE; ++i) {
+        states[i].name = "ring";
+        states[i].variable = &variables[i];
+    }
+    corresps[0] = (struct fsm_trans)FSM_TRANS_HELPER(state_start, event_null,
+                                                     NULL, NULL, &states[0]);
+    for (int i = 0; i < RING_SIZE; ++i) {
+        corresps[i + 1] = (struct fsm_trans)FSM_TRANS_HELPER(&states[i], event_next, NULL, NULL,
+                                                             &states[(i + 1) % RING_SIZE]);
+    }
+
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    struct fsm *machine = fsm_init(NULL, corresps);
+    struct fsm_journal *journal = fsm_journal_open(path, NULL, corresps);
+    if ((machine == NULL) || (journal == NULL)) {
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+    start = bench_now();
+    for (size_t i = 0; i < events; ++i) {
+        payload = i;
+        fsm_journal_transition(journal, machine, event_next, &payload, sizeof(payload));
+    }
+    fsm_journal_close(journal);
+    recorded = bench_now() - start;
+    fsm_term(machine);
+
+    machine = fsm_init(NULL, corresps);
+    start = bench_now();
+    fsm_journal_replay(path, NULL, corresps, machine, NULL, NULL, &stats);
+    replayed = bench_now() - start;
+    fsm_term(machine);
+    unlink(path);
+
+    bench_header("fsm_journal_transition (8-byte payload)", "per event[ns]");
+    bench_report(events, recorded, events);
+    bench_header("fsm_journal_replay", "per event[ns]");
+    bench_report(stats.records, replayed, stats.records);
+    if ((stats.records != events) || (stats.diverged >= 0)) {
+        fprintf(stderr, "replayed %zu of %zu events, diverged at %zd\n",
+                stats.records, events, stats.diverged);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
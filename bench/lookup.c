@@ -0,0 +1,165 @@
+/** @file   lookup.c
+ *  @brief  遷移表の検索方式のベンチマーク.
+ *
+ *  状態毎に 8 つの遷移を持つ疎な遷移表について, 検索方式毎の
+ *  遷移表の生成時間, メモリ量および @ref fsm_transition 1 回あたりの時間を計測する.
+ *  線形走査は大きな遷移表では遅すぎるため, 小さな遷移表のみ計測する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hfsm.h"
+#include "bench.h"
+
+/**
+ *  状態毎の遷移の数.
+ */
+#define FANOUT (8)
+
+/**
+ *  イベントの数.
+ */
+#define NEVENTS (5000)
+
+/**
+ *  計測する遷移の回数.
+ */
+#define ITERATIONS (1000 * 1000)
+
+/**
+ *  線形走査を計測する状態の数の上限.
+ */
+#define LINEAR_MAX (1000)
+
+/**
+ *  乱数を生成する. (xorshift64)
+ *
+ *  @param  [in,out]    state   乱数の状態.
+ *  @return 乱数が返る.
+ */
+static inline uint64_t next_random(uint64_t *state)
+{
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+
+    return x;
+}
+
+/**
+ *  検索方式の名前.
+ */
+static const char *const lookup_names[] = {"auto", "linear", "sorted", "hash"};
+
+/**
+ *  1 つの検索方式で計測する.
+ *
+ *  @param  [in]    nstates     状態の数.
+ *  @param  [in]    states      状態の配列.
+ *  @param  [in]    corresps    遷移の対応表.
+ *  @param  [in]    events      状態毎の遷移のイベント.
+ *  @param  [in]    lookup      検索方式.
+ */
+static void measure(size_t nstates,
+                    struct fsm_state *states,
+                    const struct fsm_trans *corresps,
+                    const struct fsm_event **events,
+                    enum fsm_lookup lookup)
+{
+    uint64_t random = 2501;
+    uint64_t start = bench_now();
+    struct fsm_table *table = fsm_table_compile_as(corresps, lookup, NULL, NULL);
+    uint64_t built = bench_now() - start;
+    struct fsm *machine = fsm_init_table(NULL, table);
+    int iterations = (lookup == FSM_LOOKUP_LINEAR) ? ITERATIONS / 10 : ITERATIONS;
+
+    if ((table == NULL) || (machine == NULL)) {
+        fprintf(stderr, "failed to build %s table\n", lookup_names[lookup]);
+        exit(EXIT_FAILURE);
+    }
+
+    start = bench_now();
+    for (int i = 0; i < iterations; ++i) {
+        size_t current = (size_t)(fsm_get_current(machine) - states);
+        fsm_transition(machine, events[(current * FANOUT) + (next_random(&random) % FANOUT)]);
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    printf("%10zu %10zu %-8s %12.2f %12.1f %14.1f\n",
+           nstates,
+           nstates * FANOUT,
+           lookup_names[fsm_table_lookup(table)],
+           (double)fsm_table_bytes(table) / (1024.0 * 1024.0),
+           (double)built / 1000000.0,
+           (double)elapsed / iterations);
+
+    fsm_term(machine);
+    fsm_table_release(table);
+}
+
+int main(void)
+{
+    static const size_t sizes[] = {1000, 10000, 100000};
+    static struct fsm_event events[NEVENTS];
+    uint64_t random = 1;
+
+    for (int i = 0; i < NEVENTS; ++i) {
+        events[i].name = "event";
+    }
+
+    printf("# fsm_transition on sparse tables (%d events, %d transitions per state)\n",
+           NEVENTS, FANOUT);
+    printf("%10s %10s %-8s %12s %12s %14s\n",
+           "states", "trans", "lookup", "memory[MiB]", "build[ms]", "ns/transition");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        size_t nstates = sizes[s];
+        struct fsm_state_variable *variables = calloc(nstates, sizeof(*variables));
+        struct fsm_state *states = calloc(nstates, sizeof(*states));
+        struct fsm_trans *corresps = calloc((nstates * FANOUT) + 2, sizeof(*corresps));
+        const struct fsm_event **trans_events = calloc(nstates * FANOUT, sizeof(*trans_events));
+        if ((variables == NULL) || (states == NULL) || (corresps == NULL) || (trans_events == NULL)) {
+            return EXIT_FAILURE;
+        }
+
+        for (size_t i = 0; i < nstates; ++i) {
+            states[i].name = "state";
+            states[i].variable = &variables[i];
+        }
+        corresps[0] = (struct fsm_trans)FSM_TRANS_HELPER(state_start, event_null,
+                                                         NULL, NULL, &states[0]);
+        for (size_t i = 0; i < nstates; ++i) {
+            /* 同じ状態で同じイベントが重ならないよう, 間隔を空けて選ぶ. */
+            size_t base = next_random(&random) % NEVENTS;
+            for (size_t j = 0; j < FANOUT; ++j) {
+                const struct fsm_event *event = &events[(base + (j * (NEVENTS / FANOUT))) % NEVENTS];
+                trans_events[(i * FANOUT) + j] = event;
+                corresps[1 + (i * FANOUT) + j] =
+                    (struct fsm_trans)FSM_TRANS_HELPER(&states[i], event, NULL, NULL,
+                                                       &states[next_random(&random) % nstates]);
+            }
+        }
+
+        if (nstates <= LINEAR_MAX) {
+            measure(nstates, states, corresps, trans_events, FSM_LOOKUP_LINEAR);
+        }
+        measure(nstates, states, corresps, trans_events, FSM_LOOKUP_SORTED);
+        measure(nstates, states, corresps, trans_events, FSM_LOOKUP_HASH);
+        measure(nstates, states, corresps, trans_events, FSM_LOOKUP_AUTO);
+
+        free(trans_events);
+        free(corresps);
+        free(states);
+        free(variables);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+/** @file   loop.c
+ *  @brief  イベントループのベンチマーク.
+ *
+ *  多数の状態マシンを 1 つのループで駆動し, 他のスレッドから積んだイベントが
+ *  処理されるまでの 1 件あたりの時間を計測する.
+ *  あわせて, ループのスレッドが消費した CPU 時間を出力する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "hfsm.h"
+#include "loop.h"
+#include "bench.h"
+
+/**
+ *  駆動する状態マシンの数.
+ */
+#define MACHINES (4096)
+
+FSM_STATE(state_idle, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_request);
+
+/**
+ *  処理したイベントの数.
+ */
+static size_t handled;
+
+FSM_ACTION(action_request, (struct fsm *machine))
+{
+    ++handled;
+}
+
+/**
+ *  イベントを積むスレッドの引数.
+ */
+struct producer {
+    struct fsm_loop *loop;
+    struct fsm **machines;
+    size_t events;
+};
+
+/**
+ *  状態マシンに順にイベントを積み, 最後にループを停止する.
+ *
+ *  @param  [in]    arg イベントを積むスレッドの引数.
+ *  @return NULL が返る.
+ */
+static void *produce(void *arg)
+{
+    struct producer *producer = arg;
+
+    for (size_t i = 0; i < producer->events; ++i) {
+        struct fsm *machine = producer->machines[i % MACHINES];
+        while (fsm_loop_post(producer->loop, machine, event_request, FSM_PRIORITY_NORMAL) != 0) {
+            if (errno != ENOBUFS) {
+                return NULL;
+            }
+            sched_yield();
+        }
+    }
+    fsm_loop_stop(producer->loop);
+
+    return NULL;
+}
+
+/**
+ *  スレッドの CPU 時間をナノ秒で取得する.
+ *
+ *  @return CPU 時間 (ナノ秒) が返る.
+ */
+static uint64_t thread_cputime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1048576;
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_idle),
+        FSM_TRANS_HELPER(state_idle, event_request, NULL, action_request, NULL),
+        FSM_TRANS_TERMINATOR
+    };
+    static struct fsm *machines[MACHINES];
+
+    struct fsm_loop *loop = fsm_loop_init();
+    if (loop == NULL) {
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < MACHINES; ++i) {
+        machines[i] = fsm_init(NULL, corresps);
+        if (machines[i] == NULL) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("# fsm_loop_post from another thread to %d machines\n", MACHINES);
+    printf("%10s %14s %14s %14s\n", "n", "total[us]", "per event[ns]", "loop cpu[us]");
+    for (size_t n = 16384; n <= max; n *= 4) {
+        struct producer producer = {
+            .loop = loop,
+            .machines = machines,
+            .events = n
+        };
+        pthread_t thread;
+
+        handled = 0;
+        uint64_t start = bench_now();
+        uint64_t cpu = thread_cputime();
+        if (pthread_create(&thread, NULL, produce, &producer) != 0) {
+            return EXIT_FAILURE;
+        }
+        fsm_loop_run(loop);
+        pthread_join(thread, NULL);
+        /* 停止の要求と同じ待ちで処理されなかったイベントを処理する. */
+        while (handled < n) {
+            if (fsm_loop_run_once(loop, 100) <= 0) {
+                break;
+            }
+        }
+        uint64_t elapsed = bench_now() - start;
+        cpu = thread_cputime() - cpu;
+
+        printf("%10zu %14.1f %14.1f %14.1f\n",
+               n, (double)elapsed / 1000.0, (double)elapsed / (double)n, (double)cpu / 1000.0);
+        if (handled != n) {
+            fprintf(stderr, "handled %zu of %zu events\n", handled, n);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (size_t i = 0; i < MACHINES; ++i) {
+        fsm_term(machines[i]);
+    }
+    fsm_loop_term(loop);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+/** @file   map.c
+ *  @brief  マップのベンチマーク.
+ *
+ *  キーと値の構造体を @ref LIST に並べて線形に探す方法と, @ref MAP で
+ *  引く方法の 1 回の検索の時間を要素数を倍々に増やして比べる.
+ *  また, 複数のスレッドから 9 割を読み込み, 1 割を書き込みとして操作した時間を,
+ *  1 つの mutex で保護した @ref MAP と, 分割毎に読み書きロックを持つ
+ *  @ref CMAP で比べる. 揺らぎを除くため, 繰り返しのうち最短の時間をとる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "collections.h"
+#include "bench.h"
+
+/**
+ *  計測の繰り返し回数.
+ */
+#define ROUNDS (3)
+
+/**
+ *  1 回の計測での MAP の検索回数.
+ */
+#define LOOKUPS (1000000)
+
+/**
+ *  並行計測でのキーの数.
+ */
+#define KEYS (65536)
+
+/**
+ *  並行計測でのスレッド毎の操作回数.
+ */
+#define OPERATIONS (200000)
+
+/**
+ *  リストに並べるキーと値.
+ */
+struct entry {
+    uint64_t key;   /**< キー. */
+    uint64_t value; /**< 値. */
+};
+
+/**
+ *  最適化で検索が除かれないよう結果を保持する.
+ */
+static volatile uint64_t sink;
+
+/**
+ *  xorshift で疑似乱数を進める.
+ */
+static inline uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ *  @c n 要素での検索の時間を計測する.
+ *
+ *  @param  [in]    n   要素数.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返る.
+ */
+static int measure_lookup(size_t n)
+{
+    LIST list = list_init(sizeof(struct entry), n);
+    MAP map = map_init(sizeof(uint64_t), sizeof(uint64_t), n);
+    size_t list_lookups = (LOOKUPS / n > 1000) ? LOOKUPS / n : 1000;
+    uint64_t list_ns = UINT64_MAX, map_ns = UINT64_MAX;
+    int ret = -1;
+
+    if ((list == NULL) || (map == NULL)) {
+        goto out;
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        struct entry e = {.key = i * 2654435761u, .value = i};
+        list_add(list, &e);
+        map_put(map, &e.key, &e.value);
+    }
+
+    for (int r = 0; r < ROUNDS; ++r) {
+        uint64_t state = 88172645463325252ULL;
+        uint64_t sum = 0;
+        uint64_t start = bench_now();
+        for (size_t l = 0; l < list_lookups; ++l) {
+            uint64_t key = (next_random(&state) % n) * 2654435761u;
+            for (ITER iter = list_iter(list); iter != NULL; iter = iter_next(iter)) {
+                struct entry *e = iter_get_payload(iter);
+                if (e->key == key) {
+                    sum += e->value;
+                    break;
+                }
+            }
+        }
+        uint64_t elapsed = bench_now() - start;
+        list_ns = (elapsed < list_ns) ? elapsed : list_ns;
+
+        start = bench_now();
+        for (size_t l = 0; l < LOOKUPS; ++l) {
+            uint64_t key = (next_random(&state) % n) * 2654435761u;
+            sum += *(uint64_t *)map_get(map, &key);
+        }
+        elapsed = bench_now() - start;
+        map_ns = (elapsed < map_ns) ? elapsed : map_ns;
+        sink = sum;
+    }
+
+    printf("%10zu %14.1f %14.1f\n", n, (double)list_ns / (double)list_lookups, (double)map_ns / (double)LOOKUPS);
+    ret = 0;
+
+out:
+    map_release(map);
+    list_release(list);
+
+    return ret;
+}
+
+/**
+ *  並行計測の共有データ.
+ */
+struct shared {
+    MAP map;                /**< mutex で保護するマップ. (CMAP の場合は NULL) */
+    pthread_mutex_t lock;   /**< @c map の排他. */
+    CMAP cmap;              /**< 並行マップ. */
+    uint64_t seed;          /**< 乱数の種. */
+};
+
+static void *worker(void *arg)
+{
+    struct shared *s = arg;
+    uint64_t state = s->seed ^ (uint64_t)(uintptr_t)&state;
+    uint64_t sum = 0;
+
+    for (int i = 0; i < OPERATIONS; ++i) {
+        uint64_t r = next_random(&state);
+        uint64_t key = r % KEYS;
+        uint64_t value = r;
+
+        if (s->map != NULL) {
+            pthread_mutex_lock(&s->lock);
+            if (((r >> 32) % 10) == 0) {
+                map_put(s->map, &key, &value);
+            } else {
+                sum += *(uint64_t *)map_get(s->map, &key);
+            }
+            pthread_mutex_unlock(&s->lock);
+        } else {
+            if (((r >> 32) % 10) == 0) {
+                cmap_put(s->cmap, &key, &value);
+            } else {
+                cmap_get(s->cmap, &key, &value);
+                sum += value;
+            }
+        }
+    }
+    sink = sum;
+
+    return NULL;
+}
+
+/**
+ *  @c threads 個のスレッドで操作する時間を計測する.
+ *
+ *  @param  [in]    threads スレッドの数.
+ *  @param  [in]    sharded true の場合は @ref CMAP を, false の場合は mutex と @ref MAP を用いる.
+ *  @return 成功時は, 1 操作あたりの時間 (ナノ秒) が返る.
+ *          失敗時は, 負の値が返る.
+ */
+static double measure_concurrent(int threads, bool sharded)
+{
+    struct shared s = {.seed = 0x2545F4914F6CDD1DULL};
+    pthread_t tids[8];
+    uint64_t best = UINT64_MAX;
+
+    pthread_mutex_init(&s.lock, NULL);
+    if (sharded) {
+        s.cmap = cmap_init(sizeof(uint64_t), sizeof(uint64_t), KEYS);
+    } else {
+        s.map = map_init(sizeof(uint64_t), sizeof(uint64_t), KEYS);
+    }
+    if ((s.map == NULL) && (s.cmap == NULL)) {
+        return -1.0;
+    }
+    for (uint64_t key = 0; key < KEYS; ++key) {
+        if (sharded) {
+            cmap_put(s.cmap, &key, &key);
+        } else {
+            map_put(s.map, &key, &key);
+        }
+    }
+
+    for (int r = 0; r < ROUNDS; ++r) {
+        uint64_t start = bench_now();
+        for (int i = 0; i < threads; ++i) {
+            pthread_create(&tids[i], NULL, worker, &s);
+        }
+        for (int i = 0; i < threads; ++i) {
+            pthread_join(tids[i], NULL);
+        }
+        uint64_t elapsed = bench_now() - start;
+        best = (elapsed < best) ? elapsed : best;
+    }
+
+    cmap_release(s.cmap);
+    map_release(s.map);
+    pthread_mutex_destroy(&s.lock);
+
+    return (double)best / (double)(OPERATIONS * threads);
+}
+
+int main(void)
+{
+    printf("# look up one key\n");
+    printf("%10s %14s %14s\n", "n", "list[ns]", "map[ns]");
+    for (size_t n = 16; n <= 65536; n *= 4) {
+        if (measure_lookup(n) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("# 90%% get, 10%% put on %d keys, per operation\n", KEYS);
+    printf("%10s %14s %14s\n", "threads", "mutex[ns]", "cmap[ns]");
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        double mutex_ns = measure_concurrent(threads, false);
+        double cmap_ns = measure_concurrent(threads, true);
+
+        if ((mutex_ns < 0.0) || (cmap_ns < 0.0)) {
+            return EXIT_FAILURE;
+        }
+        printf("%10d %14.1f %14.1f\n", threads, mutex_ns, cmap_ns);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+/** @file   metrics.c
+ *  @brief  計測の負荷のベンチマーク.
+ *
+ *  環状に遷移する定義で @ref fsm_transition 1 回あたりの時間を,
+ *  計測なしと計測ありについて計測する. また, 出力 1 回あたりの時間を計測する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "hfsm.h"
+#include "metrics.h"
+#include "bench.h"
+
+/**
+ *  環状に並べる状態の数.
+ */
+#define RING_SIZE (64)
+
+/**
+ *  計測する遷移の回数.
+ */
+#define ITERATIONS (4 * 1000 * 1000)
+
+/**
+ *  計測する出力の回数.
+ */
+#define SCRAPES (1000)
+
+FSM_EVENT(event_next);
+
+/**
+ *  出力の長さを数える書き込み関数.
+ */
+static int count_bytes(void *ctx, const char *buf, size_t len)
+{
+    *(size_t *)ctx += len;
+    return 0;
+}
+
+/**
+ *  遷移を繰り返して時間を計測する.
+ *
+ *  @param  [in]    title   計測の名前.
+ *  @param  [in]    machine 状態マシン.
+ */
+static void measure(const char *title, struct fsm *machine)
+{
+    uint64_t start = bench_now();
+
+    for (int i = 0; i < ITERATIONS; ++i) {
+        fsm_transition(machine, event_next);
+    }
+    uint64_t elapsed = bench_now() - start;
+    printf("%-24s %10.1f ns/transition\n", title, (double)elapsed / ITERATIONS);
+}
+
+int main(void)
+{
+    static struct fsm_state_variable variables[RING_SIZE];
+    static struct fsm_state states[RING_SIZE];
+    static struct fsm_trans corresps[RING_SIZE + 2];
+    static char names[RING_SIZE][16];
+    size_t bytes = 0;
+
+    for (int i = 0; i < RING_SIZE; ++i) {
+        snprintf(names[i], sizeof(names[i]), "ring%d", i);
+        states[i].name = names[i];
+        states[i].variable = &variables[i];
+    }
+    corresps[0] = (struct fsm_trans)FSM_TRANS_HELPER(state_start, event_null,
+                                                     NULL, NULL, &states[0]);
+    for (int i = 0; i < RING_SIZE; ++i) {
+        corresps[i + 1] = (struct fsm_trans)FSM_TRANS_HELPER(&states[i], event_next, NULL, NULL,
+                                                             &states[(i + 1) % RING_SIZE]);
+    }
+
+    struct fsm *machine = fsm_init(NULL, corresps);
+    struct fsm_metrics *metrics = fsm_metrics_init("bench", NULL, corresps);
+    if ((machine == NULL) || (metrics == NULL)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("# fsm_transition with metrics\n");
+    measure("no metrics", machine);
+    if (fsm_metrics_attach(metrics, machine) != 0) {
+        if (errno == ENOTSUP) {
+            printf("observers are compiled out (OBSERVER=0)\n");
+        }
+        fsm_metrics_term(metrics);
+        fsm_term(machine);
+        return EXIT_SUCCESS;
+    }
+    measure("metrics", machine);
+
+    uint64_t start = bench_now();
+    for (int i = 0; i < SCRAPES; ++i) {
+        fsm_metrics_export(metrics, count_bytes, &bytes);
+    }
+    uint64_t elapsed = bench_now() - start;
+    printf("%-24s %10.1f us/scrape (%zu bytes)\n",
+           "export", (double)elapsed / SCRAPES / 1000.0, bytes / SCRAPES);
+
+    fsm_metrics_term(metrics);
+    fsm_term(machine);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/** @file   observer.c
+ *  @brief  オブザーバの負荷のベンチマーク.
+ *
+ *  環状に遷移する定義で @ref fsm_transition 1 回あたりの時間を,
+ *  オブザーバなし, 空のオブザーバおよび計数するオブザーバについて計測する.
+ *  OBSERVER=0 でビルドした結果と比較することで, ビルド時に取り除いた場合の
+ *  負荷と, 実行時に登録しない場合の負荷 (分岐 1 つ) の差を確認できる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "hfsm.h"
+#include "bench.h"
+
+/**
+ *  環状に並べる状態の数.
+ */
+#define RING_SIZE (64)
+
+/**
+ *  計測する遷移の回数.
+ */
+#define ITERATIONS (4 * 1000 * 1000)
+
+FSM_EVENT(event_next);
+
+/**
+ *  計数するオブザーバのコールバック.
+ */
+static void count_entry(struct fsm *machine, const struct fsm_state *state, void *ctx)
+{
+    ++*(size_t *)ctx;
+}
+
+/**
+ *  遷移を繰り返して時間を計測する.
+ *
+ *  @param  [in]    title   計測の名前.
+ *  @param  [in]    machine 状態マシン.
+ */
+static void measure(const char *title, struct fsm *machine)
+{
+    uint64_t start = bench_now();
+
+    for (int i = 0; i < ITERATIONS; ++i) {
+        fsm_transition(machine, event_next);
+    }
+    uint64_t elapsed = bench_now() - start;
+    printf("%-24s %10.1f ns/transition\n", title, (double)elapsed / ITERATIONS);
+}
+
+int main(void)
+{
+    static struct fsm_state_variable variables[RING_SIZE];
+    static struct fsm_state states[RING_SIZE];
+    static struct fsm_trans corresps[RING_SIZE + 2];
+    struct fsm_observer empty = FSM_OBSERVER_HELPER(NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    size_t entries = 0;
+    struct fsm_observer counter = FSM_OBSERVER_HELPER(NULL, NULL, NULL, NULL,
+                                                      count_entry, NULL, &entries);
+
+    for (int i = 0; i < RING_SIZE; ++i) {
+        states[i].name = "ring";
+        states[i].variable = &variables[i];
+    }
+    corresps[0] = (struct fsm_trans)FSM_TRANS_HELPER(state_start, event_null,
+                                                     NULL, NULL, &states[0]);
+    for (int i = 0; i < RING_SIZE; ++i) {
+        corresps[i + 1] = (struct fsm_trans)FSM_TRANS_HELPER(&states[i], event_next, NULL, NULL,
+                                                             &states[(i + 1) % RING_SIZE]);
+    }
+
+    struct fsm *machine = fsm_init(NULL, corresps);
+    if (machine == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    printf("# fsm_transition with observers\n");
+    measure("no observer", machine);
+    if (fsm_add_observer(machine, &empty) != 0) {
+        if (errno == ENOTSUP) {
+            printf("observers are compiled out (OBSERVER=0)\n");
+        }
+        fsm_term(machine);
+        return EXIT_SUCCESS;
+    }
+    measure("empty observer", machine);
+    fsm_remove_observer(machine, &empty);
+    fsm_add_observer(machine, &counter);
+    measure("counting observer", machine);
+    fsm_remove_observer(machine, &counter);
+    if (entries != ITERATIONS) {
+        fprintf(stderr, "counted %zu entries, expected %d\n", entries, ITERATIONS);
+    }
+
+    fsm_term(machine);
+
+    return EXIT_SUCCESS;
+}
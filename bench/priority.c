@@ -0,0 +1,98 @@
+/** @file   priority.c
+ *  @brief  優先度付きイベントキューのベンチマーク.
+ *
+ *  大量の低優先度のイベントが積まれた状態で緊急のイベントを積み,
+ *  処理されるまでの時間 (レイテンシ) を計測する.
+ *  すべてを同じ優先度で積んだ場合 (単一の FIFO と同等) と比較する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hfsm.h"
+#include "bench.h"
+
+FSM_STATE(state_running, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_telemetry);
+FSM_EVENT(event_fault);
+
+/**
+ *  緊急のイベントを処理した時刻.
+ */
+static uint64_t handled_at;
+
+FSM_ACTION(action_telemetry, (struct fsm *machine))
+{
+}
+
+FSM_ACTION(action_fault, (struct fsm *machine))
+{
+    handled_at = bench_now();
+}
+
+/**
+ *  低優先度のイベントを積んだ後に緊急のイベントを積み, 処理されるまでの時間を計測する.
+ *
+ *  @param  [in,out]    machine     状態マシン.
+ *  @param  [in]        load        先に積む低優先度のイベントの数.
+ *  @param  [in]        priority    緊急のイベントの優先度.
+ *  @return 緊急のイベントが処理されるまでの時間 (ナノ秒) が返る.
+ */
+static uint64_t measure(struct fsm *machine, size_t load, enum fsm_priority priority)
+{
+    uint64_t posted;
+
+    for (size_t i = 0; i < load; ++i) {
+        fsm_post(machine, event_telemetry, FSM_PRIORITY_LOW);
+    }
+    handled_at = 0;
+    posted = bench_now();
+    fsm_post(machine, event_fault, priority);
+    while ((handled_at == 0) && (fsm_dispatch(machine) > 0)) {
+    }
+    uint64_t latency = handled_at - posted;
+
+    /* 残りのイベントを処理しておく. */
+    while (fsm_dispatch(machine) > 0) {
+    }
+
+    return latency;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max = (argc > 1) ? strtoul(argv[1], NULL, 0) : 65536;
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_running),
+        FSM_TRANS_HELPER(state_running, event_telemetry, NULL, action_telemetry, NULL),
+        FSM_TRANS_HELPER(state_running, event_fault, NULL, action_fault, NULL),
+        FSM_TRANS_TERMINATOR
+    };
+
+    struct fsm *machine = fsm_init(NULL, corresps);
+    if ((machine == NULL) || (fsm_set_queue_capacity(machine, max + 1) != 0)) {
+        return EXIT_FAILURE;
+    }
+
+    /* 初回の処理による揺らぎを除くため, 空回しをしておく. */
+    measure(machine, 1, FSM_PRIORITY_LOW);
+    measure(machine, 1, FSM_PRIORITY_URGENT);
+
+    printf("# latency of an urgent event behind queued telemetry\n");
+    printf("%10s %16s %16s\n", "load", "same lane[us]", "urgent lane[us]");
+    for (size_t load = 1024; load <= max; load *= 4) {
+        uint64_t fifo = measure(machine, load, FSM_PRIORITY_LOW);
+        uint64_t urgent = measure(machine, load, FSM_PRIORITY_URGENT);
+        printf("%10zu %16.1f %16.1f\n", load, (double)fifo / 1000.0, (double)urgent / 1000.0);
+    }
+
+    fsm_term(machine);
+
+    return EXIT_SUCCESS;
+}
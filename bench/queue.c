@@ -0,0 +1,155 @@
+/** @file   queue.c
+ *  @brief  キューのベンチマーク.
+ *
+ *  リングバッファで実装した @ref QUEUE の 1 要素ずつの出し入れと,
+ *  @ref queue_enq_bulk / @ref queue_deq_bulk によるまとめた出し入れを,
+ *  以前の @ref LIST の末尾への挿入と先頭の削除で実装したキューと比べる.
+ *  イベントの受信箱を想定し, n 個積んで n 個取り出す往復の
+ *  1 要素あたりの時間を計測する. 揺らぎを除くため, 繰り返しのうち最短の時間をとる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "collections.h"
+#include "bench.h"
+
+/**
+ *  計測の繰り返し回数.
+ */
+#define ROUNDS (20)
+
+/**
+ *  1 回の計測で出し入れする要素数の合計.
+ */
+#define OPERATIONS (1000000)
+
+/**
+ *  イベントの受信箱の要素を模したデータ.
+ */
+struct message {
+    void *machine;      /**< 宛先. */
+    const void *event;  /**< イベント. */
+    int priority;       /**< 優先度. */
+};
+
+/**
+ *  以前の実装と同じく, リストの先頭から要素を取り出す.
+ *
+ *  @param  [in,out]    list    リストオブジェクト.
+ *  @param  [out]       payload データ部をコピーするバッファ.
+ *  @return 成功時は, 残っている要素の数が返る.
+ *          失敗時は, -1 が返る.
+ */
+static int list_queue_deq(LIST list, void *payload)
+{
+    ITER iter = list_iter(list);
+
+    if (iter == NULL) {
+        errno = EAGAIN;
+        return -1;
+    }
+    memcpy(payload, iter_get_payload(iter), list_payload_bytes(list));
+    list_remove(list, iter);
+
+    return list_count(list);
+}
+
+/**
+ *  @c batch 個積んで取り出す往復の時間を計測する.
+ *
+ *  @param  [in]    batch   1 往復で出し入れする要素の数.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返る.
+ */
+static int measure(size_t batch)
+{
+    LIST list = list_init(sizeof(struct message), batch);
+    QUEUE que = queue_init(sizeof(struct message), batch);
+    struct message *in = calloc(batch, sizeof(*in));
+    struct message *out = calloc(batch, sizeof(*out));
+    size_t loops = OPERATIONS / batch;
+    uint64_t start, elapsed, list_ns = UINT64_MAX, ring_ns = UINT64_MAX, bulk_ns = UINT64_MAX;
+    volatile int sink = 0;
+    int ret = -1;
+
+    if ((list == NULL) || (que == NULL) || (in == NULL) || (out == NULL)) {
+        goto out;
+    }
+    for (size_t i = 0; i < batch; ++i) {
+        in[i].priority = (int)i;
+    }
+
+    for (int r = 0; r < ROUNDS; ++r) {
+        start = bench_now();
+        for (size_t l = 0; l < loops; ++l) {
+            for (size_t i = 0; i < batch; ++i) {
+                list_insert(list, -1, &in[i]);
+            }
+            for (size_t i = 0; list_queue_deq(list, &out[i]) >= 0; ++i) {
+            }
+            sink += out[batch - 1].priority;
+        }
+        elapsed = bench_now() - start;
+        list_ns = (elapsed < list_ns) ? elapsed : list_ns;
+
+        start = bench_now();
+        for (size_t l = 0; l < loops; ++l) {
+            for (size_t i = 0; i < batch; ++i) {
+                queue_enq(que, &in[i]);
+            }
+            for (size_t i = 0; queue_deq(que, &out[i]) >= 0; ++i) {
+            }
+            sink += out[batch - 1].priority;
+        }
+        elapsed = bench_now() - start;
+        ring_ns = (elapsed < ring_ns) ? elapsed : ring_ns;
+
+        start = bench_now();
+        for (size_t l = 0; l < loops; ++l) {
+            queue_enq_bulk(que, in, batch);
+            queue_deq_bulk(que, out, batch);
+            sink += out[batch - 1].priority;
+        }
+        elapsed = bench_now() - start;
+        bulk_ns = (elapsed < bulk_ns) ? elapsed : bulk_ns;
+    }
+
+    printf("%10zu %14.2f %14.2f %14.2f\n",
+           batch,
+           (double)list_ns / (double)(loops * batch),
+           (double)ring_ns / (double)(loops * batch),
+           (double)bulk_ns / (double)(loops * batch));
+    ret = 0;
+
+out:
+    free(out);
+    free(in);
+    queue_release(que);
+    list_release(list);
+
+    return ret;
+}
+
+int main(void)
+{
+    const size_t batches[] = {1, 8, 64, 1024};
+
+    printf("# enqueue and dequeue one %zu-byte element\n", sizeof(struct message));
+    printf("%10s %14s %14s %14s\n", "batch", "list[ns]", "ring[ns]", "bulk[ns]");
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); ++i) {
+        if (measure(batches[i]) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+/** @file   ring.c
+ *  @brief  共有メモリのイベントリングのベンチマーク.
+ *
+ *  子プロセスから送ったイベントを親プロセスの状態マシンで処理し終えるまでの
+ *  1 件あたりの時間を計測する.
+ *  イベント毎に書き込みのシステムコールを行う socketpair と比較する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "hfsm.h"
+#include "ring.h"
+#include "bench.h"
+
+/**
+ *  リングに格納できる記録の数.
+ */
+#define RING_CAPACITY (4096)
+
+/**
+ *  socketpair で送る記録構造体.
+ */
+struct wire_record {
+    uint32_t machine;
+    uint32_t event;
+    uint64_t payload;
+};
+
+FSM_STATE(state_idle, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_sample);
+
+/**
+ *  処理したイベントの数.
+ */
+static size_t handled;
+
+FSM_ACTION(action_sample, (struct fsm *machine))
+{
+    ++handled;
+}
+
+/**
+ *  イベントリングで送り, 処理し終えるまでの時間を計測する.
+ *
+ *  @param  [in]    corresps    状態遷移の対応表.
+ *  @param  [in]    machine     状態マシン.
+ *  @param  [in]    n           送るイベントの数.
+ *  @return 経過時間 (ナノ秒) が返る.
+ */
+static uint64_t measure_ring(const struct fsm_trans *corresps, struct fsm *machine, size_t n)
+{
+    struct fsm_ring *ring = fsm_ring_create(NULL, RING_CAPACITY, NULL, corresps);
+    struct fsm *machines[] = {machine};
+    uint64_t start;
+    pid_t pid;
+
+    if (ring == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    handled = 0;
+    start = bench_now();
+    pid = fork();
+    if (pid == 0) {
+        for (uint64_t i = 0; i < n; ) {
+            if (fsm_ring_send(ring, 0, event_sample, FSM_PRIORITY_NORMAL, &i, sizeof(i)) == 0) {
+                ++i;
+            } else {
+                sched_yield();
+            }
+        }
+        _exit(EXIT_SUCCESS);
+    }
+    while (handled < n) {
+        if (fsm_ring_wait(ring, 1000) != 0) {
+            break;
+        }
+        fsm_ring_drain(ring, machines, 1, SIZE_MAX, NULL, NULL);
+    }
+    uint64_t elapsed = bench_now() - start;
+    waitpid(pid, NULL, 0);
+    fsm_ring_close(ring);
+
+    return elapsed;
+}
+
+/**
+ *  socketpair でイベント毎に送り, 処理し終えるまでの時間を計測する.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    n       送るイベントの数.
+ *  @return 経過時間 (ナノ秒) が返る.
+ */
+static uint64_t measure_socket(struct fsm *machine, size_t n)
+{
+    static struct wire_record records[RING_CAPACITY];
+    int sv[2];
+    uint64_t start;
+    pid_t pid;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    handled = 0;
+    start = bench_now();
+    pid = fork();
+    if (pid == 0) {
+        close(sv[0]);
+        for (uint64_t i = 0; i < n; ++i) {
+            struct wire_record record = {.machine = 0, .event = 0, .payload = i};
+            if (write(sv[1], &record, sizeof(record)) != sizeof(record)) {
+                _exit(EXIT_FAILURE);
+            }
+        }
+        _exit(EXIT_SUCCESS);
+    }
+    close(sv[1]);
+
+    size_t pending = 0;
+    while (handled < n) {
+        ssize_t len = read(sv[0], (char *)records + pending, sizeof(records) - pending);
+        if (len <= 0) {
+            break;
+        }
+        pending += (size_t)len;
+        size_t count = pending / sizeof(struct wire_record);
+        for (size_t i = 0; i < count; ++i) {
+            fsm_transition(machine, event_sample);
+        }
+        pending -= count * sizeof(struct wire_record);
+        memmove(records, (char *)records + count * sizeof(struct wire_record), pending);
+    }
+    uint64_t elapsed = bench_now() - start;
+    waitpid(pid, NULL, 0);
+    close(sv[0]);
+
+    return elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1048576;
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_idle),
+        FSM_TRANS_HELPER(state_idle, event_sample, NULL, action_sample, NULL),
+        FSM_TRANS_TERMINATOR
+    };
+
+    struct fsm *machine = fsm_init(NULL, corresps);
+    if (machine == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    printf("# cross-process events from a child process\n");
+    printf("%10s %16s %16s\n", "n", "ring[ns/ev]", "socket[ns/ev]");
+    for (size_t n = 16384; n <= max; n *= 4) {
+        uint64_t ring = measure_ring(corresps, machine, n);
+        uint64_t socket = measure_socket(machine, n);
+        printf("%10zu %16.1f %16.1f\n", n, (double)ring / (double)n, (double)socket / (double)n);
+    }
+
+    fsm_term(machine);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+/** @file   set.c
+ *  @brief  セットのベンチマーク.
+ *
+ *  ハッシュ表で実装した @ref SET と, 以前の全要素を @c memcmp で比べてから
+ *  @ref LIST に追加するセットについて, n 要素のセットを構築する時間と
+ *  全要素を引く時間を計測する. 揺らぎを除くため, 繰り返しのうち最短の時間をとる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "collections.h"
+#include "bench.h"
+
+/**
+ *  計測の繰り返し回数.
+ */
+#define ROUNDS (5)
+
+/**
+ *  以前の実装と同じく, 全要素と比べてからリストに追加する.
+ *
+ *  @param  [in,out]    list    リストオブジェクト.
+ *  @param  [in]        payload 追加するデータ.
+ *  @return 成功時は, 追加したデータ部のポインタが返る.
+ *          失敗時は, NULL が返る.
+ */
+static void *list_set_add(LIST list, void *payload)
+{
+    ssize_t payload_bytes = list_payload_bytes(list);
+
+    for (ITER iter = list_iter(list); iter != NULL; iter = iter_next(iter)) {
+        void *p = iter_get_payload(iter);
+        if (memcmp(payload, p, payload_bytes) == 0) {
+            return p;
+        }
+    }
+
+    return list_insert(list, -1, payload);
+}
+
+/**
+ *  n 要素のセットの構築と検索の時間を計測する.
+ *
+ *  @param  [in]    n   要素の数.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返る.
+ */
+static int measure(size_t n)
+{
+    LIST list = list_init(sizeof(uint64_t), n);
+    SET set = set_init(sizeof(uint64_t), n);
+    uint64_t start, elapsed, list_ns = UINT64_MAX, add_ns = UINT64_MAX, find_ns = UINT64_MAX;
+    volatile size_t hits = 0;
+    int ret = -1;
+
+    if ((list == NULL) || (set == NULL)) {
+        goto out;
+    }
+
+    for (int r = 0; r < ROUNDS; ++r) {
+        list_clear(list);
+        start = bench_now();
+        for (uint64_t i = 0; i < n; ++i) {
+            uint64_t key = i * 0x9E3779B97F4A7C15ULL;
+            list_set_add(list, &key);
+        }
+        elapsed = bench_now() - start;
+        list_ns = (elapsed < list_ns) ? elapsed : list_ns;
+
+        set_clear(set);
+        start = bench_now();
+        for (uint64_t i = 0; i < n; ++i) {
+            uint64_t key = i * 0x9E3779B97F4A7C15ULL;
+            set_add(set, &key);
+        }
+        elapsed = bench_now() - start;
+        add_ns = (elapsed < add_ns) ? elapsed : add_ns;
+
+        start = bench_now();
+        for (uint64_t i = 0; i < n; ++i) {
+            uint64_t key = i * 0x9E3779B97F4A7C15ULL;
+            hits += set_contains(set, &key);
+        }
+        elapsed = bench_now() - start;
+        find_ns = (elapsed < find_ns) ? elapsed : find_ns;
+    }
+
+    printf("%10zu %14.1f %14.1f %14.1f\n",
+           n,
+           (double)list_ns / (double)n,
+           (double)add_ns / (double)n,
+           (double)find_ns / (double)n);
+    ret = 0;
+
+out:
+    set_release(set);
+    list_release(list);
+
+    return ret;
+}
+
+int main(void)
+{
+    const size_t sizes[] = {100, 1000, 10000, 30000};
+
+    printf("# build a set of n elements, then look each one up\n");
+    printf("%10s %14s %14s %14s\n", "n", "list add[ns]", "set add[ns]", "contains[ns]");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        if (measure(sizes[i]) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
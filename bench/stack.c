@@ -0,0 +1,144 @@
+/** @file   stack.c
+ *  @brief  スタックのベンチマーク.
+ *
+ *  配列で実装した @ref STACK と, 以前の @ref LIST の先頭への挿入と削除で実装した
+ *  スタックについて, 深さ n まで積んで全て取り出す 1 往復の時間を計測する.
+ *  揺らぎを除くため, 繰り返しのうち最短の時間をとる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "collections.h"
+#include "bench.h"
+
+/**
+ *  計測の繰り返し回数.
+ */
+#define ROUNDS (20)
+
+/**
+ *  1 回の計測で行う往復の要素数の合計.
+ */
+#define OPERATIONS (1000000)
+
+/**
+ *  以前の実装と同じく, リストの先頭に要素を積む.
+ *
+ *  @param  [in,out]    list    リストオブジェクト.
+ *  @param  [in]        payload 積むデータ.
+ *  @return 成功時は, 積んだデータ部のポインタが返る.
+ *          失敗時は, NULL が返る.
+ */
+static void *list_stack_push(LIST list, void *payload)
+{
+    return list_insert(list, 0, payload);
+}
+
+/**
+ *  以前の実装と同じく, リストの先頭から要素を取り出す.
+ *
+ *  @param  [in,out]    list    リストオブジェクト.
+ *  @param  [out]       payload データ部をコピーするバッファ.
+ *  @return 成功時は, 残っている要素の数が返る.
+ *          失敗時は, -1 が返る.
+ */
+static int list_stack_pop(LIST list, void *payload)
+{
+    ITER iter = list_iter(list);
+
+    if (iter == NULL) {
+        errno = EAGAIN;
+        return -1;
+    }
+    memcpy(payload, iter_get_payload(iter), list_payload_bytes(list));
+    list_remove(list, iter);
+
+    return list_count(list);
+}
+
+/**
+ *  深さ @c depth まで積んで取り出す往復の時間を計測する.
+ *
+ *  @param  [in]    depth   積む要素の数.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返る.
+ */
+static int measure(size_t depth)
+{
+    LIST list = list_init(sizeof(void *), depth);
+    STACK stack = stack_init(sizeof(void *), depth);
+    size_t loops = OPERATIONS / depth;
+    uint64_t start, elapsed, list_ns = UINT64_MAX, array_ns = UINT64_MAX;
+    volatile uintptr_t sink = 0;
+    int ret = -1;
+
+    if ((list == NULL) || (stack == NULL)) {
+        goto out;
+    }
+
+    for (int r = 0; r < ROUNDS; ++r) {
+        start = bench_now();
+        for (size_t l = 0; l < loops; ++l) {
+            void *p;
+            for (uintptr_t i = 0; i < depth; ++i) {
+                p = (void *)i;
+                list_stack_push(list, &p);
+            }
+            while (list_stack_pop(list, &p) >= 0) {
+                sink += (uintptr_t)p;
+            }
+        }
+        elapsed = bench_now() - start;
+        list_ns = (elapsed < list_ns) ? elapsed : list_ns;
+
+        start = bench_now();
+        for (size_t l = 0; l < loops; ++l) {
+            void *p;
+            for (uintptr_t i = 0; i < depth; ++i) {
+                p = (void *)i;
+                stack_push(stack, &p);
+            }
+            while (stack_pop(stack, &p) >= 0) {
+                sink += (uintptr_t)p;
+            }
+        }
+        elapsed = bench_now() - start;
+        array_ns = (elapsed < array_ns) ? elapsed : array_ns;
+    }
+
+    printf("%10zu %14.2f %14.2f\n",
+           depth,
+           (double)list_ns / (double)(loops * depth),
+           (double)array_ns / (double)(loops * depth));
+    ret = 0;
+
+out:
+    stack_release(stack);
+    list_release(list);
+
+    return ret;
+}
+
+int main(void)
+{
+    const size_t depths[] = {4, 16, 64, 1024};
+
+    printf("# push and pop one element\n");
+    printf("%10s %14s %14s\n", "depth", "list[ns]", "array[ns]");
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i) {
+        if (measure(depths[i]) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
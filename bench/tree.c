@@ -0,0 +1,121 @@
+/** @file   tree.c
+ *  @brief  N-ary ツリーの構築と走査のベンチマーク.
+ *
+ *  要素数を倍々に増やし, 親をデータ部で指定する @ref tree_insert で
+ *  ツリーを構築する時間を計測する. 各要素の親は, それより前に追加した
+ *  要素から選ぶ. 1 要素あたりの時間が一定であれば, 追加は要素数によらない.
+ *  構築したツリーを反復子と, 順を変えた @ref tree_walk_subtree で辿る時間も計測する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "collections.h"
+#include "bench.h"
+
+/**
+ *  計測の繰り返し回数.
+ */
+#define REPEAT (5)
+
+/**
+ *  空のツリーに @c n 要素を追加する.
+ *
+ *  @param  [in,out]    tree    ツリーオブジェクト.
+ *  @param  [in]        n       要素数.
+ *  @return 成功時は 0 が, 失敗時は -1 が返る.
+ */
+static int build(TREE tree, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t parent = (i * 7) / 8;
+        if (tree_insert(tree, (i == 0) ? NULL : &parent, &i) == NULL) {
+            fprintf(stderr, "failed to insert %" PRIu64 "\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ *  データ部を合計する.
+ */
+static int sum_visit(void *payload, int age, void *ctx)
+{
+    (void)age;
+    *(uint64_t *)ctx += *(uint64_t *)payload;
+    return 0;
+}
+
+/**
+ *  最適化で走査が除かれないよう結果を保持する.
+ */
+static volatile uint64_t sink;
+
+int main(int argc, char **argv)
+{
+    size_t max = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1048576;
+    const char *titles[] = {
+        "tree_insert",
+        "tree_iter",
+        "tree_walk (pre-order)",
+        "tree_walk (post-order)",
+        "tree_walk (level-order)"
+    };
+    const enum tree_order orders[] = {
+        TREE_PRE_ORDER,
+        TREE_PRE_ORDER,
+        TREE_PRE_ORDER,
+        TREE_POST_ORDER,
+        TREE_LEVEL_ORDER
+    };
+
+    for (int kind = 0; kind < 5; ++kind) {
+        bench_header(titles[kind], "per element[ns]");
+        for (size_t n = 1024; n <= max; n *= 2) {
+            TREE tree = tree_init(sizeof(uint64_t), n);
+            uint64_t best = UINT64_MAX;
+
+            if ((tree == NULL) || ((kind != 0) && (build(tree, n) != 0))) {
+                tree_release(tree);
+                return EXIT_FAILURE;
+            }
+            for (int r = 0; r < REPEAT; ++r) {
+                uint64_t sum = 0;
+                if (kind == 0) {
+                    tree_clear(tree);
+                }
+                uint64_t start = bench_now();
+                if (kind == 0) {
+                    if (build(tree, n) != 0) {
+                        tree_release(tree);
+                        return EXIT_FAILURE;
+                    }
+                } else if (kind == 1) {
+                    for (TREE_ITER iter = tree_iter_get(tree); iter != NULL; iter = tree_iter_next(iter)) {
+                        sum += *(uint64_t *)tree_iter_get_payload(iter);
+                    }
+                } else {
+                    tree_walk_subtree(tree, NULL, orders[kind], sum_visit, &sum);
+                }
+                uint64_t elapsed = bench_now() - start;
+                sink = sum;
+                if (elapsed < best) {
+                    best = elapsed;
+                }
+            }
+            bench_report(n, best, n);
+
+            tree_release(tree);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
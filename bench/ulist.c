@@ -0,0 +1,126 @@
+/** @file   ulist.c
+ *  @brief  展開リストのベンチマーク.
+ *
+ *  @ref ULIST と @ref LIST に, それまでの要素数の中央の位置へ
+ *  1 つずつ挿入して n 要素を追加する時間と, 全要素を辿る時間を比べる.
+ *  @ref LIST は位置まで先頭から辿るため挿入は O(n) であり,
+ *  @ref ULIST はチャンク間で要素を送るため O(√n) である.
+ *  揺らぎを除くため, 繰り返しのうち最短の時間をとる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "collections.h"
+#include "bench.h"
+
+/**
+ *  計測の繰り返し回数.
+ */
+#define ROUNDS (3)
+
+/**
+ *  データ部を合計する.
+ */
+static int sum_visit(void *payload, void *ctx)
+{
+    *(uint64_t *)ctx += *(uint64_t *)payload;
+    return 0;
+}
+
+/**
+ *  最適化で走査が除かれないよう結果を保持する.
+ */
+static volatile uint64_t sink;
+
+/**
+ *  @c n 要素について挿入と走査の時間を計測する.
+ *
+ *  @param  [in]    n   要素数.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返る.
+ */
+static int measure(size_t n)
+{
+    LIST list = list_init(sizeof(uint64_t), n);
+    ULIST ulist = ulist_init(sizeof(uint64_t), n);
+    uint64_t start, elapsed;
+    uint64_t list_ins = UINT64_MAX, ulist_ins = UINT64_MAX, list_iter_ns = UINT64_MAX, ulist_walk_ns = UINT64_MAX;
+    int ret = -1;
+
+    if ((list == NULL) || (ulist == NULL)) {
+        goto out;
+    }
+
+    for (int r = 0; r < ROUNDS; ++r) {
+        uint64_t sum = 0;
+
+        list_clear(list);
+        start = bench_now();
+        for (uint64_t i = 0; i < n; ++i) {
+            if (list_insert(list, (int)(i / 2), &i) == NULL) {
+                goto out;
+            }
+        }
+        elapsed = bench_now() - start;
+        list_ins = (elapsed < list_ins) ? elapsed : list_ins;
+
+        ulist_clear(ulist);
+        start = bench_now();
+        for (uint64_t i = 0; i < n; ++i) {
+            if (ulist_insert(ulist, i / 2, &i) == NULL) {
+                goto out;
+            }
+        }
+        elapsed = bench_now() - start;
+        ulist_ins = (elapsed < ulist_ins) ? elapsed : ulist_ins;
+
+        start = bench_now();
+        for (ITER iter = list_iter(list); iter != NULL; iter = iter_next(iter)) {
+            sum += *(uint64_t *)iter_get_payload(iter);
+        }
+        elapsed = bench_now() - start;
+        list_iter_ns = (elapsed < list_iter_ns) ? elapsed : list_iter_ns;
+
+        start = bench_now();
+        ulist_walk(ulist, sum_visit, &sum);
+        elapsed = bench_now() - start;
+        ulist_walk_ns = (elapsed < ulist_walk_ns) ? elapsed : ulist_walk_ns;
+        sink = sum;
+    }
+
+    printf("%10zu %14.1f %14.1f %14.2f %14.2f\n",
+           n,
+           (double)list_ins / (double)n,
+           (double)ulist_ins / (double)n,
+           (double)list_iter_ns / (double)n,
+           (double)ulist_walk_ns / (double)n);
+    ret = 0;
+
+out:
+    ulist_release(ulist);
+    list_release(list);
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max = (argc > 1) ? strtoul(argv[1], NULL, 0) : 32768;
+
+    printf("# insert at the middle and walk, per element\n");
+    printf("%10s %14s %14s %14s %14s\n", "n", "list ins[ns]", "ulist ins[ns]", "list iter[ns]", "ulist walk[ns]");
+    for (size_t n = 1024; n <= max; n *= 2) {
+        if (measure(n) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -8,6 +8,9 @@ VERSION = $(MAJOR_VERSION).$(MINOR_VERSION).$(REVISION)
 
 NODEBUG = 0
 
+## Observer hooks. (0: compiled out)
+OBSERVER = 1
+
 ## Header direcotyr of Catch2 test framework.
 CATCH2_DIR ?=
 
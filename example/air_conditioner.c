@@ -19,17 +19,14 @@ struct setting {
 };
 
 /*
- *  冷房設定情報.
- */
-static struct setting cooling_setting = {
-    .temperature = 23
-};
-
-/*
- *  暖房設定情報.
+ *  エアコン構造体.
+ *
+ *  状態マシンのコンテキストとして, エアコン毎に持つ.
  */
-static struct setting heating_setting = {
-    .temperature = 18
+struct aircon {
+    const char *room;       /* 設置場所. */
+    struct setting cooling; /* 冷房設定情報. */
+    struct setting heating; /* 暖房設定情報. */
 };
 
 /*
@@ -83,7 +80,7 @@ static void entry_cooling(struct fsm *machine, void *data, bool cmpl)
 /*
  *  冷房状態.
  */
-FSM_STATE(state_cooling, &cooling_setting, entry_cooling, NULL, NULL);
+FSM_STATE_SLOT(state_cooling, struct aircon, cooling, entry_cooling, NULL, NULL);
 
 /*
  *  暖房状態の entry アクション.
@@ -102,7 +99,7 @@ static void entry_heating(struct fsm *machine, void *data, bool cmpl)
 /*
  *  暖房状態.
  */
-FSM_STATE(state_heating, &heating_setting, entry_heating, NULL, NULL);
+FSM_STATE_SLOT(state_heating, struct aircon, heating, entry_heating, NULL, NULL);
 
 /*
  *  運転イベント.
@@ -138,74 +135,85 @@ FSM_EVENT(event_dec_temp);
  *  冷房温度上昇アクション.
  *
  *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    ctx     エアコン.
  */
-FSM_ACTION(action_cooling_inc_temp, (struct fsm *machine))
+FSM_ACTION_CTX(action_cooling_inc_temp, (struct fsm *machine, void *ctx))
 {
-    struct setting *setting = fsm_get_state_data(state_cooling);
+    struct aircon *aircon = ctx;
 
-    ++(setting->temperature);
-    DEBUG("冷房の温度を %d 度に変更する.", setting->temperature);
+    ++(aircon->cooling.temperature);
+    DEBUG("%s の冷房の温度を %d 度に変更する.", aircon->room, aircon->cooling.temperature);
 }
 
 /*
  *  冷房温度下降アクション.
  *
  *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    ctx     エアコン.
  */
-FSM_ACTION(action_cooling_dec_temp, (struct fsm *machine))
+FSM_ACTION_CTX(action_cooling_dec_temp, (struct fsm *machine, void *ctx))
 {
-    struct setting *setting = fsm_get_state_data(state_cooling);
+    struct aircon *aircon = ctx;
 
-    --(setting->temperature);
-    DEBUG("冷房の温度を %d 度に変更する.", setting->temperature);
+    --(aircon->cooling.temperature);
+    DEBUG("%s の冷房の温度を %d 度に変更する.", aircon->room, aircon->cooling.temperature);
 }
 
 /*
  *  暖房温度上昇アクション.
  *
  *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    ctx     エアコン.
  */
-FSM_ACTION(action_heating_inc_temp, (struct fsm *machine))
+FSM_ACTION_CTX(action_heating_inc_temp, (struct fsm *machine, void *ctx))
 {
-    struct setting *setting = fsm_get_state_data(state_heating);
+    struct aircon *aircon = ctx;
 
-    ++(setting->temperature);
-    DEBUG("暖房の温度を %d 度に変更する.", setting->temperature);
+    ++(aircon->heating.temperature);
+    DEBUG("%s の暖房の温度を %d 度に変更する.", aircon->room, aircon->heating.temperature);
 }
 
 /*
  *  暖房温度下降アクション.
  *
  *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    ctx     エアコン.
  */
-FSM_ACTION(action_heating_dec_temp, (struct fsm *machine))
+FSM_ACTION_CTX(action_heating_dec_temp, (struct fsm *machine, void *ctx))
 {
-    struct setting *setting = fsm_get_state_data(state_heating);
+    struct aircon *aircon = ctx;
 
-    --(setting->temperature);
-    DEBUG("暖房の温度を %d 度に変更する.", setting->temperature);
+    --(aircon->heating.temperature);
+    DEBUG("%s の暖房の温度を %d 度に変更する.", aircon->room, aircon->heating.temperature);
 }
 
 /*
  *  実行ログは以下のようになる.
  *  @code
  *  $ ./example/air_conditioner 
- *  hfsm.c:245(fsm_state_transit) state: start --null-> state_stopped
- *  air_conditioner.c:44:entry_stopped エンジンを停止する
- *  hfsm.c:245(fsm_state_transit) state: state_stopped --event_run-> state_running
- *  air_conditioner.c:61:entry_running エンジンを始動する.
- *  air_conditioner.c:80:entry_cooling 23 度の冷房運転に切り替える.
- *  air_conditioner.c:147:action_cooling_inc_temp_func 冷房の温度を 24 度に変更する.
- *  hfsm.c:259(fsm_state_transit) state: state_cooling event_inc_temp/action_cooling_inc_temp
- *  hfsm.c:245(fsm_state_transit) state: state_cooling --event_heating-> state_heating
- *  air_conditioner.c:99:entry_heating 18 度の暖房運転に切り替える.
- *  air_conditioner.c:186:action_heating_dec_temp_func 暖房の温度を 17 度に変更する.
- *  hfsm.c:259(fsm_state_transit) state: state_heating event_dec_temp/action_heating_dec_temp
- *  hfsm.c:245(fsm_state_transit) state: state_running --event_stop-> state_stopped
- *  air_conditioner.c:44:entry_stopped エンジンを停止する
- *  hfsm.c:245(fsm_state_transit) state: state_stopped --event_run-> state_running
- *  air_conditioner.c:61:entry_running エンジンを始動する.
- *  air_conditioner.c:99:entry_heating 17 度の暖房運転に切り替える.
+ *  hfsm.c:584(fsm_state_transit) state: start --null-> state_stopped
+ *  air_conditioner.c:41:entry_stopped エンジンを停止する
+ *  hfsm.c:584(fsm_state_transit) state: start --null-> state_stopped
+ *  air_conditioner.c:41:entry_stopped エンジンを停止する
+ *  hfsm.c:584(fsm_state_transit) state: state_stopped --event_run-> state_running
+ *  air_conditioner.c:58:entry_running エンジンを始動する.
+ *  air_conditioner.c:77:entry_cooling 23 度の冷房運転に切り替える.
+ *  hfsm.c:584(fsm_state_transit) state: state_stopped --event_run-> state_running
+ *  air_conditioner.c:58:entry_running エンジンを始動する.
+ *  air_conditioner.c:77:entry_cooling 26 度の冷房運転に切り替える.
+ *  air_conditioner.c:145:action_cooling_inc_temp_func 居間 の冷房の温度を 24 度に変更する.
+ *  hfsm.c:578(fsm_state_transit) state: state_cooling event_inc_temp/action_cooling_inc_temp
+ *  hfsm.c:584(fsm_state_transit) state: state_cooling --event_heating-> state_heating
+ *  air_conditioner.c:96:entry_heating 18 度の暖房運転に切り替える.
+ *  hfsm.c:584(fsm_state_transit) state: state_cooling --event_heating-> state_heating
+ *  air_conditioner.c:96:entry_heating 20 度の暖房運転に切り替える.
+ *  air_conditioner.c:187:action_heating_dec_temp_func 居間 の暖房の温度を 17 度に変更する.
+ *  hfsm.c:578(fsm_state_transit) state: state_heating event_dec_temp/action_heating_dec_temp
+ *  hfsm.c:584(fsm_state_transit) state: state_running --event_stop-> state_stopped
+ *  air_conditioner.c:41:entry_stopped エンジンを停止する
+ *  hfsm.c:584(fsm_state_transit) state: state_stopped --event_run-> state_running
+ *  air_conditioner.c:58:entry_running エンジンを始動する.
+ *  air_conditioner.c:96:entry_heating 17 度の暖房運転に切り替える.
  *  @endcode
  */
 int main(int argc, char **argv)
@@ -242,27 +250,40 @@ int main(int argc, char **argv)
         FSM_TRANS_TERMINATOR
     };
 
-    struct fsm *machine = fsm_init(rels, corresps);
+    const struct aircon defaults[] = {
+        {.room = "居間", .cooling = {.temperature = 23}, .heating = {.temperature = 18}},
+        {.room = "寝室", .cooling = {.temperature = 26}, .heating = {.temperature = 20}}
+    };
+    struct fsm_table *table = fsm_table_compile(corresps, NULL, NULL);
+    struct fsm *living, *bedroom;
+
+    /* 遷移表を共有し, 設定情報はエアコン毎に持つ. */
+    living = fsm_init_context(rels, table, &defaults[0], sizeof(struct aircon));
+    bedroom = fsm_init_context(rels, table, &defaults[1], sizeof(struct aircon));
+    fsm_table_release(table);
 
     /* 運転を開始する. */
-    fsm_transition(machine, event_run);
+    fsm_transition(living, event_run);
+    fsm_transition(bedroom, event_run);
 
     /* 温度を上げる. */
-    fsm_transition(machine, event_inc_temp);
+    fsm_transition(living, event_inc_temp);
 
     /* 暖房に切り替える. */
-    fsm_transition(machine, event_heating);
+    fsm_transition(living, event_heating);
+    fsm_transition(bedroom, event_heating);
 
     /* 温度を下げる. */
-    fsm_transition(machine, event_dec_temp);
+    fsm_transition(living, event_dec_temp);
 
     /* 運転を停止する. */
-    fsm_transition(machine, event_stop);
+    fsm_transition(living, event_stop);
 
     /* 運転を再開する. */
-    fsm_transition(machine, event_run);
+    fsm_transition(living, event_run);
 
-    fsm_term(machine);
+    fsm_term(bedroom);
+    fsm_term(living);
 
     return 0;
 }
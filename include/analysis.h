@@ -0,0 +1,69 @@
+/** @file   analysis.h
+ *  @brief  状態遷移定義の解析.
+ *
+ *  状態遷移定義から到達可能な構成 (現在の状態と履歴状態の組) を列挙し,
+ *  到達不能な状態, 発火しない遷移およびデッドロックする状態を検出する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_ANALYSIS_H__
+#define __HFSM_ANALYSIS_H__
+
+#include <stdbool.h>
+
+#include "collections.h"
+#include "hfsm.h"
+
+/** @addtogroup cat_analysis 状態空間解析
+ *  状態遷移定義の状態空間を解析するモジュール.
+ *  @ingroup cat_hfsm
+ *  @{
+ */
+
+struct fsm_analysis;
+
+/**
+ *  状態遷移定義の到達可能性を解析する.
+ */
+struct fsm_analysis *fsm_analyze(const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps,
+                                 int threads,
+                                 size_t max_configs);
+
+/**
+ *  解析結果を解放する.
+ */
+void fsm_analysis_release(struct fsm_analysis *analysis);
+
+/**
+ *  到達可能な構成の数を取得する.
+ */
+ssize_t fsm_analysis_configs(const struct fsm_analysis *analysis);
+
+/**
+ *  構成の上限により探索を打ち切ったかを取得する.
+ */
+bool fsm_analysis_truncated(const struct fsm_analysis *analysis);
+
+/**
+ *  到達不能な状態のリストを取得する.
+ */
+LIST fsm_analysis_unreachable_states(const struct fsm_analysis *analysis);
+
+/**
+ *  発火しない遷移のリストを取得する.
+ */
+LIST fsm_analysis_dead_transitions(const struct fsm_analysis *analysis);
+
+/**
+ *  デッドロックする状態のリストを取得する.
+ */
+LIST fsm_analysis_deadlock_states(const struct fsm_analysis *analysis);
+
+/** @} */
+
+#endif /* __HFSM_ANALYSIS_H__ */
@@ -1,7 +1,7 @@
 /** @file   collections.h
  *  @brief  コレクションに関する機能を提供する.
  *
- *  コレクション (リスト, スタック, キュー, ツリー) を提供する.
+ *  コレクション (リスト, スタック, キュー, セット, ツリー, 展開リスト, 並行キュー, マップ) を提供する.
  *
  *  @author t-kenji <protect.2501@gmail.com>
  *  @date   2018-03-18 新規作成.
@@ -12,6 +12,7 @@
 #ifndef __HFSM_COLLECTIONS_H__
 #define __HFSM_COLLECTIONS_H__
 
+#include <stdbool.h>
 #include <unistd.h>
 
 /** @defgroup cat_collections Collections
@@ -74,6 +75,16 @@ void list_release(LIST list);
  */
 int list_clear(LIST list);
 
+/**
+ *  リストの容量の自動拡張を設定する.
+ */
+int list_set_growth(LIST list, size_t limit);
+
+/**
+ *  リストの未使用の拡張分を解放する.
+ */
+ssize_t list_shrink(LIST list);
+
 /**
  *  要素をリストに追加する.
  */
@@ -225,6 +236,16 @@ void *queue_enq(QUEUE que, void *payload);
  */
 int queue_deq(QUEUE que, void *payload);
 
+/**
+ *  複数の要素をまとめてキューに積める.
+ */
+ssize_t queue_enq_bulk(QUEUE que, const void *payloads, size_t n);
+
+/**
+ *  キューから複数の要素をまとめて取り出す.
+ */
+ssize_t queue_deq_bulk(QUEUE que, void *payloads, size_t n);
+
 /**
  *  キューの長さを取得する.
  */
@@ -273,6 +294,14 @@ typedef struct {} *SET;
  */
 SET set_init(size_t payload_bytes, size_t capacity);
 
+/**
+ *  ハッシュ関数と等価判定関数を指定してセットオブジェクトを初期化する.
+ */
+SET set_init_custom(size_t payload_bytes,
+                    size_t capacity,
+                    size_t (*hash)(const void *payload, size_t bytes),
+                    bool (*equal)(const void *a, const void *b, size_t bytes));
+
 /**
  *  セットオブジェクトを解放する.
  */
@@ -288,6 +317,16 @@ int set_clear(SET set);
  */
 void *set_add(SET set, void *payload);
 
+/**
+ *  要素がセットに追加されているかを判定する.
+ */
+bool set_contains(SET set, const void *payload);
+
+/**
+ *  要素をセットから削除する.
+ */
+int set_remove(SET set, const void *payload);
+
 /**
  *  セットの長さを取得する.
  */
@@ -316,6 +355,15 @@ typedef struct {} *TREE;
  */
 typedef struct {} *TREE_ITER;
 
+/**
+ *  N-ary ツリーを辿る順.
+ */
+enum tree_order {
+    TREE_PRE_ORDER = 0, /**< 行きがけ順. 親を子より先に辿る. */
+    TREE_POST_ORDER,    /**< 帰りがけ順. 子を親より先に辿る. */
+    TREE_LEVEL_ORDER    /**< 幅優先. 浅い世代から順に辿る. */
+};
+
 /**
  *  N-ary ツリーオブジェクトを初期化する.
  *
@@ -354,11 +402,31 @@ void tree_release(TREE tree);
  */
 int tree_clear(TREE tree);
 
+/**
+ *  N-ary ツリーの容量の自動拡張を設定する.
+ */
+int tree_set_growth(TREE tree, size_t limit);
+
+/**
+ *  N-ary ツリーの未使用の拡張分を解放する.
+ */
+ssize_t tree_shrink(TREE tree);
+
 /**
  *  N-ary 要素をツリーに挿入する.
  */
 void *tree_insert(TREE tree, void *parent, void *payload);
 
+/**
+ *  N-ary 要素を追加済みの要素の子としてツリーに挿入する.
+ */
+void *tree_insert_child(TREE tree, void *parent, void *payload);
+
+/**
+ *  N-ary ツリーから要素を探す.
+ */
+void *tree_find(TREE tree, const void *payload);
+
 /**
  *  N-ary ツリーの要素の数を取得する.
  */
@@ -389,6 +457,265 @@ void *tree_iter_get_payload(TREE_ITER iter);
  */
 int tree_iter_get_age(TREE_ITER iter);
 
+/**
+ *  N-ary ツリーの要素を行きがけ順に辿る.
+ */
+int tree_walk(TREE tree, int (*visit)(void *payload, int age, void *ctx), void *ctx);
+
+/**
+ *  N-ary ツリーの部分木を指定した順に辿る.
+ */
+int tree_walk_subtree(TREE tree,
+                      void *top,
+                      enum tree_order order,
+                      int (*visit)(void *payload, int age, void *ctx),
+                      void *ctx);
+
+/** @} */
+
+/** @addtogroup cat_ulist Unrolled List 構造
+ *  位置を指定した挿入, 削除, 取得が速い展開リスト構造を提供するモジュール.
+ *  @ingroup cat_collections
+ *  @{
+ */
+
+/**
+ *  汎用展開リスト型.
+ */
+typedef struct {} *ULIST;
+
+/**
+ *  展開リストオブジェクトを初期化する.
+ *
+ *  @par    使用例
+ *          @code
+ *          ULIST list = ulist_init(sizeof(int), 100);
+ *          int data;
+ *          data = 1;
+ *          ulist_add(list, &data);
+ *          data = 0;
+ *          ulist_insert(list, 0, &data);
+ *          for (size_t i = 0; i < (size_t)ulist_count(list); ++i) {
+ *              data = *(int *)ulist_get(list, i);
+ *              // do something.
+ *          }
+ *          ulist_release(list);
+ *          @endcode
+ */
+ULIST ulist_init(size_t payload_bytes, size_t capacity);
+
+/**
+ *  展開リストオブジェクトを解放する.
+ */
+void ulist_release(ULIST list);
+
+/**
+ *  展開リスト要素をすべて消去する.
+ */
+int ulist_clear(ULIST list);
+
+/**
+ *  要素を展開リストの末尾に追加する.
+ */
+void *ulist_add(ULIST list, void *payload);
+
+/**
+ *  要素を展開リストの指定した位置に挿入する.
+ */
+void *ulist_insert(ULIST list, size_t index, void *payload);
+
+/**
+ *  展開リストの指定した位置の要素を削除する.
+ */
+int ulist_remove(ULIST list, size_t index);
+
+/**
+ *  展開リストの指定した位置の要素を取得する.
+ */
+void *ulist_get(ULIST list, size_t index);
+
+/**
+ *  展開リストの長さを取得する.
+ */
+ssize_t ulist_count(ULIST list);
+
+/**
+ *  展開リストの要素を先頭から順に辿る.
+ */
+int ulist_walk(ULIST list, int (*visit)(void *payload, void *ctx), void *ctx);
+
+/** @} */
+
+/** @addtogroup cat_cqueue Concurrent Queue 構造
+ *  スレッド間で要素を受け渡すロックフリーのキュー構造を提供するモジュール.
+ *  @ingroup cat_collections
+ *  @{
+ */
+
+/**
+ *  汎用並行キュー型.
+ */
+typedef struct {} *CQUEUE;
+
+/**
+ *  並行キューの生産者と消費者の数.
+ */
+enum cqueue_mode {
+    CQUEUE_SPSC = 0,    /**< 単一生産者/単一消費者. */
+    CQUEUE_MPMC         /**< 複数生産者/複数消費者. */
+};
+
+/**
+ *  並行キューオブジェクトを初期化する.
+ *
+ *  @par    使用例
+ *          @code
+ *          CQUEUE que = cqueue_init(sizeof(int), 128, CQUEUE_MPMC);
+ *          int data = 1;
+ *          // producer thread.
+ *          while (cqueue_enq(que, &data) != 0) {
+ *              // full.
+ *          }
+ *          // consumer thread.
+ *          if (cqueue_deq(que, &data) == 0) {
+ *              // do something.
+ *          }
+ *          cqueue_release(que);
+ *          @endcode
+ */
+CQUEUE cqueue_init(size_t payload_bytes, size_t capacity, enum cqueue_mode mode);
+
+/**
+ *  並行キューオブジェクトを解放する.
+ */
+void cqueue_release(CQUEUE que);
+
+/**
+ *  要素を並行キューに積める.
+ */
+int cqueue_enq(CQUEUE que, const void *payload);
+
+/**
+ *  並行キューから要素を取り出す.
+ */
+int cqueue_deq(CQUEUE que, void *payload);
+
+/**
+ *  複数の要素をまとめて並行キューに積める.
+ */
+ssize_t cqueue_enq_bulk(CQUEUE que, const void *payloads, size_t n);
+
+/**
+ *  並行キューから複数の要素をまとめて取り出す.
+ */
+ssize_t cqueue_deq_bulk(CQUEUE que, void *payloads, size_t n);
+
+/**
+ *  並行キューの長さを取得する.
+ */
+ssize_t cqueue_count(CQUEUE que);
+
+/** @} */
+
+/** @addtogroup cat_map Map 構造
+ *  固定長のキーと値を対応付ける Map 構造を提供するモジュール.
+ *  @ingroup cat_collections
+ *  @{
+ */
+
+/**
+ *  汎用マップ型.
+ */
+typedef struct {} *MAP;
+
+/**
+ *  汎用並行マップ型.
+ */
+typedef struct {} *CMAP;
+
+/**
+ *  マップオブジェクトを初期化する.
+ *
+ *  @par    使用例
+ *          @code
+ *          MAP map = map_init(sizeof(int), sizeof(const char *), 100);
+ *          int key = 1;
+ *          const char *name = "idle";
+ *          map_put(map, &key, &name);
+ *          const char **found = map_get(map, &key);
+ *          if (found != NULL) {
+ *              // do something.
+ *          }
+ *          map_release(map);
+ *          @endcode
+ */
+MAP map_init(size_t key_bytes, size_t value_bytes, size_t capacity);
+
+/**
+ *  マップオブジェクトを解放する.
+ */
+void map_release(MAP map);
+
+/**
+ *  マップ要素をすべて消去する.
+ */
+int map_clear(MAP map);
+
+/**
+ *  キーに値を対応付ける.
+ */
+void *map_put(MAP map, const void *key, const void *value);
+
+/**
+ *  キーに対応付けた値を取得する.
+ */
+void *map_get(MAP map, const void *key);
+
+/**
+ *  キーをマップから削除する.
+ */
+int map_remove(MAP map, const void *key);
+
+/**
+ *  マップの長さを取得する.
+ */
+ssize_t map_count(MAP map);
+
+/**
+ *  マップの要素を追加順に辿る.
+ */
+int map_walk(MAP map, int (*visit)(const void *key, void *value, void *ctx), void *ctx);
+
+/**
+ *  並行マップオブジェクトを初期化する.
+ */
+CMAP cmap_init(size_t key_bytes, size_t value_bytes, size_t capacity);
+
+/**
+ *  並行マップオブジェクトを解放する.
+ */
+void cmap_release(CMAP cmap);
+
+/**
+ *  並行マップのキーに値を対応付ける.
+ */
+int cmap_put(CMAP cmap, const void *key, const void *value);
+
+/**
+ *  並行マップのキーに対応付けた値をコピーする.
+ */
+int cmap_get(CMAP cmap, const void *key, void *value);
+
+/**
+ *  キーを並行マップから削除する.
+ */
+int cmap_remove(CMAP cmap, const void *key);
+
+/**
+ *  並行マップの長さを取得する.
+ */
+ssize_t cmap_count(CMAP cmap);
+
 /** @} */
 
 #endif /* __HFSM_COLLECTIONS_H__ */
@@ -0,0 +1,60 @@
+/** @file   export.h
+ *  @brief  状態遷移定義のグラフ出力.
+ *
+ *  状態, 階層および遷移 (ガード条件と遷移アクションを含む) を DOT または
+ *  JSON 形式で逐次出力する.
+ *  出力は固定長のバッファを経由して書き込み関数に渡すため,
+ *  定義の規模によらず出力内容を保持しない.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_EXPORT_H__
+#define __HFSM_EXPORT_H__
+
+#include <stdio.h>
+
+#include "hfsm.h"
+
+/** @addtogroup cat_export グラフ出力
+ *  状態遷移定義をグラフとして出力するモジュール.
+ *  @ingroup cat_hfsm
+ *  @{
+ */
+
+/**
+ *  状態遷移定義を DOT 形式で書き込み関数に出力する.
+ */
+int fsm_export_dot(const struct fsm_rels *rels,
+                   const struct fsm_trans *corresps,
+                   int (*writer)(void *, const char *, size_t),
+                   void *ctx);
+
+/**
+ *  状態遷移定義を DOT 形式でファイルに出力する.
+ */
+int fsm_export_dot_to_file(const struct fsm_rels *rels,
+                           const struct fsm_trans *corresps,
+                           FILE *fp);
+
+/**
+ *  状態遷移定義を JSON 形式で書き込み関数に出力する.
+ */
+int fsm_export_json(const struct fsm_rels *rels,
+                    const struct fsm_trans *corresps,
+                    int (*writer)(void *, const char *, size_t),
+                    void *ctx);
+
+/**
+ *  状態遷移定義を JSON 形式でファイルに出力する.
+ */
+int fsm_export_json_to_file(const struct fsm_rels *rels,
+                            const struct fsm_trans *corresps,
+                            FILE *fp);
+
+/** @} */
+
+#endif /* __HFSM_EXPORT_H__ */
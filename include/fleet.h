@@ -0,0 +1,85 @@
+/** @file   fleet.h
+ *  @brief  同じ定義の多数の状態マシンを配列でまとめて動かすフリート.
+ *
+ *  インスタンス毎の現在の状態を番号の配列で保持し,
+ *  (状態, イベント) 毎の遷移先を引く表を用いて全インスタンスを一度に遷移させる.
+ *  ガード条件, 遷移アクション, entry/exit アクションを伴う遷移のみ
+ *  インスタンス毎に個別に処理する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_FLEET_H__
+#define __HFSM_FLEET_H__
+
+#include <stdint.h>
+
+#include "hfsm.h"
+
+/** @addtogroup cat_fleet フリート
+ *  同じ定義の多数の状態マシンをまとめて動かすモジュール.
+ *  @ingroup cat_hfsm
+ *  @{
+ */
+
+struct fsm_fleet;
+
+/**
+ *  フリートの遷移の処理方式.
+ */
+enum fsm_fleet_kernel {
+    FSM_FLEET_AUTO = 0, /**< 実行環境で使える最速の方式を選択する. */
+    FSM_FLEET_SCALAR,   /**< インスタンスを 1 つずつ処理する. */
+    FSM_FLEET_AVX2      /**< AVX2 の gather で 8 インスタンスずつ処理する. */
+};
+
+/**
+ *  フリートを初期化する.
+ */
+struct fsm_fleet *fsm_fleet_init(const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps,
+                                 size_t count,
+                                 const void *context,
+                                 size_t bytes);
+
+/**
+ *  フリートを終了する.
+ */
+int fsm_fleet_term(struct fsm_fleet *fleet);
+
+/**
+ *  遷移の処理方式を設定する.
+ */
+int fsm_fleet_set_kernel(struct fsm_fleet *fleet, enum fsm_fleet_kernel kernel);
+
+/**
+ *  イベントの番号を取得する.
+ */
+int32_t fsm_fleet_event_id(const struct fsm_fleet *fleet, const struct fsm_event *event);
+
+/**
+ *  全インスタンスにイベントを与える.
+ */
+int fsm_fleet_dispatch(struct fsm_fleet *fleet, const struct fsm_event *event);
+
+/**
+ *  インスタンス毎に異なるイベントを与える.
+ */
+int fsm_fleet_dispatch_each(struct fsm_fleet *fleet, const int32_t *events);
+
+/**
+ *  インスタンスの現在の状態を取得する.
+ */
+const struct fsm_state *fsm_fleet_get_current(const struct fsm_fleet *fleet, size_t index);
+
+/**
+ *  インスタンスのコンテキストを取得する.
+ */
+void *fsm_fleet_get_context(struct fsm_fleet *fleet, size_t index);
+
+/** @} */
+
+#endif /* __HFSM_FLEET_H__ */
@@ -0,0 +1,62 @@
+/** @file   group.h
+ *  @brief  状態マシンのグループへのイベントの一斉配信.
+ *
+ *  グループに参加した状態マシンについて, イベント毎に現在の状態で
+ *  そのイベントを処理できる状態マシンの索引を保持し,
+ *  一斉配信では索引に載っている状態マシンにのみイベントを与える.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_GROUP_H__
+#define __HFSM_GROUP_H__
+
+#include <sys/types.h>
+
+#include "hfsm.h"
+
+/** @addtogroup cat_group グループ
+ *  状態マシンのグループにイベントを一斉配信するモジュール.
+ *  @ingroup cat_hfsm
+ *  @{
+ */
+
+struct fsm_group;
+
+/**
+ *  グループを初期化する.
+ */
+struct fsm_group *fsm_group_init(const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps);
+
+/**
+ *  グループを終了する.
+ */
+int fsm_group_term(struct fsm_group *group);
+
+/**
+ *  状態マシンをグループに参加させる.
+ */
+int fsm_group_join(struct fsm_group *group, struct fsm *machine);
+
+/**
+ *  状態マシンをグループから外す.
+ */
+int fsm_group_leave(struct fsm_group *group, struct fsm *machine);
+
+/**
+ *  イベントを処理できる状態マシンにイベントを一斉配信する.
+ */
+ssize_t fsm_group_broadcast(struct fsm_group *group, const struct fsm_event *event);
+
+/**
+ *  イベントを処理できる状態マシンの数を取得する.
+ */
+ssize_t fsm_group_subscribers(struct fsm_group *group, const struct fsm_event *event);
+
+/** @} */
+
+#endif /* __HFSM_GROUP_H__ */
@@ -13,12 +13,14 @@
 #ifndef __HFSM_HFSM_H__
 #define __HFSM_HFSM_H__
 
+#include <stddef.h>
 #include <stdbool.h>
 #include <string.h>
 
 #include "collections.h"
 
 struct fsm_trans;
+struct fsm_table;
 struct fsm;
 
 /** @addtogroup cat_hfsm 階層型有限状態マシン
@@ -31,7 +33,7 @@ struct fsm;
  */
 struct fsm_state_variable {
     const struct fsm_state *parent;  /**< 親状態. */
-    const struct fsm_state *history; /**< 履歴状態. */
+    const struct fsm_state *history; /**< 既定の履歴状態. (状態マシンの履歴は状態マシン毎に保持する) */
     void *data;                      /**< 状態固有情報. */
 };
 
@@ -55,6 +57,9 @@ struct fsm_state {
     void (* const entry)(struct fsm *, void *, bool); /**  entry アクション. */
     void (* const exec)(struct fsm *, void *);        /**  do アクティビティ. */
     void (* const exit)(struct fsm *, void *, bool);  /**  exit アクション. */
+    bool fiber;                                       /**< do アクティビティをファイバで実行するか. */
+    bool slot;                                        /**< インスタンス毎の状態固有情報を持つか. */
+    size_t slot_offset;                               /**< 状態マシンのコンテキスト中の状態固有情報の位置. */
 };
 
 /**
@@ -88,6 +93,68 @@ struct fsm_state {
         FSM_STATE_HELPER(#var, &var##_var, (ent), (exe), (exi)), \
                                   *var = &var##_
 
+/**
+ *  ファイバ状態構造体設定ヘルパ.
+ */
+#define FSM_FIBER_STATE_HELPER(nam, var, ent, exe, exi) \
+    {                                                   \
+        .name = (nam),                                  \
+        .variable = (var),                              \
+        .entry = (ent),                                 \
+        .exec = (exe),                                  \
+        .exit = (exi),                                  \
+        .fiber = true                                   \
+    }
+
+/**
+ *  ファイバ状態定義ヘルパ.
+ *
+ *  do アクティビティをファイバで実行する状態を定義する.
+ *  do アクティビティは @ref fsm_yield で中断し, 次の @ref fsm_update で再開する.
+ *  状態から出る際には, exit アクションの前に do アクティビティが中断される.
+ */
+#define FSM_FIBER_STATE(var, dat, ent, exe, exi)                       \
+    static struct fsm_state_variable var##_var = {                     \
+        .parent = NULL,                                                \
+        .history = NULL,                                               \
+        .data = (dat)                                                  \
+    };                                                                 \
+    static const struct fsm_state var##_ =                             \
+        FSM_FIBER_STATE_HELPER(#var, &var##_var, (ent), (exe), (exi)), \
+                                  *var = &var##_
+
+/**
+ *  インスタンス状態構造体設定ヘルパ.
+ */
+#define FSM_STATE_SLOT_HELPER(nam, var, type, member, ent, exe, exi) \
+    {                                                                \
+        .name = (nam),                                               \
+        .variable = (var),                                           \
+        .entry = (ent),                                              \
+        .exec = (exe),                                               \
+        .exit = (exi),                                               \
+        .slot = true,                                                \
+        .slot_offset = offsetof(type, member)                        \
+    }
+
+/**
+ *  インスタンス状態定義ヘルパ.
+ *
+ *  状態固有情報を状態マシン毎に持つ状態を定義する.
+ *  状態固有情報は状態マシンのコンテキスト (@c type 型) のメンバ @c member とし,
+ *  entry/do/exit アクションにはその状態マシンのメンバのポインタが渡される.
+ *  コンテキストのない状態マシンでは NULL が渡される.
+ */
+#define FSM_STATE_SLOT(var, type, member, ent, exe, exi)                            \
+    static struct fsm_state_variable var##_var = {                                  \
+        .parent = NULL,                                                             \
+        .history = NULL,                                                            \
+        .data = NULL                                                                \
+    };                                                                              \
+    static const struct fsm_state var##_ =                                          \
+        FSM_STATE_SLOT_HELPER(#var, &var##_var, type, member, (ent), (exe), (exi)), \
+                                  *var = &var##_
+
 /**
  *  開始状態.
  */
@@ -137,8 +204,9 @@ extern const struct fsm_event *event_null;
  *  ガード条件構造体.
  */
 struct fsm_cond {
-    const char *name;                 /**< 条件名. */
-    bool (*const func)(struct fsm *); /**< ガード条件. */
+    const char *name;                             /**< 条件名. */
+    bool (*const func)(struct fsm *);             /**< ガード条件. */
+    bool (*const func_ctx)(struct fsm *, void *); /**< コンテキストを受け取るガード条件. */
 };
 
 /**
@@ -160,12 +228,36 @@ struct fsm_cond {
                                  *var = &var##_; \
     static bool var##_func args
 
+/**
+ *  コンテキストを受け取るガード条件構造体設定ヘルパ.
+ */
+#define FSM_COND_CTX_HELPER(nam, fn) \
+    {                                \
+        .name = (nam),               \
+        .func = NULL,                \
+        .func_ctx = (fn)             \
+    }
+
+/**
+ *  コンテキストを受け取るガード条件定義ヘルパ.
+ *
+ *  @c args は (struct fsm *machine, void *ctx) とし,
+ *  @c ctx には状態マシンのコンテキストが渡される.
+ */
+#define FSM_COND_CTX(var, args)                  \
+    static bool var##_func args;                 \
+    static const struct fsm_cond var##_ =        \
+        FSM_COND_CTX_HELPER(#var, var##_func),   \
+                                 *var = &var##_; \
+    static bool var##_func args
+
 /**
  *  遷移アクション構造体.
  */
 struct fsm_action {
-    const char *name;                 /**< アクション名. */
-    void (*const func)(struct fsm *); /**< 遷移アクション. */
+    const char *name;                             /**< アクション名. */
+    void (*const func)(struct fsm *);             /**< 遷移アクション. */
+    void (*const func_ctx)(struct fsm *, void *); /**< コンテキストを受け取る遷移アクション. */
 };
 
 /**
@@ -187,6 +279,29 @@ struct fsm_action {
                                    *var = &var##_; \
     static void var##_func args
 
+/**
+ *  コンテキストを受け取る遷移アクション構造体設定ヘルパ.
+ */
+#define FSM_ACTION_CTX_HELPER(nam, fn) \
+    {                                  \
+        .name = (nam),                 \
+        .func = NULL,                  \
+        .func_ctx = (fn)               \
+    }
+
+/**
+ *  コンテキストを受け取る遷移アクション定義ヘルパ.
+ *
+ *  @c args は (struct fsm *machine, void *ctx) とし,
+ *  @c ctx には状態マシンのコンテキストが渡される.
+ */
+#define FSM_ACTION_CTX(var, args)                  \
+    static void var##_func args;                   \
+    static const struct fsm_action var##_ =        \
+        FSM_ACTION_CTX_HELPER(#var, var##_func),   \
+                                   *var = &var##_; \
+    static void var##_func args
+
 /**
  *  遷移構造体.
  */
@@ -251,6 +366,73 @@ struct fsm_rels {
  */
 #define FSM_RELS_TERMINATOR FSM_RELS_INITIALIZER
 
+/**
+ *  イベントの優先度.
+ *
+ *  @ref fsm_post で積んだイベントは, 優先度の高いものから順に処理される.
+ *  同じ優先度のイベントは積んだ順に処理される.
+ */
+enum fsm_priority {
+    FSM_PRIORITY_LOW = 0, /**< 低優先度. (大量のテレメトリなど) */
+    FSM_PRIORITY_NORMAL,  /**< 通常. */
+    FSM_PRIORITY_HIGH,    /**< 高優先度. */
+    FSM_PRIORITY_URGENT,  /**< 緊急. (異常, 停止など) */
+    FSM_PRIORITY_LANES    /**< 優先度の数. */
+};
+
+/**
+ *  遷移表の検索方式.
+ */
+enum fsm_lookup {
+    FSM_LOOKUP_AUTO = 0, /**< 遷移の数と密度から自動で選択する. */
+    FSM_LOOKUP_LINEAR,   /**< 対応表を先頭から走査する. */
+    FSM_LOOKUP_SORTED,   /**< (状態, イベント) の整列済み配列を二分探索する. */
+    FSM_LOOKUP_HASH      /**< (状態, イベント) の完全ハッシュで引く. */
+};
+
+/**
+ *  オブザーバ構造体.
+ *
+ *  状態マシンの処理の各時点で呼び出されるコールバックを保持する.
+ *  呼び出しが不要なコールバックは NULL とする.
+ *  オブザーバは @ref fsm_add_observer で登録した順に呼び出される.
+ *  登録中のオブザーバの領域は呼び出し側で保持すること.
+ */
+struct fsm_observer {
+    /** イベントを受け付けた. */
+    void (*event_received)(struct fsm *, const struct fsm_event *, void *);
+    /** ガード条件を評価した. */
+    void (*guard_evaluated)(struct fsm *, const struct fsm_trans *, bool, void *);
+    /** 遷移を実施する. (遷移アクションの実行前) */
+    void (*transition_taken)(struct fsm *, const struct fsm_trans *, void *);
+    /** 状態から出た. */
+    void (*exit)(struct fsm *, const struct fsm_state *, void *);
+    /** 状態に入った. */
+    void (*entry)(struct fsm *, const struct fsm_state *, void *);
+    /** イベントに対応する遷移がなかった. */
+    void (*unhandled_event)(struct fsm *, const struct fsm_event *, void *);
+    /** イベントの処理を終えた. (Null 遷移の実施後) */
+    void (*event_processed)(struct fsm *, const struct fsm_event *, void *);
+
+    void *ctx;                 /**< コールバックの最後の引数. */
+    struct fsm_observer *next; /**< 次のオブザーバ. (ライブラリ内部で使用) */
+};
+
+/**
+ *  オブザーバ構造体設定ヘルパ.
+ */
+#define FSM_OBSERVER_HELPER(ev, gu, tr, exi, ent, un, c) \
+    {                                                   \
+        .event_received = (ev),                         \
+        .guard_evaluated = (gu),                        \
+        .transition_taken = (tr),                       \
+        .exit = (exi),                                  \
+        .entry = (ent),                                 \
+        .unhandled_event = (un),                        \
+        .ctx = (c),                                     \
+        .next = NULL                                    \
+    }
+
 /**
  *  ダンプ処理の標準ハンドラ.
  */
@@ -265,11 +447,10 @@ static inline void fsm_dump_state_transition_to_text(TREE tree)
         const struct fsm_state *state =
             *(const struct fsm_state **)tree_iter_get_payload(iter);
         int age = tree_iter_get_age(iter);
-        char spacer[128] = {'\0'};
         for (int i = 0; i < age; ++i) {
-            strncat(spacer, "    ", sizeof(spacer) - (i * 4));
+            fputs("    ", stdout);
         }
-        printf("%s%s\n", spacer, state->name);
+        printf("%s\n", state->name);
     }
 
     tree_iter_release(iter);
@@ -281,6 +462,19 @@ static inline void fsm_dump_state_transition_to_text(TREE tree)
 struct fsm *fsm_init(const struct fsm_rels *rels,
                      const struct fsm_trans *corresps);
 
+/**
+ *  遷移表を共有する状態マシンを初期化する.
+ */
+struct fsm *fsm_init_table(const struct fsm_rels *rels, struct fsm_table *table);
+
+/**
+ *  コンテキストを持つ状態マシンを初期化する.
+ */
+struct fsm *fsm_init_context(const struct fsm_rels *rels,
+                             struct fsm_table *table,
+                             const void *context,
+                             size_t bytes);
+
 /**
  *  状態マシンを破棄する.
  */
@@ -296,21 +490,111 @@ void fsm_transition(struct fsm *machine, const struct fsm_event *event);
  */
 void fsm_update(struct fsm *machine);
 
+/**
+ *  ファイバで実行中の do アクティビティを中断する.
+ */
+bool fsm_yield(struct fsm *machine);
+
 /**
  *  状態の固有情報を取得する.
  */
 void *fsm_get_state_data(const struct fsm_state *state);
 
+/**
+ *  状態マシンにおける状態の固有情報を取得する.
+ */
+void *fsm_get_state_data_of(const struct fsm *machine, const struct fsm_state *state);
+
+/**
+ *  状態マシンのコンテキストを取得する.
+ */
+void *fsm_get_context(const struct fsm *machine);
+
 /**
  *  現在の状態名を取得する.
  */
 void fsm_current_state(struct fsm *machine, char *name, size_t len);
 
+/**
+ *  現在の状態を取得する.
+ */
+const struct fsm_state *fsm_get_current(struct fsm *machine);
+
 /**
  *  状態遷移設定をダンプする.
  */
 void fsm_dump_state_transition(struct fsm *machine, void (*handler)(TREE));
 
+/**
+ *  イベントを優先度付きで積む.
+ */
+int fsm_post(struct fsm *machine, const struct fsm_event *event, enum fsm_priority priority);
+
+/**
+ *  積まれたイベントのうち最も優先度の高いものを処理する.
+ */
+int fsm_dispatch(struct fsm *machine);
+
+/**
+ *  積まれているイベントの数を取得する.
+ */
+ssize_t fsm_pending(struct fsm *machine);
+
+/**
+ *  優先度毎に積めるイベントの数を設定する.
+ */
+int fsm_set_queue_capacity(struct fsm *machine, size_t capacity);
+
+/**
+ *  遷移の対応表から遷移表を生成する.
+ */
+struct fsm_table *fsm_table_compile(const struct fsm_trans *corresps,
+                                    void (*reclaim)(struct fsm_table *, void *),
+                                    void *ctx);
+
+/**
+ *  検索方式を指定して遷移の対応表から遷移表を生成する.
+ */
+struct fsm_table *fsm_table_compile_as(const struct fsm_trans *corresps,
+                                       enum fsm_lookup lookup,
+                                       void (*reclaim)(struct fsm_table *, void *),
+                                       void *ctx);
+
+/**
+ *  遷移表の参照を解放する.
+ */
+void fsm_table_release(struct fsm_table *table);
+
+/**
+ *  遷移表の対応表を取得する.
+ */
+const struct fsm_trans *fsm_table_corresps(const struct fsm_table *table);
+
+/**
+ *  遷移表の検索方式を取得する.
+ */
+enum fsm_lookup fsm_table_lookup(const struct fsm_table *table);
+
+/**
+ *  遷移表の使用メモリ量を取得する.
+ */
+size_t fsm_table_bytes(const struct fsm_table *table);
+
+/**
+ *  状態マシンの遷移表を差し替える.
+ */
+int fsm_publish_table(struct fsm *machine, struct fsm_table *table);
+
+/**
+ *  オブザーバを登録する.
+ */
+int fsm_add_observer(struct fsm *machine, struct fsm_observer *observer);
+
+/**
+ *  オブザーバの登録を解除する.
+ */
+int fsm_remove_observer(struct fsm *machine, struct fsm_observer *observer);
+
 /** @} */
 
 #endif /* __HFSM_HFSM_H__ */
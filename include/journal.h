@@ -0,0 +1,105 @@
+/** @file   journal.h
+ *  @brief  イベントの記録と再生.
+ *
+ *  状態マシンに発生させたイベントを追記専用のバイナリログに記録し,
+ *  記録したイベントを同じ定義の状態マシンに高速に再生する.
+ *  記録毎に遷移後の状態を保持し, 再生時に状態の列のチェックサムと
+ *  比較することで, 記録時と異なる遷移 (乖離) を検出する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_JOURNAL_H__
+#define __HFSM_JOURNAL_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "hfsm.h"
+
+/** @addtogroup cat_journal イベントの記録と再生
+ *  イベントを記録し再生するモジュール.
+ *  @ingroup cat_hfsm
+ *  @{
+ */
+
+/**
+ *  記録できる付加データの最大サイズ.
+ */
+#define FSM_JOURNAL_PAYLOAD_MAX (16 * 1024 * 1024)
+
+struct fsm_journal;
+
+/**
+ *  再生結果構造体.
+ */
+struct fsm_replay_stats {
+    size_t records;    /**< 再生した記録の数. */
+    ssize_t diverged;  /**< 最初に乖離した記録の位置 (乖離なしは -1). */
+    uint32_t checksum; /**< 再生した状態の列のチェックサム. */
+    bool truncated;    /**< 末尾の記録が途中で切れていたか. */
+};
+
+/**
+ *  記録を開始する.
+ */
+struct fsm_journal *fsm_journal_open(const char *path,
+                                     const struct fsm_rels *rels,
+                                     const struct fsm_trans *corresps);
+
+/**
+ *  記録を終了する.
+ */
+int fsm_journal_close(struct fsm_journal *journal);
+
+/**
+ *  状態マシンを記録対象として登録する.
+ */
+int fsm_journal_attach(struct fsm_journal *journal, struct fsm *machine);
+
+/**
+ *  記録対象の状態マシンの登録を解除する.
+ */
+int fsm_journal_detach(struct fsm_journal *journal);
+
+/**
+ *  イベントを発生させ, 記録する.
+ */
+int fsm_journal_transition(struct fsm_journal *journal,
+                           struct fsm *machine,
+                           const struct fsm_event *event,
+                           const void *payload,
+                           size_t payload_bytes);
+
+/**
+ *  記録をファイルに書き出す.
+ */
+int fsm_journal_flush(struct fsm_journal *journal);
+
+/**
+ *  記録した状態の列のチェックサムを取得する.
+ */
+uint32_t fsm_journal_checksum(const struct fsm_journal *journal);
+
+/**
+ *  記録を再生する.
+ */
+int fsm_journal_replay(const char *path,
+                       const struct fsm_rels *rels,
+                       const struct fsm_trans *corresps,
+                       struct fsm *machine,
+                       void (*handler)(struct fsm *,
+                                       const struct fsm_event *,
+                                       uint64_t,
+                                       const void *,
+                                       size_t,
+                                       void *),
+                       void *ctx,
+                       struct fsm_replay_stats *stats);
+
+/** @} */
+
+#endif /* __HFSM_JOURNAL_H__ */
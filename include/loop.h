@@ -0,0 +1,100 @@
+/** @file   loop.h
+ *  @brief  epoll によるイベントループ. (Linux 専用)
+ *
+ *  ファイルディスクリプタ, タイマ (timerfd) およびシグナル (signalfd) の
+ *  準備完了を状態マシンのイベントに対応付け, 1 つのスレッドで多数の
+ *  状態マシンを駆動する.
+ *  1 回の epoll_wait で準備完了となったものをまとめてイベントとして積み,
+ *  その後に各状態マシンのイベントを優先度順に処理する.
+ *  他のスレッドから積んだイベントは eventfd により待機中のループを起こして処理する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_LOOP_H__
+#define __HFSM_LOOP_H__
+
+#include <stdint.h>
+
+#include "hfsm.h"
+
+/** @addtogroup cat_loop イベントループ
+ *  epoll によるイベントループのモジュール.
+ *  @ingroup cat_hfsm
+ *  @{
+ */
+
+struct fsm_loop;
+
+/**
+ *  イベントループを初期化する.
+ */
+struct fsm_loop *fsm_loop_init(void);
+
+/**
+ *  イベントループを破棄する.
+ */
+int fsm_loop_term(struct fsm_loop *loop);
+
+/**
+ *  ファイルディスクリプタの読み込み可能をイベントに対応付ける.
+ */
+int fsm_loop_add_fd(struct fsm_loop *loop,
+                    int fd,
+                    struct fsm *machine,
+                    const struct fsm_event *event,
+                    enum fsm_priority priority);
+
+/**
+ *  タイマの満了をイベントに対応付ける.
+ */
+int fsm_loop_add_timer(struct fsm_loop *loop,
+                       unsigned int initial_ms,
+                       unsigned int interval_ms,
+                       struct fsm *machine,
+                       const struct fsm_event *event,
+                       enum fsm_priority priority);
+
+/**
+ *  シグナルの受信をイベントに対応付ける.
+ */
+int fsm_loop_add_signal(struct fsm_loop *loop,
+                        int signo,
+                        struct fsm *machine,
+                        const struct fsm_event *event,
+                        enum fsm_priority priority);
+
+/**
+ *  対応付けを解除する.
+ */
+int fsm_loop_remove(struct fsm_loop *loop, int fd);
+
+/**
+ *  イベントを積み, ループを起こす. (スレッドセーフ)
+ */
+int fsm_loop_post(struct fsm_loop *loop,
+                  struct fsm *machine,
+                  const struct fsm_event *event,
+                  enum fsm_priority priority);
+
+/**
+ *  準備完了を 1 回待ち, イベントを処理する.
+ */
+int fsm_loop_run_once(struct fsm_loop *loop, int timeout_ms);
+
+/**
+ *  @ref fsm_loop_stop が呼ばれるまでイベントを処理する.
+ */
+int fsm_loop_run(struct fsm_loop *loop);
+
+/**
+ *  @ref fsm_loop_run を終了させる. (スレッドセーフ)
+ */
+int fsm_loop_stop(struct fsm_loop *loop);
+
+/** @} */
+
+#endif /* __HFSM_LOOP_H__ */
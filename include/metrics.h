@@ -0,0 +1,97 @@
+/** @file   metrics.h
+ *  @brief  状態毎の滞在数と滞在時間の計測.
+ *
+ *  登録した状態マシンについて, 状態毎の滞在している状態マシンの数,
+ *  入状と出状の回数および滞在時間のヒストグラムを計測し,
+ *  Prometheus のテキスト形式で出力する.
+ *  計数はスレッド毎の領域に行い, 出力時に合算するため,
+ *  遷移の処理で共有のキャッシュラインへの不可分な読み書きは発生しない.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_METRICS_H__
+#define __HFSM_METRICS_H__
+
+#include <stdint.h>
+
+#include "hfsm.h"
+
+/** @addtogroup cat_metrics 計測
+ *  状態毎の滞在数と滞在時間を計測するモジュール.
+ *  @ingroup cat_hfsm
+ *  @{
+ */
+
+/**
+ *  滞在時間のヒストグラムの区間の数. (上限なしの区間を含む)
+ *
+ *  区間の上限は 1 us から 100 s まで 10 倍毎とする.
+ */
+#define FSM_METRICS_BUCKETS (10)
+
+struct fsm_metrics;
+
+/**
+ *  状態毎の計測値構造体.
+ */
+struct fsm_state_metrics {
+    int64_t population;                     /**< 滞在している状態マシンの数. */
+    uint64_t entries;                       /**< 入状の回数. */
+    uint64_t exits;                         /**< 出状の回数. */
+    uint64_t residency_ns;                  /**< 滞在時間の合計 (ナノ秒). */
+    uint64_t buckets[FSM_METRICS_BUCKETS];  /**< 区間毎の出状の回数. (累積しない) */
+};
+
+/**
+ *  計測を初期化する.
+ */
+struct fsm_metrics *fsm_metrics_init(const char *name,
+                                     const struct fsm_rels *rels,
+                                     const struct fsm_trans *corresps);
+
+/**
+ *  計測を終了する.
+ */
+int fsm_metrics_term(struct fsm_metrics *metrics);
+
+/**
+ *  状態マシンを計測の対象に登録する.
+ */
+int fsm_metrics_attach(struct fsm_metrics *metrics, struct fsm *machine);
+
+/**
+ *  状態マシンを計測の対象から解除する.
+ */
+int fsm_metrics_detach(struct fsm_metrics *metrics, struct fsm *machine);
+
+/**
+ *  状態の計測値を取得する.
+ */
+int fsm_metrics_read(struct fsm_metrics *metrics,
+                     const struct fsm_state *state,
+                     struct fsm_state_metrics *values);
+
+/**
+ *  計測値を Prometheus のテキスト形式で書き込み関数に出力する.
+ */
+int fsm_metrics_export(struct fsm_metrics *metrics,
+                       int (*writer)(void *, const char *, size_t),
+                       void *ctx);
+
+/**
+ *  計測値を Prometheus のテキスト形式でファイルディスクリプタに出力する.
+ */
+int fsm_metrics_export_to_fd(struct fsm_metrics *metrics, int fd);
+
+/**
+ *  計測値を Prometheus のテキスト形式でファイルに出力する.
+ */
+int fsm_metrics_export_to_path(struct fsm_metrics *metrics, const char *path);
+
+/** @} */
+
+#endif /* __HFSM_METRICS_H__ */
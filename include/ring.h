@@ -0,0 +1,112 @@
+/** @file   ring.h
+ *  @brief  共有メモリによるプロセス間のイベントリング.
+ *
+ *  複数の生成側プロセスから 1 つの状態マシンのホストプロセスへ,
+ *  共有メモリ上の固定長の記録 (状態マシン番号, イベント番号, 優先度,
+ *  小さな付加データ) でイベントを渡す.
+ *  記録の受け渡しにシステムコールは不要で, 受け取り側が待機している場合のみ
+ *  futex で起こす.
+ *  イベントの番号は状態遷移表の索引による番号を用いるため,
+ *  両側で同じ状態遷移定義を用いること.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_RING_H__
+#define __HFSM_RING_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "hfsm.h"
+
+/** @addtogroup cat_ring イベントリング
+ *  共有メモリによるプロセス間のイベントリングのモジュール.
+ *  @ingroup cat_hfsm
+ *  @{
+ */
+
+/**
+ *  1 つの記録に格納できる付加データの最大長.
+ */
+#define FSM_RING_PAYLOAD_MAX (40)
+
+struct fsm_ring;
+
+/**
+ *  イベントリングを生成する.
+ */
+struct fsm_ring *fsm_ring_create(const char *name,
+                                 size_t capacity,
+                                 const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps);
+
+/**
+ *  名前付きのイベントリングに接続する.
+ */
+struct fsm_ring *fsm_ring_attach(const char *name,
+                                 const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps);
+
+/**
+ *  ファイルディスクリプタでイベントリングに接続する.
+ */
+struct fsm_ring *fsm_ring_attach_fd(int fd,
+                                    const struct fsm_rels *rels,
+                                    const struct fsm_trans *corresps);
+
+/**
+ *  イベントリングから切断する.
+ */
+int fsm_ring_close(struct fsm_ring *ring);
+
+/**
+ *  イベントリングの共有メモリのファイルディスクリプタを取得する.
+ */
+int fsm_ring_fd(const struct fsm_ring *ring);
+
+/**
+ *  記録の領域を予約し, 付加データの書き込み先を取得する.
+ */
+void *fsm_ring_reserve(struct fsm_ring *ring,
+                       uint32_t machine_id,
+                       const struct fsm_event *event,
+                       enum fsm_priority priority);
+
+/**
+ *  予約した記録を受け取り側に公開する.
+ */
+int fsm_ring_commit(struct fsm_ring *ring, void *payload, size_t payload_bytes);
+
+/**
+ *  イベントを送る.
+ */
+int fsm_ring_send(struct fsm_ring *ring,
+                  uint32_t machine_id,
+                  const struct fsm_event *event,
+                  enum fsm_priority priority,
+                  const void *payload,
+                  size_t payload_bytes);
+
+/**
+ *  記録が届くまで待つ.
+ */
+int fsm_ring_wait(struct fsm_ring *ring, int timeout_ms);
+
+/**
+ *  届いた記録を状態マシンに積み, 処理する.
+ */
+ssize_t fsm_ring_drain(struct fsm_ring *ring,
+                       struct fsm *const *machines,
+                       size_t nmachines,
+                       size_t max,
+                       void (*handler)(struct fsm *, const struct fsm_event *,
+                                       const void *, size_t, void *),
+                       void *ctx);
+
+/** @} */
+
+#endif /* __HFSM_RING_H__ */
@@ -0,0 +1,1052 @@
+/** @file   analysis.c
+ *  @brief  状態遷移定義の解析.
+ *
+ *  到達可能な構成を, 複数スレッドによる幅優先探索で列挙する.
+ *  構成は現在の状態と, 遷移先となり得るコンポジット状態の履歴状態の組で表す.
+ *  ガード条件は評価できないため, 成立する場合と成立しない場合の両方を辿る.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "debug.h"
+#include "chart.h"
+#include "analysis.h"
+
+/**
+ *  訪問済み集合の分割数の対数.
+ */
+#define SHARD_BITS (6)
+
+/**
+ *  訪問済み集合の分割数.
+ */
+#define SHARD_COUNT (1 << SHARD_BITS)
+
+/**
+ *  訪問済み集合の分割毎の初期の大きさ.
+ */
+#define SHARD_MIN (64)
+
+/**
+ *  スレッドが一度に取得する構成の数.
+ */
+#define FRONTIER_CHUNK (64)
+
+/**
+ *  構成を格納するアリーナの 1 ブロックの語数.
+ */
+#define ARENA_WORDS (16 * 1024)
+
+/**
+ *  解析結果構造体.
+ */
+struct fsm_analysis {
+    size_t configs;          /**< 到達可能な構成の数. */
+    bool truncated;          /**< 構成の上限により探索を打ち切ったか. */
+    LIST unreachable_states; /**< 到達不能な状態 (const struct fsm_state *) のリスト. */
+    LIST dead_transitions;   /**< 発火しない遷移 (const struct fsm_trans *) のリスト. */
+    LIST deadlock_states;    /**< デッドロックする状態 (const struct fsm_state *) のリスト. */
+};
+
+/**
+ *  階層の区切りで探索スレッドを同期するバリア.
+ */
+struct barrier {
+    pthread_mutex_t lock; /**< バリアのロック. */
+    pthread_cond_t cond;  /**< 待ち合わせの条件変数. */
+    int count;            /**< 待ち合わせるスレッドの数. */
+    int waiting;          /**< 待ち合わせ中のスレッドの数. */
+    unsigned phase;       /**< 待ち合わせの世代. */
+};
+
+/**
+ *  訪問済み集合の分割.
+ *
+ *  分割毎にロックを持ち, 異なる分割への挿入は並行して行える.
+ */
+struct visited_shard {
+    alignas(64) pthread_mutex_t lock; /**< 分割のロック. */
+    uint64_t *hashes;                 /**< 構成のハッシュ値. */
+    uint32_t **configs;               /**< 構成へのポインタ. */
+    size_t mask;                      /**< 表の大きさ - 1. */
+    size_t count;                     /**< 格納済みの構成の数. */
+};
+
+/**
+ *  構成を格納するアリーナ.
+ */
+struct arena {
+    struct arena *next; /**< 次のブロック. */
+    size_t used;        /**< 使用済みの語数. */
+    uint32_t words[];   /**< 構成の格納領域. */
+};
+
+struct analyzer;
+
+/**
+ *  探索スレッド毎の作業領域.
+ */
+struct worker {
+    struct analyzer *az;  /**< 解析器. */
+    int id;               /**< スレッドの番号. */
+    pthread_t thread;     /**< スレッド. */
+    struct arena *arena;  /**< 構成を格納するアリーナ. */
+    uint32_t **next;      /**< 次の階層の構成. */
+    size_t nnext;         /**< 次の階層の構成の数. */
+    size_t next_capacity; /**< 次の階層の構成の容量. */
+    uint32_t *scratch;    /**< 後続の構成を組み立てる作業領域. */
+    unsigned *resolved;   /**< イベント毎の処理済み世代. */
+    unsigned generation;  /**< 処理中の世代. */
+};
+
+/**
+ *  解析器構造体.
+ */
+struct analyzer {
+    const struct chart *chart;    /**< 状態遷移表の索引. */
+    int start;                    /**< 開始状態の番号. */
+    int end;                      /**< 終了状態の番号. */
+    int null_event;               /**< Null 遷移イベントの番号. */
+    size_t words;                 /**< 構成の語数. */
+    int *depths;                  /**< 状態の深さ. */
+    int *slots;                   /**< 状態の履歴を保持する構成上の位置 (なしは -1). */
+    bool *live;                   /**< 自身か祖先にイベントによる遷移があるか. */
+    atomic_uchar *active;         /**< 活性化した状態. */
+    atomic_uchar *fired;          /**< 発火した遷移. */
+    atomic_uchar *deadlock;       /**< デッドロックした状態. */
+
+    struct visited_shard shards[SHARD_COUNT]; /**< 訪問済み集合. */
+    atomic_size_t configs;        /**< 訪問済みの構成の数. */
+    size_t max_configs;           /**< 構成の上限 (0 は無制限). */
+    atomic_bool truncated;        /**< 上限に達したか. */
+    atomic_int error;             /**< 発生したエラー. */
+
+    uint32_t **frontier;          /**< 処理中の階層の構成. */
+    size_t nfrontier;             /**< 処理中の階層の構成の数. */
+    atomic_size_t cursor;         /**< 次に処理する構成の位置. */
+    struct barrier barrier;       /**< 階層の区切りの同期. */
+    bool done;                    /**< 探索の完了. */
+    struct worker *workers;       /**< 探索スレッド. */
+    int nworkers;                 /**< 探索スレッドの数. */
+};
+
+/**
+ *  バリアを初期化する.
+ *
+ *  @param  [out]   barrier バリア.
+ *  @param  [in]    count   待ち合わせるスレッドの数.
+ */
+static void barrier_init(struct barrier *barrier, int count)
+{
+    pthread_mutex_init(&barrier->lock, NULL);
+    pthread_cond_init(&barrier->cond, NULL);
+    barrier->count = count;
+    barrier->waiting = 0;
+    barrier->phase = 0;
+}
+
+/**
+ *  バリアを破棄する.
+ *
+ *  @param  [in,out]    barrier バリア.
+ */
+static void barrier_destroy(struct barrier *barrier)
+{
+    pthread_cond_destroy(&barrier->cond);
+    pthread_mutex_destroy(&barrier->lock);
+}
+
+/**
+ *  待ち合わせ中のスレッドを解放する.
+ *
+ *  @param  [in,out]    barrier バリア.
+ *  @pre    @c barrier のロックを獲得していること.
+ */
+static void barrier_release_locked(struct barrier *barrier)
+{
+    barrier->waiting = 0;
+    ++barrier->phase;
+    pthread_cond_broadcast(&barrier->cond);
+}
+
+/**
+ *  すべてのスレッドが到達するまで待つ.
+ *
+ *  @param  [in,out]    barrier バリア.
+ */
+static void barrier_wait(struct barrier *barrier)
+{
+    pthread_mutex_lock(&barrier->lock);
+    if (++barrier->waiting >= barrier->count) {
+        barrier_release_locked(barrier);
+    } else {
+        unsigned phase = barrier->phase;
+        while (phase == barrier->phase) {
+            pthread_cond_wait(&barrier->cond, &barrier->lock);
+        }
+    }
+    pthread_mutex_unlock(&barrier->lock);
+}
+
+/**
+ *  待ち合わせるスレッドの数を減らす.
+ *
+ *  @param  [in,out]    barrier バリア.
+ *  @param  [in]        count   新しいスレッドの数.
+ */
+static void barrier_shrink(struct barrier *barrier, int count)
+{
+    pthread_mutex_lock(&barrier->lock);
+    barrier->count = count;
+    if ((barrier->waiting > 0) && (barrier->waiting >= barrier->count)) {
+        barrier_release_locked(barrier);
+    }
+    pthread_mutex_unlock(&barrier->lock);
+}
+
+/**
+ *  構成のハッシュ値を計算する.
+ *
+ *  @param  [in]    config  構成.
+ *  @param  [in]    words   構成の語数.
+ *  @return ハッシュ値が返る.
+ */
+static inline uint64_t config_hash(const uint32_t *config, size_t words)
+{
+    uint64_t h = UINT64_C(0x9e3779b97f4a7c15) ^ words;
+
+    for (size_t i = 0; i < words; ++i) {
+        h = (h ^ config[i]) * UINT64_C(0xff51afd7ed558ccd);
+        h ^= h >> 32;
+    }
+
+    return h;
+}
+
+/**
+ *  アリーナから構成の領域を確保する.
+ *
+ *  @param  [in,out]    worker  探索スレッドの作業領域.
+ *  @return 成功時は, 確保した領域が返る.
+ *          失敗時は, NULL が返る.
+ */
+static uint32_t *arena_alloc(struct worker *worker)
+{
+    size_t words = worker->az->words;
+    struct arena *arena = worker->arena;
+
+    if ((arena == NULL) || (arena->used + words > ARENA_WORDS)) {
+        size_t capacity = (words > ARENA_WORDS) ? words : ARENA_WORDS;
+        arena = malloc(sizeof(*arena) + capacity * sizeof(uint32_t));
+        if (arena == NULL) {
+            return NULL;
+        }
+        arena->next = worker->arena;
+        arena->used = 0;
+        worker->arena = arena;
+    }
+    arena->used += words;
+
+    return &arena->words[arena->used - words];
+}
+
+/**
+ *  訪問済み集合の分割を拡張する.
+ *
+ *  @param  [in,out]    shard   分割.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返る.
+ *  @pre    @c shard のロックを獲得していること.
+ */
+static int visited_grow(struct visited_shard *shard)
+{
+    size_t size = (shard->mask + 1) * 2;
+    uint64_t *hashes = malloc(size * sizeof(*hashes));
+    uint32_t **configs = calloc(size, sizeof(*configs));
+
+    if ((hashes == NULL) || (configs == NULL)) {
+        free(configs);
+        free(hashes);
+        return -1;
+    }
+    for (size_t i = 0; i <= shard->mask; ++i) {
+        if (shard->configs[i] != NULL) {
+            size_t pos = shard->hashes[i] & (size - 1);
+            while (configs[pos] != NULL) {
+                pos = (pos + 1) & (size - 1);
+            }
+            hashes[pos] = shard->hashes[i];
+            configs[pos] = shard->configs[i];
+        }
+    }
+    free(shard->configs);
+    free(shard->hashes);
+    shard->hashes = hashes;
+    shard->configs = configs;
+    shard->mask = size - 1;
+
+    return 0;
+}
+
+/**
+ *  構成を訪問済み集合に追加する.
+ *
+ *  @param  [in,out]    worker  探索スレッドの作業領域.
+ *  @param  [in]        config  追加する構成.
+ *  @return 新たに追加した場合は, 格納した構成が返る.
+ *          訪問済みの場合や追加できなかった場合は, NULL が返る.
+ */
+static uint32_t *visited_insert(struct worker *worker, const uint32_t *config)
+{
+    struct analyzer *az = worker->az;
+    uint64_t hash = config_hash(config, az->words);
+    struct visited_shard *shard = &az->shards[hash >> (64 - SHARD_BITS)];
+    uint32_t *stored = NULL;
+    size_t pos;
+
+    pthread_mutex_lock(&shard->lock);
+    if (((shard->count + 1) * 2 > shard->mask + 1) && (visited_grow(shard) != 0)) {
+        atomic_store(&az->error, ENOMEM);
+        goto out;
+    }
+    for (pos = hash & shard->mask;
+         shard->configs[pos] != NULL;
+         pos = (pos + 1) & shard->mask) {
+
+        if ((shard->hashes[pos] == hash)
+            && (memcmp(shard->configs[pos], config, az->words * sizeof(*config)) == 0)) {
+            goto out;
+        }
+    }
+    if ((az->max_configs > 0) && (atomic_fetch_add(&az->configs, 1) >= az->max_configs)) {
+        atomic_fetch_sub(&az->configs, 1);
+        atomic_store(&az->truncated, true);
+        goto out;
+    } else if (az->max_configs == 0) {
+        atomic_fetch_add(&az->configs, 1);
+    }
+    stored = arena_alloc(worker);
+    if (stored == NULL) {
+        atomic_store(&az->error, ENOMEM);
+        goto out;
+    }
+    memcpy(stored, config, az->words * sizeof(*config));
+    shard->hashes[pos] = hash;
+    shard->configs[pos] = stored;
+    ++shard->count;
+
+out:
+    pthread_mutex_unlock(&shard->lock);
+    return stored;
+}
+
+/**
+ *  後続の構成を次の階層に加える.
+ *
+ *  @param  [in,out]    worker  探索スレッドの作業領域.
+ *  @param  [in]        config  後続の構成.
+ */
+static void analyzer_emit(struct worker *worker, const uint32_t *config)
+{
+    uint32_t *stored = visited_insert(worker, config);
+
+    if (stored == NULL) {
+        return;
+    }
+    if (worker->nnext == worker->next_capacity) {
+        size_t capacity = (worker->next_capacity > 0) ? worker->next_capacity * 2 : 256;
+        uint32_t **next = realloc(worker->next, capacity * sizeof(*next));
+        if (next == NULL) {
+            atomic_store(&worker->az->error, ENOMEM);
+            return;
+        }
+        worker->next = next;
+        worker->next_capacity = capacity;
+    }
+    worker->next[worker->nnext++] = stored;
+}
+
+/**
+ *  構成上の履歴状態を更新する.
+ *
+ *  @param  [in]        az      解析器.
+ *  @param  [in,out]    config  構成.
+ *  @param  [in]        parent  親状態の番号.
+ *  @param  [in]        state   履歴とする状態の番号.
+ */
+static inline void analyzer_set_history(const struct analyzer *az,
+                                        uint32_t *config,
+                                        int parent,
+                                        int state)
+{
+    if ((parent >= 0) && (az->slots[parent] >= 0)) {
+        config[az->slots[parent]] = (uint32_t)state + 1;
+    }
+}
+
+/**
+ *  構成上で状態を変更する.
+ *
+ *  状態マシンの状態変更と同様に, 共通の祖先までの exit で親の履歴状態を
+ *  更新し, 遷移先に履歴状態があればそちらへ遷移する.
+ *
+ *  @param  [in]        az      解析器.
+ *  @param  [in,out]    config  構成.
+ *  @param  [in]        next    新しい状態の番号.
+ */
+static void analyzer_change(const struct analyzer *az, uint32_t *config, int next)
+{
+    const int *parents = az->chart->parents;
+
+    for (;;) {
+        int current = (int)config[0];
+        int a = current, b = next;
+
+        /* 自己遷移の場合 */
+        if (current == next) {
+            analyzer_set_history(az, config, parents[current], current);
+            return;
+        }
+
+        while (az->depths[a] > az->depths[b]) {
+            a = parents[a];
+        }
+        while (az->depths[b] > az->depths[a]) {
+            b = parents[b];
+        }
+        while (a != b) {
+            a = parents[a];
+            b = parents[b];
+        }
+        for (int s = current; s != a; s = parents[s]) {
+            analyzer_set_history(az, config, parents[s], s);
+        }
+        config[0] = (uint32_t)next;
+
+        /* 履歴状態に対する遷移を行う. */
+        if ((az->slots[next] < 0) || (config[az->slots[next]] == 0)) {
+            return;
+        }
+        next = (int)config[az->slots[next]] - 1;
+    }
+}
+
+/**
+ *  Null 遷移を行い, 後続の構成を次の階層に加える.
+ *
+ *  @param  [in,out]    worker  探索スレッドの作業領域.
+ *  @param  [in]        config  イベント処理後の構成.
+ */
+static void analyzer_null_step(struct worker *worker, const uint32_t *config)
+{
+    struct analyzer *az = worker->az;
+    const struct chart *chart = az->chart;
+    uint32_t *branch = worker->scratch + az->words;
+    int state = (int)config[0];
+
+    for (size_t k = chart->outs[state]; k < chart->outs[state + 1]; ++k) {
+        int t = chart->out_trans[k];
+        if (chart->evs[t] != az->null_event) {
+            continue;
+        }
+        atomic_store_explicit(&az->fired[t], 1, memory_order_relaxed);
+        memcpy(branch, config, az->words * sizeof(*config));
+        if (chart->tos[t] >= 0) {
+            analyzer_change(az, branch, chart->tos[t]);
+        }
+        analyzer_emit(worker, branch);
+        if (chart->corresps[t].cond == NULL) {
+            return;
+        }
+    }
+    analyzer_emit(worker, config);
+}
+
+/**
+ *  状態とその祖先を活性化済みとする.
+ *
+ *  @param  [in,out]    az      解析器.
+ *  @param  [in]        state   状態の番号.
+ */
+static void analyzer_activate(struct analyzer *az, int state)
+{
+    for (; state >= 0; state = az->chart->parents[state]) {
+        if (atomic_load_explicit(&az->active[state], memory_order_relaxed)) {
+            break;
+        }
+        atomic_store_explicit(&az->active[state], 1, memory_order_relaxed);
+    }
+}
+
+/**
+ *  構成から発火し得るすべての遷移を辿る.
+ *
+ *  ガード条件のない遷移が見つかったイベントは, それ以降 (祖先を含む) の
+ *  遷移を辿らない.
+ *
+ *  @param  [in,out]    worker  探索スレッドの作業領域.
+ *  @param  [in]        config  構成.
+ */
+static void analyzer_expand(struct worker *worker, const uint32_t *config)
+{
+    struct analyzer *az = worker->az;
+    const struct chart *chart = az->chart;
+    uint32_t *next = worker->scratch;
+    int current = (int)config[0];
+
+    analyzer_activate(az, current);
+    if (!az->live[current] && (current != az->end)) {
+        atomic_store_explicit(&az->deadlock[current], 1, memory_order_relaxed);
+    }
+
+    ++worker->generation;
+    for (int s = current; s >= 0; s = chart->parents[s]) {
+        for (size_t k = chart->outs[s]; k < chart->outs[s + 1]; ++k) {
+            int t = chart->out_trans[k];
+            int e = chart->evs[t];
+            if ((e == az->null_event) || (worker->resolved[e] == worker->generation)) {
+                continue;
+            }
+            atomic_store_explicit(&az->fired[t], 1, memory_order_relaxed);
+            memcpy(next, config, az->words * sizeof(*config));
+            if (chart->tos[t] >= 0) {
+                analyzer_change(az, next, chart->tos[t]);
+            }
+            analyzer_null_step(worker, next);
+            if (chart->corresps[t].cond == NULL) {
+                worker->resolved[e] = worker->generation;
+            }
+        }
+    }
+}
+
+/**
+ *  各スレッドの次の階層をまとめ, 処理中の階層とする.
+ *
+ *  @param  [in,out]    az  解析器.
+ */
+static void analyzer_advance(struct analyzer *az)
+{
+    size_t total = 0;
+
+    for (int i = 0; i < az->nworkers; ++i) {
+        total += az->workers[i].nnext;
+    }
+    if (total > 0) {
+        uint32_t **frontier = realloc(az->frontier, total * sizeof(*frontier));
+        if (frontier == NULL) {
+            atomic_store(&az->error, ENOMEM);
+            total = 0;
+        } else {
+            az->frontier = frontier;
+        }
+    }
+    az->nfrontier = 0;
+    for (int i = 0; i < az->nworkers; ++i) {
+        struct worker *worker = &az->workers[i];
+        if ((total > 0) && (worker->nnext > 0)) {
+            memcpy(&az->frontier[az->nfrontier], worker->next, worker->nnext * sizeof(*worker->next));
+            az->nfrontier += worker->nnext;
+        }
+        worker->nnext = 0;
+    }
+    atomic_store(&az->cursor, 0);
+    az->done = (az->nfrontier == 0)
+               || atomic_load(&az->truncated)
+               || (atomic_load(&az->error) != 0);
+}
+
+/**
+ *  探索スレッドの処理.
+ *
+ *  階層毎に, 処理中の構成を一定数ずつ取得して展開する.
+ *
+ *  @param  [in,out]    arg 探索スレッドの作業領域.
+ *  @return 常に NULL が返る.
+ */
+static void *analyzer_worker(void *arg)
+{
+    struct worker *worker = (struct worker *)arg;
+    struct analyzer *az = worker->az;
+
+    for (;;) {
+        barrier_wait(&az->barrier);
+        if (az->done) {
+            break;
+        }
+        for (;;) {
+            size_t begin = atomic_fetch_add(&az->cursor, FRONTIER_CHUNK);
+            size_t end = begin + FRONTIER_CHUNK;
+            if (begin >= az->nfrontier) {
+                break;
+            }
+            if (end > az->nfrontier) {
+                end = az->nfrontier;
+            }
+            for (size_t i = begin; i < end; ++i) {
+                analyzer_expand(worker, az->frontier[i]);
+            }
+        }
+        barrier_wait(&az->barrier);
+        if (worker->id == 0) {
+            analyzer_advance(az);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  状態の深さ, 履歴状態の位置およびイベントの有無を求める.
+ *
+ *  履歴状態を構成に含めるのは, 遷移先となるコンポジット状態と,
+ *  その履歴状態となり得るコンポジット状態に限る.
+ *
+ *  @param  [in,out]    az  解析器.
+ */
+static void analyzer_prepare(struct analyzer *az)
+{
+    const struct chart *chart = az->chart;
+    const int *parents = chart->parents;
+    size_t nstates = chart->nstates;
+    bool *composite = az->live;
+    bool changed;
+    size_t i;
+    int slot = 1;
+
+    for (i = 0; i < nstates; ++i) {
+        int depth = 0;
+        for (int s = parents[i]; s >= 0; s = parents[s]) {
+            ++depth;
+        }
+        az->depths[i] = depth;
+        az->slots[i] = -1;
+        composite[i] = false;
+    }
+    for (i = 0; i < nstates; ++i) {
+        if (parents[i] >= 0) {
+            composite[parents[i]] = true;
+        }
+    }
+    for (i = 0; i < chart->ntrans; ++i) {
+        if ((chart->tos[i] >= 0) && composite[chart->tos[i]]) {
+            az->slots[chart->tos[i]] = 0;
+        }
+    }
+    do {
+        changed = false;
+        for (i = 0; i < nstates; ++i) {
+            if (composite[i] && (az->slots[i] < 0)
+                && (parents[i] >= 0) && (az->slots[parents[i]] >= 0)) {
+                az->slots[i] = 0;
+                changed = true;
+            }
+        }
+    } while (changed);
+    for (i = 0; i < nstates; ++i) {
+        if (az->slots[i] >= 0) {
+            az->slots[i] = slot++;
+        }
+    }
+    az->words = (size_t)slot;
+
+    /* 自身か祖先にイベントによる遷移があるかを求める. */
+    for (i = 0; i < nstates; ++i) {
+        az->live[i] = false;
+        for (size_t k = chart->outs[i]; k < chart->outs[i + 1]; ++k) {
+            if (chart->evs[chart->out_trans[k]] != az->null_event) {
+                az->live[i] = true;
+                break;
+            }
+        }
+    }
+    for (i = 0; i < nstates; ++i) {
+        for (int s = parents[i]; (s >= 0) && !az->live[i]; s = parents[s]) {
+            az->live[i] = az->live[s];
+        }
+    }
+}
+
+/**
+ *  解析器の使用領域を解放する.
+ *
+ *  @param  [in,out]    az  解析器.
+ */
+static void analyzer_release(struct analyzer *az)
+{
+    for (int i = 0; (az->workers != NULL) && (i < az->nworkers); ++i) {
+        struct worker *worker = &az->workers[i];
+        while (worker->arena != NULL) {
+            struct arena *next = worker->arena->next;
+            free(worker->arena);
+            worker->arena = next;
+        }
+        free(worker->next);
+        free(worker->scratch);
+        free(worker->resolved);
+    }
+    for (int i = 0; i < SHARD_COUNT; ++i) {
+        pthread_mutex_destroy(&az->shards[i].lock);
+        free(az->shards[i].configs);
+        free(az->shards[i].hashes);
+    }
+    free(az->workers);
+    free(az->frontier);
+    free(az->deadlock);
+    free(az->fired);
+    free(az->active);
+    free(az->live);
+    free(az->slots);
+    free(az->depths);
+}
+
+/**
+ *  解析器を初期化する.
+ *
+ *  @param  [out]   az          解析器.
+ *  @param  [in]    chart       状態遷移表の索引.
+ *  @param  [in]    threads     探索スレッドの数.
+ *  @param  [in]    max_configs 構成の上限.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int analyzer_init(struct analyzer *az,
+                         const struct chart *chart,
+                         int threads,
+                         size_t max_configs)
+{
+    size_t nstates = chart->nstates;
+    int i;
+
+    memset(az, 0, sizeof(*az));
+    az->chart = chart;
+    az->start = chart_state_id(chart, state_start);
+    az->end = chart_state_id(chart, state_end);
+    az->null_event = chart_event_id(chart, event_null);
+    az->max_configs = max_configs;
+    az->nworkers = threads;
+    for (i = 0; i < SHARD_COUNT; ++i) {
+        pthread_mutex_init(&az->shards[i].lock, NULL);
+        az->shards[i].mask = SHARD_MIN - 1;
+        az->shards[i].hashes = malloc(SHARD_MIN * sizeof(uint64_t));
+        az->shards[i].configs = calloc(SHARD_MIN, sizeof(uint32_t *));
+        if ((az->shards[i].hashes == NULL) || (az->shards[i].configs == NULL)) {
+            goto fail;
+        }
+    }
+
+    az->depths = malloc((nstates + 1) * sizeof(*az->depths));
+    az->slots = malloc((nstates + 1) * sizeof(*az->slots));
+    az->live = malloc((nstates + 1) * sizeof(*az->live));
+    az->active = calloc(nstates + 1, sizeof(*az->active));
+    az->fired = calloc(chart->ntrans + 1, sizeof(*az->fired));
+    az->deadlock = calloc(nstates + 1, sizeof(*az->deadlock));
+    az->workers = calloc(threads, sizeof(*az->workers));
+    if ((az->depths == NULL) || (az->slots == NULL) || (az->live == NULL)
+        || (az->active == NULL) || (az->fired == NULL) || (az->deadlock == NULL)
+        || (az->workers == NULL)) {
+        goto fail;
+    }
+    analyzer_prepare(az);
+
+    for (i = 0; i < threads; ++i) {
+        struct worker *worker = &az->workers[i];
+        worker->az = az;
+        worker->id = i;
+        worker->scratch = malloc(az->words * 2 * sizeof(*worker->scratch));
+        worker->resolved = calloc(chart->nevents + 1, sizeof(*worker->resolved));
+        if ((worker->scratch == NULL) || (worker->resolved == NULL)) {
+            goto fail;
+        }
+    }
+
+    return 0;
+
+fail:
+    analyzer_release(az);
+    errno = ENOMEM;
+    return -1;
+}
+
+/**
+ *  探索を行う.
+ *
+ *  呼び出したスレッドも探索スレッドの 1 つとして動作する.
+ *
+ *  @param  [in,out]    az  解析器.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int analyzer_run(struct analyzer *az)
+{
+    struct worker *main_worker = &az->workers[0];
+    uint32_t *config = main_worker->scratch;
+    int started = 1;
+    int ret = 0;
+
+    if (az->start < 0) {
+        return 0;
+    }
+
+    /* 初期構成は開始状態と既定の履歴状態の組とし, Null 遷移を行う. */
+    memset(config, 0, az->words * sizeof(*config));
+    config[0] = (uint32_t)az->start;
+    for (size_t i = 0; i < az->chart->nstates; ++i) {
+        if ((az->slots[i] >= 0) && (az->chart->histories[i] >= 0)) {
+            config[az->slots[i]] = (uint32_t)az->chart->histories[i] + 1;
+        }
+    }
+    analyzer_activate(az, az->start);
+    analyzer_null_step(main_worker, config);
+    analyzer_advance(az);
+
+    barrier_init(&az->barrier, az->nworkers);
+    for (; started < az->nworkers; ++started) {
+        struct worker *worker = &az->workers[started];
+        if (pthread_create(&worker->thread, NULL, analyzer_worker, worker) != 0) {
+            /* 起動できたスレッドだけで探索を続ける. */
+            barrier_shrink(&az->barrier, started);
+            break;
+        }
+    }
+    analyzer_worker(main_worker);
+    for (int i = 1; i < started; ++i) {
+        pthread_join(az->workers[i].thread, NULL);
+    }
+    barrier_destroy(&az->barrier);
+
+    if (atomic_load(&az->error) != 0) {
+        errno = atomic_load(&az->error);
+        ret = -1;
+    }
+
+    return ret;
+}
+
+/**
+ *  フラグが指定の値の要素をリストにする.
+ *
+ *  @param  [in]    flags   フラグの配列.
+ *  @param  [in]    items   要素の配列.
+ *  @param  [in]    count   要素の数.
+ *  @param  [in]    bytes   要素のサイズ.
+ *  @param  [in]    indirect    要素がポインタの配列か.
+ *  @param  [in]    want    リストにするフラグの値.
+ *  @param  [in]    skip    対象外とする要素の番号 (なしは -1).
+ *  @return 成功時は, リストが返る.
+ *          失敗時は, NULL が返る.
+ */
+static LIST analyzer_collect(const atomic_uchar *flags,
+                             const void *items,
+                             size_t count,
+                             size_t bytes,
+                             bool indirect,
+                             unsigned char want,
+                             int skip)
+{
+    size_t n = 0;
+    LIST list;
+
+    for (size_t i = 0; i < count; ++i) {
+        n += ((atomic_load(&flags[i]) == want) && ((int)i != skip));
+    }
+    list = list_init(sizeof(void *), (n > 0) ? n : 1);
+    for (size_t i = 0; (list != NULL) && (i < count); ++i) {
+        if ((atomic_load(&flags[i]) == want) && ((int)i != skip)) {
+            const void *item = (const char *)items + (bytes * i);
+            if (indirect) {
+                item = *(const void * const *)item;
+            }
+            list_add(list, (void *)&item);
+        }
+    }
+
+    return list;
+}
+
+/**
+ *  @details    @c rels と @c corresps で定義される状態マシンについて,
+ *              開始状態から到達可能な構成を列挙する.
+ *              構成は現在の状態と履歴状態の組であり, 遷移先となり得る
+ *              コンポジット状態の履歴のみを区別する.
+ *              ガード条件は成立, 不成立の両方を辿るため, 結果は実行時に
+ *              起こり得る遷移を包含する.
+ *
+ *              列挙は @c threads 個のスレッドによる幅優先探索で行い,
+ *              訪問済みの構成は分割ロック付きのハッシュ集合で共有する.
+ *
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @param      [in]    threads     探索スレッドの数. 0 以下の場合は CPU の数となる.
+ *  @param      [in]    max_configs 列挙する構成の上限. 0 の場合は無制限となる.
+ *  @return     成功時は, 解析結果が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @remarks    デッドロックする状態は, イベントによる遷移が自身にも祖先にも
+ *              ない状態とする. ただし, @ref state_end は除く.
+ */
+struct fsm_analysis *fsm_analyze(const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps,
+                                 int threads,
+                                 size_t max_configs)
+{
+    struct fsm_analysis *analysis;
+    struct chart chart;
+    struct analyzer az;
+
+    if (corresps == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (int)cpus : 1;
+    }
+
+    analysis = calloc(1, sizeof(*analysis));
+    if (analysis == NULL) {
+        return NULL;
+    }
+    if (chart_build(&chart, rels, corresps) != 0) {
+        free(analysis);
+        return NULL;
+    }
+    if (analyzer_init(&az, &chart, threads, max_configs) != 0) {
+        chart_release(&chart);
+        free(analysis);
+        return NULL;
+    }
+
+    if (analyzer_run(&az) == 0) {
+        analysis->configs = atomic_load(&az.configs);
+        analysis->truncated = atomic_load(&az.truncated);
+        analysis->unreachable_states =
+            analyzer_collect(az.active, chart.states, chart.nstates, sizeof(void *), true, 0, -1);
+        analysis->dead_transitions =
+            analyzer_collect(az.fired, chart.corresps, chart.ntrans, sizeof(struct fsm_trans), false, 0, -1);
+        analysis->deadlock_states =
+            analyzer_collect(az.deadlock, chart.states, chart.nstates, sizeof(void *), true, 1, az.end);
+    }
+    analyzer_release(&az);
+    chart_release(&chart);
+
+    if ((analysis->unreachable_states == NULL)
+        || (analysis->dead_transitions == NULL)
+        || (analysis->deadlock_states == NULL)) {
+        fsm_analysis_release(analysis);
+        return NULL;
+    }
+
+    return analysis;
+}
+
+/**
+ *  @details    @c analysis の使用領域を解放する.
+ *
+ *  @param      [in,out]    analysis    解析結果.
+ */
+void fsm_analysis_release(struct fsm_analysis *analysis)
+{
+    if (analysis != NULL) {
+        list_release(analysis->deadlock_states);
+        list_release(analysis->dead_transitions);
+        list_release(analysis->unreachable_states);
+        free(analysis);
+    }
+}
+
+/**
+ *  @details    到達可能な構成の数を取得する.
+ *
+ *  @param      [in]    analysis    解析結果.
+ *  @return     成功時は, 構成の数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+ssize_t fsm_analysis_configs(const struct fsm_analysis *analysis)
+{
+    if (analysis == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return (ssize_t)analysis->configs;
+}
+
+/**
+ *  @details    構成の上限に達して探索を打ち切ったかを取得する.
+ *              打ち切った場合, 他の結果は探索済みの範囲に基づく.
+ *
+ *  @param      [in]    analysis    解析結果.
+ *  @return     打ち切った場合は, true が返る.
+ */
+bool fsm_analysis_truncated(const struct fsm_analysis *analysis)
+{
+    return (analysis != NULL) && analysis->truncated;
+}
+
+/**
+ *  @details    到達不能な状態 (const struct fsm_state *) のリストを取得する.
+ *              リストは @c analysis と共に解放される.
+ *
+ *  @param      [in]    analysis    解析結果.
+ *  @return     成功時は, リストが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+LIST fsm_analysis_unreachable_states(const struct fsm_analysis *analysis)
+{
+    if (analysis == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return analysis->unreachable_states;
+}
+
+/**
+ *  @details    発火しない遷移 (const struct fsm_trans *) のリストを取得する.
+ *              リストは @c analysis と共に解放される.
+ *
+ *  @param      [in]    analysis    解析結果.
+ *  @return     成功時は, リストが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+LIST fsm_analysis_dead_transitions(const struct fsm_analysis *analysis)
+{
+    if (analysis == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return analysis->dead_transitions;
+}
+
+/**
+ *  @details    デッドロックする状態 (const struct fsm_state *) のリストを取得する.
+ *              リストは @c analysis と共に解放される.
+ *
+ *  @param      [in]    analysis    解析結果.
+ *  @return     成功時は, リストが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+LIST fsm_analysis_deadlock_states(const struct fsm_analysis *analysis)
+{
+    if (analysis == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return analysis->deadlock_states;
+}
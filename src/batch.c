@@ -0,0 +1,136 @@
+/** @file   batch.c
+ *  @brief  イベントの一括配信.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdlib.h>
+#include <errno.h>
+
+#include "debug.h"
+#include "batch.h"
+
+/**
+ *  イベントを積んだ状態マシンを記録する.
+ *
+ *  記録済みの状態マシンは重ねて記録しないため, 記録の数は状態マシンの数を超えない.
+ *
+ *  @param  [in,out]    batch   一括配信.
+ *  @param  [in]        machine 状態マシン.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int batch_touch(struct batch *batch, struct fsm *machine)
+{
+    if ((batch->seen.keys == NULL) && (ptr_index_init(&batch->seen, 64) != 0)) {
+        return -1;
+    }
+    if (ptr_index_find(&batch->seen, machine) >= 0) {
+        return 0;
+    }
+    if (batch->ntouched == batch->capacity) {
+        size_t capacity = (batch->capacity > 0) ? batch->capacity * 2 : 64;
+        struct fsm **touched = realloc(batch->touched, capacity * sizeof(struct fsm *));
+        if (touched == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+        batch->touched = touched;
+        batch->capacity = capacity;
+    }
+    if (ptr_index_add(&batch->seen, machine, 0) != 0) {
+        return -1;
+    }
+    batch->touched[batch->ntouched++] = machine;
+
+    return 0;
+}
+
+/**
+ *  状態マシンに積まれたイベントをすべて処理する.
+ *
+ *  @param  [in,out]    machine 状態マシン.
+ *  @return 処理したイベントの数が返る.
+ */
+static int batch_drain(struct fsm *machine)
+{
+    int count = 0;
+
+    while (fsm_dispatch(machine) > 0) {
+        ++count;
+    }
+
+    return count;
+}
+
+/**
+ *  @details    @c batch の使用領域を解放する.
+ *
+ *  @param      [in,out]    batch   一括配信.
+ */
+void batch_release(struct batch *batch)
+{
+    ptr_index_release(&batch->seen);
+    free(batch->touched);
+    batch->touched = NULL;
+    batch->ntouched = 0;
+    batch->capacity = 0;
+}
+
+/**
+ *  @details    @c machine に @c event を積み, @c machine を記録する.
+ *              キューが一杯の場合は, 積まれているイベントを処理してから積み直す.
+ *              記録できない場合は, その場で処理する.
+ *
+ *  @param      [in,out]    batch       一括配信.
+ *  @param      [in,out]    machine     状態マシン.
+ *  @param      [in]        event       積むイベント.
+ *  @param      [in]        priority    イベントの優先度.
+ *  @return     積む前 (または記録できずにその場で) 処理したイベントの数が返る.
+ */
+int batch_deliver(struct batch *batch,
+                  struct fsm *machine,
+                  const struct fsm_event *event,
+                  enum fsm_priority priority)
+{
+    int count = 0;
+
+    if (fsm_post(machine, event, priority) != 0) {
+        if (errno != ENOBUFS) {
+            return 0;
+        }
+        count = batch_drain(machine);
+        if (fsm_post(machine, event, priority) != 0) {
+            return count;
+        }
+    }
+    if (batch_touch(batch, machine) != 0) {
+        /* 記録できない場合はその場で処理する. */
+        count += batch_drain(machine);
+    }
+
+    return count;
+}
+
+/**
+ *  @details    記録した状態マシンに積まれたイベントをすべて処理し,
+ *              記録を空にする.
+ *
+ *  @param      [in,out]    batch   一括配信.
+ *  @return     処理したイベントの数が返る.
+ */
+int batch_flush(struct batch *batch)
+{
+    int count = 0;
+
+    for (size_t i = 0; i < batch->ntouched; ++i) {
+        count += batch_drain(batch->touched[i]);
+    }
+    batch->ntouched = 0;
+    ptr_index_clear(&batch->seen);
+
+    return count;
+}
@@ -0,0 +1,51 @@
+/** @file   batch.h
+ *  @brief  イベントの一括配信.
+ *
+ *  イベントを状態マシンの優先度付きキューに積み, 積んだ状態マシンを記録しておき,
+ *  最後にまとめて処理する. イベントループとイベントリングで共用する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_BATCH_H__
+#define __HFSM_BATCH_H__
+
+#include <stddef.h>
+
+#include "hfsm.h"
+#include "chart.h"
+
+/**
+ *  一括配信構造体.
+ *
+ *  ゼロで初期化した状態で使用できる.
+ */
+struct batch {
+    struct fsm **touched;   /**< イベントを積んだ状態マシン. */
+    size_t ntouched;        /**< イベントを積んだ状態マシンの数. */
+    size_t capacity;        /**< イベントを積んだ状態マシンの配列の大きさ. */
+    struct ptr_index seen;  /**< 記録済みの状態マシンの索引. */
+};
+
+/**
+ *  一括配信の使用領域を解放する.
+ */
+void batch_release(struct batch *batch);
+
+/**
+ *  状態マシンにイベントを積む.
+ */
+int batch_deliver(struct batch *batch,
+                  struct fsm *machine,
+                  const struct fsm_event *event,
+                  enum fsm_priority priority);
+
+/**
+ *  イベントを積んだ状態マシンをすべて処理する.
+ */
+int batch_flush(struct batch *batch);
+
+#endif /* __HFSM_BATCH_H__ */
@@ -0,0 +1,557 @@
+/** @file   chart.c
+ *  @brief  状態遷移表の索引に関する機能を提供する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "debug.h"
+#include "chart.h"
+
+/**
+ *  ポインタ索引の初期の大きさ.
+ */
+#define PTR_INDEX_MIN (16)
+
+/**
+ *  FNV-1a の初期値 (64 ビット).
+ */
+#define FNV64_BASIS (14695981039346656037ULL)
+
+/**
+ *  ポインタのハッシュ値を計算する.
+ *
+ *  @param  [in]    key ポインタ.
+ *  @return ハッシュ値が返る.
+ */
+static inline size_t ptr_hash(const void *key)
+{
+    uint64_t h = (uint64_t)(uintptr_t)key;
+
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+
+    return (size_t)h;
+}
+
+/**
+ *  ポインタ索引の表を指定の大きさで作り直す.
+ *
+ *  @param  [in,out]    index   ポインタ索引.
+ *  @param  [in]        size    新しい表の大きさ (2 の冪).
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ *  @pre    @c index の非 NULL は呼び出し側で保証すること.
+ */
+static int ptr_index_rehash(struct ptr_index *index, size_t size)
+{
+    const void **keys = calloc(size, sizeof(*keys));
+    int *values = malloc(size * sizeof(*values));
+    size_t i;
+
+    if ((keys == NULL) || (values == NULL)) {
+        free(values);
+        free(keys);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    for (i = 0; (index->keys != NULL) && (i <= index->mask); ++i) {
+        if (index->keys[i] != NULL) {
+            size_t pos = ptr_hash(index->keys[i]) & (size - 1);
+            while (keys[pos] != NULL) {
+                pos = (pos + 1) & (size - 1);
+            }
+            keys[pos] = index->keys[i];
+            values[pos] = index->values[i];
+        }
+    }
+    free(index->values);
+    free(index->keys);
+    index->keys = keys;
+    index->values = values;
+    index->mask = size - 1;
+
+    return 0;
+}
+
+/**
+ *  @details    要素数 @c hint 程度を収められるポインタ索引を初期化する.
+ *              要素が増えた場合は自動的に拡張する.
+ *
+ *  @param      [out]   index   ポインタ索引.
+ *  @param      [in]    hint    想定する要素の数.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int ptr_index_init(struct ptr_index *index, size_t hint)
+{
+    size_t size = PTR_INDEX_MIN;
+
+    if (index == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    while (size < hint * 2) {
+        size <<= 1;
+    }
+    index->keys = NULL;
+    index->values = NULL;
+    index->count = 0;
+
+    return ptr_index_rehash(index, size);
+}
+
+/**
+ *  @details    @c index の使用領域を解放する.
+ *
+ *  @param      [in,out]    index   ポインタ索引.
+ */
+void ptr_index_release(struct ptr_index *index)
+{
+    if (index != NULL) {
+        free(index->values);
+        free(index->keys);
+        index->keys = NULL;
+        index->values = NULL;
+    }
+}
+
+/**
+ *  @details    @c index に登録した要素をすべて削除する.
+ *              表の大きさは保つ.
+ *
+ *  @param      [in,out]    index   ポインタ索引.
+ */
+void ptr_index_clear(struct ptr_index *index)
+{
+    if ((index != NULL) && (index->keys != NULL)) {
+        memset(index->keys, 0, (index->mask + 1) * sizeof(*index->keys));
+        index->count = 0;
+    }
+}
+
+/**
+ *  @details    @c key に対応する値を検索する.
+ *
+ *  @param      [in]    index   ポインタ索引.
+ *  @param      [in]    key     キー.
+ *  @return     登録されている場合は値が返り, 登録されていない場合は -1 が返る.
+ */
+int ptr_index_find(const struct ptr_index *index, const void *key)
+{
+    size_t pos;
+
+    if ((index == NULL) || (index->keys == NULL) || (key == NULL)) {
+        return -1;
+    }
+
+    for (pos = ptr_hash(key) & index->mask;
+         index->keys[pos] != NULL;
+         pos = (pos + 1) & index->mask) {
+
+        if (index->keys[pos] == key) {
+            return index->values[pos];
+        }
+    }
+
+    return -1;
+}
+
+/**
+ *  @details    @c key に @c value を対応付ける.
+ *              すでに登録されている場合は値を更新する.
+ *
+ *  @param      [in,out]    index   ポインタ索引.
+ *  @param      [in]        key     キー.
+ *  @param      [in]        value   値.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int ptr_index_add(struct ptr_index *index, const void *key, int value)
+{
+    size_t pos;
+
+    if ((index == NULL) || (index->keys == NULL) || (key == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if ((index->count + 1) * 2 > index->mask + 1) {
+        if (ptr_index_rehash(index, (index->mask + 1) * 2) != 0) {
+            return -1;
+        }
+    }
+
+    for (pos = ptr_hash(key) & index->mask;
+         index->keys[pos] != NULL;
+         pos = (pos + 1) & index->mask) {
+
+        if (index->keys[pos] == key) {
+            index->values[pos] = value;
+            return 0;
+        }
+    }
+    index->keys[pos] = key;
+    index->values[pos] = value;
+    ++index->count;
+
+    return 0;
+}
+
+/**
+ *  索引構築中の作業領域.
+ */
+struct chart_builder {
+    struct chart *chart;         /**< 構築中の索引. */
+    const struct fsm_rels *rels; /**< 状態の関係性. */
+    struct ptr_index rels_index; /**< 状態から関係性配列の位置への索引. */
+    size_t state_capacity;       /**< 状態の配列の容量. */
+    size_t event_capacity;       /**< イベントの配列の容量. */
+};
+
+/**
+ *  状態の親を取得する.
+ *
+ *  関係性配列で指定されている場合はそちらを優先し, 指定されていない場合は
+ *  状態変数に設定されている親を返す.
+ *
+ *  @param  [in]    builder 作業領域.
+ *  @param  [in]    state   状態.
+ *  @return 親状態が返る. 親がない場合は NULL が返る.
+ */
+static const struct fsm_state *chart_parent_of(const struct chart_builder *builder,
+                                               const struct fsm_state *state)
+{
+    int pos = ptr_index_find(&builder->rels_index, state);
+
+    if (pos >= 0) {
+        return builder->rels[pos].parent;
+    }
+    return (state->variable != NULL) ? state->variable->parent : NULL;
+}
+
+/**
+ *  状態とその祖先を索引に追加する.
+ *
+ *  祖先は常に子より先に索引済みとなるため, 索引済みの状態に到達した時点で
+ *  辿るのをやめる.
+ *
+ *  @param  [in,out]    builder 作業領域.
+ *  @param  [in]        state   追加する状態.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int chart_add_state(struct chart_builder *builder, const struct fsm_state *state)
+{
+    struct chart *chart = builder->chart;
+
+    for (; state != NULL; state = chart_parent_of(builder, state)) {
+        if (ptr_index_find(&chart->state_index, state) >= 0) {
+            break;
+        }
+        if (chart->nstates == builder->state_capacity) {
+            size_t capacity = builder->state_capacity * 2;
+            const struct fsm_state **states =
+                realloc(chart->states, capacity * sizeof(*states));
+            if (states == NULL) {
+                errno = ENOMEM;
+                return -1;
+            }
+            chart->states = states;
+            builder->state_capacity = capacity;
+        }
+        if (ptr_index_add(&chart->state_index, state, (int)chart->nstates) != 0) {
+            return -1;
+        }
+        chart->states[chart->nstates++] = state;
+    }
+
+    return 0;
+}
+
+/**
+ *  イベントを索引に追加する.
+ *
+ *  @param  [in,out]    builder 作業領域.
+ *  @param  [in]        event   追加するイベント.
+ *  @return 成功時は, イベントの番号が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int chart_add_event(struct chart_builder *builder, const struct fsm_event *event)
+{
+    struct chart *chart = builder->chart;
+    int id = ptr_index_find(&chart->event_index, event);
+
+    if (id >= 0) {
+        return id;
+    }
+    if (chart->nevents == builder->event_capacity) {
+        size_t capacity = builder->event_capacity * 2;
+        const struct fsm_event **events =
+            realloc(chart->events, capacity * sizeof(*events));
+        if (events == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+        chart->events = events;
+        builder->event_capacity = capacity;
+    }
+    if (ptr_index_add(&chart->event_index, event, (int)chart->nevents) != 0) {
+        return -1;
+    }
+    chart->events[chart->nevents] = event;
+
+    return (int)chart->nevents++;
+}
+
+/**
+ *  状態と遷移を収集する.
+ *
+ *  @param  [in,out]    builder 作業領域.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int chart_collect(struct chart_builder *builder)
+{
+    struct chart *chart = builder->chart;
+    const struct fsm_rels *rels = builder->rels;
+    size_t i;
+
+    for (i = 0; (rels != NULL) && (rels[i].oneself != NULL); ++i) {
+        if (ptr_index_add(&builder->rels_index, rels[i].oneself, (int)i) != 0) {
+            return -1;
+        }
+    }
+
+    for (i = 0; i < chart->ntrans; ++i) {
+        const struct fsm_trans *corr = &chart->corresps[i];
+        if ((chart_add_state(builder, corr->from) != 0)
+            || (chart_add_state(builder, corr->to) != 0)) {
+            return -1;
+        }
+        chart->evs[i] = chart_add_event(builder, corr->event);
+        if (chart->evs[i] < 0) {
+            return -1;
+        }
+    }
+    for (i = 0; (rels != NULL) && (rels[i].oneself != NULL); ++i) {
+        if ((chart_add_state(builder, rels[i].oneself) != 0)
+            || (chart_add_state(builder, rels[i].parent) != 0)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ *  状態の親子関係と遷移の番号を設定する.
+ *
+ *  @param  [in,out]    builder 作業領域.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int chart_link(struct chart_builder *builder)
+{
+    struct chart *chart = builder->chart;
+    const struct fsm_rels *rels = builder->rels;
+    size_t *fill;
+    size_t i;
+
+    chart->parents = malloc(chart->nstates * sizeof(*chart->parents));
+    chart->histories = malloc(chart->nstates * sizeof(*chart->histories));
+    chart->outs = calloc(chart->nstates + 1, sizeof(*chart->outs));
+    chart->out_trans = malloc((chart->ntrans + 1) * sizeof(*chart->out_trans));
+    fill = malloc((chart->nstates + 1) * sizeof(*fill));
+    if ((chart->parents == NULL) || (chart->histories == NULL)
+        || (chart->outs == NULL) || (chart->out_trans == NULL) || (fill == NULL)) {
+        free(fill);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    for (i = 0; i < chart->nstates; ++i) {
+        const struct fsm_state *state = chart->states[i];
+        const struct fsm_state *history =
+            (state->variable != NULL) ? state->variable->history : NULL;
+        chart->parents[i] = chart_state_id(chart, chart_parent_of(builder, state));
+        chart->histories[i] = (rels == NULL) ? chart_state_id(chart, history) : -1;
+    }
+    for (i = 0; (rels != NULL) && (rels[i].oneself != NULL); ++i) {
+        if (rels[i].is_default && (rels[i].parent != NULL)) {
+            chart->histories[chart_state_id(chart, rels[i].parent)] =
+                chart_state_id(chart, rels[i].oneself);
+        }
+    }
+
+    /* 起点状態毎に, 表の順序を保って遷移を並べる. */
+    for (i = 0; i < chart->ntrans; ++i) {
+        const struct fsm_trans *corr = &chart->corresps[i];
+        chart->froms[i] = chart_state_id(chart, corr->from);
+        chart->tos[i] = chart_state_id(chart, corr->to);
+        ++chart->outs[chart->froms[i] + 1];
+    }
+    for (i = 0; i < chart->nstates; ++i) {
+        chart->outs[i + 1] += chart->outs[i];
+        fill[i] = chart->outs[i];
+    }
+    for (i = 0; i < chart->ntrans; ++i) {
+        chart->out_trans[fill[chart->froms[i]]++] = (int)i;
+    }
+    free(fill);
+
+    return 0;
+}
+
+/**
+ *  @details    @c corresps の状態, イベントおよび遷移に番号を割り当てる.
+ *              状態の親は @c rels の指定を優先し, 指定がない場合は状態変数に
+ *              設定されている親を用いる.
+ *              処理量は状態の数と遷移の数の和に比例する.
+ *
+ *  @param      [out]   chart       構築する索引.
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int chart_build(struct chart *chart,
+                const struct fsm_rels *rels,
+                const struct fsm_trans *corresps)
+{
+    struct chart_builder builder;
+    size_t ntrans;
+    int ret = -1;
+
+    if ((chart == NULL) || (corresps == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (ntrans = 0; corresps[ntrans].from != NULL; ++ntrans) {
+        /* 終端まで数える. */
+    }
+
+    memset(chart, 0, sizeof(*chart));
+    chart->corresps = corresps;
+    chart->ntrans = ntrans;
+    builder = (struct chart_builder){
+        .chart = chart,
+        .rels = rels,
+        .state_capacity = ntrans + PTR_INDEX_MIN,
+        .event_capacity = PTR_INDEX_MIN
+    };
+
+    chart->states = malloc(builder.state_capacity * sizeof(*chart->states));
+    chart->events = malloc(builder.event_capacity * sizeof(*chart->events));
+    chart->froms = malloc((ntrans + 1) * sizeof(*chart->froms));
+    chart->tos = malloc((ntrans + 1) * sizeof(*chart->tos));
+    chart->evs = malloc((ntrans + 1) * sizeof(*chart->evs));
+    if ((chart->states == NULL) || (chart->events == NULL) || (chart->froms == NULL)
+        || (chart->tos == NULL) || (chart->evs == NULL)) {
+        errno = ENOMEM;
+    } else if ((ptr_index_init(&chart->state_index, builder.state_capacity) == 0)
+               && (ptr_index_init(&chart->event_index, 0) == 0)
+               && (ptr_index_init(&builder.rels_index, 0) == 0)
+               && (chart_collect(&builder) == 0)
+               && (chart_link(&builder) == 0)) {
+        ret = 0;
+    }
+    ptr_index_release(&builder.rels_index);
+    if (ret != 0) {
+        chart_release(chart);
+    }
+
+    return ret;
+}
+
+/**
+ *  @details    @c chart の使用領域を解放する.
+ *
+ *  @param      [in,out]    chart   状態遷移表の索引.
+ */
+void chart_release(struct chart *chart)
+{
+    if (chart != NULL) {
+        ptr_index_release(&chart->event_index);
+        ptr_index_release(&chart->state_index);
+        free(chart->out_trans);
+        free(chart->outs);
+        free(chart->evs);
+        free(chart->tos);
+        free(chart->froms);
+        free(chart->histories);
+        free(chart->parents);
+        free(chart->events);
+        free(chart->states);
+        memset(chart, 0, sizeof(*chart));
+    }
+}
+
+/**
+ *  指紋にバイト列を加える.
+ *
+ *  @param  [in]    hash    これまでの指紋.
+ *  @param  [in]    data    バイト列.
+ *  @param  [in]    len     バイト列の長さ.
+ *  @return 更新した指紋が返る.
+ */
+static uint64_t fingerprint_update(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ *  指紋に文字列を加える.
+ *
+ *  @param  [in]    hash    これまでの指紋.
+ *  @param  [in]    s       文字列. (NULL は空文字列として扱う)
+ *  @return 更新した指紋が返る.
+ */
+static inline uint64_t fingerprint_string(uint64_t hash, const char *s)
+{
+    return fingerprint_update(hash, (s != NULL) ? s : "", (s != NULL) ? strlen(s) + 1 : 1);
+}
+
+/**
+ *  @details    状態遷移定義の指紋を求める.
+ *              状態とイベントの名前, 親子関係および遷移の構成から求めるため,
+ *              番号の割り当てが変わる変更を検出できる.
+ *
+ *  @param      [in]    chart   状態遷移表の索引.
+ *  @return     指紋が返る.
+ */
+uint64_t chart_fingerprint(const struct chart *chart)
+{
+    uint64_t hash = FNV64_BASIS;
+
+    for (size_t i = 0; i < chart->nstates; ++i) {
+        hash = fingerprint_string(hash, chart->states[i]->name);
+        hash = fingerprint_update(hash, &chart->parents[i], sizeof(chart->parents[i]));
+    }
+    for (size_t i = 0; i < chart->nevents; ++i) {
+        hash = fingerprint_string(hash, chart->events[i]->name);
+    }
+    for (size_t i = 0; i < chart->ntrans; ++i) {
+        hash = fingerprint_update(hash, &chart->froms[i], sizeof(chart->froms[i]));
+        hash = fingerprint_update(hash, &chart->evs[i], sizeof(chart->evs[i]));
+        hash = fingerprint_update(hash, &chart->tos[i], sizeof(chart->tos[i]));
+    }
+    return hash;
+}
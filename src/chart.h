@@ -0,0 +1,127 @@
+/** @file   chart.h
+ *  @brief  状態遷移表の索引に関する機能を提供する.
+ *
+ *  状態, イベントおよび遷移に通し番号を割り当て, 解析やダンプなどの
+ *  処理から番号で参照できるようにする.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_CHART_H__
+#define __HFSM_CHART_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hfsm.h"
+
+/**
+ *  ポインタ索引構造体.
+ *
+ *  ポインタから通し番号を引くためのオープンアドレス法のハッシュ表.
+ */
+struct ptr_index {
+    const void **keys; /**< キーの配列. */
+    int *values;       /**< 値の配列. */
+    size_t mask;       /**< 表の大きさ - 1. */
+    size_t count;      /**< 登録済みの要素の数. */
+};
+
+/**
+ *  状態遷移表の索引構造体.
+ *
+ *  状態の番号は, 遷移表での出現順 (状態の祖先を含む) に割り当て,
+ *  その後に関係性配列にのみ現れる状態を割り当てる.
+ */
+struct chart {
+    const struct fsm_trans *corresps; /**< 遷移の対応表. */
+    size_t ntrans;                    /**< 遷移の数. */
+
+    const struct fsm_state **states;  /**< 状態の配列. */
+    size_t nstates;                   /**< 状態の数. */
+    int *parents;                     /**< 親状態の番号 (なしは -1). */
+    int *histories;                   /**< 既定の履歴状態の番号 (なしは -1). */
+
+    const struct fsm_event **events;  /**< イベントの配列. */
+    size_t nevents;                   /**< イベントの数. */
+
+    int *froms;                       /**< 遷移毎の起点状態の番号. */
+    int *tos;                         /**< 遷移毎の遷移先状態の番号 (内部遷移は -1). */
+    int *evs;                         /**< 遷移毎のイベントの番号. */
+    size_t *outs;                     /**< 起点状態毎の遷移の開始位置 (@c nstates + 1 個). */
+    int *out_trans;                   /**< 起点状態毎に並べた遷移の番号 (表の順). */
+
+    struct ptr_index state_index;     /**< 状態の索引. */
+    struct ptr_index event_index;     /**< イベントの索引. */
+};
+
+/**
+ *  ポインタ索引を初期化する.
+ */
+int ptr_index_init(struct ptr_index *index, size_t hint);
+
+/**
+ *  ポインタ索引を解放する.
+ */
+void ptr_index_release(struct ptr_index *index);
+
+/**
+ *  ポインタ索引を空にする.
+ */
+void ptr_index_clear(struct ptr_index *index);
+
+/**
+ *  ポインタ索引から値を検索する.
+ */
+int ptr_index_find(const struct ptr_index *index, const void *key);
+
+/**
+ *  ポインタ索引に値を登録する.
+ */
+int ptr_index_add(struct ptr_index *index, const void *key, int value);
+
+/**
+ *  状態遷移表の索引を構築する.
+ */
+int chart_build(struct chart *chart,
+                const struct fsm_rels *rels,
+                const struct fsm_trans *corresps);
+
+/**
+ *  状態遷移表の索引を解放する.
+ */
+void chart_release(struct chart *chart);
+
+/**
+ *  状態遷移定義の指紋を求める.
+ */
+uint64_t chart_fingerprint(const struct chart *chart);
+
+/**
+ *  状態の番号を取得する.
+ *
+ *  @param  [in]    chart   状態遷移表の索引.
+ *  @param  [in]    state   状態.
+ *  @return 登録されている場合は番号が返り, 登録されていない場合は -1 が返る.
+ */
+static inline int chart_state_id(const struct chart *chart, const struct fsm_state *state)
+{
+    return ptr_index_find(&chart->state_index, state);
+}
+
+/**
+ *  イベントの番号を取得する.
+ *
+ *  @param  [in]    chart   状態遷移表の索引.
+ *  @param  [in]    event   イベント.
+ *  @return 登録されている場合は番号が返り, 登録されていない場合は -1 が返る.
+ */
+static inline int chart_event_id(const struct chart *chart, const struct fsm_event *event)
+{
+    return ptr_index_find(&chart->event_index, event);
+}
+
+#endif /* __HFSM_CHART_H__ */
@@ -1,7 +1,7 @@
 /** @file   collections.c
  *  @brief  コレクションに関する機能を提供する.
  *
- *  コレクション (リスト, スタック, キュー, ツリー) を提供する.
+ *  コレクション (リスト, スタック, キュー, セット, ツリー, 展開リスト, 並行キュー, マップ) を提供する.
  *
  *  @author t-kenji <protect.2501@gmail.com>
  *  @date   2018-03-18 新規作成.
@@ -9,15 +9,127 @@
  *
  *  This code is licensed under the MIT License.
  */
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 #include "collections.h"
 #include "debug.h"
 
+/**
+ *  ノードを確保する単位 (スラブ) の管理構造体.
+ *  ノードは管理構造体の直後に連続して置く.
+ */
+struct slab {
+    struct slab *next;  /**< 次のスラブ. */
+    size_t count;       /**< ノードの数. */
+    size_t nfree;       /**< 縮小時に数える, 解放済みのノードの数. */
+};
+
+/**
+ *  スラブの管理構造体のサイズ.
+ *  ノードのデータ部の境界を保つよう, 最大の境界に切り上げる.
+ */
+#define SLAB_HEADER_BYTES \
+    ((sizeof(struct slab) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+
+/**
+ *  スラブの @c index 番目のノードを取得する.
+ *
+ *  @param  [in]    slab        スラブ.
+ *  @param  [in]    node_bytes  ノードのサイズ.
+ *  @param  [in]    index       ノードの位置.
+ *  @return ノードのポインタが返る.
+ */
+static inline void *slab_node(const struct slab *slab, size_t node_bytes, size_t index)
+{
+    return (void *)((uintptr_t)slab + SLAB_HEADER_BYTES + (node_bytes * index));
+}
+
+/**
+ *  @c count 個のノードを持つスラブを確保する.
+ *
+ *  @param  [in]    count       ノードの数.
+ *  @param  [in]    node_bytes  ノードのサイズ.
+ *  @return 成功時は, スラブのポインタが返る.
+ *          失敗時は, NULL が返り, errno が適切に設定される.
+ */
+static struct slab *slab_alloc(size_t count, size_t node_bytes)
+{
+    struct slab *slab;
+
+    if (count > (SIZE_MAX - SLAB_HEADER_BYTES) / node_bytes) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    slab = calloc(1, SLAB_HEADER_BYTES + (node_bytes * count));
+    if (slab == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    slab->count = count;
+
+    return slab;
+}
+
+/**
+ *  スラブの連鎖をすべて解放する.
+ *
+ *  @param  [in,out]    slab    先頭のスラブ.
+ */
+static void slab_free_all(struct slab *slab)
+{
+    while (slab != NULL) {
+        struct slab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+}
+
+/**
+ *  @c node を含むスラブを探す.
+ *
+ *  @param  [in]    slab        先頭のスラブ.
+ *  @param  [in]    node        ノード.
+ *  @param  [in]    node_bytes  ノードのサイズ.
+ *  @return @c node を含むスラブが返る. 含むものがなければ NULL が返る.
+ */
+static struct slab *slab_owner(struct slab *slab, const void *node, size_t node_bytes)
+{
+    for (; slab != NULL; slab = slab->next) {
+        uintptr_t begin = (uintptr_t)slab_node(slab, node_bytes, 0);
+        if (((uintptr_t)node >= begin) && ((uintptr_t)node < begin + (node_bytes * slab->count))) {
+            return slab;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  自動拡張で追加するノードの数を求める.
+ *  現在の容量と同じ数だけ追加し, 上限を超える場合は上限までとする.
+ *
+ *  @param  [in]    capacity    現在の容量.
+ *  @param  [in]    limit       容量の上限.
+ *  @return 追加するノードの数が返る. 上限に達している場合は 0 が返る.
+ */
+static inline size_t slab_grow_count(size_t capacity, size_t limit)
+{
+    if (capacity >= limit) {
+        return 0;
+    }
+    return ((limit - capacity) < capacity) ? (limit - capacity) : capacity;
+}
+
 /**
  *  リストノード構造体.
  */
@@ -40,27 +152,198 @@ struct list_node {
  *  リスト管理構造体.
  */
 struct list {
-    void *pool;                 /**< リストで使用するメモリプール. */
+    struct slab *slabs;         /**< ノードのスラブ. 末尾が初期に確保したもの. */
     struct list_node *released; /**< 解放済みノードのリスト. */
     struct list_node *root;     /**< 使用中の先頭ノード. */
     struct list_node *last;     /**< 使用中の末尾ノード. */
     size_t payload_bytes;       /**< データ部のサイズ. */
     size_t capacity;            /**< 確保したノードの数. */
+    size_t limit;               /**< 自動拡張する容量の上限. */
     size_t count;               /**< 使用中のノードの数. */
 };
 
 /**
  *  リスト管理構造体の初期化子.
  */
-#define LIST_INITIALIZER(p, b, c) \
-    (struct list){                \
-        .pool = (p),              \
-        .released = NULL,         \
-        .root = NULL,             \
-        .last = NULL,             \
-        .payload_bytes = (b),     \
-        .capacity = (c),          \
-        .count = 0                \
+#define LIST_INITIALIZER(p, b, c, l) \
+    (struct list){                   \
+        .slabs = (p),                \
+        .released = NULL,            \
+        .root = NULL,                \
+        .last = NULL,                \
+        .payload_bytes = (b),        \
+        .capacity = (c),             \
+        .limit = (l),                \
+        .count = 0                   \
+    }
+
+/**
+ *  スタック管理構造体.
+ *
+ *  要素は連続した配列に置く. 各要素は @ref list_node と同じ形で,
+ *  @c next に 1 つ下の要素を予め設定しておくことで,
+ *  リストと同じ @ref iter_next で辿れるようにする.
+ */
+struct stack {
+    void *cells;                /**< 要素の配列. */
+    size_t cell_bytes;          /**< 1 要素のサイズ. */
+    size_t payload_bytes;       /**< データ部のサイズ. */
+    size_t capacity;            /**< 確保した要素の数. */
+    size_t count;               /**< 積まれている要素の数. */
+};
+
+/**
+ *  スタック管理構造体の初期化子.
+ */
+#define STACK_INITIALIZER(p, cb, b, c) \
+    (struct stack){                    \
+        .cells = (p),                  \
+        .cell_bytes = (cb),            \
+        .payload_bytes = (b),          \
+        .capacity = (c),               \
+        .count = 0                     \
+    }
+
+/**
+ *  データ部が @c b バイトの, 配列やスラブに並べる @c type 型のノードのサイズ.
+ *  後続のノードがずれないよう, @c type の境界に切り上げる.
+ */
+#define NODE_BYTES(type, b) \
+    ((sizeof(type) + (b) + _Alignof(type) - 1) & ~(_Alignof(type) - 1))
+
+/**
+ *  @ref NODE_BYTES が桁溢れしない, データ部の最大のサイズ.
+ */
+#define NODE_PAYLOAD_MAX(type) \
+    (SIZE_MAX - sizeof(type) - (_Alignof(type) - 1))
+
+struct queue;
+
+/**
+ *  キューの反復子が指す要素.
+ *
+ *  リングバッファの要素毎に 1 つ置き, 反復子からキューを辿れるようにする.
+ */
+struct queue_link {
+    struct queue *owner;        /**< 要素を持つキュー. */
+};
+
+/**
+ *  キュー管理構造体.
+ *
+ *  要素は 2 のべき乗の大きさのリングバッファに置く.
+ *  @c head と @c tail は折り返さない通し番号で, 位置は @c mask で求める.
+ */
+struct queue {
+    void *ring;                 /**< 要素のリングバッファ. */
+    struct queue_link *links;   /**< 反復子のための要素毎の管理情報. */
+    size_t payload_bytes;       /**< データ部のサイズ. */
+    size_t capacity;            /**< 積める要素の数. */
+    size_t mask;                /**< リングバッファの大きさ - 1. */
+    size_t head;                /**< 先頭の要素の位置. */
+    size_t tail;                /**< 次に追加する要素の位置. */
+};
+
+/**
+ *  キュー管理構造体の初期化子.
+ */
+#define QUEUE_INITIALIZER(r, l, b, c, m) \
+    (struct queue){                      \
+        .ring = (r),                     \
+        .links = (l),                    \
+        .payload_bytes = (b),            \
+        .capacity = (c),                 \
+        .mask = (m),                     \
+        .head = 0,                       \
+        .tail = 0                        \
+    }
+
+/**
+ *  キューの反復子を表すタグ.
+ *  リストノードとキューの要素はいずれもポインタの境界に置かれるため,
+ *  最下位ビットでキューの反復子を見分ける.
+ */
+#define QUEUE_ITER_TAG ((uintptr_t)1)
+
+/**
+ *  キューの要素 @c l の反復子.
+ */
+#define QUEUE_ITER(l) ((ITER)((uintptr_t)(l) | QUEUE_ITER_TAG))
+
+/**
+ *  反復子がキューの要素を指していれば, その要素を返す.
+ */
+#define QUEUE_LINK(i)                                                 \
+    ((((uintptr_t)(i)) & QUEUE_ITER_TAG)                              \
+         ? (struct queue_link *)((uintptr_t)(i) & ~QUEUE_ITER_TAG)    \
+         : NULL)
+
+/**
+ *  キューの位置 @c pos の要素のデータ部を取得する.
+ *
+ *  @param  [in]    self    キューオブジェクト.
+ *  @param  [in]    pos     要素の位置 (折り返す前の通し番号).
+ *  @return データ部のポインタが返る.
+ *  @pre    @c self の非 NULL は呼び出し側で保証すること.
+ */
+static inline void *queue_slot(const struct queue *self, size_t pos)
+{
+    return (void *)((uintptr_t)self->ring + (self->payload_bytes * (pos & self->mask)));
+}
+
+/**
+ *  セットのハッシュ表の空きバケットを表す要素の位置.
+ */
+#define SET_EMPTY (UINT32_MAX)
+
+/**
+ *  セットの容量の上限.
+ */
+#define SET_CAPACITY_MAX ((size_t)(UINT32_MAX / 2))
+
+/**
+ *  セットのハッシュ表のバケット.
+ */
+struct set_bucket {
+    uint32_t hash;              /**< 要素のハッシュ値 (下位 32 ビット). */
+    uint32_t index;             /**< 要素の位置. 空きの場合は @ref SET_EMPTY. */
+};
+
+/**
+ *  セット管理構造体.
+ *
+ *  要素は @ref list_node と同じ形で追加順に連続した配列に置き,
+ *  要素の位置をハッシュ表で引く. 要素の @c next は次の要素を指し,
+ *  最後の要素のみ NULL とする.
+ */
+struct set {
+    void *cells;                /**< 要素の配列. */
+    struct set_bucket *buckets; /**< ハッシュ表. */
+    size_t cell_bytes;          /**< 1 要素のサイズ. */
+    size_t payload_bytes;       /**< データ部のサイズ. */
+    size_t key_bytes;           /**< データ部の先頭のうち, ハッシュと等価判定に用いるサイズ. */
+    size_t capacity;            /**< 確保した要素の数. */
+    size_t mask;                /**< ハッシュ表の大きさ - 1. */
+    size_t count;               /**< 追加されている要素の数. */
+    size_t (*hash)(const void *payload, size_t bytes);          /**< ハッシュ関数. */
+    bool (*equal)(const void *a, const void *b, size_t bytes);  /**< 等価判定関数. */
+};
+
+/**
+ *  セット管理構造体の初期化子.
+ */
+#define SET_INITIALIZER(p, h, cb, b, c, m) \
+    (struct set){                          \
+        .cells = (p),                      \
+        .buckets = (h),                    \
+        .cell_bytes = (cb),                \
+        .payload_bytes = (b),              \
+        .key_bytes = (b),                  \
+        .capacity = (c),                   \
+        .mask = (m),                       \
+        .count = 0,                        \
+        .hash = NULL,                      \
+        .equal = NULL                      \
     }
 
 /**
@@ -83,6 +366,38 @@ static inline void list_push_released(struct list *self, struct list_node *node)
     self->released = node;
 }
 
+/**
+ *  リストの容量が上限に達していなければ, スラブを追加する.
+ *
+ *  @param  [in,out]    self    リストオブジェクト.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ *  @pre    @c self の非 NULL は呼び出し側で保証すること.
+ */
+static int list_grow(struct list *self)
+{
+    size_t node_bytes = NODE_BYTES(struct list_node, self->payload_bytes);
+    size_t count = slab_grow_count(self->capacity, self->limit);
+    struct slab *slab;
+
+    if (count == 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    slab = slab_alloc(count, node_bytes);
+    if (slab == NULL) {
+        return -1;
+    }
+    slab->next = self->slabs;
+    self->slabs = slab;
+    self->capacity += count;
+    for (size_t i = 0; i < count; ++i) {
+        list_push_released(self, slab_node(slab, node_bytes, i));
+    }
+
+    return 0;
+}
+
 /**
  *  解放済みノードのリストからノードを取得する.
  *
@@ -95,6 +410,9 @@ static inline struct list_node *list_pop_released(struct list *self)
 {
     struct list_node *node = self->released;
 
+    if ((node == NULL) && (list_grow(self) == 0)) {
+        node = self->released;
+    }
     if (node == NULL) {
         errno = ENOMEM;
         return NULL;
@@ -112,26 +430,28 @@ static inline struct list_node *list_pop_released(struct list *self)
  *  リストの初期設定を行う.
  *
  *  @param  [in,out]    self            リストオブジェクト.
- *  @param  [in]        pool            リストに使用するメモリプール.
+ *  @param  [in]        slabs           リストに使用するスラブ.
  *  @param  [in]        payload_bytes   データ部のサイズ.
  *  @param  [in]        capacity        リストの容量.
+ *  @param  [in]        limit           自動拡張する容量の上限.
  *  @pre    @c self の非 NULL は呼び出し側で保証すること.
- *  @pre    @c pool の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c slabs の非 NULL は呼び出し側で保証すること.
  */
 static inline void list_setup(struct list *self,
-                              void *pool,
+                              struct slab *slabs,
                               size_t payload_bytes,
-                              size_t capacity)
+                              size_t capacity,
+                              size_t limit)
 {
     size_t node_bytes;
-    struct list_node *node;
-    size_t i;
+    struct slab *slab;
 
-    *self = LIST_INITIALIZER(pool, payload_bytes, capacity);
-    node_bytes = sizeof(*node) + self->payload_bytes;
-    for (i = 0; i < self->capacity; ++i) {
-        node = (struct list_node *)((uintptr_t)self->pool + (node_bytes * i));
-        list_push_released(self, node);
+    *self = LIST_INITIALIZER(slabs, payload_bytes, capacity, limit);
+    node_bytes = NODE_BYTES(struct list_node, self->payload_bytes);
+    for (slab = self->slabs; slab != NULL; slab = slab->next) {
+        for (size_t i = 0; i < slab->count; ++i) {
+            list_push_released(self, slab_node(slab, node_bytes, i));
+        }
     }
 }
 
@@ -145,10 +465,23 @@ static inline void list_setup(struct list *self,
  */
 ITER iter_next(ITER iter)
 {
+    struct queue_link *link;
+
     if (iter == NULL) {
         errno = EINVAL;
         return NULL;
     }
+    link = QUEUE_LINK(iter);
+    if (link != NULL) {
+        const struct queue *que = link->owner;
+        size_t pos = (size_t)(link - que->links);
+
+        /* 先頭からの順番に直し, 末尾に達していれば終わり. */
+        if (((pos - que->head) & que->mask) + 1 >= que->tail - que->head) {
+            return NULL;
+        }
+        return QUEUE_ITER(&que->links[(pos + 1) & que->mask]);
+    }
     return (ITER)((struct list_node *)iter)->next;
 }
 
@@ -162,10 +495,16 @@ ITER iter_next(ITER iter)
  */
 void *iter_get_payload(ITER iter)
 {
+    struct queue_link *link;
+
     if (iter == NULL) {
         errno = EINVAL;
         return NULL;
     }
+    link = QUEUE_LINK(iter);
+    if (link != NULL) {
+        return queue_slot(link->owner, (size_t)(link - link->owner->links));
+    }
     return ((struct list_node *)iter)->payload;
 }
 
@@ -181,8 +520,7 @@ void *iter_get_payload(ITER iter)
 LIST list_init(size_t payload_bytes, size_t capacity)
 {
     struct list *self;
-    size_t node_bytes;
-    void *pool;
+    struct slab *slab;
 
     if ((payload_bytes == 0) || (capacity == 0)) {
         errno = EINVAL;
@@ -190,16 +528,15 @@ LIST list_init(size_t payload_bytes, size_t capacity)
     }
 
     self = malloc(sizeof(*self));
-    node_bytes = sizeof(struct list_node) + payload_bytes;
-    pool = calloc(capacity, node_bytes);
-    if ((self == NULL) || (pool == NULL)) {
-        free(pool);
+    slab = slab_alloc(capacity, NODE_BYTES(struct list_node, payload_bytes));
+    if ((self == NULL) || (slab == NULL)) {
+        free(slab);
         free(self);
         errno = ENOMEM;
         return NULL;
     }
 
-    list_setup(self, pool, payload_bytes, capacity);
+    list_setup(self, slab, payload_bytes, capacity, capacity);
 
     return (LIST)self;
 }
@@ -216,7 +553,7 @@ void list_release(LIST list)
     struct list *self = (struct list *)list;
 
     if (self != NULL) {
-        free(self->pool);
+        slab_free_all(self->slabs);
         free(self);
     }
 }
@@ -238,11 +575,101 @@ int list_clear(LIST list)
         return -1;
     }
 
-    list_setup(self, self->pool, self->payload_bytes, self->capacity);
+    list_setup(self, self->slabs, self->payload_bytes, self->capacity, self->limit);
+
+    return 0;
+}
+
+/**
+ *  @details    @c list の要素が容量を超えて追加される場合に,
+ *              @c limit を上限として容量を自動で拡張するようにする.
+ *              拡張はその時点の容量と同じ数のノードを持つスラブを追加して行い,
+ *              既存のノードは移動しないため, 返したデータ部のポインタは
+ *              有効なままとなる.
+ *              @c limit に現在の容量を指定すると拡張しなくなる.
+ *
+ *  @param      [in,out]    list    リストオブジェクト.
+ *  @param      [in]        limit   容量の上限. 上限を設けない場合は SIZE_MAX.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int list_set_growth(LIST list, size_t limit)
+{
+    struct list *self = (struct list *)list;
+
+    if ((self == NULL) || (limit < self->capacity)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    self->limit = limit;
 
     return 0;
 }
 
+/**
+ *  @details    @c list の拡張で追加したスラブのうち,
+ *              すべてのノードが未使用のものを解放する.
+ *              @ref list_init で確保した分は解放しない.
+ *
+ *  @param      [in,out]    list    リストオブジェクト.
+ *  @return     成功時は, 縮小後の容量が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+ssize_t list_shrink(LIST list)
+{
+    struct list *self = (struct list *)list;
+    size_t node_bytes;
+    struct list_node *node, *next;
+    struct slab **link;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    node_bytes = NODE_BYTES(struct list_node, self->payload_bytes);
+
+    /* スラブ毎に未使用のノードを数える. */
+    for (struct slab *slab = self->slabs; slab != NULL; slab = slab->next) {
+        slab->nfree = 0;
+    }
+    for (node = self->released; node != NULL; node = node->next) {
+        ++slab_owner(self->slabs, node, node_bytes)->nfree;
+    }
+
+    /* 解放するスラブのノードを解放済みノードのリストから外す. */
+    for (node = self->released; node != NULL; node = next) {
+        struct slab *slab = slab_owner(self->slabs, node, node_bytes);
+        next = node->next;
+        if ((slab->next != NULL) && (slab->nfree == slab->count)) {
+            if (node->prev == NULL) {
+                self->released = next;
+            } else {
+                node->prev->next = next;
+            }
+            if (next != NULL) {
+                next->prev = node->prev;
+            }
+        }
+    }
+
+    /* 初期に確保したスラブ (末尾) は残す. */
+    for (link = &self->slabs; (*link)->next != NULL;) {
+        struct slab *slab = *link;
+        if (slab->nfree == slab->count) {
+            *link = slab->next;
+            self->capacity -= slab->count;
+            free(slab);
+        } else {
+            link = &slab->next;
+        }
+    }
+
+    return (ssize_t)self->capacity;
+}
+
 /**
  *  リストの先頭にノードを追加する.
  *
@@ -494,9 +921,24 @@ int list_to_array(LIST list, void **array, size_t *count)
     return 0;
 }
 
+/**
+ *  スタックの要素を取得する.
+ *
+ *  @param  [in]    self    スタックオブジェクト.
+ *  @param  [in]    index   要素の位置 (底が 0).
+ *  @return 要素のポインタが返る.
+ *  @pre    @c self の非 NULL は呼び出し側で保証すること.
+ */
+static inline struct list_node *stack_cell(const struct stack *self, size_t index)
+{
+    return (struct list_node *)((uintptr_t)self->cells + (self->cell_bytes * index));
+}
+
 /**
  *  @details    空で, 指定の容量を備えた, @ref STACK オブジェクトを確保
  *              および初期化する.
+ *              要素は連続した配列に置き, 反復子のための隣接要素へのリンクは
+ *              ここで一度だけ張る.
  *
  *  @param      [in]    payload_bytes   データ部のサイズ.
  *  @param      [in]    capacity        スタックの容量.
@@ -505,7 +947,33 @@ int list_to_array(LIST list, void **array, size_t *count)
  */
 STACK stack_init(size_t payload_bytes, size_t capacity)
 {
-    return (STACK)list_init(payload_bytes, capacity);
+    struct stack *self;
+    size_t cell_bytes;
+    void *cells;
+
+    if ((payload_bytes == 0) || (capacity == 0)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    self = malloc(sizeof(*self));
+    cell_bytes = NODE_BYTES(struct list_node, payload_bytes);
+    cells = calloc(capacity, cell_bytes);
+    if ((self == NULL) || (cells == NULL)) {
+        free(cells);
+        free(self);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    *self = STACK_INITIALIZER(cells, cell_bytes, payload_bytes, capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        struct list_node *cell = stack_cell(self, i);
+        cell->prev = (i + 1 < capacity) ? stack_cell(self, i + 1) : NULL;
+        cell->next = (i > 0) ? stack_cell(self, i - 1) : NULL;
+    }
+
+    return (STACK)self;
 }
 
 /**
@@ -517,7 +985,12 @@ STACK stack_init(size_t payload_bytes, size_t capacity)
  */
 void stack_release(STACK stack)
 {
-    list_release((LIST)stack);
+    struct stack *self = (struct stack *)stack;
+
+    if (self != NULL) {
+        free(self->cells);
+        free(self);
+    }
 }
 
 /**
@@ -530,7 +1003,16 @@ void stack_release(STACK stack)
  */
 int stack_clear(STACK stack)
 {
-    return list_clear((LIST)stack);
+    struct stack *self = (struct stack *)stack;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    self->count = 0;
+
+    return 0;
 }
 
 /**
@@ -544,7 +1026,22 @@ int stack_clear(STACK stack)
  */
 void *stack_push(STACK stack, void *payload)
 {
-    return list_insert((LIST)stack, 0, payload);
+    struct stack *self = (struct stack *)stack;
+    struct list_node *cell;
+
+    if ((self == NULL) || (payload == NULL)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (self->count >= self->capacity) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    cell = stack_cell(self, self->count++);
+    memcpy(cell->payload, payload, self->payload_bytes);
+
+    return cell->payload;
 }
 
 /**
@@ -558,22 +1055,20 @@ void *stack_push(STACK stack, void *payload)
  */
 int stack_pop(STACK stack, void *payload)
 {
-    LIST list = (LIST)stack;
-    ITER iter = list_iter(list);
+    struct stack *self = (struct stack *)stack;
 
-    if ((list == NULL) || (payload == NULL)) {
+    if ((self == NULL) || (payload == NULL)) {
         errno = EINVAL;
         return -1;
     }
-    if (iter == NULL) {
+    if (self->count == 0) {
         errno = EAGAIN;
         return -1;
     }
 
-    memcpy(payload, iter_get_payload(iter), list_payload_bytes(list));
-    list_remove(list, iter);
+    memcpy(payload, stack_cell(self, --self->count)->payload, self->payload_bytes);
 
-    return list_count(list);
+    return (int)self->count;
 }
 
 /**
@@ -586,11 +1081,19 @@ int stack_pop(STACK stack, void *payload)
  */
 ssize_t stack_count(STACK stack)
 {
-    return list_count((LIST)stack);
+    struct stack *self = (struct stack *)stack;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return (ssize_t)self->count;
 }
 
 /**
  *  @details    @c stack の反復子を取得する.
+ *              最後に積んだ要素から順に辿る.
  *
  *  @code
  *  for (ITER iter = stack_iter(stack);
@@ -608,21 +1111,94 @@ ssize_t stack_count(STACK stack)
  */
 ITER stack_iter(STACK stack)
 {
-    return list_iter((LIST)stack);
+    struct stack *self = (struct stack *)stack;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (self->count == 0) {
+        return NULL;
+    }
+    return (ITER)stack_cell(self, self->count - 1);
 }
 
 /**
- *  @details    空で, 指定の容量を備えた, @ref QUEUE オブジェクトを
- *              確保および初期化する.
+ *  キューの位置 @c pos から @c n 個の要素を @c buf との間でコピーする.
+ *  リングの末尾で折り返す場合も, memcpy は高々 2 回で済む.
  *
- *  @param      [in]    payload_bytes   データ部のサイズ.
- *  @param      [in]    capacity        キューの容量.
- *  @return     成功時は, 確保および初期化したオブジェクトのポインタが返る.
+ *  @param  [in]        self    キューオブジェクト.
+ *  @param  [in]        pos     先頭の要素の位置.
+ *  @param  [in,out]    buf     コピー元またはコピー先のバッファ.
+ *  @param  [in]        n       要素の数.
+ *  @param  [in]        to_ring @c buf からリングへコピーする場合は true.
+ *  @pre    @c self の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c n はキューの容量以下であること.
+ */
+static inline void queue_copy(const struct queue *self, size_t pos, void *buf, size_t n, bool to_ring)
+{
+    size_t first = self->mask + 1 - (pos & self->mask);
+    size_t bytes;
+
+    if (n == 0) {
+        return;
+    }
+    if (first > n) {
+        first = n;
+    }
+    bytes = self->payload_bytes * first;
+    if (to_ring) {
+        memcpy(queue_slot(self, pos), buf, bytes);
+        memcpy(self->ring, (void *)((uintptr_t)buf + bytes), self->payload_bytes * (n - first));
+    } else {
+        memcpy(buf, queue_slot(self, pos), bytes);
+        memcpy((void *)((uintptr_t)buf + bytes), self->ring, self->payload_bytes * (n - first));
+    }
+}
+
+/**
+ *  @details    空で, 指定の容量を備えた, @ref QUEUE オブジェクトを
+ *              確保および初期化する.
+ *              要素は容量以上の 2 のべき乗の大きさのリングバッファに置くが,
+ *              積める要素の数は @c capacity までとする.
+ *
+ *  @param      [in]    payload_bytes   データ部のサイズ.
+ *  @param      [in]    capacity        キューの容量.
+ *  @return     成功時は, 確保および初期化したオブジェクトのポインタが返る.
  *              失敗時は, NULL が返り, errno が適切に設定される.
  */
 QUEUE queue_init(size_t payload_bytes, size_t capacity)
 {
-    return (QUEUE)list_init(payload_bytes, capacity);
+    struct queue *self;
+    size_t slots = 1;
+    void *ring;
+    struct queue_link *links;
+
+    if ((payload_bytes == 0) || (capacity == 0) || (capacity > (SIZE_MAX / 2) / payload_bytes)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+
+    self = malloc(sizeof(*self));
+    ring = calloc(slots, payload_bytes);
+    links = calloc(slots, sizeof(*links));
+    if ((self == NULL) || (ring == NULL) || (links == NULL)) {
+        free(links);
+        free(ring);
+        free(self);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    *self = QUEUE_INITIALIZER(ring, links, payload_bytes, capacity, slots - 1);
+    for (size_t i = 0; i < slots; ++i) {
+        links[i].owner = self;
+    }
+
+    return (QUEUE)self;
 }
 
 /**
@@ -634,7 +1210,13 @@ QUEUE queue_init(size_t payload_bytes, size_t capacity)
  */
 void queue_release(QUEUE que)
 {
-    list_release((LIST)que);
+    struct queue *self = (struct queue *)que;
+
+    if (self != NULL) {
+        free(self->links);
+        free(self->ring);
+        free(self);
+    }
 }
 
 /**
@@ -647,7 +1229,16 @@ void queue_release(QUEUE que)
  */
 int queue_clear(QUEUE que)
 {
-    return list_clear((LIST)que);
+    struct queue *self = (struct queue *)que;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    self->head = self->tail = 0;
+
+    return 0;
 }
 
 /**
@@ -661,7 +1252,22 @@ int queue_clear(QUEUE que)
  */
 void *queue_enq(QUEUE que, void *payload)
 {
-    return list_insert((LIST)que, -1, payload);
+    struct queue *self = (struct queue *)que;
+    void *slot;
+
+    if ((self == NULL) || (payload == NULL)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (self->tail - self->head >= self->capacity) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    slot = queue_slot(self, self->tail++);
+    memcpy(slot, payload, self->payload_bytes);
+
+    return slot;
 }
 
 /**
@@ -675,22 +1281,82 @@ void *queue_enq(QUEUE que, void *payload)
  */
 int queue_deq(QUEUE que, void *payload)
 {
-    LIST list = (LIST)que;
-    ITER iter = list_iter(list);
+    struct queue *self = (struct queue *)que;
 
-    if ((list == NULL) || (payload == NULL)) {
+    if ((self == NULL) || (payload == NULL)) {
         errno = EINVAL;
         return -1;
     }
-    if (iter == NULL) {
+    if (self->tail == self->head) {
         errno = EAGAIN;
         return -1;
     }
 
-    memcpy(payload, iter_get_payload(iter), list_payload_bytes(list));
-    list_remove(list, iter);
+    memcpy(payload, queue_slot(self, self->head++), self->payload_bytes);
+
+    return (int)(self->tail - self->head);
+}
+
+/**
+ *  @details    @c que の最後に @c payloads の先頭から最大 @c n 個の要素を
+ *              追加する. 空きが足りない場合は, 空きの分だけ追加する.
+ *
+ *  @param      [in,out]    que         キューオブジェクト.
+ *  @param      [in]        payloads    追加するデータの配列.
+ *  @param      [in]        n           追加するデータの数.
+ *  @return     成功時は, 追加した要素の数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+ssize_t queue_enq_bulk(QUEUE que, const void *payloads, size_t n)
+{
+    struct queue *self = (struct queue *)que;
+    size_t room;
+
+    if ((self == NULL) || ((payloads == NULL) && (n > 0))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    room = self->capacity - (self->tail - self->head);
+    if (n > room) {
+        n = room;
+    }
+    queue_copy(self, self->tail, (void *)payloads, n, true);
+    self->tail += n;
+
+    return (ssize_t)n;
+}
+
+/**
+ *  @details    @c que の先頭から最大 @c n 個の要素を @c payloads にコピーし,
+ *              削除する.
+ *
+ *  @param      [in,out]    que         キューオブジェクト.
+ *  @param      [out]       payloads    データ部をコピーする配列.
+ *  @param      [in]        n           取り出す要素の最大数.
+ *  @return     成功時は, 取り出した要素の数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+ssize_t queue_deq_bulk(QUEUE que, void *payloads, size_t n)
+{
+    struct queue *self = (struct queue *)que;
+    size_t count;
+
+    if ((self == NULL) || ((payloads == NULL) && (n > 0))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    count = self->tail - self->head;
+    if (n > count) {
+        n = count;
+    }
+    queue_copy(self, self->head, payloads, n, false);
+    self->head += n;
 
-    return list_count(list);
+    return (ssize_t)n;
 }
 
 /**
@@ -703,11 +1369,19 @@ int queue_deq(QUEUE que, void *payload)
  */
 ssize_t queue_count(QUEUE que)
 {
-    return list_count((LIST)que);
+    struct queue *self = (struct queue *)que;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return (ssize_t)(self->tail - self->head);
 }
 
 /**
  *  @details    @c que の反復子を取得する.
+ *              反復子の途中で要素を追加または削除してはならない.
  *
  *  @code
  *  for (ITER iter = queue_iter(que);
@@ -725,7 +1399,16 @@ ssize_t queue_count(QUEUE que)
  */
 ITER queue_iter(QUEUE que)
 {
-    return list_iter((LIST)que);
+    struct queue *self = (struct queue *)que;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (self->tail == self->head) {
+        return NULL;
+    }
+    return QUEUE_ITER(&self->links[self->head & self->mask]);
 }
 
 /**
@@ -742,12 +1425,133 @@ ITER queue_iter(QUEUE que)
 
 int queue_to_array(QUEUE que, void **array, size_t *count)
 {
-    return list_to_array((LIST)que, array, count);
+    struct queue *self = (struct queue *)que;
+    size_t n;
+    void *buf;
+
+    if ((self == NULL) || (array == NULL) || (count == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    n = self->tail - self->head;
+    buf = malloc(self->payload_bytes * n);
+    if (buf == NULL) {
+        return -1;
+    }
+    queue_copy(self, self->head, buf, n, false);
+    *array = buf;
+    *count = n;
+
+    return 0;
+}
+
+/**
+ *  セットの要素を取得する.
+ *
+ *  @param  [in]    self    セットオブジェクト.
+ *  @param  [in]    index   要素の位置 (追加順).
+ *  @return 要素のポインタが返る.
+ *  @pre    @c self の非 NULL は呼び出し側で保証すること.
+ */
+static inline struct list_node *set_cell(const struct set *self, size_t index)
+{
+    return (struct list_node *)((uintptr_t)self->cells + (self->cell_bytes * index));
+}
+
+/**
+ *  既定のハッシュ関数.
+ *  8 バイト毎に乗算で混ぜ, 最後に全ビットを拡散させる.
+ *
+ *  @param  [in]    payload データ.
+ *  @param  [in]    bytes   データのサイズ.
+ *  @return ハッシュ値が返る.
+ */
+static size_t set_default_hash(const void *payload, size_t bytes)
+{
+    const unsigned char *p = payload;
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ bytes;
+    uint64_t chunk;
+
+    for (; bytes >= sizeof(chunk); bytes -= sizeof(chunk), p += sizeof(chunk)) {
+        memcpy(&chunk, p, sizeof(chunk));
+        h = (h ^ chunk) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    if (bytes > 0) {
+        chunk = 0;
+        memcpy(&chunk, p, bytes);
+        h = (h ^ chunk) * 0xFF51AFD7ED558CCDULL;
+    }
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+
+    return (size_t)h;
+}
+
+/**
+ *  既定の等価判定関数.
+ *
+ *  @param  [in]    a       比較するデータ.
+ *  @param  [in]    b       比較するデータ.
+ *  @param  [in]    bytes   データのサイズ.
+ *  @return 等しい場合は true が返る.
+ */
+static bool set_default_equal(const void *a, const void *b, size_t bytes)
+{
+    return memcmp(a, b, bytes) == 0;
+}
+
+/**
+ *  バケットの, 本来の位置からの距離を取得する.
+ *
+ *  @param  [in]    self    セットオブジェクト.
+ *  @param  [in]    pos     バケットの位置.
+ *  @return 距離が返る.
+ *  @pre    バケットは使用中であること.
+ */
+static inline size_t set_distance(const struct set *self, size_t pos)
+{
+    return (pos - self->buckets[pos].hash) & self->mask;
+}
+
+/**
+ *  @c payload を持つバケットを探す.
+ *
+ *  @param  [in]    self    セットオブジェクト.
+ *  @param  [in]    payload 探すデータ.
+ *  @param  [in]    hash    @c payload のハッシュ値.
+ *  @return 見つかった場合は, バケットの位置が返る.
+ *          見つからない場合は, -1 が返る.
+ *  @pre    @c self および @c payload の非 NULL は呼び出し側で保証すること.
+ */
+static ssize_t set_find(const struct set *self, const void *payload, uint32_t hash)
+{
+    size_t pos = hash & self->mask;
+
+    /* 距離が探索中の距離より短いバケットに達したら, それ以降には無い. */
+    for (size_t dist = 0; self->buckets[pos].index != SET_EMPTY; ++dist) {
+        const struct set_bucket *bucket = &self->buckets[pos];
+
+        if (set_distance(self, pos) < dist) {
+            break;
+        }
+        if ((bucket->hash == hash)
+            && self->equal(set_cell(self, bucket->index)->payload, payload, self->key_bytes)) {
+            return (ssize_t)pos;
+        }
+        pos = (pos + 1) & self->mask;
+    }
+
+    return -1;
 }
 
 /**
  *  @details    空で, 指定の容量を備えた, @ref SET オブジェクトを確保
  *              および初期化する.
+ *              ハッシュ関数と等価判定関数には既定のもの
+ *              (データ部全体のハッシュと @c memcmp) を用いる.
  *
  *  @param      [in]    payload_bytes   データ部のサイズ.
  *  @param      [in]    capacity        セットの容量.
@@ -756,7 +1560,60 @@ int queue_to_array(QUEUE que, void **array, size_t *count)
  */
 SET set_init(size_t payload_bytes, size_t capacity)
 {
-    return (SET)list_init(payload_bytes, capacity);
+    return set_init_custom(payload_bytes, capacity, NULL, NULL);
+}
+
+/**
+ *  @details    空で, 指定の容量を備えた, @ref SET オブジェクトを確保
+ *              および初期化する.
+ *              要素は追加順に連続した配列に置き, 要素の位置を
+ *              Robin Hood 法の開番地ハッシュ表で引く.
+ *              ハッシュ表は容量の 4/3 倍以上の 2 のべき乗の大きさとする.
+ *
+ *  @param      [in]    payload_bytes   データ部のサイズ.
+ *  @param      [in]    capacity        セットの容量.
+ *  @param      [in]    hash            ハッシュ関数. NULL の場合は既定のものを用いる.
+ *  @param      [in]    equal           等価判定関数. NULL の場合は既定のものを用いる.
+ *  @return     成功時は, 確保および初期化したオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+SET set_init_custom(size_t payload_bytes,
+                    size_t capacity,
+                    size_t (*hash)(const void *payload, size_t bytes),
+                    bool (*equal)(const void *a, const void *b, size_t bytes))
+{
+    struct set *self;
+    size_t cell_bytes;
+    size_t slots = 1;
+    void *cells;
+    struct set_bucket *buckets;
+
+    if ((payload_bytes == 0) || (capacity == 0) || (capacity > SET_CAPACITY_MAX)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    while (slots < capacity + (capacity / 3) + 1) {
+        slots <<= 1;
+    }
+
+    self = malloc(sizeof(*self));
+    cell_bytes = NODE_BYTES(struct list_node, payload_bytes);
+    cells = calloc(capacity, cell_bytes);
+    buckets = malloc(slots * sizeof(*buckets));
+    if ((self == NULL) || (cells == NULL) || (buckets == NULL)) {
+        free(buckets);
+        free(cells);
+        free(self);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    *self = SET_INITIALIZER(cells, buckets, cell_bytes, payload_bytes, capacity, slots - 1);
+    self->hash = (hash != NULL) ? hash : set_default_hash;
+    self->equal = (equal != NULL) ? equal : set_default_equal;
+    memset(buckets, 0xFF, slots * sizeof(*buckets));
+
+    return (SET)self;
 }
 
 /**
@@ -768,7 +1625,13 @@ SET set_init(size_t payload_bytes, size_t capacity)
  */
 void set_release(SET set)
 {
-    list_release((LIST)set);
+    struct set *self = (struct set *)set;
+
+    if (self != NULL) {
+        free(self->buckets);
+        free(self->cells);
+        free(self);
+    }
 }
 
 /**
@@ -781,7 +1644,64 @@ void set_release(SET set)
  */
 int set_clear(SET set)
 {
-    return list_clear((LIST)set);
+    struct set *self = (struct set *)set;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memset(self->buckets, 0xFF, (self->mask + 1) * sizeof(*self->buckets));
+    self->count = 0;
+
+    return 0;
+}
+
+/**
+ *  要素を追加順の配列の末尾に置き, ハッシュ表に登録する.
+ *  データ部は呼び出し側で書き込む.
+ *
+ *  @param  [in,out]    self    セットオブジェクト.
+ *  @param  [in]        hash    追加する要素のハッシュ値.
+ *  @return 成功時は, 追加した要素のデータ部のポインタが返る.
+ *          失敗時は, NULL が返り, errno が適切に設定される.
+ *  @pre    @c self の非 NULL は呼び出し側で保証すること.
+ *  @pre    同じ要素が追加されていないことは呼び出し側で保証すること.
+ */
+static void *set_emplace(struct set *self, uint32_t hash)
+{
+    struct set_bucket carry = {.hash = hash, .index = (uint32_t)self->count};
+    struct list_node *cell;
+    size_t pos;
+
+    if (self->count >= self->capacity) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    /* 追加順の配列の末尾に置き, 反復子の終端を付け替える. */
+    cell = set_cell(self, self->count);
+    if (self->count > 0) {
+        set_cell(self, self->count - 1)->next = cell;
+    }
+    cell->next = NULL;
+    ++self->count;
+
+    /* 本来の位置から遠いものほど手前に置く (Robin Hood 法). */
+    pos = carry.hash & self->mask;
+    for (size_t dist = 0; self->buckets[pos].index != SET_EMPTY; ++dist) {
+        size_t existing = set_distance(self, pos);
+        if (existing < dist) {
+            struct set_bucket tmp = self->buckets[pos];
+            self->buckets[pos] = carry;
+            carry = tmp;
+            dist = existing;
+        }
+        pos = (pos + 1) & self->mask;
+    }
+    self->buckets[pos] = carry;
+
+    return cell->payload;
 }
 
 /**
@@ -791,129 +1711,292 @@ int set_clear(SET set)
  *  @param      [in,out]    set     セットオブジェクト.
  *  @param      [in]        payload セットに追加するデータ.
  *  @return     成功時は, 追加したセット上のデータ部のポインタが返る.
+ *              すでに追加されている場合は, そのデータ部のポインタが返る.
  *              失敗時は, NULL が返り, errno が適切に設定される.
  *  @warning    スレッドセーフではない.
  */
 void *set_add(SET set, void *payload)
 {
-    LIST list = (LIST)set;
-    ssize_t payload_bytes;
-    ITER iter;
+    struct set *self = (struct set *)set;
+    uint32_t hash;
+    ssize_t found;
+    void *slot;
 
-    if ((list == NULL) || (payload == NULL)) {
+    if ((self == NULL) || (payload == NULL)) {
         errno = EINVAL;
         return NULL;
     }
 
-    payload_bytes = list_payload_bytes(list);
-    for (iter = list_iter(list); iter != NULL; iter = iter_next(iter)) {
-        void *p = iter_get_payload(iter);
-        if (memcmp(payload, p, payload_bytes) == 0) {
-            return p;
-        }
+    hash = (uint32_t)self->hash(payload, self->key_bytes);
+    found = set_find(self, payload, hash);
+    if (found >= 0) {
+        return set_cell(self, self->buckets[found].index)->payload;
     }
 
-    return list_insert(list, -1, payload);
+    slot = set_emplace(self, hash);
+    if (slot != NULL) {
+        memcpy(slot, payload, self->payload_bytes);
+    }
+
+    return slot;
 }
 
 /**
- *  @details    @c set に追加されている要素の数を返す.
+ *  @details    @c set に @c payload が追加されているかを判定する.
  *
- *  @param      [in]    set セットオブジェクト.
- *  @return     成功時は, @c set に追加されている要素の数を返す.
- *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @param      [in]    set     セットオブジェクト.
+ *  @param      [in]    payload 探すデータ.
+ *  @return     追加されている場合は true が返る.
+ *              追加されていない場合, および失敗時は false が返る.
+ *              失敗時は errno が適切に設定される.
  *  @warning    スレッドセーフではない.
  */
-ssize_t set_count(SET set)
+bool set_contains(SET set, const void *payload)
 {
-    return list_count((LIST)set);
+    struct set *self = (struct set *)set;
+
+    if ((self == NULL) || (payload == NULL)) {
+        errno = EINVAL;
+        return false;
+    }
+
+    return set_find(self, payload, (uint32_t)self->hash(payload, self->key_bytes)) >= 0;
 }
 
 /**
- *  @details    @c set の反復子を取得する.
- *
- *  @code
- *  for (ITER iter = set_iter(set;
- *       iter != NULL;
- *       iter = iter_next(iter)) {
- *      void *payload = iter_get_payload(iter);
- *  }
- *  @endcode
+ *  @details    @c set から @c payload を削除する.
+ *              追加順の配列の末尾の要素を空いた位置に移すため,
+ *              その要素のデータ部のポインタと反復の順序は変わる.
  *
- *  @param      [in]    set セットオブジェクト.
- *  @return     成功時は, @c set の反復子が返る.
- *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @param      [in,out]    set     セットオブジェクト.
+ *  @param      [in]        payload 削除するデータ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
  *  @warning    スレッドセーフではない.
- *  @sa         iter_next, iter_get_payload
  */
-ITER set_iter(SET set)
+int set_remove(SET set, const void *payload)
 {
-    return list_iter((LIST)set);
-}
+    struct set *self = (struct set *)set;
+    ssize_t found;
+    size_t pos, next, index, last;
 
-/**
- *  N-ary ツリーノード構造体.
- */
-struct tree_node {
-    struct tree_node *first_child;  /**< 最初の子要素へのポインタ. */
-    struct tree_node *next_sibling; /**< 次の兄弟要素へのポインタ. */
-    int age;                        /**< 世代. (ツリー上での深さ) */
-    char payload[];                 /**< データ部. */
-};
+    if ((self == NULL) || (payload == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
 
-/**
- *  N-ary ツリーノード構造体の初期化子.
+    found = set_find(self, payload, (uint32_t)self->hash(payload, self->key_bytes));
+    if (found < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    /* 後続のバケットを 1 つずつ詰める. */
+    pos = (size_t)found;
+    index = self->buckets[pos].index;
+    for (next = (pos + 1) & self->mask;
+         (self->buckets[next].index != SET_EMPTY) && (set_distance(self, next) > 0);
+         next = (next + 1) & self->mask) {
+        self->buckets[pos] = self->buckets[next];
+        pos = next;
+    }
+    self->buckets[pos].index = SET_EMPTY;
+
+    /* 追加順の配列の末尾を空いた位置に移し, 指すバケットを付け替える. */
+    last = self->count - 1;
+    if (index != last) {
+        void *moved = set_cell(self, last)->payload;
+        uint32_t hash = (uint32_t)self->hash(moved, self->key_bytes);
+
+        for (pos = hash & self->mask; self->buckets[pos].index != last; pos = (pos + 1) & self->mask) {
+        }
+        self->buckets[pos].index = (uint32_t)index;
+        memcpy(set_cell(self, index)->payload, moved, self->payload_bytes);
+    }
+    self->count = last;
+    if (last > 0) {
+        set_cell(self, last - 1)->next = NULL;
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    @c set に追加されている要素の数を返す.
+ *
+ *  @param      [in]    set セットオブジェクト.
+ *  @return     成功時は, @c set に追加されている要素の数を返す.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+ssize_t set_count(SET set)
+{
+    struct set *self = (struct set *)set;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return (ssize_t)self->count;
+}
+
+/**
+ *  @details    @c set の反復子を取得する.
+ *              要素は追加順に辿る.
+ *
+ *  @code
+ *  for (ITER iter = set_iter(set);
+ *       iter != NULL;
+ *       iter = iter_next(iter)) {
+ *      void *payload = iter_get_payload(iter);
+ *  }
+ *  @endcode
+ *
+ *  @param      [in]    set セットオブジェクト.
+ *  @return     成功時は, @c set の反復子が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ *  @sa         iter_next, iter_get_payload
+ */
+ITER set_iter(SET set)
+{
+    struct set *self = (struct set *)set;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (self->count == 0) {
+        return NULL;
+    }
+    return (ITER)set_cell(self, 0);
+}
+
+/**
+ *  N-ary ツリーノード構造体.
+ */
+struct tree_node {
+    struct tree_node *parent;       /**< 親要素へのポインタ. (根は NULL) */
+    struct tree_node *first_child;  /**< 最初の子要素へのポインタ. */
+    struct tree_node *last_child;   /**< 最後の子要素へのポインタ. */
+    struct tree_node *next_sibling; /**< 次の兄弟要素へのポインタ. */
+    int age;                        /**< 世代. (ツリー上での深さ) */
+    char payload[];                 /**< データ部. */
+};
+
+/**
+ *  N-ary ツリーノード構造体の初期化子.
  */
 #define TREE_NODE_INITIALIZER \
     (struct tree_node){       \
+        .parent = NULL,       \
         .first_child = NULL,  \
+        .last_child = NULL,   \
         .next_sibling = NULL, \
         .age = 0              \
     }
 
+/**
+ *  N-ary ツリーのデータ部の索引の要素.
+ */
+struct tree_slot {
+    size_t hash;                /**< データ部のハッシュ値. */
+    struct tree_node *node;     /**< ノード. 空きの場合は NULL. */
+};
+
 /**
  *  N-ary ツリー管理構造体.
  */
 struct tree {
-    void *pool;                 /**< ツリーで使用するメモリプール. */
+    struct slab *slabs;         /**< ノードのスラブ. 末尾が初期に確保したもの. */
     struct tree_node *released; /**< 解放済みのノードのリスト. */
     struct tree_node *root;     /**< ツリーの根. */
     size_t payload_bytes;       /**< データ部のサイズ. */
     size_t capacity;            /**< 確保したノードの数. */
+    size_t limit;               /**< 自動拡張する容量の上限. */
     size_t count;               /**< 使用中のノードの数. */
+    struct tree_slot *index;    /**< データ部からノードを引く開番地の索引. */
+    size_t index_mask;          /**< 索引の大きさ - 1. */
 };
 
 /**
  *  N-ary ツリー管理構造体の初期化子.
  */
-#define TREE_INITIALIZER(p, b, c) \
-    (struct tree){                \
-        .pool = (p),              \
-        .released = NULL,         \
-        .root = NULL,             \
-        .payload_bytes = (b),     \
-        .capacity = (c),          \
-        .count = 0                \
+#define TREE_INITIALIZER(p, b, c, l) \
+    (struct tree){                   \
+        .slabs = (p),                \
+        .released = NULL,            \
+        .root = NULL,                \
+        .payload_bytes = (b),        \
+        .capacity = (c),             \
+        .limit = (l),                \
+        .count = 0,                  \
+        .index = NULL,               \
+        .index_mask = 0              \
     }
 
 /**
- *  N-ary ツリー反復子構造体.
+ *  N-ary ツリーを行きがけ順に辿り, @c node の次のノードを取得する.
+ *  子, 兄弟, 親の兄弟の順に辿るため, 追加のメモリを要さない.
+ *
+ *  @param  [in]    node    ノード.
+ *  @param  [in]    top     走査する部分木の頂点. NULL の場合はツリー全体を辿る.
+ *  @return 次のノードが返る. 最後のノードの場合は NULL が返る.
+ *  @pre    @c node の非 NULL は呼び出し側で保証すること.
  */
-struct tree_iter {
-    STACK fringe;               /**< 探索経路を保持するスタック. */
-    int age;                    /**< 現在地の世代. */
-    void *payload;              /**< 現在地のデータ部. */
-};
+static inline struct tree_node *tree_node_next(const struct tree_node *node,
+                                               const struct tree_node *top)
+{
+    if (node->first_child != NULL) {
+        return node->first_child;
+    }
+    for (; node != top; node = node->parent) {
+        if (node->next_sibling != NULL) {
+            return node->next_sibling;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  N-ary ツリーの @c node を頂点とする部分木で, 最初に辿る葉を取得する.
+ *
+ *  @param  [in]    node    ノード.
+ *  @return 最初の子を辿って得た葉が返る.
+ *  @pre    @c node の非 NULL は呼び出し側で保証すること.
+ */
+static inline struct tree_node *tree_node_leftmost(struct tree_node *node)
+{
+    while (node->first_child != NULL) {
+        node = node->first_child;
+    }
+
+    return node;
+}
 
 /**
- *  N-ary ツリー反復子構造体の初期化子.
+ *  N-ary ツリーを帰りがけ順に辿り, @c node の次のノードを取得する.
+ *  兄弟があればその最初の葉, なければ親を辿るため, 追加のメモリを要さない.
+ *
+ *  @param  [in]    node    ノード.
+ *  @param  [in]    top     走査する部分木の頂点.
+ *  @return 次のノードが返る. @c top を辿り終えた場合は NULL が返る.
+ *  @pre    @c node の非 NULL は呼び出し側で保証すること.
  */
-#define TREE_ITER_INITIALIZER \
-    (struct tree_iter){       \
-        .fringe = NULL,       \
-        .age = 0,             \
-        .payload = NULL       \
+static inline struct tree_node *tree_node_next_post(struct tree_node *node,
+                                                    const struct tree_node *top)
+{
+    if (node == top) {
+        return NULL;
     }
+    if (node->next_sibling != NULL) {
+        return tree_node_leftmost(node->next_sibling);
+    }
+
+    return node->parent;
+}
 
 /**
  *  N-ary ツリー向け, 解放済みノードのリストにノードを追加する.
@@ -934,6 +2017,139 @@ static inline void tree_push_released(struct tree *self, struct tree_node *node)
     self->released = node;
 }
 
+/**
+ *  容量 @c capacity のツリーの索引の大きさを求める.
+ *  使用率が 3/4 を超えない 2 のべき乗とする.
+ *
+ *  @param  [in]    capacity    ツリーの容量.
+ *  @return 索引の大きさが返る.
+ */
+static inline size_t tree_index_slots(size_t capacity)
+{
+    size_t slots = 1;
+
+    while (slots < capacity + (capacity / 3) + 1) {
+        slots <<= 1;
+    }
+
+    return slots;
+}
+
+/**
+ *  索引に @c node を登録する.
+ *
+ *  @param  [in,out]    index   索引.
+ *  @param  [in]        mask    索引の大きさ - 1.
+ *  @param  [in]        hash    @c node のデータ部のハッシュ値.
+ *  @param  [in]        node    登録するノード.
+ *  @pre    索引に空きがあること.
+ */
+static inline void tree_index_put(struct tree_slot *index, size_t mask, size_t hash, struct tree_node *node)
+{
+    size_t pos = hash & mask;
+
+    while (index[pos].node != NULL) {
+        pos = (pos + 1) & mask;
+    }
+    index[pos].hash = hash;
+    index[pos].node = node;
+}
+
+/**
+ *  索引から @c payload と等しいデータ部のノードを探す.
+ *
+ *  @param  [in]    self    ツリーオブジェクト.
+ *  @param  [in]    payload 探すデータ.
+ *  @param  [in]    hash    @c payload のハッシュ値.
+ *  @return 見つかった場合は, ノードのポインタが返る.
+ *          見つからない場合は, NULL が返る.
+ *  @pre    @c self および @c payload の非 NULL は呼び出し側で保証すること.
+ */
+static struct tree_node *tree_index_find(const struct tree *self, const void *payload, size_t hash)
+{
+    size_t pos = hash & self->index_mask;
+
+    for (; self->index[pos].node != NULL; pos = (pos + 1) & self->index_mask) {
+        const struct tree_slot *slot = &self->index[pos];
+        if ((slot->hash == hash) && (memcmp(slot->node->payload, payload, self->payload_bytes) == 0)) {
+            return slot->node;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ *  容量 @c capacity に合わせて索引を大きくする.
+ *
+ *  @param  [in,out]    self        ツリーオブジェクト.
+ *  @param  [in]        capacity    ツリーの容量.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ *  @pre    @c self の非 NULL は呼び出し側で保証すること.
+ */
+static int tree_index_reserve(struct tree *self, size_t capacity)
+{
+    size_t slots = tree_index_slots(capacity);
+    struct tree_slot *index;
+
+    if ((self->index != NULL) && (slots <= self->index_mask + 1)) {
+        return 0;
+    }
+    index = calloc(slots, sizeof(*index));
+    if (index == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (self->index != NULL) {
+        for (size_t i = 0; i <= self->index_mask; ++i) {
+            if (self->index[i].node != NULL) {
+                tree_index_put(index, slots - 1, self->index[i].hash, self->index[i].node);
+            }
+        }
+        free(self->index);
+    }
+    self->index = index;
+    self->index_mask = slots - 1;
+
+    return 0;
+}
+
+/**
+ *  ツリーの容量が上限に達していなければ, スラブを追加する.
+ *
+ *  @param  [in,out]    self    ツリーオブジェクト.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ *  @pre    @c self の非 NULL は呼び出し側で保証すること.
+ */
+static int tree_grow(struct tree *self)
+{
+    size_t node_bytes = NODE_BYTES(struct tree_node, self->payload_bytes);
+    size_t count = slab_grow_count(self->capacity, self->limit);
+    struct slab *slab;
+
+    if (count == 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (tree_index_reserve(self, self->capacity + count) != 0) {
+        return -1;
+    }
+    slab = slab_alloc(count, node_bytes);
+    if (slab == NULL) {
+        return -1;
+    }
+    slab->next = self->slabs;
+    self->slabs = slab;
+    self->capacity += count;
+    for (size_t i = 0; i < count; ++i) {
+        tree_push_released(self, slab_node(slab, node_bytes, i));
+    }
+
+    return 0;
+}
+
 /**
  *  N-ary ツリー向け, 解放済みノードのリストからノードを取得する.
  *
@@ -946,6 +2162,9 @@ static inline struct tree_node *tree_pop_released(struct tree *self)
 {
     struct tree_node *node = self->released;
 
+    if ((node == NULL) && (tree_grow(self) == 0)) {
+        node = self->released;
+    }
     if (node == NULL) {
         errno = ENOMEM;
         return NULL;
@@ -957,34 +2176,31 @@ static inline struct tree_node *tree_pop_released(struct tree *self)
 }
 
 /**
- *  ツリーの初期設定を行う.
+ *  ツリーを空の状態に設定する.
+ *  すべてのノードを解放済みにし, 索引を空にする.
  *
- *  @param  [in,out]    self            ツリーオブジェクト.
- *  @param  [in]        pool            ツリーに使用するメモリプール.
- *  @param  [in]        payload_bytes   データ部のサイズ.
- *  @param  [in]        capacity        リストの容量.
+ *  @param  [in,out]    self    ツリーオブジェクト.
  *  @pre    @c self の非 NULL は呼び出し側で保証すること.
- *  @pre    @c pool の非 NULL は呼び出し側で保証すること.
+ *  @pre    スラブと索引が確保済みであること.
  */
-static inline void tree_setup(struct tree *self,
-                              void *pool,
-                              size_t payload_bytes,
-                              size_t capacity)
+static inline void tree_setup(struct tree *self)
 {
     size_t node_bytes;
-    struct tree_node *node;
-
-    *self = TREE_INITIALIZER(pool, payload_bytes, capacity);
-    node_bytes = sizeof(*node) + self->payload_bytes;
-    for (size_t i = 0; i < self->capacity + 1; ++i) {
-        node = (struct tree_node *)((uintptr_t)self->pool + (node_bytes * i));
-        tree_push_released(self, node);
+    struct slab *slab;
+
+    self->released = NULL;
+    self->root = NULL;
+    self->count = 0;
+    memset(self->index, 0, (self->index_mask + 1) * sizeof(*self->index));
+    node_bytes = NODE_BYTES(struct tree_node, self->payload_bytes);
+    for (slab = self->slabs; slab != NULL; slab = slab->next) {
+        for (size_t i = 0; i < slab->count; ++i) {
+            tree_push_released(self, slab_node(slab, node_bytes, i));
+        }
     }
 
-    /* root は固定で割り当てる. */
-    /** @todo root は他の要素と重複しなさそうなデータ部にする,
-     *  もしくは区別できる仕組みを入れる.
-     */
+    /* root は固定で割り当てる. root のデータ部は索引に登録しないため,
+     * 要素のデータ部と重複しても区別できる. */
     self->root = tree_pop_released(self);
     *(self->root) = TREE_NODE_INITIALIZER;
     memset(self->root->payload, 0x5A, self->payload_bytes);
@@ -1003,25 +2219,30 @@ static inline void tree_setup(struct tree *self,
 TREE tree_init(size_t payload_bytes, size_t capacity)
 {
     struct tree *self;
-    size_t node_bytes;
-    void *pool;
+    struct slab *slab;
 
     if ((payload_bytes == 0) || (capacity == 0)) {
         errno = EINVAL;
         return NULL;
     }
 
+    /* root の分を含めて確保する. */
     self = malloc(sizeof(*self));
-    node_bytes = sizeof(struct tree_node) + payload_bytes;
-    pool = calloc(capacity + 1, node_bytes);
-    if ((self == NULL) || (pool == NULL)) {
-        free(pool);
+    slab = slab_alloc(capacity + 1, NODE_BYTES(struct tree_node, payload_bytes));
+    if ((self == NULL) || (slab == NULL)) {
+        free(slab);
         free(self);
         errno = ENOMEM;
         return NULL;
     }
+    *self = TREE_INITIALIZER(slab, payload_bytes, capacity, capacity);
+    if (tree_index_reserve(self, capacity) != 0) {
+        free(slab);
+        free(self);
+        return NULL;
+    }
 
-    tree_setup(self, pool, payload_bytes, capacity);
+    tree_setup(self);
 
     return (TREE)self;
 }
@@ -1038,7 +2259,8 @@ void tree_release(TREE tree)
     struct tree *self = (struct tree *)tree;
 
     if (self != NULL) {
-        free(self->pool);
+        free(self->index);
+        slab_free_all(self->slabs);
         free(self);
     }
 }
@@ -1060,229 +2282,328 @@ int tree_clear(TREE tree)
         return -1;
     }
 
-    tree_setup(self, self->pool, self->payload_bytes, self->capacity);
+    tree_setup(self);
 
     return 0;
 }
 
 /**
- *  @details    @c t に追加された @c parent の子に要素を追加するための再帰処理.
- *              @c parent が複数存在する場合は, 最初に見つかった要素の子として
- *              追加する.
- *
- *  @param      [in,out]    self    ツリーオブジェクト.
- *  @param      [in,out]    node    探索中の要素.
- *  @param      [in]        age     探索中の世代 (深さ).
- *  @param      [in]        parent  探索対象のデータ部.
- *  @param      [in]        payload ツリーに追加するデータ.
- *  @return     成功時は, 追加したツリー上のデータ部のポインタが返る.
- *              失敗時は, NULL が返り, errno が適切に設定される.
- *  @remarks    探索は幅 (同一の親に追加された要素) 優先で行われる.
- *  @pre        @c self の非 NULL は呼び出し側で保証すること.
- *  @pre        @c node の非 NULL は呼び出し側で保証すること.
- *  @pre        @c parent の非 NULL は呼び出し側で保証すること.
- *  @pre        @c payload の非 NULL は呼び出し側で保証すること.
- */
-static void *tree_insert_inner(struct tree *self,
-                               struct tree_node *node,
-                               int age,
-                               void *parent,
-                               void *payload)
-{
-    void *additional = NULL;
-
-    if (memcmp(node->payload, parent, self->payload_bytes) == 0) {
-        struct tree_node *child = node->first_child;
-        if (child == NULL) {
-            node->first_child = tree_pop_released(self);
-            if (node->first_child == NULL) {
-                return NULL;
-            }
-            *node->first_child = TREE_NODE_INITIALIZER;
-            node->first_child->age = age;
-            memcpy(node->first_child->payload, payload, self->payload_bytes);
-            additional = node->first_child->payload;
-        } else {
-            while (child->next_sibling != NULL) {
-                child = child->next_sibling;
-            }
-            child->next_sibling = tree_pop_released(self);
-            if (child->next_sibling == NULL) {
-                return NULL;
-            }
-            *child->next_sibling = TREE_NODE_INITIALIZER;
-            child->next_sibling->age = age;
-            memcpy(child->next_sibling->payload, payload, self->payload_bytes);
-            additional = child->next_sibling->payload;
-        }
-        ++self->count;
-    } else {
-        if (node->next_sibling != NULL) {
-            additional = tree_insert_inner(self,
-                                           node->next_sibling,
-                                           age,
-                                           parent,
-                                           payload);
-        }
-        if ((additional == NULL) && (node->first_child != NULL)) {
-            additional = tree_insert_inner(self,
-                                           node->first_child,
-                                           age + 1,
-                                           parent,
-                                           payload);
-        }
-    }
-
-    return additional;
-}
-
-/**
- *  @details    @c tree の指定位置に要素を追加する.
+ *  @details    @c tree の要素が容量を超えて追加される場合に,
+ *              @c limit を上限として容量を自動で拡張するようにする.
+ *              既存のノードは移動しないため, 返したデータ部のポインタは
+ *              有効なままとなる.
  *
  *  @param      [in,out]    tree    ツリーオブジェクト.
- *  @param      [in]        parent  子として追加する親要素.
- *  @param      [in]        payload ツリーに追加するデータ.
- *  @return     成功時は, 追加したツリー上のデータ部のポインタが返る.
- *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @param      [in]        limit   容量の上限. 上限を設けない場合は SIZE_MAX.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
  *  @warning    スレッドセーフではない.
+ *  @sa         list_set_growth
  */
-void *tree_insert(TREE tree, void *parent, void *payload)
+int tree_set_growth(TREE tree, size_t limit)
 {
     struct tree *self = (struct tree *)tree;
 
-    if ((self == NULL) || (payload == NULL)) {
+    if ((self == NULL) || (limit < self->capacity)) {
         errno = EINVAL;
-        return NULL;
+        return -1;
     }
 
-    return tree_insert_inner(self,
-                             self->root,
-                             1,
-                             (parent ?: self->root->payload),
-                             payload);
+    self->limit = limit;
+
+    return 0;
 }
 
 /**
- *  @details    @c tree に追加されている要素の数を返す.
+ *  @details    @c tree の拡張で追加したスラブのうち,
+ *              すべてのノードが未使用のものを解放する.
+ *              @ref tree_init で確保した分は解放しない.
  *
- *  @param      [in]    tree    ツリーオブジェクト.
- *  @return     成功時は, @c tree に追加されている要素の数を返す.
+ *  @param      [in,out]    tree    ツリーオブジェクト.
+ *  @return     成功時は, 縮小後の容量が返る.
  *              失敗時は, -1 が返り, errno が適切に設定される.
  *  @warning    スレッドセーフではない.
  */
-ssize_t tree_count(TREE tree)
+ssize_t tree_shrink(TREE tree)
 {
     struct tree *self = (struct tree *)tree;
+    size_t node_bytes;
+    struct tree_node *node, *next, **tail;
+    struct slab **link;
 
     if (self == NULL) {
         errno = EINVAL;
         return -1;
     }
+    node_bytes = NODE_BYTES(struct tree_node, self->payload_bytes);
 
-    return self->count;
+    /* スラブ毎に未使用のノードを数える. */
+    for (struct slab *slab = self->slabs; slab != NULL; slab = slab->next) {
+        slab->nfree = 0;
+    }
+    for (node = self->released; node != NULL; node = node->next_sibling) {
+        ++slab_owner(self->slabs, node, node_bytes)->nfree;
+    }
+
+    /* 解放するスラブのノードを解放済みノードのリストから外す. */
+    tail = &self->released;
+    for (node = self->released; node != NULL; node = next) {
+        struct slab *slab = slab_owner(self->slabs, node, node_bytes);
+        next = node->next_sibling;
+        if ((slab->next == NULL) || (slab->nfree < slab->count)) {
+            *tail = node;
+            tail = &node->next_sibling;
+        }
+    }
+    *tail = NULL;
+
+    /* 初期に確保したスラブ (末尾) は残す. */
+    for (link = &self->slabs; (*link)->next != NULL;) {
+        struct slab *slab = *link;
+        if (slab->nfree == slab->count) {
+            *link = slab->next;
+            self->capacity -= slab->count;
+            free(slab);
+        } else {
+            link = &slab->next;
+        }
+    }
+
+    return (ssize_t)self->capacity;
 }
 
 /**
- *  @details    @c tree の反復子を取得する.
- *
- *  @code
- *  for (TREE_ITER iter = tree_iter_get(tree);
- *       iter != NULL;
- *       iter = tree_iter_next(iter)) {
- *      void *payload = tree_iter_get_payload(iter);
-        int age = tree_iter_get_age(iter);
- *  }
- *  @endcode
+ *  N-ary ツリー向け, ノードの末尾の子として要素を追加する.
  *
- *  @param      [in]    tree    ツリーオブジェクト.
- *  @return     成功時は, @c tree の反復子が返る.
- *              失敗時は, NULL が返り, errno が適切に設定される.
- *  @remarks    走査は深さ (子要素) 優先で行われる.
- *  @warning    スレッドセーフではない.
- *  @sa         tree_iter_next, tree_iter_get_payload, tree_iter_get_age
+ *  @param  [in,out]    self    ツリーオブジェクト.
+ *  @param  [in,out]    node    親となるノード.
+ *  @param  [in]        age     追加する要素の世代 (深さ).
+ *  @param  [in]        payload ツリーに追加するデータ.
+ *  @return 成功時は, 追加したツリー上のデータ部のポインタが返る.
+ *          失敗時は, NULL が返り, errno が適切に設定される.
+ *  @pre    @c self の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c node の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c payload の非 NULL は呼び出し側で保証すること.
  */
-TREE_ITER tree_iter_get(TREE tree)
+static inline void *tree_append_child(struct tree *self,
+                                      struct tree_node *node,
+                                      int age,
+                                      const void *payload)
 {
-    struct tree *self = (struct tree *)tree;
-    struct tree_iter *iter;
+    struct tree_node *child;
+    size_t hash = set_default_hash(payload, self->payload_bytes);
 
-    iter = malloc(sizeof(*iter));
-    if (iter == NULL) {
+    child = tree_pop_released(self);
+    if (child == NULL) {
         return NULL;
     }
-    *iter = TREE_ITER_INITIALIZER;
-    iter->fringe = stack_init(sizeof(struct tree_node *), self->capacity);
-    if (iter->fringe == NULL) {
-        free(iter);
-        return NULL;
+    *child = TREE_NODE_INITIALIZER;
+    child->parent = node;
+    child->age = age;
+    memcpy(child->payload, payload, self->payload_bytes);
+
+    /* 同じデータ部の要素がある場合は, 先に追加したものを引けるようにしておく. */
+    if (tree_index_find(self, payload, hash) == NULL) {
+        tree_index_put(self->index, self->index_mask, hash, child);
     }
 
-    if (self->root->first_child != NULL) {
-        stack_push(iter->fringe, &self->root->first_child);
+    if (node->last_child == NULL) {
+        node->first_child = child;
+    } else {
+        node->last_child->next_sibling = child;
     }
+    node->last_child = child;
+    ++self->count;
 
-    if (tree_iter_next((TREE_ITER)iter) == NULL) {
-        tree_iter_release((TREE_ITER)iter);
-        iter = NULL;
-    }
-    return (TREE_ITER)iter;
+    return child->payload;
 }
 
 /**
- *  @details    @c iter を解放する.
- *              @c iter は @ref tree_iter_get の戻り値である必要がある.
+ *  @details    @c tree の指定位置に要素を追加する.
+ *              親はデータ部の索引で引くため, 要素数によらず定数時間で追加できる.
+ *              @c parent と等しいデータ部の要素が複数ある場合は,
+ *              最初に追加した要素の子として追加する.
  *
- *  @param      [in,out]    iter    反復子オブジェクト.
- *  @warning    スレッドセーフではない.
+ *  @param      [in,out]    tree    ツリーオブジェクト.
+ *  @param      [in]        parent  子として追加する親要素. NULL の場合は根に追加する.
+ *  @param      [in]        payload ツリーに追加するデータ.
+ *  @return     成功時は, 追加したツリー上のデータ部のポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
  */
-void tree_iter_release(TREE_ITER iter)
+void *tree_insert(TREE tree, void *parent, void *payload)
 {
-    struct tree_iter *self = (struct tree_iter *)iter;
+    struct tree *self = (struct tree *)tree;
+    struct tree_node *node;
 
-    if (self != NULL) {
-        stack_release(self->fringe);
-        free(self);
+    if ((self == NULL) || (payload == NULL)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (parent == NULL) {
+        node = self->root;
+    } else {
+        node = tree_index_find(self, parent, set_default_hash(parent, self->payload_bytes));
+        if (node == NULL) {
+            errno = ENOENT;
+            return NULL;
+        }
     }
+
+    return tree_append_child(self, node, node->age + 1, payload);
 }
 
 /**
- *  @details    @c iter の次の反復子を取得する.
+ *  @details    @c tree から @c payload と等しいデータ部の要素を探す.
+ *              等しい要素が複数ある場合は, 最初に追加した要素が返る.
  *
- *  @param      [in]    iter    N-ary ツリーの反復子.
- *  @return     成功時は, 次の反復子が返る. 次の要素がない場合は NULL が返る.
+ *  @param      [in]    tree    ツリーオブジェクト.
+ *  @param      [in]    payload 探すデータ.
+ *  @return     成功時は, ツリー上のデータ部のポインタが返る.
  *              失敗時は, NULL が返り, errno が適切に設定される.
  *  @warning    スレッドセーフではない.
  */
-TREE_ITER tree_iter_next(TREE_ITER iter)
+void *tree_find(TREE tree, const void *payload)
 {
-    struct tree_iter *self = (struct tree_iter *)iter;
+    struct tree *self = (struct tree *)tree;
     struct tree_node *node;
-    int ret;
 
-    if (self == NULL) {
+    if ((self == NULL) || (payload == NULL)) {
         errno = EINVAL;
         return NULL;
     }
 
-    if (stack_count(self->fringe) == 0) {
+    node = tree_index_find(self, payload, set_default_hash(payload, self->payload_bytes));
+    if (node == NULL) {
         errno = ENOENT;
         return NULL;
     }
 
-    ret = stack_pop(self->fringe, &node);
-    if (ret == -1) {
+    return node->payload;
+}
+
+/**
+ *  @details    @c tree に追加済みの要素の子として要素を追加する.
+ *              @ref tree_insert と異なりデータ部による親の探索を行わず,
+ *              追加時の戻り値で親を指定する.
+ *              子は追加した順に並ぶ.
+ *
+ *  @param      [in,out]    tree    ツリーオブジェクト.
+ *  @param      [in]        parent  親要素のデータ部. (@ref tree_insert または
+ *                                  本関数の戻り値) NULL の場合は根に追加する.
+ *  @param      [in]        payload ツリーに追加するデータ.
+ *  @return     成功時は, 追加したツリー上のデータ部のポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+void *tree_insert_child(TREE tree, void *parent, void *payload)
+{
+    struct tree *self = (struct tree *)tree;
+    struct tree_node *node;
+
+    if ((self == NULL) || (payload == NULL)) {
+        errno = EINVAL;
         return NULL;
     }
-    self->age = node->age;
-    self->payload = node->payload;
-    if (node->next_sibling != NULL) {
-        stack_push(self->fringe, &node->next_sibling);
+
+    if (parent == NULL) {
+        node = self->root;
+    } else {
+        node = (struct tree_node *)((uintptr_t)parent - offsetof(struct tree_node, payload));
     }
-    if (node->first_child != NULL) {
-        stack_push(self->fringe, &node->first_child);
+
+    return tree_append_child(self, node, node->age + 1, payload);
+}
+
+/**
+ *  @details    @c tree に追加されている要素の数を返す.
+ *
+ *  @param      [in]    tree    ツリーオブジェクト.
+ *  @return     成功時は, @c tree に追加されている要素の数を返す.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+ssize_t tree_count(TREE tree)
+{
+    struct tree *self = (struct tree *)tree;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return self->count;
+}
+
+/**
+ *  @details    @c tree の反復子を取得する.
+ *              反復子はノードそのものであり, 取得と走査でメモリを確保しない.
+ *
+ *  @code
+ *  for (TREE_ITER iter = tree_iter_get(tree);
+ *       iter != NULL;
+ *       iter = tree_iter_next(iter)) {
+ *      void *payload = tree_iter_get_payload(iter);
+ *      int age = tree_iter_get_age(iter);
+ *  }
+ *  @endcode
+ *
+ *  @param      [in]    tree    ツリーオブジェクト.
+ *  @return     成功時は, @c tree の反復子が返る. 要素がない場合は NULL が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @remarks    走査は深さ (子要素) 優先で行われる.
+ *  @warning    スレッドセーフではない.
+ *  @sa         tree_iter_next, tree_iter_get_payload, tree_iter_get_age
+ */
+TREE_ITER tree_iter_get(TREE tree)
+{
+    struct tree *self = (struct tree *)tree;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return (TREE_ITER)self->root->first_child;
+}
+
+/**
+ *  @details    @c iter を解放する.
+ *              反復子はメモリを確保しないため, 何もしない.
+ *              以前の反復子との互換のために残している.
+ *
+ *  @param      [in,out]    iter    反復子オブジェクト.
+ */
+void tree_iter_release(TREE_ITER iter)
+{
+    (void)iter;
+}
+
+/**
+ *  @details    @c iter の次の反復子を取得する.
+ *
+ *  @param      [in]    iter    N-ary ツリーの反復子.
+ *  @return     成功時は, 次の反復子が返る.
+ *              次の要素がない場合は, NULL が返り, errno に ENOENT が設定される.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+TREE_ITER tree_iter_next(TREE_ITER iter)
+{
+    struct tree_node *node;
+
+    if (iter == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    node = tree_node_next((struct tree_node *)iter, NULL);
+    if (node == NULL) {
+        errno = ENOENT;
     }
 
-    return iter;
+    return (TREE_ITER)node;
 }
 
 /**
@@ -1295,32 +2616,1495 @@ TREE_ITER tree_iter_next(TREE_ITER iter)
  */
 void *tree_iter_get_payload(TREE_ITER iter)
 {
-    struct tree_iter *self = (struct tree_iter *)iter;
-
-    if (self == NULL) {
+    if (iter == NULL) {
         errno = EINVAL;
         return NULL;
     }
 
-    return self->payload;
+    return ((struct tree_node *)iter)->payload;
 }
 
 /**
- *  @details    @c iter のツリー上での世代 (深さ) を取得する.
+ *  @details    @c iter の世代 (深さ) を取得する.
  *
  *  @param      [in]    iter    N-ary ツリーの反復子.
- *  @return     成功時は, 世代が返る.
+ *  @return     成功時は, 世代が返る. 根の子が 1 となる.
  *              失敗時は, -1 が返り, errno が適切に設定される.
  *  @warning    スレッドセーフではない.
  */
 int tree_iter_get_age(TREE_ITER iter)
 {
-    struct tree_iter *self = (struct tree_iter *)iter;
+    if (iter == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
 
-    if (self == NULL) {
+    return ((struct tree_node *)iter)->age;
+}
+
+/**
+ *  @c head を頂点とする部分木を幅優先に辿る.
+ *
+ *  辿るノードは走査毎に確保する待ち行列に積むため, ツリーは変更しない.
+ *
+ *  @param  [in]    self    ツリー管理構造体.
+ *  @param  [in]    head    部分木の頂点のノード.
+ *  @param  [in]    visit   要素毎に呼び出す関数.
+ *  @param  [in]    ctx     @c visit に渡す任意のデータ.
+ *  @return 成功時は, すべて辿った場合は 0 が, 打ち切った場合は
+ *          @c visit の戻り値が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int tree_walk_level(struct tree *self,
+                           struct tree_node *head,
+                           int (*visit)(void *payload, int age, void *ctx),
+                           void *ctx)
+{
+    QUEUE pending;
+    struct tree_node *node;
+    int ret = 0;
+
+    /* 待ち行列に積むノードは部分木のノード (根の番兵を含む) に限られる. */
+    pending = queue_init(sizeof(node), self->count + 1);
+    if (pending == NULL) {
+        return -1;
+    }
+
+    queue_enq(pending, &head);
+    while (queue_deq(pending, &node) >= 0) {
+        for (struct tree_node *child = node->first_child; child != NULL; child = child->next_sibling) {
+            queue_enq(pending, &child);
+        }
+        if (node != self->root) {
+            ret = visit(node->payload, node->age, ctx);
+            if (ret != 0) {
+                break;
+            }
+        }
+    }
+    queue_release(pending);
+
+    return ret;
+}
+
+/**
+ *  @details    @c tree の要素を行きがけ順に辿り, 要素毎に @c visit を呼び出す.
+ *              親へのリンクを用いて辿るため, 要素数によらず追加のメモリを要さない.
+ *              @c visit が 0 以外を返した場合は, その時点で走査を打ち切る.
+ *              打ち切る場合は正の値を返すこと. -1 は失敗を表すために予約する.
+ *
+ *  @param      [in]    tree    ツリーオブジェクト.
+ *  @param      [in]    visit   要素毎に呼び出す関数.
+ *                              データ部, 世代 (根の子が 1) および @c ctx が渡される.
+ *  @param      [in]    ctx     @c visit に渡す任意のデータ.
+ *  @return     成功時は, すべて辿った場合は 0 が, 打ち切った場合は
+ *              @c visit の戻り値が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ *  @warning    走査中に @c tree へ要素を追加してはならない.
+ *  @sa         tree_walk_subtree
+ */
+int tree_walk(TREE tree, int (*visit)(void *payload, int age, void *ctx), void *ctx)
+{
+    return tree_walk_subtree(tree, NULL, TREE_PRE_ORDER, visit, ctx);
+}
+
+/**
+ *  @details    @c tree の @c top を頂点とする部分木を @c order の順に辿り,
+ *              要素毎に @c visit を呼び出す.
+ *              - @ref TREE_PRE_ORDER は, 親, 子の順 (深さ優先) に辿る.
+ *              - @ref TREE_POST_ORDER は, 子, 親の順に辿る.
+ *                子はすべて親より先に渡されるため, 葉から集計する場合に用いる.
+ *              - @ref TREE_LEVEL_ORDER は, 浅い世代から順 (幅優先) に辿る.
+ *
+ *              行きがけ順と帰りがけ順は親へのリンクを辿るため, メモリを確保しない.
+ *              幅優先は走査毎に待ち行列を確保するため, ツリーを変更せず,
+ *              同じツリーを同時に辿ってもよい.
+ *              @c visit が 0 以外を返した場合は, その時点で走査を打ち切る.
+ *              打ち切る場合は正の値を返すこと. -1 は失敗を表すために予約する.
+ *
+ *  @param      [in]    tree    ツリーオブジェクト.
+ *  @param      [in]    top     部分木の頂点となる要素のデータ部. (@ref tree_insert,
+ *                              @ref tree_insert_child または @ref tree_find の戻り値)
+ *                              NULL の場合はツリー全体を辿る.
+ *  @param      [in]    order   辿る順.
+ *  @param      [in]    visit   要素毎に呼び出す関数.
+ *                              データ部, 世代 (根の子が 1) および @c ctx が渡される.
+ *  @param      [in]    ctx     @c visit に渡す任意のデータ.
+ *  @return     成功時は, すべて辿った場合は 0 が, 打ち切った場合は
+ *              @c visit の戻り値が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @remarks    @c top が NULL でない場合, @c top 自身も辿る.
+ *  @warning    スレッドセーフではない.
+ *  @warning    走査中に @c tree へ要素を追加してはならない.
+ */
+int tree_walk_subtree(TREE tree,
+                      void *top,
+                      enum tree_order order,
+                      int (*visit)(void *payload, int age, void *ctx),
+                      void *ctx)
+{
+    struct tree *self = (struct tree *)tree;
+    struct tree_node *head;
+    struct tree_node *node;
+    int ret;
+
+    if ((self == NULL) || (visit == NULL)) {
         errno = EINVAL;
         return -1;
     }
 
-    return self->age;
+    if (top == NULL) {
+        head = self->root;
+    } else {
+        head = (struct tree_node *)((uintptr_t)top - offsetof(struct tree_node, payload));
+    }
+
+    switch (order) {
+    case TREE_PRE_ORDER:
+        node = (top == NULL) ? head->first_child : head;
+        for (; node != NULL; node = tree_node_next(node, head)) {
+            ret = visit(node->payload, node->age, ctx);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        break;
+    case TREE_POST_ORDER:
+        /* 根は番兵であり, データ部を持たないため渡さない. */
+        node = tree_node_leftmost(head);
+        for (; (node != NULL) && (node != self->root); node = tree_node_next_post(node, head)) {
+            ret = visit(node->payload, node->age, ctx);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        break;
+    case TREE_LEVEL_ORDER:
+        return tree_walk_level(self, head, visit, ctx);
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  展開リスト管理構造体.
+ *  要素を √capacity 程度の大きさのチャンクに分けて保持する.
+ *  各チャンクはリングバッファであり, 最後のチャンクを除いて常に満杯にしておく.
+ *  これにより, 位置からチャンクとチャンク内の位置が除算のみで求まる.
+ */
+struct ulist {
+    char *slots;                /**< 全チャンクの要素を連続して置く領域. */
+    size_t *heads;              /**< チャンク毎の先頭の要素の位置. */
+    size_t payload_bytes;       /**< データ部のサイズ. */
+    size_t capacity;            /**< 追加できる要素の数. */
+    size_t shift;               /**< チャンクの大きさの 2 を底とする対数. */
+    size_t mask;                /**< チャンクの大きさ - 1. */
+    size_t count;               /**< 要素の数. */
+};
+
+/**
+ *  展開リスト管理構造体の初期化子.
+ */
+#define ULIST_INITIALIZER(p, h, b, c, s) \
+    (struct ulist){                      \
+        .slots = (p),                    \
+        .heads = (h),                    \
+        .payload_bytes = (b),            \
+        .capacity = (c),                 \
+        .shift = (s),                    \
+        .mask = ((size_t)1 << (s)) - 1,  \
+        .count = 0                       \
+    }
+
+/**
+ *  展開リストのチャンクの @c offset 番目の要素を取得する.
+ *
+ *  @param  [in]    self    展開リストオブジェクト.
+ *  @param  [in]    chunk   チャンクの位置.
+ *  @param  [in]    offset  チャンクの先頭からの位置.
+ *  @return 要素のデータ部のポインタが返る.
+ */
+static inline void *ulist_slot(const struct ulist *self, size_t chunk, size_t offset)
+{
+    size_t pos = (chunk << self->shift) + ((self->heads[chunk] + offset) & self->mask);
+
+    return self->slots + (pos * self->payload_bytes);
+}
+
+/**
+ *  展開リストのチャンク内で, 連続する要素を 1 つ前か後ろにずらす.
+ *  リングバッファの折り返しで分かれる区間毎にまとめて移動するため,
+ *  memmove は高々 3 回で済む.
+ *
+ *  @param  [in,out]    self    展開リストオブジェクト.
+ *  @param  [in]        chunk   チャンクの位置.
+ *  @param  [in]        dst     移動先のチャンクの先頭からの位置.
+ *  @param  [in]        src     移動元のチャンクの先頭からの位置.
+ *  @param  [in]        count   移動する要素の数.
+ */
+static void ulist_move(struct ulist *self, size_t chunk, size_t dst, size_t src, size_t count)
+{
+    char *base = self->slots + ((chunk << self->shift) * self->payload_bytes);
+    size_t head = self->heads[chunk];
+
+    /* 重なる領域を壊さないよう, 後ろへずらす場合は末尾から移動する. */
+    while (count > 0) {
+        size_t s, d, n;
+
+        if (dst > src) {
+            s = (head + src + count - 1) & self->mask;
+            d = (head + dst + count - 1) & self->mask;
+            n = (s < d) ? s + 1 : d + 1;
+            n = (n < count) ? n : count;
+            memmove(base + ((d + 1 - n) * self->payload_bytes),
+                    base + ((s + 1 - n) * self->payload_bytes),
+                    n * self->payload_bytes);
+        } else {
+            s = (head + src) & self->mask;
+            d = (head + dst) & self->mask;
+            n = self->mask + 1 - ((s > d) ? s : d);
+            n = (n < count) ? n : count;
+            memmove(base + (d * self->payload_bytes),
+                    base + (s * self->payload_bytes),
+                    n * self->payload_bytes);
+            src += n;
+            dst += n;
+        }
+        count -= n;
+    }
+}
+
+/**
+ *  @details    展開リストオブジェクトを初期化する.
+ *              チャンクの大きさは, 2 のべき乗で二乗が @c capacity 以上となる最小の値とする.
+ *
+ *  @param      [in]    payload_bytes   データ部のサイズ.
+ *  @param      [in]    capacity        追加できる要素の数.
+ *  @return     成功時は, 展開リストオブジェクトが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+ULIST ulist_init(size_t payload_bytes, size_t capacity)
+{
+    struct ulist *self;
+    size_t shift = 2;
+    size_t chunks;
+    char *slots;
+    size_t *heads;
+
+    if ((payload_bytes == 0) || (capacity == 0) || (capacity > (SIZE_MAX / 4) / payload_bytes)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    while (((size_t)1 << (shift * 2)) < capacity) {
+        ++shift;
+    }
+    chunks = (capacity + ((size_t)1 << shift) - 1) >> shift;
+
+    self = malloc(sizeof(*self));
+    slots = calloc(chunks << shift, payload_bytes);
+    heads = calloc(chunks, sizeof(*heads));
+    if ((self == NULL) || (slots == NULL) || (heads == NULL)) {
+        free(heads);
+        free(slots);
+        free(self);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    *self = ULIST_INITIALIZER(slots, heads, payload_bytes, capacity, shift);
+
+    return (ULIST)self;
+}
+
+/**
+ *  @details    展開リストオブジェクトを解放する.
+ *
+ *  @param      [in]    list    展開リストオブジェクト.
+ */
+void ulist_release(ULIST list)
+{
+    struct ulist *self = (struct ulist *)list;
+
+    if (self != NULL) {
+        free(self->heads);
+        free(self->slots);
+        free(self);
+    }
+}
+
+/**
+ *  @details    展開リストの要素をすべて消去する.
+ *
+ *  @param      [in,out]    list    展開リストオブジェクト.
+ *  @return     成功時は 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int ulist_clear(ULIST list)
+{
+    struct ulist *self = (struct ulist *)list;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    self->count = 0;
+
+    return 0;
+}
+
+/**
+ *  @details    展開リストの @c index 番目に要素を挿入する.
+ *              挿入したチャンクより後ろのチャンクは, 末尾の要素を次のチャンクの先頭へ
+ *              1 つずつ送るため, 挿入は O(√n) で済む.
+ *
+ *  @param      [in,out]    list    展開リストオブジェクト.
+ *  @param      [in]        index   挿入する位置. 要素の数を指定すると末尾に追加する.
+ *  @param      [in]        payload 展開リストに追加するデータ.
+ *  @return     成功時は, 追加した展開リスト上のデータ部のポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @remarks    要素は挿入と削除で移動するため, 返したポインタは次に
+ *              展開リストを変更するまでのみ有効である.
+ *  @warning    スレッドセーフではない.
+ */
+void *ulist_insert(ULIST list, size_t index, void *payload)
+{
+    struct ulist *self = (struct ulist *)list;
+    size_t chunk;
+    size_t offset;
+    size_t last;
+    size_t count;
+
+    if ((self == NULL) || (payload == NULL) || (index > self->count)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (self->count >= self->capacity) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    chunk = index >> self->shift;
+    offset = index & self->mask;
+    last = self->count >> self->shift;
+
+    /* 後ろのチャンクから順に, 前のチャンクの末尾の要素を先頭に受け取る. */
+    for (size_t c = last; c > chunk; --c) {
+        self->heads[c] = (self->heads[c] - 1) & self->mask;
+        memcpy(ulist_slot(self, c, 0), ulist_slot(self, c - 1, self->mask), self->payload_bytes);
+    }
+
+    /* チャンク内では, 挿入位置の前後のうち少ない方をずらす. */
+    count = (chunk < last) ? self->mask : (self->count & self->mask);
+    if (offset < count - offset) {
+        self->heads[chunk] = (self->heads[chunk] - 1) & self->mask;
+        ulist_move(self, chunk, 0, 1, offset);
+    } else {
+        ulist_move(self, chunk, offset + 1, offset, count - offset);
+    }
+    memcpy(ulist_slot(self, chunk, offset), payload, self->payload_bytes);
+    ++self->count;
+
+    return ulist_slot(self, chunk, offset);
+}
+
+/**
+ *  @details    展開リストの末尾に要素を追加する.
+ *
+ *  @param      [in,out]    list    展開リストオブジェクト.
+ *  @param      [in]        payload 展開リストに追加するデータ.
+ *  @return     成功時は, 追加した展開リスト上のデータ部のポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+void *ulist_add(ULIST list, void *payload)
+{
+    struct ulist *self = (struct ulist *)list;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return ulist_insert(list, self->count, payload);
+}
+
+/**
+ *  @details    展開リストの @c index 番目の要素を削除する.
+ *              削除したチャンクより後ろのチャンクは, 先頭の要素を前のチャンクの末尾へ
+ *              1 つずつ送るため, 削除は O(√n) で済む.
+ *
+ *  @param      [in,out]    list    展開リストオブジェクト.
+ *  @param      [in]        index   削除する位置.
+ *  @return     成功時は 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int ulist_remove(ULIST list, size_t index)
+{
+    struct ulist *self = (struct ulist *)list;
+    size_t chunk;
+    size_t offset;
+    size_t last;
+    size_t count;
+
+    if ((self == NULL) || (index >= self->count)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    chunk = index >> self->shift;
+    offset = index & self->mask;
+    last = (self->count - 1) >> self->shift;
+
+    /* チャンク内では, 削除位置の前後のうち少ない方を詰める. */
+    count = (chunk < last) ? self->mask + 1 : self->count - (chunk << self->shift);
+    if (offset < count - 1 - offset) {
+        ulist_move(self, chunk, 1, 0, offset);
+        self->heads[chunk] = (self->heads[chunk] + 1) & self->mask;
+    } else {
+        ulist_move(self, chunk, offset, offset + 1, count - 1 - offset);
+    }
+
+    /* 前のチャンクから順に, 次のチャンクの先頭の要素を末尾に受け取る. */
+    for (size_t c = chunk + 1; c <= last; ++c) {
+        memcpy(ulist_slot(self, c - 1, self->mask), ulist_slot(self, c, 0), self->payload_bytes);
+        self->heads[c] = (self->heads[c] + 1) & self->mask;
+    }
+    --self->count;
+
+    return 0;
+}
+
+/**
+ *  @details    展開リストの @c index 番目の要素を取得する.
+ *              最後のチャンク以外は満杯であるため, 定数時間で取得できる.
+ *
+ *  @param      [in]    list    展開リストオブジェクト.
+ *  @param      [in]    index   取得する位置.
+ *  @return     成功時は, 展開リスト上のデータ部のポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+void *ulist_get(ULIST list, size_t index)
+{
+    struct ulist *self = (struct ulist *)list;
+
+    if ((self == NULL) || (index >= self->count)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return ulist_slot(self, index >> self->shift, index & self->mask);
+}
+
+/**
+ *  @details    展開リストの長さを返す.
+ *
+ *  @param      [in]    list    展開リストオブジェクト.
+ *  @return     成功時は, 展開リストの長さが返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+ssize_t ulist_count(ULIST list)
+{
+    struct ulist *self = (struct ulist *)list;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return (ssize_t)self->count;
+}
+
+/**
+ *  @details    展開リストの要素を先頭から順に辿り, 要素毎に @c visit を呼び出す.
+ *              チャンク毎に連続した領域を順に辿るため, 反復子で辿るより局所性がよい.
+ *              @c visit が 0 以外を返した場合は, その時点で走査を打ち切る.
+ *
+ *  @param      [in]    list    展開リストオブジェクト.
+ *  @param      [in]    visit   要素毎に呼び出す関数. データ部と @c ctx が渡される.
+ *  @param      [in]    ctx     @c visit に渡す任意のデータ.
+ *  @return     成功時は, すべて辿った場合は 0 が, 打ち切った場合は
+ *              @c visit の戻り値が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ *  @warning    走査中に @c list を変更してはならない.
+ */
+int ulist_walk(ULIST list, int (*visit)(void *payload, void *ctx), void *ctx)
+{
+    struct ulist *self = (struct ulist *)list;
+
+    if ((self == NULL) || (visit == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (size_t base = 0; base < self->count; base += self->mask + 1) {
+        size_t chunk = base >> self->shift;
+        size_t count = self->count - base;
+        char *first = self->slots + ((chunk << self->shift) * self->payload_bytes);
+        char *slot = ulist_slot(self, chunk, 0);
+
+        if (count > self->mask + 1) {
+            count = self->mask + 1;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            int ret = visit(slot, ctx);
+            if (ret != 0) {
+                return ret;
+            }
+            /* リングバッファの終端に達したらチャンクの先頭に戻る. */
+            slot += self->payload_bytes;
+            if (slot == first + ((self->mask + 1) * self->payload_bytes)) {
+                slot = first;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ *  キャッシュラインのサイズ.
+ */
+#define CACHE_LINE_BYTES (64)
+
+/**
+ *  複数生産者/複数消費者の並行キューの要素.
+ *  @c seq は, 積める状態では要素の位置を, 取り出せる状態では位置 + 1 を持つ.
+ */
+struct cqueue_cell {
+    _Atomic size_t seq; /**< 要素の状態を表す通し番号. */
+    char payload[];     /**< データ部. */
+};
+
+/**
+ *  並行キュー管理構造体.
+ *  生産者と消費者がそれぞれ更新する値は, 別のキャッシュラインに置く.
+ */
+struct cqueue {
+    _Alignas(CACHE_LINE_BYTES) _Atomic size_t tail; /**< 次に積める位置. */
+    size_t head_cache;                              /**< 単一生産者が最後に読んだ @c head. */
+    _Alignas(CACHE_LINE_BYTES) _Atomic size_t head; /**< 次に取り出す位置. */
+    size_t tail_cache;                              /**< 単一消費者が最後に読んだ @c tail. */
+    _Alignas(CACHE_LINE_BYTES) char *cells;         /**< 要素の配列. */
+    size_t cell_bytes;                              /**< 要素のサイズ. */
+    size_t payload_bytes;                           /**< データ部のサイズ. */
+    size_t mask;                                    /**< 要素の数 - 1. */
+    enum cqueue_mode mode;                          /**< 生産者と消費者の数. */
+};
+
+/**
+ *  並行キューの位置 @c pos の要素を取得する.
+ *
+ *  @param  [in]    self    並行キューオブジェクト.
+ *  @param  [in]    pos     位置. 要素の数を超える値は折り返す.
+ *  @return 要素のポインタが返る.
+ */
+static inline void *cqueue_cell(const struct cqueue *self, size_t pos)
+{
+    return self->cells + ((pos & self->mask) * self->cell_bytes);
+}
+
+/**
+ *  単一生産者/単一消費者の並行キューで, 位置 @c pos から @c n 個の要素を
+ *  複写する. リングバッファは高々 1 回しか折り返さないため, memcpy は 2 回で済む.
+ *
+ *  @param  [in]        self    並行キューオブジェクト.
+ *  @param  [in]        pos     先頭の位置.
+ *  @param  [in,out]    buf     複写元または複写先のバッファ.
+ *  @param  [in]        n       要素の数.
+ *  @param  [in]        to_ring true の場合はキューへ, false の場合はバッファへ複写する.
+ */
+static inline void cqueue_copy(const struct cqueue *self, size_t pos, void *buf, size_t n, bool to_ring)
+{
+    size_t first = self->mask + 1 - (pos & self->mask);
+    size_t bytes;
+
+    if (first > n) {
+        first = n;
+    }
+    bytes = self->payload_bytes * first;
+    if (to_ring) {
+        memcpy(cqueue_cell(self, pos), buf, bytes);
+        memcpy(self->cells, (char *)buf + bytes, self->payload_bytes * (n - first));
+    } else {
+        memcpy(buf, cqueue_cell(self, pos), bytes);
+        memcpy((char *)buf + bytes, self->cells, self->payload_bytes * (n - first));
+    }
+}
+
+/**
+ *  @details    並行キューオブジェクトを初期化する.
+ *              要素の数は @c capacity を 2 のべき乗に切り上げたものとなり,
+ *              その数まで積める.
+ *
+ *  @param      [in]    payload_bytes   データ部のサイズ.
+ *  @param      [in]    capacity        積める要素の数.
+ *  @param      [in]    mode            生産者と消費者の数.
+ *  @return     成功時は, 並行キューオブジェクトが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+CQUEUE cqueue_init(size_t payload_bytes, size_t capacity, enum cqueue_mode mode)
+{
+    struct cqueue *self;
+    size_t slots = 1;
+    size_t cell_bytes;
+    char *cells;
+
+    if ((payload_bytes == 0) || (payload_bytes > NODE_PAYLOAD_MAX(struct cqueue_cell)) ||
+        (capacity == 0) || (capacity > (SIZE_MAX >> 1) + 1) ||
+        ((mode != CQUEUE_SPSC) && (mode != CQUEUE_MPMC))) {
+        errno = EINVAL;
+        return NULL;
+    }
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+    /* 2 のべき乗に切り上げた数の, 通番を含む要素が確保できること. */
+    cell_bytes = (mode == CQUEUE_SPSC) ? payload_bytes : NODE_BYTES(struct cqueue_cell, payload_bytes);
+    if (slots > SIZE_MAX / cell_bytes) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    self = aligned_alloc(CACHE_LINE_BYTES, sizeof(*self));
+    cells = calloc(slots, cell_bytes);
+    if ((self == NULL) || (cells == NULL)) {
+        free(cells);
+        free(self);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    memset(self, 0, sizeof(*self));
+    atomic_init(&self->tail, 0);
+    atomic_init(&self->head, 0);
+    self->cells = cells;
+    self->cell_bytes = cell_bytes;
+    self->payload_bytes = payload_bytes;
+    self->mask = slots - 1;
+    self->mode = mode;
+    if (mode == CQUEUE_MPMC) {
+        for (size_t i = 0; i < slots; ++i) {
+            atomic_init(&((struct cqueue_cell *)cqueue_cell(self, i))->seq, i);
+        }
+    }
+
+    return (CQUEUE)self;
+}
+
+/**
+ *  @details    並行キューオブジェクトを解放する.
+ *
+ *  @param      [in]    que     並行キューオブジェクト.
+ *  @warning    他のスレッドが使用していないこと.
+ */
+void cqueue_release(CQUEUE que)
+{
+    struct cqueue *self = (struct cqueue *)que;
+
+    if (self != NULL) {
+        free(self->cells);
+        free(self);
+    }
+}
+
+/**
+ *  @details    @c que の最後に要素を追加する.
+ *              @ref CQUEUE_MPMC では, 空いている要素の位置を CAS で予約し,
+ *              データ部を書いた後に要素の通し番号を進めて消費者に渡す.
+ *
+ *  @param      [in,out]    que     並行キューオブジェクト.
+ *  @param      [in]        payload キューに追加するデータ.
+ *  @return     成功時は 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              満杯の場合は ENOMEM となる.
+ *  @remarks    @ref CQUEUE_SPSC では, 同時に呼び出せるのは 1 スレッドのみである.
+ */
+int cqueue_enq(CQUEUE que, const void *payload)
+{
+    struct cqueue *self = (struct cqueue *)que;
+    struct cqueue_cell *cell;
+    size_t pos;
+
+    if ((self == NULL) || (payload == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pos = atomic_load_explicit(&self->tail, memory_order_relaxed);
+    if (self->mode == CQUEUE_SPSC) {
+        if (pos - self->head_cache > self->mask) {
+            self->head_cache = atomic_load_explicit(&self->head, memory_order_acquire);
+            if (pos - self->head_cache > self->mask) {
+                errno = ENOMEM;
+                return -1;
+            }
+        }
+        memcpy(cqueue_cell(self, pos), payload, self->payload_bytes);
+        atomic_store_explicit(&self->tail, pos + 1, memory_order_release);
+        return 0;
+    }
+
+    for (;;) {
+        intptr_t diff;
+
+        cell = cqueue_cell(self, pos);
+        diff = (intptr_t)(atomic_load_explicit(&cell->seq, memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&self->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* 1 周前の要素がまだ取り出されていない. */
+            errno = ENOMEM;
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&self->tail, memory_order_relaxed);
+        }
+    }
+    memcpy(cell->payload, payload, self->payload_bytes);
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+    return 0;
+}
+
+/**
+ *  @details    @c que の最初の要素をコピーし, 削除する.
+ *              @ref CQUEUE_MPMC では, 取り出せる要素の位置を CAS で予約し,
+ *              データ部を読んだ後に要素の通し番号を 1 周先へ進めて生産者に返す.
+ *
+ *  @param      [in,out]    que     並行キューオブジェクト.
+ *  @param      [out]       payload データ部をコピーするバッファ.
+ *  @return     成功時は 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              空の場合は EAGAIN となる.
+ *  @remarks    @ref CQUEUE_SPSC では, 同時に呼び出せるのは 1 スレッドのみである.
+ */
+int cqueue_deq(CQUEUE que, void *payload)
+{
+    struct cqueue *self = (struct cqueue *)que;
+    struct cqueue_cell *cell;
+    size_t pos;
+
+    if ((self == NULL) || (payload == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pos = atomic_load_explicit(&self->head, memory_order_relaxed);
+    if (self->mode == CQUEUE_SPSC) {
+        if (pos == self->tail_cache) {
+            self->tail_cache = atomic_load_explicit(&self->tail, memory_order_acquire);
+            if (pos == self->tail_cache) {
+                errno = EAGAIN;
+                return -1;
+            }
+        }
+        memcpy(payload, cqueue_cell(self, pos), self->payload_bytes);
+        atomic_store_explicit(&self->head, pos + 1, memory_order_release);
+        return 0;
+    }
+
+    for (;;) {
+        intptr_t diff;
+
+        cell = cqueue_cell(self, pos);
+        diff = (intptr_t)(atomic_load_explicit(&cell->seq, memory_order_acquire) - (pos + 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&self->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* まだ積まれていない. */
+            errno = EAGAIN;
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&self->head, memory_order_relaxed);
+        }
+    }
+    memcpy(payload, cell->payload, self->payload_bytes);
+    atomic_store_explicit(&cell->seq, pos + self->mask + 1, memory_order_release);
+
+    return 0;
+}
+
+/**
+ *  @details    @c que の最後に @c payloads の先頭から最大 @c n 個の要素を
+ *              追加する. 空きが足りない場合は, 空きの分だけ追加する.
+ *              @ref CQUEUE_SPSC では, 空きを確かめた後に高々 2 回の memcpy で複写し,
+ *              @c tail を 1 度だけ進める.
+ *              @ref CQUEUE_MPMC では, 1 要素ずつ @ref cqueue_enq と同じ手順で追加する.
+ *
+ *  @param      [in,out]    que         並行キューオブジェクト.
+ *  @param      [in]        payloads    追加するデータの配列.
+ *  @param      [in]        n           追加するデータの数.
+ *  @return     成功時は, 追加した要素の数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+ssize_t cqueue_enq_bulk(CQUEUE que, const void *payloads, size_t n)
+{
+    struct cqueue *self = (struct cqueue *)que;
+    size_t pos;
+    size_t room;
+
+    if ((self == NULL) || ((payloads == NULL) && (n > 0))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (self->mode == CQUEUE_MPMC) {
+        size_t i;
+        for (i = 0; i < n; ++i) {
+            if (cqueue_enq(que, (const char *)payloads + (i * self->payload_bytes)) != 0) {
+                break;
+            }
+        }
+        return (ssize_t)i;
+    }
+
+    pos = atomic_load_explicit(&self->tail, memory_order_relaxed);
+    room = self->mask + 1 - (pos - self->head_cache);
+    if (room < n) {
+        self->head_cache = atomic_load_explicit(&self->head, memory_order_acquire);
+        room = self->mask + 1 - (pos - self->head_cache);
+    }
+    if (n > room) {
+        n = room;
+    }
+    if (n > 0) {
+        cqueue_copy(self, pos, (void *)payloads, n, true);
+        atomic_store_explicit(&self->tail, pos + n, memory_order_release);
+    }
+
+    return (ssize_t)n;
+}
+
+/**
+ *  @details    @c que の先頭から最大 @c n 個の要素を @c payloads にコピーし,
+ *              削除する. 要素が足りない場合は, ある分だけ取り出す.
+ *              @ref CQUEUE_SPSC では, 高々 2 回の memcpy で複写し,
+ *              @c head を 1 度だけ進める.
+ *              @ref CQUEUE_MPMC では, 1 要素ずつ @ref cqueue_deq と同じ手順で取り出す.
+ *
+ *  @param      [in,out]    que         並行キューオブジェクト.
+ *  @param      [out]       payloads    データ部をコピーする配列.
+ *  @param      [in]        n           取り出す要素の最大数.
+ *  @return     成功時は, 取り出した要素の数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+ssize_t cqueue_deq_bulk(CQUEUE que, void *payloads, size_t n)
+{
+    struct cqueue *self = (struct cqueue *)que;
+    size_t pos;
+    size_t avail;
+
+    if ((self == NULL) || ((payloads == NULL) && (n > 0))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (self->mode == CQUEUE_MPMC) {
+        size_t i;
+        for (i = 0; i < n; ++i) {
+            if (cqueue_deq(que, (char *)payloads + (i * self->payload_bytes)) != 0) {
+                break;
+            }
+        }
+        return (ssize_t)i;
+    }
+
+    pos = atomic_load_explicit(&self->head, memory_order_relaxed);
+    avail = self->tail_cache - pos;
+    if (avail < n) {
+        self->tail_cache = atomic_load_explicit(&self->tail, memory_order_acquire);
+        avail = self->tail_cache - pos;
+    }
+    if (n > avail) {
+        n = avail;
+    }
+    if (n > 0) {
+        cqueue_copy(self, pos, payloads, n, false);
+        atomic_store_explicit(&self->head, pos + n, memory_order_release);
+    }
+
+    return (ssize_t)n;
+}
+
+/**
+ *  @details    @c que の長さを返す.
+ *              他のスレッドが出し入れしている間は, 呼び出した時点の概数となる.
+ *
+ *  @param      [in]    que     並行キューオブジェクト.
+ *  @return     成功時は, @c que の長さが返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+ssize_t cqueue_count(CQUEUE que)
+{
+    struct cqueue *self = (struct cqueue *)que;
+    size_t head, tail;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    head = atomic_load_explicit(&self->head, memory_order_acquire);
+    tail = atomic_load_explicit(&self->tail, memory_order_acquire);
+    if ((ssize_t)(tail - head) < 0) {
+        return 0;
+    }
+
+    return (ssize_t)(((tail - head) > self->mask + 1) ? self->mask + 1 : tail - head);
+}
+
+/**
+ *  マップ管理構造体.
+ *
+ *  キーと値を連結した要素を @ref SET に置き, キーの部分のみで
+ *  ハッシュと等価判定を行う.
+ */
+struct map {
+    struct set *set;            /**< キーと値を連結した要素のセット. */
+    size_t key_bytes;           /**< キーのサイズ. */
+    size_t value_offset;        /**< 要素の先頭から値までのオフセット. */
+    size_t value_bytes;         /**< 値のサイズ. */
+};
+
+/**
+ *  @c key を持つ要素の値を取得する.
+ *
+ *  @param  [in]    self    マップオブジェクト.
+ *  @param  [in]    key     キー.
+ *  @param  [in]    hash    @c key のハッシュ値.
+ *  @return 見つかった場合は, 値のポインタが返る.
+ *          見つからない場合は, NULL が返る.
+ *  @pre    @c self および @c key の非 NULL は呼び出し側で保証すること.
+ */
+static inline void *map_find(const struct map *self, const void *key, size_t hash)
+{
+    ssize_t found = set_find(self->set, key, (uint32_t)hash);
+
+    if (found < 0) {
+        return NULL;
+    }
+
+    return set_cell(self->set, self->set->buckets[found].index)->payload + self->value_offset;
+}
+
+/**
+ *  @c key の値を @c value にする. @c key がなければ追加する.
+ *
+ *  @param  [in,out]    self    マップオブジェクト.
+ *  @param  [in]        key     キー.
+ *  @param  [in]        value   値.
+ *  @param  [in]        hash    @c key のハッシュ値.
+ *  @return 成功時は, マップ上の値のポインタが返る.
+ *          失敗時は, NULL が返り, errno が適切に設定される.
+ *  @pre    @c self, @c key および @c value の非 NULL は呼び出し側で保証すること.
+ */
+static void *map_store(struct map *self, const void *key, const void *value, size_t hash)
+{
+    char *slot = map_find(self, key, hash);
+
+    if (slot == NULL) {
+        slot = set_emplace(self->set, (uint32_t)hash);
+        if (slot == NULL) {
+            return NULL;
+        }
+        memcpy(slot, key, self->key_bytes);
+        slot += self->value_offset;
+    }
+    memcpy(slot, value, self->value_bytes);
+
+    return slot;
+}
+
+/**
+ *  @details    空で, 指定の容量を備えた, @ref MAP オブジェクトを確保
+ *              および初期化する.
+ *              値は, そのサイズに応じた境界 (ポインタの境界まで) に置く.
+ *
+ *  @param      [in]    key_bytes   キーのサイズ.
+ *  @param      [in]    value_bytes 値のサイズ.
+ *  @param      [in]    capacity    マップの容量.
+ *  @return     成功時は, 確保および初期化したオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+MAP map_init(size_t key_bytes, size_t value_bytes, size_t capacity)
+{
+    struct map *self;
+    size_t align = _Alignof(struct list_node);
+    size_t value_offset;
+
+    if ((key_bytes == 0) || (value_bytes == 0) || (key_bytes > NODE_PAYLOAD_MAX(struct list_node))) {
+        errno = EINVAL;
+        return NULL;
+    }
+    while ((value_bytes % align) != 0) {
+        align >>= 1;
+    }
+    /* キー, 境界調整および値を合わせた要素がノードに収まること. */
+    value_offset = (key_bytes + align - 1) & ~(align - 1);
+    if (value_bytes > NODE_PAYLOAD_MAX(struct list_node) - value_offset) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    self = malloc(sizeof(*self));
+    if (self == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    self->key_bytes = key_bytes;
+    self->value_offset = value_offset;
+    self->value_bytes = value_bytes;
+    self->set = (struct set *)set_init(self->value_offset + value_bytes, capacity);
+    if (self->set == NULL) {
+        free(self);
+        return NULL;
+    }
+    self->set->key_bytes = key_bytes;
+
+    return (MAP)self;
+}
+
+/**
+ *  @details    @c map を解放する.
+ *
+ *  @param      [in,out]    map マップオブジェクト.
+ *  @warning    スレッドセーフではない.
+ */
+void map_release(MAP map)
+{
+    struct map *self = (struct map *)map;
+
+    if (self != NULL) {
+        set_release((SET)self->set);
+        free(self);
+    }
+}
+
+/**
+ *  @details    @c map を空の状態にする.
+ *
+ *  @param      [in,out]    map マップオブジェクト.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int map_clear(MAP map)
+{
+    struct map *self = (struct map *)map;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return set_clear((SET)self->set);
+}
+
+/**
+ *  @details    @c map の @c key の値を @c value にする.
+ *              @c key がなければ追加し, あれば値を上書きする.
+ *
+ *  @param      [in,out]    map     マップオブジェクト.
+ *  @param      [in]        key     キー.
+ *  @param      [in]        value   値.
+ *  @return     成功時は, マップ上の値のポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @remarks    要素は削除で移動するため, 返したポインタは次に
+ *              要素を削除するまでのみ有効である.
+ *  @warning    スレッドセーフではない.
+ */
+void *map_put(MAP map, const void *key, const void *value)
+{
+    struct map *self = (struct map *)map;
+
+    if ((self == NULL) || (key == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return map_store(self, key, value, set_default_hash(key, self->key_bytes));
+}
+
+/**
+ *  @details    @c map から @c key の値を取得する.
+ *
+ *  @param      [in]    map マップオブジェクト.
+ *  @param      [in]    key キー.
+ *  @return     成功時は, マップ上の値のポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *              @c key がない場合は ENOENT となる.
+ *  @warning    スレッドセーフではない.
+ */
+void *map_get(MAP map, const void *key)
+{
+    struct map *self = (struct map *)map;
+    void *value;
+
+    if ((self == NULL) || (key == NULL)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    value = map_find(self, key, set_default_hash(key, self->key_bytes));
+    if (value == NULL) {
+        errno = ENOENT;
+    }
+
+    return value;
+}
+
+/**
+ *  @details    @c map から @c key の要素を削除する.
+ *              最後に追加した要素を空いた位置に移すため, その値のポインタは変わる.
+ *
+ *  @param      [in,out]    map マップオブジェクト.
+ *  @param      [in]        key キー.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              @c key がない場合は ENOENT となる.
+ *  @warning    スレッドセーフではない.
+ */
+int map_remove(MAP map, const void *key)
+{
+    struct map *self = (struct map *)map;
+
+    if ((self == NULL) || (key == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return set_remove((SET)self->set, key);
+}
+
+/**
+ *  @details    @c map に追加されている要素の数を返す.
+ *
+ *  @param      [in]    map マップオブジェクト.
+ *  @return     成功時は, @c map に追加されている要素の数を返す.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+ssize_t map_count(MAP map)
+{
+    struct map *self = (struct map *)map;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return (ssize_t)self->set->count;
+}
+
+/**
+ *  @details    @c map の要素を追加順に辿り, 要素毎に @c visit を呼び出す.
+ *              @c visit が 0 以外を返した場合は, その時点で走査を打ち切る.
+ *
+ *  @param      [in]    map     マップオブジェクト.
+ *  @param      [in]    visit   要素毎に呼び出す関数. キー, 値および @c ctx が渡される.
+ *  @param      [in]    ctx     @c visit に渡す任意のデータ.
+ *  @return     成功時は, すべて辿った場合は 0 が, 打ち切った場合は
+ *              @c visit の戻り値が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ *  @warning    走査中に要素を追加, 削除してはならない. 値の書き換えは行ってよい.
+ */
+int map_walk(MAP map, int (*visit)(const void *key, void *value, void *ctx), void *ctx)
+{
+    struct map *self = (struct map *)map;
+
+    if ((self == NULL) || (visit == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (size_t i = 0; i < self->set->count; ++i) {
+        char *payload = set_cell(self->set, i)->payload;
+        int ret = visit(payload, payload + self->value_offset, ctx);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ *  並行マップの分割数の対数.
+ */
+#define CMAP_SHARD_BITS (4)
+
+/**
+ *  並行マップの分割数.
+ */
+#define CMAP_SHARDS (1 << CMAP_SHARD_BITS)
+
+/**
+ *  並行マップの分割毎に平均の 2 倍に加えて確保する容量.
+ */
+#define CMAP_SHARD_SLACK (64)
+
+/**
+ *  並行マップの分割.
+ *  分割毎のロックが別のキャッシュラインに載るよう, 境界を揃える.
+ */
+struct cmap_shard {
+    _Alignas(CACHE_LINE_BYTES) pthread_rwlock_t lock;   /**< 分割の読み書きロック. */
+    struct map *map;                                    /**< 分割のマップ. */
+};
+
+/**
+ *  並行マップ管理構造体.
+ */
+struct cmap {
+    struct cmap_shard *shards;  /**< 分割の配列. */
+    size_t key_bytes;           /**< キーのサイズ. */
+    size_t value_bytes;         /**< 値のサイズ. */
+};
+
+/**
+ *  @c hash のキーを持つ分割を取得する.
+ *  分割内のハッシュ表は下位ビットを用いるため, 最上位のビットで選ぶ.
+ *
+ *  @param  [in]    self    並行マップオブジェクト.
+ *  @param  [in]    hash    キーのハッシュ値.
+ *  @return 分割のポインタが返る.
+ */
+static inline struct cmap_shard *cmap_shard(const struct cmap *self, size_t hash)
+{
+    return &self->shards[hash >> ((sizeof(hash) * 8) - CMAP_SHARD_BITS)];
+}
+
+/**
+ *  @details    空で, 指定の容量を備えた, @ref CMAP オブジェクトを確保
+ *              および初期化する.
+ *              キーのハッシュ値で 16 個の分割に振り分け, 分割毎に読み書きロックを持つ.
+ *              偏りを吸収するため, 各分割には平均の 2 倍に 64 を加えた容量
+ *              (ただし @c capacity 以下) を確保する.
+ *              このため @c capacity が 64 以下の場合は, キーが 1 つの分割に
+ *              偏っても必ず @c capacity まで格納できる.
+ *              それより大きい場合は, 分割毎のキーの数の揺らぎ (平均の平方根程度) を
+ *              十分に上回るため, ハッシュ値が極端に偏らない限り @c capacity まで
+ *              格納できる.
+ *
+ *  @param      [in]    key_bytes   キーのサイズ.
+ *  @param      [in]    value_bytes 値のサイズ.
+ *  @param      [in]    capacity    マップの容量.
+ *  @return     成功時は, 確保および初期化したオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+CMAP cmap_init(size_t key_bytes, size_t value_bytes, size_t capacity)
+{
+    struct cmap *self;
+    size_t per_shard;
+
+    if ((capacity == 0) || (capacity > SET_CAPACITY_MAX)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    per_shard = (((capacity + CMAP_SHARDS - 1) / CMAP_SHARDS) * 2) + CMAP_SHARD_SLACK;
+    if (per_shard > capacity) {
+        per_shard = capacity;
+    }
+
+    self = malloc(sizeof(*self));
+    if (self != NULL) {
+        self->shards = aligned_alloc(CACHE_LINE_BYTES, sizeof(*self->shards) * CMAP_SHARDS);
+    }
+    if ((self == NULL) || (self->shards == NULL)) {
+        free(self);
+        errno = ENOMEM;
+        return NULL;
+    }
+    self->key_bytes = key_bytes;
+    self->value_bytes = value_bytes;
+
+    for (int i = 0; i < CMAP_SHARDS; ++i) {
+        struct cmap_shard *shard = &self->shards[i];
+        int err = pthread_rwlock_init(&shard->lock, NULL);
+
+        if (err == 0) {
+            shard->map = (struct map *)map_init(key_bytes, value_bytes, per_shard);
+            if (shard->map == NULL) {
+                err = errno;
+                pthread_rwlock_destroy(&shard->lock);
+            }
+        }
+        if (err != 0) {
+            while (--i >= 0) {
+                pthread_rwlock_destroy(&self->shards[i].lock);
+                map_release((MAP)self->shards[i].map);
+            }
+            free(self->shards);
+            free(self);
+            errno = err;
+            return NULL;
+        }
+    }
+
+    return (CMAP)self;
+}
+
+/**
+ *  @details    @c cmap を解放する.
+ *
+ *  @param      [in,out]    cmap    並行マップオブジェクト.
+ *  @warning    他のスレッドが使用していないこと.
+ */
+void cmap_release(CMAP cmap)
+{
+    struct cmap *self = (struct cmap *)cmap;
+
+    if (self != NULL) {
+        for (int i = 0; i < CMAP_SHARDS; ++i) {
+            pthread_rwlock_destroy(&self->shards[i].lock);
+            map_release((MAP)self->shards[i].map);
+        }
+        free(self->shards);
+        free(self);
+    }
+}
+
+/**
+ *  @details    @c cmap の @c key の値を @c value にする.
+ *              @c key がなければ追加し, あれば値を上書きする.
+ *              キーの属する分割のみを書き込みロックする.
+ *
+ *  @param      [in,out]    cmap    並行マップオブジェクト.
+ *  @param      [in]        key     キー.
+ *  @param      [in]        value   値.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              分割が満杯の場合は ENOMEM となる.
+ */
+int cmap_put(CMAP cmap, const void *key, const void *value)
+{
+    struct cmap *self = (struct cmap *)cmap;
+    struct cmap_shard *shard;
+    size_t hash;
+    void *slot;
+
+    if ((self == NULL) || (key == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    hash = set_default_hash(key, self->key_bytes);
+    shard = cmap_shard(self, hash);
+    pthread_rwlock_wrlock(&shard->lock);
+    slot = map_store(shard->map, key, value, hash);
+    pthread_rwlock_unlock(&shard->lock);
+
+    return (slot != NULL) ? 0 : -1;
+}
+
+/**
+ *  @details    @c cmap から @c key の値を @c value にコピーする.
+ *              キーの属する分割のみを読み込みロックするため,
+ *              読み込みどうしは並行して行える.
+ *
+ *  @param      [in]    cmap    並行マップオブジェクト.
+ *  @param      [in]    key     キー.
+ *  @param      [out]   value   値をコピーするバッファ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              @c key がない場合は ENOENT となる.
+ */
+int cmap_get(CMAP cmap, const void *key, void *value)
+{
+    struct cmap *self = (struct cmap *)cmap;
+    struct cmap_shard *shard;
+    size_t hash;
+    void *slot;
+
+    if ((self == NULL) || (key == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    hash = set_default_hash(key, self->key_bytes);
+    shard = cmap_shard(self, hash);
+    pthread_rwlock_rdlock(&shard->lock);
+    slot = map_find(shard->map, key, hash);
+    if (slot != NULL) {
+        memcpy(value, slot, self->value_bytes);
+    }
+    pthread_rwlock_unlock(&shard->lock);
+
+    if (slot == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    @c cmap から @c key の要素を削除する.
+ *
+ *  @param      [in,out]    cmap    並行マップオブジェクト.
+ *  @param      [in]        key     キー.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              @c key がない場合は ENOENT となる.
+ */
+int cmap_remove(CMAP cmap, const void *key)
+{
+    struct cmap *self = (struct cmap *)cmap;
+    struct cmap_shard *shard;
+    int ret;
+
+    if ((self == NULL) || (key == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    shard = cmap_shard(self, set_default_hash(key, self->key_bytes));
+    pthread_rwlock_wrlock(&shard->lock);
+    ret = map_remove((MAP)shard->map, key);
+    pthread_rwlock_unlock(&shard->lock);
+
+    return ret;
+}
+
+/**
+ *  @details    @c cmap に追加されている要素の数を返す.
+ *              分割毎に数えるため, 他のスレッドが変更している間は概数となる.
+ *
+ *  @param      [in]    cmap    並行マップオブジェクト.
+ *  @return     成功時は, @c cmap に追加されている要素の数を返す.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+ssize_t cmap_count(CMAP cmap)
+{
+    struct cmap *self = (struct cmap *)cmap;
+    ssize_t count = 0;
+
+    if (self == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (int i = 0; i < CMAP_SHARDS; ++i) {
+        pthread_rwlock_rdlock(&self->shards[i].lock);
+        count += (ssize_t)self->shards[i].map->set->count;
+        pthread_rwlock_unlock(&self->shards[i].lock);
+    }
+
+    return count;
 }
@@ -0,0 +1,447 @@
+/** @file   export.c
+ *  @brief  状態遷移定義のグラフ出力.
+ *
+ *  状態には状態遷移表の索引による番号を割り当て, 番号を識別子として出力する.
+ *  出力は 1 回の走査で行い, 固定長のバッファが一杯になる度に書き込み関数へ
+ *  渡すため, 状態名などの長さや階層の深さによる切り詰めは発生しない.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#include "debug.h"
+#include "chart.h"
+#include "export.h"
+
+/**
+ *  出力バッファのサイズ.
+ */
+#define EXPORT_BUFFER_BYTES (512)
+
+/**
+ *  出力器構造体.
+ */
+struct exporter {
+    int (*writer)(void *, const char *, size_t); /**< 書き込み関数. */
+    void *ctx;                                   /**< 書き込み関数の引数. */
+    int error;                                   /**< 発生したエラー. */
+    size_t len;                                  /**< バッファの使用量. */
+    char buf[EXPORT_BUFFER_BYTES];               /**< 出力バッファ. */
+};
+
+/**
+ *  出力器構造体の初期化子.
+ */
+#define EXPORTER_INITIALIZER(w, c) \
+    (struct exporter){             \
+        .writer = (w),             \
+        .ctx = (c),                \
+        .error = 0,                \
+        .len = 0                   \
+    }
+
+/**
+ *  バッファの内容を書き込み関数に渡す.
+ *
+ *  @param  [in,out]    ex  出力器.
+ */
+static void export_flush(struct exporter *ex)
+{
+    if ((ex->error == 0) && (ex->len > 0)) {
+        errno = 0;
+        if (ex->writer(ex->ctx, ex->buf, ex->len) != 0) {
+            ex->error = (errno != 0) ? errno : EIO;
+        }
+    }
+    ex->len = 0;
+}
+
+/**
+ *  バイト列を出力する.
+ *
+ *  @param  [in,out]    ex  出力器.
+ *  @param  [in]        s   バイト列.
+ *  @param  [in]        len バイト列の長さ.
+ */
+static void export_write(struct exporter *ex, const char *s, size_t len)
+{
+    while ((ex->error == 0) && (len > 0)) {
+        size_t room = sizeof(ex->buf) - ex->len;
+        size_t n = (len < room) ? len : room;
+
+        memcpy(&ex->buf[ex->len], s, n);
+        ex->len += n;
+        s += n;
+        len -= n;
+        if (ex->len == sizeof(ex->buf)) {
+            export_flush(ex);
+        }
+    }
+}
+
+/**
+ *  文字列を出力する.
+ *
+ *  @param  [in,out]    ex  出力器.
+ *  @param  [in]        s   文字列.
+ */
+static inline void export_puts(struct exporter *ex, const char *s)
+{
+    export_write(ex, s, strlen(s));
+}
+
+/**
+ *  整数を 10 進数で出力する.
+ *
+ *  @param  [in,out]    ex      出力器.
+ *  @param  [in]        value   整数.
+ */
+static void export_int(struct exporter *ex, long value)
+{
+    char digits[24];
+    int len = snprintf(digits, sizeof(digits), "%ld", value);
+
+    export_write(ex, digits, (size_t)len);
+}
+
+/**
+ *  状態の識別子を DOT 形式で出力する.
+ *
+ *  @param  [in,out]    ex  出力器.
+ *  @param  [in]        id  状態の番号.
+ */
+static inline void export_dot_node(struct exporter *ex, int id)
+{
+    export_puts(ex, "s");
+    export_int(ex, id);
+}
+
+/**
+ *  文字列を DOT 形式の引用符内で有効となるようエスケープして出力する.
+ *
+ *  @param  [in,out]    ex  出力器.
+ *  @param  [in]        s   文字列. (NULL は空文字列として扱う)
+ */
+static void export_dot_escaped(struct exporter *ex, const char *s)
+{
+    const char *run = s;
+
+    if (s == NULL) {
+        return;
+    }
+
+    for (; *s != '\0'; ++s) {
+        const char *escape;
+        switch (*s) {
+        case '"':
+            escape = "\\\"";
+            break;
+        case '\\':
+            escape = "\\\\";
+            break;
+        case '\n':
+            escape = "\\n";
+            break;
+        default:
+            escape = ((unsigned char)*s < 0x20) ? " " : NULL;
+            break;
+        }
+        if (escape != NULL) {
+            export_write(ex, run, (size_t)(s - run));
+            export_puts(ex, escape);
+            run = s + 1;
+        }
+    }
+    export_write(ex, run, (size_t)(s - run));
+}
+
+/**
+ *  文字列を JSON 形式の文字列としてエスケープして出力する.
+ *
+ *  @param  [in,out]    ex  出力器.
+ *  @param  [in]        s   文字列. (NULL は null として出力する)
+ */
+static void export_json_string(struct exporter *ex, const char *s)
+{
+    const char *run = s;
+
+    if (s == NULL) {
+        export_puts(ex, "null");
+        return;
+    }
+
+    export_puts(ex, "\"");
+    for (; *s != '\0'; ++s) {
+        char escape[8];
+        unsigned char c = (unsigned char)*s;
+        if ((c != '"') && (c != '\\') && (c >= 0x20)) {
+            continue;
+        }
+        switch (c) {
+        case '"':
+            strcpy(escape, "\\\"");
+            break;
+        case '\\':
+            strcpy(escape, "\\\\");
+            break;
+        case '\n':
+            strcpy(escape, "\\n");
+            break;
+        case '\r':
+            strcpy(escape, "\\r");
+            break;
+        case '\t':
+            strcpy(escape, "\\t");
+            break;
+        default:
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            break;
+        }
+        export_write(ex, run, (size_t)(s - run));
+        export_puts(ex, escape);
+        run = s + 1;
+    }
+    export_write(ex, run, (size_t)(s - run));
+    export_puts(ex, "\"");
+}
+
+/**
+ *  状態の番号を JSON 形式で出力する.
+ *
+ *  @param  [in,out]    ex  出力器.
+ *  @param  [in]        id  状態の番号. (負の場合は null として出力する)
+ */
+static inline void export_json_id(struct exporter *ex, int id)
+{
+    if (id < 0) {
+        export_puts(ex, "null");
+    } else {
+        export_int(ex, id);
+    }
+}
+
+/**
+ *  出力を完了する.
+ *
+ *  @param  [in,out]    ex      出力器.
+ *  @param  [in,out]    chart   状態遷移表の索引.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int export_finish(struct exporter *ex, struct chart *chart)
+{
+    export_flush(ex);
+    chart_release(chart);
+    if (ex->error != 0) {
+        errno = ex->error;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    @c rels と @c corresps で定義される状態遷移を DOT 形式で出力する.
+ *              状態は @c s<番号> のノードとし, 状態名をラベルとする.
+ *              階層は親から子への点線の辺で表し, 既定の子の辺は太線とする.
+ *              遷移は "イベント [ガード条件] / 遷移アクション" をラベルとする辺で,
+ *              内部遷移は破線の自己ループで表す.
+ *
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @param      [in]    writer      書き込み関数. 成功時に 0 を返すこと.
+ *  @param      [in]    ctx         書き込み関数の第 1 引数.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fsm_export_dot(const struct fsm_rels *rels,
+                   const struct fsm_trans *corresps,
+                   int (*writer)(void *, const char *, size_t),
+                   void *ctx)
+{
+    struct exporter ex = EXPORTER_INITIALIZER(writer, ctx);
+    struct chart chart;
+
+    if ((corresps == NULL) || (writer == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (chart_build(&chart, rels, corresps) != 0) {
+        return -1;
+    }
+
+    export_puts(&ex, "digraph hfsm {\n");
+    for (size_t i = 0; i < chart.nstates; ++i) {
+        export_puts(&ex, "    ");
+        export_dot_node(&ex, (int)i);
+        export_puts(&ex, " [label=\"");
+        export_dot_escaped(&ex, chart.states[i]->name);
+        export_puts(&ex, "\"];\n");
+    }
+    for (size_t i = 0; i < chart.nstates; ++i) {
+        int parent = chart.parents[i];
+        if (parent < 0) {
+            continue;
+        }
+        export_puts(&ex, "    ");
+        export_dot_node(&ex, parent);
+        export_puts(&ex, " -> ");
+        export_dot_node(&ex, (int)i);
+        export_puts(&ex, (chart.histories[parent] == (int)i)
+                         ? " [style=\"dotted,bold\", arrowhead=none];\n"
+                         : " [style=dotted, arrowhead=none];\n");
+    }
+    for (size_t i = 0; i < chart.ntrans; ++i) {
+        const struct fsm_trans *corr = &chart.corresps[i];
+        export_puts(&ex, "    ");
+        export_dot_node(&ex, chart.froms[i]);
+        export_puts(&ex, " -> ");
+        export_dot_node(&ex, (chart.tos[i] < 0) ? chart.froms[i] : chart.tos[i]);
+        export_puts(&ex, " [label=\"");
+        export_dot_escaped(&ex, corr->event->name);
+        if (corr->cond != NULL) {
+            export_puts(&ex, " [");
+            export_dot_escaped(&ex, corr->cond->name);
+            export_puts(&ex, "]");
+        }
+        if (corr->action != NULL) {
+            export_puts(&ex, " / ");
+            export_dot_escaped(&ex, corr->action->name);
+        }
+        export_puts(&ex, (chart.tos[i] < 0) ? "\", style=dashed];\n" : "\"];\n");
+    }
+    export_puts(&ex, "}\n");
+
+    return export_finish(&ex, &chart);
+}
+
+/**
+ *  @details    @c rels と @c corresps で定義される状態遷移を JSON 形式で出力する.
+ *              出力は "states" と "transitions" の 2 つの配列を持つオブジェクトで,
+ *              状態は番号 ("id"), 状態名 ("name"), 親状態の番号 ("parent") および
+ *              既定の子状態の番号 ("default") を持つ.
+ *              遷移は起点 ("from"), イベント名 ("event"), ガード条件名 ("cond"),
+ *              遷移アクション名 ("action") および遷移先 ("to") を持つ.
+ *              該当するものがない場合, 内部遷移の遷移先の場合は null となる.
+ *
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @param      [in]    writer      書き込み関数. 成功時に 0 を返すこと.
+ *  @param      [in]    ctx         書き込み関数の第 1 引数.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fsm_export_json(const struct fsm_rels *rels,
+                    const struct fsm_trans *corresps,
+                    int (*writer)(void *, const char *, size_t),
+                    void *ctx)
+{
+    struct exporter ex = EXPORTER_INITIALIZER(writer, ctx);
+    struct chart chart;
+
+    if ((corresps == NULL) || (writer == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (chart_build(&chart, rels, corresps) != 0) {
+        return -1;
+    }
+
+    export_puts(&ex, "{\n  \"states\": [");
+    for (size_t i = 0; i < chart.nstates; ++i) {
+        export_puts(&ex, (i == 0) ? "\n    {\"id\": " : ",\n    {\"id\": ");
+        export_int(&ex, (long)i);
+        export_puts(&ex, ", \"name\": ");
+        export_json_string(&ex, chart.states[i]->name);
+        export_puts(&ex, ", \"parent\": ");
+        export_json_id(&ex, chart.parents[i]);
+        export_puts(&ex, ", \"default\": ");
+        export_json_id(&ex, chart.histories[i]);
+        export_puts(&ex, "}");
+    }
+    export_puts(&ex, "\n  ],\n  \"transitions\": [");
+    for (size_t i = 0; i < chart.ntrans; ++i) {
+        const struct fsm_trans *corr = &chart.corresps[i];
+        export_puts(&ex, (i == 0) ? "\n    {\"from\": " : ",\n    {\"from\": ");
+        export_int(&ex, chart.froms[i]);
+        export_puts(&ex, ", \"event\": ");
+        export_json_string(&ex, corr->event->name);
+        export_puts(&ex, ", \"cond\": ");
+        export_json_string(&ex, (corr->cond != NULL) ? corr->cond->name : NULL);
+        export_puts(&ex, ", \"action\": ");
+        export_json_string(&ex, (corr->action != NULL) ? corr->action->name : NULL);
+        export_puts(&ex, ", \"to\": ");
+        export_json_id(&ex, chart.tos[i]);
+        export_puts(&ex, "}");
+    }
+    export_puts(&ex, "\n  ]\n}\n");
+
+    return export_finish(&ex, &chart);
+}
+
+/**
+ *  ファイルへの書き込み関数.
+ *
+ *  @param  [in]    ctx 出力先のファイル.
+ *  @param  [in]    buf 書き込む内容.
+ *  @param  [in]    len 書き込む内容の長さ.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int export_file_writer(void *ctx, const char *buf, size_t len)
+{
+    return (fwrite(buf, 1, len, (FILE *)ctx) == len) ? 0 : -1;
+}
+
+/**
+ *  @details    @c rels と @c corresps で定義される状態遷移を DOT 形式で
+ *              @c fp に出力する.
+ *
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @param      [in]    fp          出力先のファイル.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @sa         fsm_export_dot
+ */
+int fsm_export_dot_to_file(const struct fsm_rels *rels,
+                           const struct fsm_trans *corresps,
+                           FILE *fp)
+{
+    if (fp == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return fsm_export_dot(rels, corresps, export_file_writer, fp);
+}
+
+/**
+ *  @details    @c rels と @c corresps で定義される状態遷移を JSON 形式で
+ *              @c fp に出力する.
+ *
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @param      [in]    fp          出力先のファイル.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @sa         fsm_export_json
+ */
+int fsm_export_json_to_file(const struct fsm_rels *rels,
+                            const struct fsm_trans *corresps,
+                            FILE *fp)
+{
+    if (fp == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return fsm_export_json(rels, corresps, export_file_writer, fp);
+}
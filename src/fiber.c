@@ -0,0 +1,145 @@
+/** @file   fiber.c
+ *  @brief  ファイバ (協調的に切り替える軽量な実行コンテキスト) に関する機能を提供する.
+ *
+ *  ucontext を用いて実装する.
+ *  スタック領域は初期化時に確保し, 関数を設定し直す際に再利用する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define _XOPEN_SOURCE 700
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "debug.h"
+#include "fiber.h"
+
+/**
+ *  ファイバの開始関数.
+ *
+ *  makecontext には int の引数しか渡せないため, ファイバのポインタを
+ *  上位と下位の 32 ビットに分けて受け取る.
+ *  関数の終了後は uc_link により再開元に戻る.
+ *
+ *  @param  [in]    hi  ファイバのポインタの上位 32 ビット.
+ *  @param  [in]    lo  ファイバのポインタの下位 32 ビット.
+ */
+static void fiber_entry(unsigned int hi, unsigned int lo)
+{
+    struct fiber *fiber = (struct fiber *)(((uintptr_t)hi << 16 << 16) | (uintptr_t)lo);
+
+    fiber->func(fiber->arg);
+    fiber->finished = true;
+}
+
+/**
+ *  @details    @c stack_bytes のスタック領域を持つファイバを初期化する.
+ *              初期化直後のファイバは終了した状態となる.
+ *
+ *  @param      [out]   fiber       ファイバ.
+ *  @param      [in]    stack_bytes スタック領域のサイズ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fiber_init(struct fiber *fiber, size_t stack_bytes)
+{
+    if ((fiber == NULL) || (stack_bytes == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    fiber->stack = malloc(stack_bytes);
+    if (fiber->stack == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    fiber->stack_bytes = stack_bytes;
+    fiber->func = NULL;
+    fiber->arg = NULL;
+    fiber->finished = true;
+
+    return 0;
+}
+
+/**
+ *  @details    ファイバのスタック領域を解放する.
+ *              実行途中のファイバを解放した場合, 関数の残りは実行されない.
+ *
+ *  @param      [in,out]    fiber   ファイバ.
+ */
+void fiber_release(struct fiber *fiber)
+{
+    if (fiber != NULL) {
+        free(fiber->stack);
+        fiber->stack = NULL;
+    }
+}
+
+/**
+ *  @details    ファイバで実行する関数を設定する.
+ *              関数は @ref fiber_resume で開始する.
+ *
+ *  @param      [in,out]    fiber   終了した状態のファイバ.
+ *  @param      [in]        func    実行する関数.
+ *  @param      [in]        arg     関数の引数.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fiber_start(struct fiber *fiber, void (*func)(void *), void *arg)
+{
+    uintptr_t ptr = (uintptr_t)fiber;
+
+    if ((fiber == NULL) || (func == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!fiber->finished) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    if (getcontext(&fiber->context) != 0) {
+        return -1;
+    }
+    fiber->context.uc_stack.ss_sp = fiber->stack;
+    fiber->context.uc_stack.ss_size = fiber->stack_bytes;
+    fiber->context.uc_link = &fiber->caller;
+    fiber->func = func;
+    fiber->arg = arg;
+    fiber->finished = false;
+    makecontext(&fiber->context, (void (*)(void))fiber_entry, 2,
+                (unsigned int)(ptr >> 16 >> 16), (unsigned int)(ptr & 0xFFFFFFFFU));
+
+    return 0;
+}
+
+/**
+ *  @details    ファイバを再開し, ファイバが中断するか関数が終了するまで待つ.
+ *              終了したファイバに対しては何もしない.
+ *
+ *  @param      [in,out]    fiber   ファイバ.
+ */
+void fiber_resume(struct fiber *fiber)
+{
+    if ((fiber != NULL) && !fiber->finished) {
+        swapcontext(&fiber->caller, &fiber->context);
+    }
+}
+
+/**
+ *  @details    ファイバを中断し, 再開元に戻る.
+ *              ファイバで実行中の関数から呼び出すこと.
+ *
+ *  @param      [in,out]    fiber   ファイバ.
+ */
+void fiber_yield(struct fiber *fiber)
+{
+    if (fiber != NULL) {
+        swapcontext(&fiber->context, &fiber->caller);
+    }
+}
@@ -0,0 +1,66 @@
+/** @file   fiber.h
+ *  @brief  ファイバ (協調的に切り替える軽量な実行コンテキスト) に関する機能を提供する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_FIBER_H__
+#define __HFSM_FIBER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <ucontext.h>
+
+/**
+ *  ファイバ構造体.
+ */
+struct fiber {
+    ucontext_t context;    /**< ファイバのコンテキスト. */
+    ucontext_t caller;     /**< 再開元のコンテキスト. */
+    void *stack;           /**< スタック領域. */
+    size_t stack_bytes;    /**< スタック領域のサイズ. */
+    void (*func)(void *);  /**< ファイバで実行する関数. */
+    void *arg;             /**< 関数の引数. */
+    bool finished;         /**< 関数が終了したか. */
+};
+
+/**
+ *  ファイバを初期化する.
+ */
+int fiber_init(struct fiber *fiber, size_t stack_bytes);
+
+/**
+ *  ファイバを解放する.
+ */
+void fiber_release(struct fiber *fiber);
+
+/**
+ *  ファイバで実行する関数を設定する.
+ */
+int fiber_start(struct fiber *fiber, void (*func)(void *), void *arg);
+
+/**
+ *  ファイバを再開する.
+ */
+void fiber_resume(struct fiber *fiber);
+
+/**
+ *  ファイバを中断し, 再開元に戻る.
+ */
+void fiber_yield(struct fiber *fiber);
+
+/**
+ *  ファイバの関数が終了したかを取得する.
+ *
+ *  @param  [in]    fiber   ファイバ.
+ *  @return 終了している場合は true が返る.
+ */
+static inline bool fiber_finished(const struct fiber *fiber)
+{
+    return fiber->finished;
+}
+
+#endif /* __HFSM_FIBER_H__ */
@@ -0,0 +1,786 @@
+/** @file   fleet.c
+ *  @brief  同じ定義の多数の状態マシンを配列でまとめて動かすフリート.
+ *
+ *  (イベント, 状態) 毎に, イベントによる遷移とその後の Null 遷移を合わせた
+ *  遷移先の状態の番号を初期化時に求めて表にする.
+ *  遷移の途中でガード条件や遷移アクション, entry/exit アクションを呼び出す必要が
+ *  ある組は負の値とし, そのインスタンスのみ @ref fsm_transition と同じ手順で個別に処理する.
+ *  表の最後の行は未知のイベント用で, Null 遷移のみを行う.
+ *  インスタンスは状態マシンを持たないため, コールバックには現在の状態と
+ *  コンテキストをインスタンス毎に差し替えた代理の状態マシンを渡す.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FLEET_AVX2 (1)
+#else
+#define FLEET_AVX2 (0)
+#endif
+
+#include "debug.h"
+#include "chart.h"
+#include "proxy.h"
+#include "fleet.h"
+
+/**
+ *  状態の番号の配列の境界.
+ */
+#define FLEET_ALIGN (32)
+
+/**
+ *  個別に処理する組の印.
+ */
+#define FLEET_SLOW (-1)
+
+/**
+ *  フリート構造体.
+ */
+struct fsm_fleet {
+    struct chart chart;             /**< 状態遷移表の索引. */
+    size_t count;                   /**< インスタンスの数. */
+    int32_t *current;               /**< インスタンス毎の現在の状態の番号. */
+    int32_t *table;                 /**< (イベント, 状態) 毎の遷移先. (@c nevents + 1 行) */
+    bool *composite;                /**< 状態毎の子を持つか. */
+    int *chain;                     /**< 入状する状態の作業領域. */
+    int null_id;                    /**< Null 遷移イベントの番号. (なしは -1) */
+    enum fsm_fleet_kernel kernel;   /**< 遷移の処理方式. */
+    struct fsm *proxy;              /**< コールバックに渡す代理の状態マシン. */
+
+    unsigned char *contexts;        /**< インスタンス毎のコンテキスト. */
+    size_t stride;                  /**< コンテキストの間隔. */
+};
+
+/**
+ *  インスタンスのコンテキストを取得する.
+ *
+ *  @param  [in]    fleet   フリート.
+ *  @param  [in]    index   インスタンスの番号.
+ *  @return コンテキストのポインタが返る. コンテキストがない場合は NULL が返る.
+ */
+static inline void *fleet_context(const struct fsm_fleet *fleet, size_t index)
+{
+    return (fleet->contexts != NULL) ? fleet->contexts + index * fleet->stride : NULL;
+}
+
+/**
+ *  entry/exit アクションに渡す状態固有情報を取得する.
+ *
+ *  @param  [in]    fleet   フリート.
+ *  @param  [in]    index   インスタンスの番号.
+ *  @param  [in]    state   状態.
+ *  @return 状態固有情報のポインタが返る.
+ */
+static inline void *fleet_state_data(const struct fsm_fleet *fleet,
+                                     size_t index,
+                                     const struct fsm_state *state)
+{
+    if (state->slot) {
+        unsigned char *ctx = fleet_context(fleet, index);
+        return (ctx != NULL) ? ctx + state->slot_offset : NULL;
+    }
+    return (state->variable != NULL) ? state->variable->data : NULL;
+}
+
+/**
+ *  2 つの状態の共通の祖先を求める.
+ *
+ *  @c from が @c to の祖先の場合は @c from 自身を返す.
+ *
+ *  @param  [in]    chart   状態遷移表の索引.
+ *  @param  [in]    from    遷移元の状態の番号.
+ *  @param  [in]    to      遷移先の状態の番号.
+ *  @return 共通の祖先の番号が返る. ない場合は -1 が返る.
+ */
+static int fleet_ancestor(const struct chart *chart, int from, int to)
+{
+    for (int a = from; a >= 0; a = chart->parents[a]) {
+        for (int b = to; b >= 0; b = chart->parents[b]) {
+            if (a == b) {
+                return a;
+            }
+        }
+    }
+
+    return -1;
+}
+
+/**
+ *  状態の変更で entry/exit アクションを呼び出すかを判定する.
+ *
+ *  @param  [in]    chart   状態遷移表の索引.
+ *  @param  [in]    from    遷移元の状態の番号.
+ *  @param  [in]    to      遷移先の状態の番号.
+ *  @return 呼び出す場合は true が返る.
+ */
+static bool fleet_has_callbacks(const struct chart *chart, int from, int to)
+{
+    int ancestor;
+
+    if (from == to) {
+        return (chart->states[from]->exit != NULL) || (chart->states[to]->entry != NULL);
+    }
+    ancestor = fleet_ancestor(chart, from, to);
+    for (int s = from; s != ancestor; s = chart->parents[s]) {
+        if (chart->states[s]->exit != NULL) {
+            return true;
+        }
+    }
+    for (int s = to; s != ancestor; s = chart->parents[s]) {
+        if (chart->states[s]->entry != NULL) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ *  状態から出るイベントの遷移を, 呼び出しなしで求める.
+ *
+ *  @param  [in]        chart   状態遷移表の索引.
+ *  @param  [in]        from    起点の状態の番号.
+ *  @param  [in]        event   イベントの番号.
+ *  @param  [in,out]    current 現在の状態の番号. (遷移した場合は更新する)
+ *  @param  [out]       slow    個別に処理する必要があるか.
+ *  @return 遷移が見つかった場合は true が返る.
+ */
+static bool fleet_resolve_transit(const struct chart *chart, int from, int event,
+                                  int *current, bool *slow)
+{
+    for (size_t i = chart->outs[from]; i < chart->outs[from + 1]; ++i) {
+        int t = chart->out_trans[i];
+        const struct fsm_trans *corr = &chart->corresps[t];
+
+        if (chart->evs[t] != event) {
+            continue;
+        }
+        if ((corr->cond != NULL) || (corr->action != NULL)) {
+            *slow = true;
+            return true;
+        }
+        if (chart->tos[t] >= 0) {
+            if (fleet_has_callbacks(chart, *current, chart->tos[t])) {
+                *slow = true;
+            }
+            *current = chart->tos[t];
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ *  状態にイベントを与えた後の状態を, 呼び出しなしで求める.
+ *
+ *  @param  [in]    fleet   フリート.
+ *  @param  [in]    state   現在の状態の番号.
+ *  @param  [in]    event   イベントの番号. (未知のイベントは @c nevents)
+ *  @return 遷移先の状態の番号が返る. 個別に処理する必要がある場合は負の値が返る.
+ */
+static int32_t fleet_resolve(const struct fsm_fleet *fleet, int state, int event)
+{
+    const struct chart *chart = &fleet->chart;
+    int current = state;
+    bool slow = false;
+
+    if ((size_t)event < chart->nevents) {
+        for (int a = state; a >= 0; a = chart->parents[a]) {
+            if (fleet_resolve_transit(chart, a, event, &current, &slow)) {
+                break;
+            }
+        }
+    }
+    if (!slow && (fleet->null_id >= 0)) {
+        fleet_resolve_transit(chart, current, fleet->null_id, &current, &slow);
+    }
+
+    return slow ? FLEET_SLOW : current;
+}
+
+/**
+ *  インスタンスの状態を変更し, entry/exit アクションを呼び出す.
+ *
+ *  @ref fsm_transition と同じ順序で呼び出す.
+ *
+ *  @param  [in,out]    fleet   フリート.
+ *  @param  [in]        index   インスタンスの番号.
+ *  @param  [in]        to      遷移先の状態の番号.
+ */
+static void fleet_change_state(struct fsm_fleet *fleet, size_t index, int to)
+{
+    const struct chart *chart = &fleet->chart;
+    int from = fleet->current[index];
+    int ancestor, depth = 0;
+
+    if (from == to) {
+        const struct fsm_state *state = chart->states[from];
+        if (state->exit != NULL) {
+            state->exit(fleet->proxy, fleet_state_data(fleet, index, state), true);
+        }
+        if (state->entry != NULL) {
+            state->entry(fleet->proxy, fleet_state_data(fleet, index, state), true);
+        }
+        return;
+    }
+
+    ancestor = fleet_ancestor(chart, from, to);
+    for (int s = from; s != ancestor; s = chart->parents[s]) {
+        const struct fsm_state *state = chart->states[s];
+        if (state->exit != NULL) {
+            state->exit(fleet->proxy, fleet_state_data(fleet, index, state),
+                        chart->parents[s] == ancestor);
+        }
+    }
+    fleet->current[index] = to;
+    fsm_proxy_bind(fleet->proxy, chart->states[to], fleet_context(fleet, index));
+    for (int s = to; s != ancestor; s = chart->parents[s]) {
+        fleet->chain[depth++] = s;
+    }
+    while (depth-- > 0) {
+        const struct fsm_state *state = chart->states[fleet->chain[depth]];
+        if (state->entry != NULL) {
+            state->entry(fleet->proxy, fleet_state_data(fleet, index, state), depth == 0);
+        }
+    }
+}
+
+/**
+ *  インスタンスの状態から出るイベントの遷移を実施する.
+ *
+ *  @param  [in,out]    fleet   フリート.
+ *  @param  [in]        index   インスタンスの番号.
+ *  @param  [in]        from    起点の状態の番号.
+ *  @param  [in]        event   イベントの番号.
+ *  @return 遷移が行われた場合は true が返る.
+ */
+static bool fleet_transit(struct fsm_fleet *fleet, size_t index, int from, int event)
+{
+    const struct chart *chart = &fleet->chart;
+    void *ctx = fleet_context(fleet, index);
+
+    for (size_t i = chart->outs[from]; i < chart->outs[from + 1]; ++i) {
+        int t = chart->out_trans[i];
+        const struct fsm_trans *corr = &chart->corresps[t];
+
+        if (chart->evs[t] != event) {
+            continue;
+        }
+        if (corr->cond != NULL) {
+            bool passed = (corr->cond->func != NULL)
+                          ? corr->cond->func(fleet->proxy)
+                          : corr->cond->func_ctx(fleet->proxy, ctx);
+            if (!passed) {
+                continue;
+            }
+        }
+        if (corr->action != NULL) {
+            if (corr->action->func != NULL) {
+                corr->action->func(fleet->proxy);
+            } else {
+                corr->action->func_ctx(fleet->proxy, ctx);
+            }
+        }
+        if (chart->tos[t] >= 0) {
+            fleet_change_state(fleet, index, chart->tos[t]);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ *  インスタンスを個別に遷移させる.
+ *
+ *  @param  [in,out]    fleet   フリート.
+ *  @param  [in]        index   インスタンスの番号.
+ *  @param  [in]        event   イベントの番号. (未知のイベントは @c nevents)
+ */
+static void fleet_step(struct fsm_fleet *fleet, size_t index, int event)
+{
+    const struct chart *chart = &fleet->chart;
+
+    fsm_proxy_bind(fleet->proxy, chart->states[fleet->current[index]], fleet_context(fleet, index));
+    if ((size_t)event < chart->nevents) {
+        for (int a = fleet->current[index];
+             (a >= 0) && !fleet_transit(fleet, index, a, event);
+             a = chart->parents[a]) {
+        }
+    }
+    if (fleet->null_id >= 0) {
+        fleet_transit(fleet, index, fleet->current[index], fleet->null_id);
+    }
+}
+
+/**
+ *  表の行を引いてインスタンスを遷移させる.
+ *
+ *  @param  [in,out]    fleet   フリート.
+ *  @param  [in]        event   イベントの番号. (未知のイベントは @c nevents)
+ *  @param  [in]        first   処理を始めるインスタンスの番号.
+ */
+static void fleet_dispatch_scalar(struct fsm_fleet *fleet, int event, size_t first)
+{
+    const int32_t *row = fleet->table + (size_t)event * fleet->chart.nstates;
+    int32_t *current = fleet->current;
+
+    for (size_t i = first; i < fleet->count; ++i) {
+        int32_t next = row[current[i]];
+        if (next >= 0) {
+            current[i] = next;
+        } else {
+            fleet_step(fleet, i, event);
+        }
+    }
+}
+
+/**
+ *  インスタンス毎のイベントで表を引いてインスタンスを遷移させる.
+ *
+ *  @param  [in,out]    fleet   フリート.
+ *  @param  [in]        events  インスタンス毎のイベントの番号.
+ *  @param  [in]        first   処理を始めるインスタンスの番号.
+ */
+static void fleet_dispatch_each_scalar(struct fsm_fleet *fleet, const int32_t *events, size_t first)
+{
+    uint32_t nevents = (uint32_t)fleet->chart.nevents;
+    size_t nstates = fleet->chart.nstates;
+    int32_t *current = fleet->current;
+
+    for (size_t i = first; i < fleet->count; ++i) {
+        uint32_t event = ((uint32_t)events[i] < nevents) ? (uint32_t)events[i] : nevents;
+        int32_t next = fleet->table[event * nstates + (size_t)current[i]];
+        if (next >= 0) {
+            current[i] = next;
+        } else {
+            fleet_step(fleet, i, (int)event);
+        }
+    }
+}
+
+#if FLEET_AVX2
+/**
+ *  表の行を 8 インスタンスずつ gather で引いて遷移させる.
+ *
+ *  個別に処理する組に当たったインスタンスは状態を変えずに残し,
+ *  8 インスタンスの書き戻しの後で個別に処理する.
+ *
+ *  @param  [in,out]    fleet   フリート.
+ *  @param  [in]        event   イベントの番号. (未知のイベントは @c nevents)
+ */
+__attribute__((target("avx2")))
+static void fleet_dispatch_avx2(struct fsm_fleet *fleet, int event)
+{
+    const int32_t *row = fleet->table + (size_t)event * fleet->chart.nstates;
+    int32_t *current = fleet->current;
+    size_t i;
+
+    for (i = 0; i + 8 <= fleet->count; i += 8) {
+        __m256i states = _mm256_loadu_si256((const __m256i *)&current[i]);
+        __m256i next = _mm256_i32gather_epi32((const int *)row, states, 4);
+        int slow = _mm256_movemask_ps(_mm256_castsi256_ps(next));
+
+        next = _mm256_blendv_epi8(next, states, _mm256_srai_epi32(next, 31));
+        _mm256_storeu_si256((__m256i *)&current[i], next);
+        while (slow != 0) {
+            fleet_step(fleet, i + (size_t)__builtin_ctz(slow), event);
+            slow &= slow - 1;
+        }
+    }
+    fleet_dispatch_scalar(fleet, event, i);
+}
+
+/**
+ *  インスタンス毎のイベントで表を 8 インスタンスずつ gather で引いて遷移させる.
+ *
+ *  @param  [in,out]    fleet   フリート.
+ *  @param  [in]        events  インスタンス毎のイベントの番号.
+ */
+__attribute__((target("avx2")))
+static void fleet_dispatch_each_avx2(struct fsm_fleet *fleet, const int32_t *events)
+{
+    const __m256i nevents = _mm256_set1_epi32((int)fleet->chart.nevents);
+    const __m256i nstates = _mm256_set1_epi32((int)fleet->chart.nstates);
+    int32_t *current = fleet->current;
+    size_t i;
+
+    for (i = 0; i + 8 <= fleet->count; i += 8) {
+        __m256i states = _mm256_loadu_si256((const __m256i *)&current[i]);
+        __m256i evs = _mm256_min_epu32(_mm256_loadu_si256((const __m256i *)&events[i]), nevents);
+        __m256i cells = _mm256_add_epi32(_mm256_mullo_epi32(evs, nstates), states);
+        __m256i next = _mm256_i32gather_epi32((const int *)fleet->table, cells, 4);
+        int slow = _mm256_movemask_ps(_mm256_castsi256_ps(next));
+
+        next = _mm256_blendv_epi8(next, states, _mm256_srai_epi32(next, 31));
+        _mm256_storeu_si256((__m256i *)&current[i], next);
+        while (slow != 0) {
+            int lane = __builtin_ctz(slow);
+            uint32_t event = (uint32_t)events[i + lane];
+            fleet_step(fleet, i + (size_t)lane,
+                       (int)((event < fleet->chart.nevents) ? event : fleet->chart.nevents));
+            slow &= slow - 1;
+        }
+    }
+    fleet_dispatch_each_scalar(fleet, events, i);
+}
+#endif
+
+/**
+ *  遷移先の表を構築する.
+ *
+ *  @param  [in,out]    fleet   フリート.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int fleet_build_table(struct fsm_fleet *fleet)
+{
+    const struct chart *chart = &fleet->chart;
+    size_t nstates = chart->nstates;
+    size_t nrows = chart->nevents + 1;
+
+    if ((nstates == 0) || (nrows > (size_t)INT32_MAX / nstates)) {
+        errno = E2BIG;
+        return -1;
+    }
+    fleet->table = malloc(nrows * nstates * sizeof(int32_t));
+    if (fleet->table == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (size_t e = 0; e < nrows; ++e) {
+        for (size_t s = 0; s < nstates; ++s) {
+            fleet->table[e * nstates + s] = fleet_resolve(fleet, (int)s, (int)e);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    @c rels と @c corresps で定義される状態マシンの
+ *              @c count 個のインスタンスからなるフリートを初期化する.
+ *              各インスタンスは開始状態から Null 遷移した状態となる.
+ *              @c bytes が 0 でない場合は, インスタンス毎のコンテキストを連続した領域に確保し,
+ *              @c context の内容 (NULL の場合は 0) で初期化する.
+ *              コンテキストは @ref FSM_COND_CTX, @ref FSM_ACTION_CTX で定義した
+ *              ガード条件と遷移アクションに渡され, @ref FSM_STATE_SLOT で定義した状態の
+ *              entry/exit アクションにはそのメンバが渡される.
+ *              コールバックの状態マシンの引数には, 現在の状態とコンテキストを
+ *              インスタンス毎に差し替えた代理の状態マシンが渡され,
+ *              @ref fsm_get_current, @ref fsm_get_context, @ref fsm_get_state_data_of で参照できる.
+ *              代理の状態マシンは遷移を持たないため, コールバックから遷移させることはできない.
+ *              do アクティビティは実行しない.
+ *              入状の際に履歴状態を辿る必要があるため, 子を持つ状態への遷移は扱えない.
+ *
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @param      [in]    count       インスタンスの数.
+ *  @param      [in]    context     コンテキストの初期値. (NULL 可)
+ *  @param      [in]    bytes       インスタンス毎のコンテキストのバイト数.
+ *  @return     成功時は, フリートが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *              開始状態からの遷移がない場合は, errno に EINVAL が設定される.
+ *              子を持つ状態への遷移がある場合は, errno に ENOTSUP が設定される.
+ */
+struct fsm_fleet *fsm_fleet_init(const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps,
+                                 size_t count,
+                                 const void *context,
+                                 size_t bytes)
+{
+    struct fsm_fleet *fleet;
+    size_t array_bytes;
+    int start;
+
+    if ((corresps == NULL) || (count == 0) || (count > (size_t)INT32_MAX)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    fleet = calloc(1, sizeof(*fleet));
+    if (fleet == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (chart_build(&fleet->chart, rels, corresps) != 0) {
+        free(fleet);
+        return NULL;
+    }
+    fleet->null_id = chart_event_id(&fleet->chart, event_null);
+    start = chart_state_id(&fleet->chart, state_start);
+    if (start < 0) {
+        errno = EINVAL;
+        goto fail;
+    }
+    fleet->composite = calloc(fleet->chart.nstates + 1, sizeof(bool));
+    fleet->chain = malloc((fleet->chart.nstates + 1) * sizeof(int));
+    if ((fleet->composite == NULL) || (fleet->chain == NULL)) {
+        errno = ENOMEM;
+        goto fail;
+    }
+    for (size_t s = 0; s < fleet->chart.nstates; ++s) {
+        if (fleet->chart.parents[s] >= 0) {
+            fleet->composite[fleet->chart.parents[s]] = true;
+        }
+    }
+    for (size_t t = 0; t < fleet->chart.ntrans; ++t) {
+        if ((fleet->chart.tos[t] >= 0) && fleet->composite[fleet->chart.tos[t]]) {
+            errno = ENOTSUP;
+            goto fail;
+        }
+    }
+    if (fleet_build_table(fleet) != 0) {
+        goto fail;
+    }
+    fleet->proxy = fsm_proxy_init();
+    if (fleet->proxy == NULL) {
+        goto fail;
+    }
+
+    array_bytes = (count * sizeof(int32_t) + FLEET_ALIGN - 1) & ~(size_t)(FLEET_ALIGN - 1);
+    fleet->current = aligned_alloc(FLEET_ALIGN, array_bytes);
+    if (fleet->current == NULL) {
+        errno = ENOMEM;
+        goto fail;
+    }
+    if (bytes > 0) {
+        fleet->stride = (bytes + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1);
+        if (fleet->stride > SIZE_MAX / count) {
+            errno = EINVAL;
+            goto fail;
+        }
+        fleet->contexts = malloc(fleet->stride * count);
+        if (fleet->contexts == NULL) {
+            errno = ENOMEM;
+            goto fail;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (context != NULL) {
+                memcpy(fleet->contexts + i * fleet->stride, context, bytes);
+            } else {
+                memset(fleet->contexts + i * fleet->stride, 0, bytes);
+            }
+        }
+    }
+    fleet->count = count;
+    fsm_fleet_set_kernel(fleet, FSM_FLEET_AUTO);
+
+    /* 開始状態から Null 遷移を行う. */
+    for (size_t i = 0; i < count; ++i) {
+        fleet->current[i] = start;
+    }
+    fleet_dispatch_scalar(fleet, (int)fleet->chart.nevents, 0);
+
+    return fleet;
+
+fail:
+    {
+        int err = errno;
+        fsm_fleet_term(fleet);
+        errno = err;
+    }
+    return NULL;
+}
+
+/**
+ *  @details    @c fleet を終了し, 領域を解放する.
+ *              exit アクションは呼び出さない.
+ *
+ *  @param      [in,out]    fleet   フリート.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fsm_fleet_term(struct fsm_fleet *fleet)
+{
+    if (fleet == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    fsm_proxy_release(fleet->proxy);
+    free(fleet->contexts);
+    free(fleet->current);
+    free(fleet->table);
+    free(fleet->chain);
+    free(fleet->composite);
+    chart_release(&fleet->chart);
+    free(fleet);
+
+    return 0;
+}
+
+/**
+ *  @details    @c fleet の遷移の処理方式を設定する.
+ *              @ref FSM_FLEET_AUTO の場合は, 実行環境で AVX2 が使えれば AVX2 を,
+ *              使えなければ 1 つずつの処理を選択する.
+ *
+ *  @param      [in,out]    fleet   フリート.
+ *  @param      [in]        kernel  遷移の処理方式.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              実行環境で使えない方式の場合は, errno に ENOTSUP が設定される.
+ */
+int fsm_fleet_set_kernel(struct fsm_fleet *fleet, enum fsm_fleet_kernel kernel)
+{
+    bool avx2 = false;
+
+    if (fleet == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+#if FLEET_AVX2
+    avx2 = __builtin_cpu_supports("avx2");
+#endif
+    switch (kernel) {
+    case FSM_FLEET_AUTO:
+        fleet->kernel = avx2 ? FSM_FLEET_AVX2 : FSM_FLEET_SCALAR;
+        return 0;
+    case FSM_FLEET_SCALAR:
+        fleet->kernel = kernel;
+        return 0;
+    case FSM_FLEET_AVX2:
+        if (!avx2) {
+            errno = ENOTSUP;
+            return -1;
+        }
+        fleet->kernel = kernel;
+        return 0;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+/**
+ *  @details    @ref fsm_fleet_dispatch_each に与えるイベントの番号を取得する.
+ *
+ *  @param      [in]    fleet   フリート.
+ *  @param      [in]    event   イベント.
+ *  @return     成功時は, イベントの番号が返る.
+ *              定義にないイベントの場合は, -1 が返る.
+ */
+int32_t fsm_fleet_event_id(const struct fsm_fleet *fleet, const struct fsm_event *event)
+{
+    if ((fleet == NULL) || (event == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return chart_event_id(&fleet->chart, event);
+}
+
+/**
+ *  @details    @c fleet の全インスタンスに @c event を与える.
+ *              各インスタンスは @ref fsm_transition と同じ遷移を行う.
+ *
+ *  @param      [in,out]    fleet   フリート.
+ *  @param      [in]        event   イベント.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ *              コールバックからフリートを遷移させないこと.
+ */
+int fsm_fleet_dispatch(struct fsm_fleet *fleet, const struct fsm_event *event)
+{
+    int id;
+
+    if ((fleet == NULL) || (event == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    id = chart_event_id(&fleet->chart, event);
+    if (id < 0) {
+        id = (int)fleet->chart.nevents;
+    }
+#if FLEET_AVX2
+    if (fleet->kernel == FSM_FLEET_AVX2) {
+        fleet_dispatch_avx2(fleet, id);
+        return 0;
+    }
+#endif
+    fleet_dispatch_scalar(fleet, id, 0);
+
+    return 0;
+}
+
+/**
+ *  @details    @c fleet の各インスタンスに @c events の同じ位置のイベントを与える.
+ *              イベントは @ref fsm_fleet_event_id で得た番号で指定し,
+ *              範囲外の番号 (-1 など) は定義にないイベントとして扱う.
+ *
+ *  @param      [in,out]    fleet   フリート.
+ *  @param      [in]        events  インスタンス毎のイベントの番号. (インスタンスの数の要素)
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ *              コールバックからフリートを遷移させないこと.
+ */
+int fsm_fleet_dispatch_each(struct fsm_fleet *fleet, const int32_t *events)
+{
+    if ((fleet == NULL) || (events == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+#if FLEET_AVX2
+    if (fleet->kernel == FSM_FLEET_AVX2) {
+        fleet_dispatch_each_avx2(fleet, events);
+        return 0;
+    }
+#endif
+    fleet_dispatch_each_scalar(fleet, events, 0);
+
+    return 0;
+}
+
+/**
+ *  @details    @c fleet の @c index 番目のインスタンスの現在の状態を取得する.
+ *
+ *  @param      [in]    fleet   フリート.
+ *  @param      [in]    index   インスタンスの番号.
+ *  @return     成功時は, 現在の状態が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+const struct fsm_state *fsm_fleet_get_current(const struct fsm_fleet *fleet, size_t index)
+{
+    if ((fleet == NULL) || (index >= fleet->count)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return fleet->chart.states[fleet->current[index]];
+}
+
+/**
+ *  @details    @c fleet の @c index 番目のインスタンスのコンテキストを取得する.
+ *
+ *  @param      [in,out]    fleet   フリート.
+ *  @param      [in]        index   インスタンスの番号.
+ *  @return     成功時は, コンテキストのポインタが返る.
+ *              コンテキストがない場合は, NULL が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+void *fsm_fleet_get_context(struct fsm_fleet *fleet, size_t index)
+{
+    if ((fleet == NULL) || (index >= fleet->count)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return fleet_context(fleet, index);
+}
@@ -0,0 +1,617 @@
+/** @file   group.c
+ *  @brief  状態マシンのグループへのイベントの一斉配信.
+ *
+ *  状態毎に, その状態または祖先から遷移を持つイベントの一覧を初期化時に求め,
+ *  イベント毎に現在の状態でそのイベントを処理できる参加者を連続した配列で保持する.
+ *  参加者の状態が変わるとオブザーバで印を付けて保留の一覧に繋ぎ,
+ *  次の一斉配信の前にまとめて索引を更新する.
+ *  索引からの削除は末尾との入れ替えで行い, 参加者は購読毎の配列上の位置を保持する.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#include "debug.h"
+#include "chart.h"
+#include "group.h"
+
+/**
+ *  一斉配信で先読みする参加者の数.
+ */
+#define GROUP_PREFETCH (4)
+
+/**
+ *  購読者の配列と参加者の表の初期容量.
+ */
+#define GROUP_INITIAL_CAPACITY (16)
+
+struct group_member;
+
+/**
+ *  購読者構造体.
+ */
+struct group_entry {
+    struct fsm *machine;            /**< 状態マシン. */
+    struct group_member *member;    /**< 参加者. */
+    size_t slot;                    /**< 参加者の購読の番号. */
+};
+
+/**
+ *  イベント毎の購読者の配列構造体.
+ */
+struct group_list {
+    struct group_entry *entries;    /**< 購読者. */
+    size_t count;                   /**< 購読者の数. */
+    size_t capacity;                /**< 配列の容量. */
+};
+
+/**
+ *  参加者構造体.
+ */
+struct group_member {
+    struct fsm_observer observer;       /**< 状態マシンに登録するオブザーバ. */
+    struct fsm_group *group;            /**< グループ. */
+    struct fsm *machine;                /**< 状態マシン. */
+    int state;                          /**< 索引に反映済みの状態の番号. (なしは -1) */
+    bool dirty;                         /**< 索引の更新を保留しているか. */
+    struct group_member *next_dirty;    /**< 索引の更新を保留している次の参加者. */
+    size_t positions[];                 /**< 購読毎の購読者の配列上の位置. */
+};
+
+/**
+ *  グループ構造体.
+ */
+struct fsm_group {
+    struct chart chart;             /**< 状態遷移表の索引. */
+    size_t *handled_offs;           /**< 状態毎の処理できるイベントの開始位置. (@c nstates + 1 個) */
+    int *handled;                   /**< 状態毎に並べた処理できるイベントの番号. */
+    size_t max_handled;             /**< 1 つの状態で処理できるイベントの最大数. */
+
+    struct group_list *lists;       /**< イベント毎の購読者. */
+    struct group_member **members;  /**< 状態マシンで引く参加者の表. (線形探査) */
+    size_t members_mask;            /**< 参加者の表の大きさ - 1. */
+    size_t nmembers;                /**< 参加者の数. */
+    struct group_member *dirty;     /**< 索引の更新を保留している参加者. */
+    unsigned int depth;             /**< 一斉配信の入れ子の深さ. */
+};
+
+/**
+ *  参加者の表での状態マシンの位置を求める.
+ *
+ *  @param  [in]    group   グループ.
+ *  @param  [in]    machine 状態マシン.
+ *  @return 状態マシンの参加者, または空きの位置が返る.
+ */
+static size_t group_slot(const struct fsm_group *group, const struct fsm *machine)
+{
+    size_t pos = (size_t)(((uint64_t)(uintptr_t)machine * 0x9e3779b97f4a7c15ULL) >> 32);
+
+    for (pos &= group->members_mask;
+         (group->members[pos] != NULL) && (group->members[pos]->machine != machine);
+         pos = (pos + 1) & group->members_mask) {
+    }
+
+    return pos;
+}
+
+/**
+ *  参加者の表を拡張する.
+ *
+ *  @param  [in,out]    group   グループ.
+ *  @param  [in]        size    新しい表の大きさ. (2 の冪)
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int group_rehash(struct fsm_group *group, size_t size)
+{
+    struct group_member **old = group->members;
+    size_t old_size = (old != NULL) ? group->members_mask + 1 : 0;
+
+    group->members = calloc(size, sizeof(struct group_member *));
+    if (group->members == NULL) {
+        group->members = old;
+        errno = ENOMEM;
+        return -1;
+    }
+    group->members_mask = size - 1;
+    for (size_t i = 0; i < old_size; ++i) {
+        if (old[i] != NULL) {
+            group->members[group_slot(group, old[i]->machine)] = old[i];
+        }
+    }
+    free(old);
+
+    return 0;
+}
+
+/**
+ *  参加者の表から位置 @c pos の参加者を除く.
+ *
+ *  後続の要素を詰め, 探査の列が途切れないようにする.
+ *
+ *  @param  [in,out]    group   グループ.
+ *  @param  [in]        pos     除く位置.
+ */
+static void group_erase(struct fsm_group *group, size_t pos)
+{
+    size_t next = pos;
+
+    group->members[pos] = NULL;
+    for (;;) {
+        next = (next + 1) & group->members_mask;
+        struct group_member *member = group->members[next];
+        if (member == NULL) {
+            break;
+        }
+        size_t home = group_slot(group, member->machine);
+        if (home != next) {
+            group->members[home] = member;
+            group->members[next] = NULL;
+        }
+    }
+    --group->nmembers;
+}
+
+/**
+ *  状態毎に処理できるイベントの一覧を求める.
+ *
+ *  状態とその祖先を起点とする遷移のイベントを重複なく並べる.
+ *  Null 遷移イベントは除く.
+ *
+ *  @param  [in,out]    group   グループ.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int group_build_handled(struct fsm_group *group)
+{
+    const struct chart *chart = &group->chart;
+    int null_id = chart_event_id(chart, event_null);
+    size_t *marks, count = 0;
+
+    group->handled_offs = malloc((chart->nstates + 1) * sizeof(size_t));
+    marks = calloc(chart->nevents + 1, sizeof(size_t));
+    if ((group->handled_offs == NULL) || (marks == NULL)) {
+        free(marks);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    /* 1 回目で数を, 2 回目で一覧を求める. */
+    for (int pass = 0; pass < 2; ++pass) {
+        memset(marks, 0, (chart->nevents + 1) * sizeof(size_t));
+        count = 0;
+        for (size_t s = 0; s < chart->nstates; ++s) {
+            size_t first = count;
+
+            group->handled_offs[s] = count;
+            for (int a = (int)s; a >= 0; a = chart->parents[a]) {
+                for (size_t i = chart->outs[a]; i < chart->outs[a + 1]; ++i) {
+                    int ev = chart->evs[chart->out_trans[i]];
+                    if ((ev == null_id) || (marks[ev] == s + 1)) {
+                        continue;
+                    }
+                    marks[ev] = s + 1;
+                    if (pass == 1) {
+                        group->handled[count] = ev;
+                    }
+                    ++count;
+                }
+            }
+            if (count - first > group->max_handled) {
+                group->max_handled = count - first;
+            }
+        }
+        group->handled_offs[chart->nstates] = count;
+        if (pass == 0) {
+            group->handled = malloc((count + 1) * sizeof(int));
+            if (group->handled == NULL) {
+                free(marks);
+                errno = ENOMEM;
+                return -1;
+            }
+        }
+    }
+    free(marks);
+
+    return 0;
+}
+
+/**
+ *  参加者の購読を索引に加える.
+ *
+ *  @param  [in,out]    group   グループ.
+ *  @param  [in,out]    member  参加者.
+ *  @param  [in]        state   購読する状態の番号.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int group_subscribe(struct fsm_group *group, struct group_member *member, int state)
+{
+    size_t first = group->handled_offs[state];
+    size_t last = group->handled_offs[state + 1];
+
+    member->state = state;
+    for (size_t i = first; i < last; ++i) {
+        struct group_list *list = &group->lists[group->handled[i]];
+        if (list->count == list->capacity) {
+            size_t capacity = (list->capacity > 0) ? list->capacity * 2 : GROUP_INITIAL_CAPACITY;
+            struct group_entry *entries = realloc(list->entries, capacity * sizeof(*entries));
+            if (entries == NULL) {
+                errno = ENOMEM;
+                return -1;
+            }
+            list->entries = entries;
+            list->capacity = capacity;
+        }
+        member->positions[i - first] = list->count;
+        list->entries[list->count++] = (struct group_entry){
+            .machine = member->machine,
+            .member = member,
+            .slot = i - first
+        };
+    }
+
+    return 0;
+}
+
+/**
+ *  参加者の購読を索引から除く.
+ *
+ *  購読の途中で失敗した場合に備え, 配列上の位置が参加者を指すもののみ除く.
+ *
+ *  @param  [in,out]    group   グループ.
+ *  @param  [in,out]    member  参加者.
+ */
+static void group_unsubscribe(struct fsm_group *group, struct group_member *member)
+{
+    size_t first, last;
+
+    if (member->state < 0) {
+        return;
+    }
+    first = group->handled_offs[member->state];
+    last = group->handled_offs[member->state + 1];
+    for (size_t i = first; i < last; ++i) {
+        struct group_list *list = &group->lists[group->handled[i]];
+        size_t pos = member->positions[i - first];
+        struct group_entry *moved;
+
+        if ((pos >= list->count) || (list->entries[pos].member != member)) {
+            continue;
+        }
+        moved = &list->entries[--list->count];
+        list->entries[pos] = *moved;
+        moved = &list->entries[pos];
+        moved->member->positions[moved->slot] = pos;
+    }
+    member->state = -1;
+}
+
+/**
+ *  参加者の購読を現在の状態に合わせる.
+ *
+ *  @param  [in,out]    group   グループ.
+ *  @param  [in,out]    member  参加者.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int group_resubscribe(struct fsm_group *group, struct group_member *member)
+{
+    int state = chart_state_id(&group->chart, fsm_get_current(member->machine));
+
+    if (state == member->state) {
+        return 0;
+    }
+    group_unsubscribe(group, member);
+    if (state < 0) {
+        return 0;
+    }
+    if (group_subscribe(group, member, state) != 0) {
+        int err = errno;
+        group_unsubscribe(group, member);
+        errno = err;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  保留している索引の更新をまとめて行う.
+ *
+ *  更新に失敗した参加者は保留のまま残す.
+ *
+ *  @param  [in,out]    group   グループ.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int group_flush(struct fsm_group *group)
+{
+    struct group_member *member;
+
+    while ((member = group->dirty) != NULL) {
+        if (group_resubscribe(group, member) != 0) {
+            return -1;
+        }
+        group->dirty = member->next_dirty;
+        member->next_dirty = NULL;
+        member->dirty = false;
+    }
+
+    return 0;
+}
+
+/**
+ *  参加者の状態の変化を保留の一覧に繋ぐ.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    state   出状または入状した状態.
+ *  @param  [in]    ctx     参加者.
+ */
+static void group_changed(struct fsm *machine, const struct fsm_state *state, void *ctx)
+{
+    struct group_member *member = ctx;
+
+    if (!member->dirty) {
+        member->dirty = true;
+        member->next_dirty = member->group->dirty;
+        member->group->dirty = member;
+    }
+}
+
+/**
+ *  @details    @c rels と @c corresps で定義される状態マシンのグループを初期化する.
+ *
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @return     成功時は, グループが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+struct fsm_group *fsm_group_init(const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps)
+{
+    struct fsm_group *group;
+
+    if (corresps == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    group = calloc(1, sizeof(*group));
+    if (group == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (chart_build(&group->chart, rels, corresps) != 0) {
+        free(group);
+        return NULL;
+    }
+    group->lists = calloc(group->chart.nevents + 1, sizeof(struct group_list));
+    if ((group->lists == NULL) || (group_build_handled(group) != 0)
+        || (group_rehash(group, GROUP_INITIAL_CAPACITY) != 0)) {
+        free(group->members);
+        free(group->handled);
+        free(group->handled_offs);
+        free(group->lists);
+        chart_release(&group->chart);
+        free(group);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    return group;
+}
+
+/**
+ *  @details    @c group を終了し, 領域を解放する.
+ *              参加中の状態マシンはすべてグループから外す.
+ *
+ *  @param      [in,out]    group   グループ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    参加中の状態マシンは, 本関数の呼び出しより前に解放しないこと.
+ */
+int fsm_group_term(struct fsm_group *group)
+{
+    if (group == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (size_t i = 0; i <= group->members_mask; ++i) {
+        struct group_member *member = group->members[i];
+        if (member != NULL) {
+            fsm_remove_observer(member->machine, &member->observer);
+            free(member);
+        }
+    }
+    free(group->members);
+    for (size_t i = 0; i < group->chart.nevents; ++i) {
+        free(group->lists[i].entries);
+    }
+    free(group->lists);
+    free(group->handled);
+    free(group->handled_offs);
+    chart_release(&group->chart);
+    free(group);
+
+    return 0;
+}
+
+/**
+ *  @details    @c machine にオブザーバを登録し, @c group に参加させる.
+ *              参加時点の状態で処理できるイベントを購読する.
+ *
+ *  @param      [in,out]    group   グループ.
+ *  @param      [in,out]    machine 状態マシン.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              既に参加している場合は, errno に EEXIST が設定される.
+ *              OBSERVER を 0 としてビルドした場合は, errno に ENOTSUP が設定される.
+ *  @warning    スレッドセーフではない.
+ *              参加中の状態マシンの遷移は, 一斉配信と同じスレッドで行うこと.
+ *              参加中の状態マシンは, グループから外してから解放すること.
+ */
+int fsm_group_join(struct fsm_group *group, struct fsm *machine)
+{
+    struct group_member *member;
+
+    if ((group == NULL) || (machine == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (group->members[group_slot(group, machine)] != NULL) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (((group->nmembers + 1) * 2 > group->members_mask + 1)
+        && (group_rehash(group, (group->members_mask + 1) * 2) != 0)) {
+        return -1;
+    }
+
+    member = calloc(1, sizeof(*member) + group->max_handled * sizeof(size_t));
+    if (member == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    member->observer = (struct fsm_observer)FSM_OBSERVER_HELPER(NULL, NULL, NULL,
+                                                                group_changed, group_changed,
+                                                                NULL, member);
+    member->group = group;
+    member->machine = machine;
+    member->state = -1;
+    if (group_resubscribe(group, member) != 0) {
+        free(member);
+        return -1;
+    }
+    if (fsm_add_observer(machine, &member->observer) != 0) {
+        int err = errno;
+        group_unsubscribe(group, member);
+        free(member);
+        errno = err;
+        return -1;
+    }
+    group->members[group_slot(group, machine)] = member;
+    ++group->nmembers;
+
+    return 0;
+}
+
+/**
+ *  @details    @c machine のオブザーバの登録を解除し, @c group から外す.
+ *
+ *  @param      [in,out]    group   グループ.
+ *  @param      [in,out]    machine 状態マシン.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              参加していない場合は, errno に ENOENT が設定される.
+ *  @warning    スレッドセーフではない.
+ *              一斉配信の遷移アクションなどから呼び出さないこと.
+ */
+int fsm_group_leave(struct fsm_group *group, struct fsm *machine)
+{
+    struct group_member *member;
+    size_t pos;
+
+    if ((group == NULL) || (machine == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pos = group_slot(group, machine);
+    member = group->members[pos];
+    if (member == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+    group_erase(group, pos);
+    if (member->dirty) {
+        struct group_member **dirty;
+        for (dirty = &group->dirty; *dirty != member; dirty = &(*dirty)->next_dirty) {
+        }
+        *dirty = member->next_dirty;
+    }
+
+    fsm_remove_observer(machine, &member->observer);
+    group_unsubscribe(group, member);
+    free(member);
+
+    return 0;
+}
+
+/**
+ *  @details    @c group の参加者のうち, 現在の状態で @c event を処理できるものに
+ *              @ref fsm_transition で @c event を与える.
+ *              配信の前に保留している索引の更新をまとめて行い,
+ *              配信中に状態が変わった参加者の索引は次の配信の前に更新する.
+ *              このため, 配信は開始時点で @c event を処理できた参加者に対して行う.
+ *
+ *  @param      [in,out]    group   グループ.
+ *  @param      [in]        event   配信するイベント.
+ *  @return     成功時は, 配信した状態マシンの数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+ssize_t fsm_group_broadcast(struct fsm_group *group, const struct fsm_event *event)
+{
+    const struct group_list *list;
+    int ev;
+
+    if ((group == NULL) || (event == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((group->depth == 0) && (group_flush(group) != 0)) {
+        return -1;
+    }
+    ev = chart_event_id(&group->chart, event);
+    if (ev < 0) {
+        return 0;
+    }
+
+    /* 配信中は索引を更新しないため, 配列は変化しない. */
+    ++group->depth;
+    list = &group->lists[ev];
+    for (size_t i = 0; i < list->count; ++i) {
+        if (i + GROUP_PREFETCH < list->count) {
+            __builtin_prefetch(list->entries[i + GROUP_PREFETCH].machine);
+        }
+        fsm_transition(list->entries[i].machine, event);
+    }
+    --group->depth;
+
+    return (ssize_t)list->count;
+}
+
+/**
+ *  @details    @c group の参加者のうち, 現在の状態で @c event を処理できるものの数を取得する.
+ *
+ *  @param      [in,out]    group   グループ.
+ *  @param      [in]        event   イベント.
+ *  @return     成功時は, 状態マシンの数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+ssize_t fsm_group_subscribers(struct fsm_group *group, const struct fsm_event *event)
+{
+    int ev;
+
+    if ((group == NULL) || (event == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((group->depth == 0) && (group_flush(group) != 0)) {
+        return -1;
+    }
+    ev = chart_event_id(&group->chart, event);
+
+    return (ev < 0) ? 0 : (ssize_t)group->lists[ev].count;
+}
@@ -8,39 +8,143 @@
  *  This code is licensed under the MIT License.
  */
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <errno.h>
 #include <assert.h>
+#include <sched.h>
 
 #include "debug.h"
 #include "hfsm.h"
+#include "chart.h"
+#include "fiber.h"
+#include "lookup.h"
+#include "proxy.h"
 
 /**
  *  最大のコンポジット状態ネスト.
  */
 #define NEST_MAX (5)
 
+/**
+ *  優先度毎に積めるイベントの数の既定値.
+ */
+#define EVENT_QUEUE_CAPACITY (256)
+
+/**
+ *  do アクティビティを実行するファイバのスタックサイズ.
+ */
+#define ACTIVITY_STACK_BYTES (64 * 1024)
+
+/**
+ *  状態マシン内に確保するコンテキストの位置.
+ */
+#define CONTEXT_OFFSET \
+    ((sizeof(struct fsm) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+
+/**
+ *  ファイバで実行する do アクティビティ構造体.
+ *
+ *  状態マシン毎に 1 つ保持し, スタック領域は状態を跨いで再利用する.
+ */
+struct fsm_activity {
+    struct fiber fiber;             /**< do アクティビティを実行するファイバ. */
+    struct fsm *machine;            /**< do アクティビティを実行する状態マシン. */
+    const struct fsm_state *state;  /**< do アクティビティを開始した状態. (未開始時は NULL) */
+    bool running;                   /**< ファイバで実行中か. */
+    bool cancelled;                 /**< 中断を要求されたか. */
+};
+
+/**
+ *  遷移表構造体.
+ *
+ *  遷移の対応表の複製とその検索索引を保持し, 参照の数が 0 になった時点で解放する.
+ */
+struct fsm_table {
+    struct fsm_trans *corresps;                   /**< 遷移の対応表の複製. (終端を含む) */
+    struct lookup lookup;                         /**< 遷移の検索索引. */
+    _Atomic size_t refs;                          /**< 参照の数. */
+    void (*reclaim)(struct fsm_table *, void *);  /**< 解放時に呼び出すコールバック. */
+    void *ctx;                                    /**< コールバックの最後の引数. */
+};
+
 /**
  *  状態マシン構造体.
  */
 struct fsm {
     const struct fsm_state *current;  /**< 現在の状態. */
-    const struct fsm_trans *corresps; /**< 遷移の対応情報.*/
+    struct fsm_table *_Atomic table;  /**< 遷移表. (他のスレッドから差し替えられる) */
+    struct fsm_table *_Atomic hazard; /**< 遷移中に参照している遷移表. */
+    struct fsm_table *active;         /**< 遷移中に用いる遷移表. */
+    struct fsm_table *deferred;       /**< 遷移の終了後に解放する遷移表. */
+    unsigned int depth;               /**< 遷移の入れ子の深さ. */
+    struct fsm *outer;                /**< 同じスレッドで遷移中の外側の状態マシン. */
+    void *context;                    /**< コンテキスト. (状態マシン内に確保した場合は直後を指す) */
 
     STACK src_ancestors;              /**< 元状態の祖先を保持するバッファ. */
     STACK dest_ancestors;             /**< 先状態の祖先を保持するバッファ. */
+    struct ptr_index history_index;   /**< 子を持つ状態から履歴の位置を引く索引. */
+    const struct fsm_state **histories; /**< 子を持つ状態毎の履歴状態. */
+
+    QUEUE lanes[FSM_PRIORITY_LANES];  /**< 優先度毎のイベントキュー. (初回使用時に確保) */
+    unsigned pending_lanes;           /**< イベントが積まれている優先度のビット集合. */
+    size_t queue_capacity;            /**< 優先度毎に積めるイベントの数. */
+    struct fsm_activity *activity;    /**< ファイバの do アクティビティ. (初回使用時に確保) */
+#if OBSERVER
+    struct fsm_observer *observers;   /**< 登録されたオブザーバ. */
+#endif
 };
 
 /**
  *  状態マシン構造体の設定ヘルパ.
  */
-#define FSM_HELPER(curr, corr, s, d) \
-    (struct fsm){                    \
-        .current = (curr),           \
-        .corresps = (corr),          \
-        .src_ancestors = (s),        \
-        .dest_ancestors = (d)        \
+#define FSM_HELPER(curr, tbl, s, d)             \
+    (struct fsm){                               \
+        .current = (curr),                      \
+        .table = (tbl),                         \
+        .hazard = NULL,                         \
+        .active = NULL,                         \
+        .deferred = NULL,                       \
+        .depth = 0,                             \
+        .outer = NULL,                          \
+        .context = NULL,                        \
+        .src_ancestors = (s),                   \
+        .dest_ancestors = (d),                  \
+        .history_index = {0},                   \
+        .histories = NULL,                      \
+        .pending_lanes = 0,                     \
+        .queue_capacity = EVENT_QUEUE_CAPACITY, \
+        .activity = NULL                        \
     }
 
+/**
+ *  オブザーバへの通知マクロ.
+ *
+ *  オブザーバが登録されていない場合の負荷は分岐 1 つのみとなる.
+ *  OBSERVER が 0 の場合は何も生成しない.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    hook    呼び出すコールバックのメンバ名.
+ *  @param  [in]    ...     コールバックの引数. (状態マシンとコンテキストを除く)
+ */
+#if OBSERVER
+#define FSM_NOTIFY(machine, hook, ...)                                   \
+    do {                                                                 \
+        if (__builtin_expect((machine)->observers != NULL, 0)) {         \
+            for (struct fsm_observer *obs_ = (machine)->observers;       \
+                 obs_ != NULL;                                           \
+                 obs_ = obs_->next) {                                    \
+                if (obs_->hook != NULL) {                                \
+                    obs_->hook((machine), __VA_ARGS__, obs_->ctx);       \
+                }                                                        \
+            }                                                            \
+        }                                                                \
+    } while (0)
+#else
+#define FSM_NOTIFY(machine, hook, ...)
+#endif
+
 /**
  *  開始状態.
  */
@@ -76,6 +180,166 @@ static inline struct fsm_state_variable *get_state_variable(const struct fsm_sta
     return (state->variable != NULL) ? state->variable : &null_obj;
 }
 
+/**
+ *  entry/do/exit アクションに渡す状態固有情報を取得する.
+ *
+ *  インスタンス状態では状態マシンのコンテキスト中のメンバを,
+ *  それ以外では状態変数の固有情報を返す.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    state   状態.
+ *  @return 状態固有情報のポインタが返る.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c state の非 NULL は呼び出し側で保証すること.
+ */
+static inline void *get_state_data(const struct fsm *machine, const struct fsm_state *state)
+{
+    if (state->slot) {
+        return (machine->context != NULL)
+               ? (char *)machine->context + state->slot_offset
+               : NULL;
+    }
+    return get_state_variable(state)->data;
+}
+
+/**
+ *  状態マシンが保持する履歴状態の位置を取得する.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    state   子を持つ状態.
+ *  @return 履歴状態を保持する場合は, @c histories の位置が返る.
+ *          保持しない場合は, -1 が返る.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
+ */
+static inline int history_slot(const struct fsm *machine, const struct fsm_state *state)
+{
+    return ptr_index_find(&machine->history_index, state);
+}
+
+/**
+ *  ガード条件を評価する.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    cond    ガード条件.
+ *  @return 条件を満たす場合は true が返る.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c cond の非 NULL は呼び出し側で保証すること.
+ */
+static inline bool cond_evaluate(struct fsm *machine, const struct fsm_cond *cond)
+{
+    return (cond->func != NULL) ? cond->func(machine) : cond->func_ctx(machine, machine->context);
+}
+
+/**
+ *  遷移アクションを実行する.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    action  遷移アクション.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c action の非 NULL は呼び出し側で保証すること.
+ */
+static inline void action_execute(struct fsm *machine, const struct fsm_action *action)
+{
+    if (action->func != NULL) {
+        action->func(machine);
+    } else {
+        action->func_ctx(machine, machine->context);
+    }
+}
+
+/**
+ *  ファイバで do アクティビティを実行する.
+ *
+ *  @param  [in,out]    arg do アクティビティ.
+ */
+static void activity_main(void *arg)
+{
+    struct fsm_activity *activity = arg;
+    const struct fsm_state *state = activity->state;
+
+    state->exec(activity->machine, get_state_data(activity->machine, state));
+}
+
+/**
+ *  状態の do アクティビティをファイバで開始または再開する.
+ *
+ *  状態に入ってから初回の呼び出しでファイバを開始し, 以降は中断した位置から再開する.
+ *  do アクティビティが終了した後は, 状態から出るまで何もしない.
+ *
+ *  @param  [in,out]    machine 状態マシン.
+ *  @param  [in]        state   現在の状態.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c state の非 NULL は呼び出し側で保証すること.
+ */
+static void activity_resume(struct fsm *machine, const struct fsm_state *state)
+{
+    struct fsm_activity *activity = machine->activity;
+
+    if (activity == NULL) {
+        activity = malloc(sizeof(struct fsm_activity));
+        if (activity == NULL) {
+            return;
+        }
+        if (fiber_init(&activity->fiber, ACTIVITY_STACK_BYTES) != 0) {
+            free(activity);
+            return;
+        }
+        activity->machine = machine;
+        activity->state = NULL;
+        activity->running = false;
+        activity->cancelled = false;
+        machine->activity = activity;
+    }
+
+    /* do アクティビティの中から呼ばれた場合は何もしない. */
+    if (activity->running) {
+        return;
+    }
+    if (activity->state == NULL) {
+        activity->state = state;
+        activity->cancelled = false;
+        if (fiber_start(&activity->fiber, activity_main, activity) != 0) {
+            activity->state = NULL;
+            return;
+        }
+    }
+
+    activity->running = true;
+    fiber_resume(&activity->fiber);
+    activity->running = false;
+}
+
+/**
+ *  状態の do アクティビティがファイバで実行中であれば, 中断する.
+ *
+ *  do アクティビティの @ref fsm_yield が true を返すようにして終了するまで再開する.
+ *  do アクティビティの中から状態遷移した場合は, ファイバに戻った後の
+ *  @ref fsm_yield が true を返し, do アクティビティの終了後に呼び出し元へ戻る.
+ *
+ *  @param  [in,out]    machine 状態マシン.
+ *  @param  [in]        state   遷移元の状態.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c state の非 NULL は呼び出し側で保証すること.
+ */
+static void activity_cancel(struct fsm *machine, const struct fsm_state *state)
+{
+    struct fsm_activity *activity = machine->activity;
+
+    if ((activity == NULL) || (activity->state != state)) {
+        return;
+    }
+
+    activity->cancelled = true;
+    if (!activity->running) {
+        activity->running = true;
+        while (!fiber_finished(&activity->fiber)) {
+            fiber_resume(&activity->fiber);
+        }
+        activity->running = false;
+    }
+    activity->state = NULL;
+}
+
 /**
  *  entry アクションが設定されていれば, 実行する.
  *
@@ -94,8 +358,9 @@ static inline void entry_if_can_be(struct fsm *machine,
                                    bool cmpl)
 {
     if (state->entry != NULL) {
-        state->entry(machine, get_state_variable(state)->data, cmpl);
+        state->entry(machine, get_state_data(machine, state), cmpl);
     }
+    FSM_NOTIFY(machine, entry, state);
 }
 
 /**
@@ -110,7 +375,11 @@ static inline void exec_if_can_be(struct fsm *machine)
 {
     const struct fsm_state *state = machine->current;
     if ((state->exec != NULL)) {
-        state->exec(machine, get_state_variable(state)->data);
+        if (state->fiber) {
+            activity_resume(machine, state);
+        } else {
+            state->exec(machine, get_state_data(machine, state));
+        }
     }
 }
 
@@ -134,11 +403,18 @@ static inline void exit_if_can_be(struct fsm *machine,
 {
     const struct fsm_state *parent = get_state_variable(state)->parent;
 
+    if (state->fiber) {
+        activity_cancel(machine, state);
+    }
     if (state->exit != NULL) {
-        state->exit(machine, get_state_variable(state)->data, cmpl);
+        state->exit(machine, get_state_data(machine, state), cmpl);
     }
+    FSM_NOTIFY(machine, exit, state);
     if (parent != NULL) {
-        get_state_variable(parent)->history = state;
+        int slot = history_slot(machine, parent);
+        if (slot >= 0) {
+            machine->histories[slot] = state;
+        }
     }
 }
 
@@ -158,7 +434,7 @@ static void fsm_change_state(struct fsm *machine,
     const struct fsm_state *src_state;
     const struct fsm_state *dest_state;
     const struct fsm_state *ancestor;
-    int count;
+    int count, slot;
 
     /* 自己遷移の場合 */
     if (machine->current == new_state) {
@@ -208,8 +484,72 @@ static void fsm_change_state(struct fsm *machine,
     } while (count >= 0);
 
     /* 履歴状態に対する遷移を行う. */
-    if (get_state_variable(dest_state)->history != NULL) {
-        fsm_change_state(machine, get_state_variable(dest_state)->history);
+    slot = history_slot(machine, dest_state);
+    if ((slot >= 0) && (machine->histories[slot] != NULL)) {
+        fsm_change_state(machine, machine->histories[slot]);
+    }
+}
+
+/**
+ *  このスレッドで遷移中の最も内側の状態マシン.
+ */
+static _Thread_local struct fsm *dispatching = NULL;
+
+/**
+ *  遷移を開始し, 遷移中に用いる遷移表を確定する.
+ *
+ *  参照する遷移表を @c hazard で公開してから差し替えの有無を再確認するため,
+ *  差し替え側は @c hazard を見ることで旧い遷移表が使用中かを判断できる.
+ *  入れ子の遷移では外側の遷移表をそのまま用いる.
+ *
+ *  @param  [in,out]    machine 状態マシン.
+ *  @return 遷移中に用いる遷移表が返る.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
+ */
+static inline struct fsm_table *table_enter(struct fsm *machine)
+{
+    struct fsm_table *table, *latest;
+
+    if (machine->depth++ > 0) {
+        return machine->active;
+    }
+
+    machine->outer = dispatching;
+    dispatching = machine;
+    table = atomic_load_explicit(&machine->table, memory_order_relaxed);
+    for (;;) {
+        atomic_exchange_explicit(&machine->hazard, table, memory_order_seq_cst);
+        latest = atomic_load_explicit(&machine->table, memory_order_seq_cst);
+        if (latest == table) {
+            break;
+        }
+        table = latest;
+    }
+    machine->active = table;
+
+    return table;
+}
+
+/**
+ *  遷移を終了し, 遷移表の参照を外す.
+ *
+ *  遷移中に自身の遷移表が差し替えられた場合は, 旧い遷移表をここで解放する.
+ *
+ *  @param  [in,out]    machine 状態マシン.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
+ */
+static inline void table_leave(struct fsm *machine)
+{
+    if (--machine->depth > 0) {
+        return;
+    }
+
+    atomic_store_explicit(&machine->hazard, NULL, memory_order_release);
+    machine->active = NULL;
+    dispatching = machine->outer;
+    if (machine->deferred != NULL) {
+        fsm_table_release(machine->deferred);
+        machine->deferred = NULL;
     }
 }
 
@@ -220,6 +560,8 @@ static void fsm_change_state(struct fsm *machine,
  *  遷移は行わない.
  *  遷移にアクションが設定されている場合は, アクションを実行後に遷移を行う.
  *  遷移先が NULL の場合は内部遷移となる.
+ *  遷移表は @ref table_enter で確定したものを用いる.
+ *  同じ状態とイベントの遷移が複数ある場合は, 対応表の順にガード条件を評価する.
  *
  *  @param  [in]    machine 状態マシン.
  *  @param  [in]    state   起点となる状態.
@@ -234,15 +576,22 @@ static bool fsm_state_transit(struct fsm *machine,
                               const struct fsm_state *state,
                               const struct fsm_event *event)
 {
-    int i;
+    const struct lookup *lookup = &machine->active->lookup;
+    const struct fsm_trans *corr;
+    size_t cursor;
 
-    for (i = 0; machine->corresps[i].from != NULL; ++i) {
-        const struct fsm_trans *corr = &machine->corresps[i];
-        if ((corr->from == state) && (corr->event == event)) {
-            if ((corr->cond == NULL) || corr->cond->func(machine)) {
-                if (corr->action != NULL) {
-                    corr->action->func(machine);
-                }
+    for (corr = lookup_first(lookup, state, event, &cursor);
+         corr != NULL;
+         corr = lookup_next(lookup, state, event, &cursor)) {
+        bool passed = (corr->cond == NULL) || cond_evaluate(machine, corr->cond);
+        if (corr->cond != NULL) {
+            FSM_NOTIFY(machine, guard_evaluated, corr, passed);
+        }
+        if (passed) {
+            FSM_NOTIFY(machine, transition_taken, corr);
+            if (corr->action != NULL) {
+                action_execute(machine, corr->action);
+            }
 if (corr->to == NULL) {
     if ((corr->cond == NULL) && (corr->action == NULL)) {
         DEBUG("state: %s %s", corr->from->name, corr->event->name);
@@ -264,12 +613,11 @@ if (corr->to == NULL) {
         DEBUG("state: %s --%s[%s]/%s-> %s", corr->from->name, corr->event->name, corr->cond->name, corr->action->name, corr->to->name);
     }
 }
-                if (corr->to != NULL) {
-                    fsm_change_state(machine, corr->to);
-                }
-
-                return true;
+            if (corr->to != NULL) {
+                fsm_change_state(machine, corr->to);
             }
+
+            return true;
         }
     }
 
@@ -281,25 +629,79 @@ if (corr->to == NULL) {
  *              初期化後の状態は @ref state_start となる.
  *
  *              @c rels が設定されている場合は, 指定に従って状態の親を設定する.
+ *              状態の親子関係は同じ状態を用いる全ての状態マシンで共有し,
+ *              履歴状態は状態マシン毎に保持する.
  *              状態マシンは, @c corresps の設定の状態遷移を行う.
  *
+ *              呼び出し毎に @c corresps から遷移表を生成し, 生成した状態マシンのみが
+ *              参照する. 同じ @c corresps で呼び出しても遷移表は共有されないため,
+ *              状態マシン毎に遷移表の複製と検索索引の構築の負荷が掛かる.
+ *              多数の状態マシンで遷移表を共有する場合や,
+ *              @ref fsm_publish_table で複数の状態マシンの遷移表をまとめて
+ *              差し替える場合は, @ref fsm_table_compile で生成した遷移表を
+ *              @ref fsm_init_table に渡すこと.
+ *
  *  @param      [in]    rels        状態の関係性.
  *  @param      [in]    corresps    状態遷移の対応表.
  *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
  *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @sa         fsm_init_table
  */
 struct fsm *fsm_init(const struct fsm_rels *rels,
                      const struct fsm_trans *corresps)
 {
     struct fsm *machine;
-    STACK src_ancs, dest_ancs;
+    struct fsm_table *table;
 
     if (corresps == NULL) {
         errno = EINVAL;
         return NULL;
     }
 
-    machine = malloc(sizeof(struct fsm));
+    table = fsm_table_compile(corresps, NULL, NULL);
+    if (table == NULL) {
+        return NULL;
+    }
+    machine = fsm_init_table(rels, table);
+    fsm_table_release(table);
+
+    return machine;
+}
+
+/**
+ *  @details    @c table を遷移表とする開始状態の状態マシンを, 生成する.
+ *              状態マシンは @c table の参照を 1 つ保持するため, 大きな遷移表を
+ *              一度だけ生成して複数の状態マシンで共有できる.
+ *
+ *  @param      [in]    rels    状態の関係性.
+ *  @param      [in]    table   遷移表.
+ *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @sa         fsm_init
+ */
+struct fsm *fsm_init_table(const struct fsm_rels *rels, struct fsm_table *table)
+{
+    return fsm_init_context(rels, table, NULL, 0);
+}
+
+/**
+ *  開始状態の状態マシンを確保する.
+ *
+ *  状態の関係性の設定と Null 遷移は行わない.
+ *
+ *  @param  [in]    table   遷移表.
+ *  @param  [in]    context コンテキストの初期値, またはコンテキスト.
+ *  @param  [in]    bytes   状態マシン内に確保するコンテキストのバイト数.
+ *  @return 成功時は, 確保したオブジェクトのポインタが返る.
+ *          失敗時は, NULL が返り, errno が適切に設定される.
+ *  @pre    @c table の非 NULL は呼び出し側で保証すること.
+ */
+static struct fsm *fsm_alloc(struct fsm_table *table, const void *context, size_t bytes)
+{
+    struct fsm *machine;
+    STACK src_ancs, dest_ancs;
+
+    machine = malloc(CONTEXT_OFFSET + bytes);
     src_ancs = stack_init(sizeof(struct fsm_state*), NEST_MAX);
     dest_ancs = stack_init(sizeof(struct fsm_state*), NEST_MAX);
     if ((machine == NULL) || (src_ancs == NULL) || (dest_ancs == NULL)) {
@@ -309,104 +711,704 @@ struct fsm *fsm_init(const struct fsm_rels *rels,
         return NULL;
     }
 
-    *machine = FSM_HELPER(state_start, corresps, src_ancs, dest_ancs);
-
-    /* 状態の関係性を設定する. */
-    if (rels != NULL) {
-        const struct fsm_state *oneself, *parent;
-        for (int i = 0; rels[i].oneself != NULL; ++i) {
-            oneself = rels[i].oneself;
-            parent = rels[i].parent;
-            get_state_variable(oneself)->parent = parent;
-            if (rels[i].is_default) {
-                get_state_variable(parent)->history = oneself;
-            }
+    atomic_fetch_add_explicit(&table->refs, 1, memory_order_relaxed);
+    *machine = FSM_HELPER(state_start, table, src_ancs, dest_ancs);
+    if (bytes > 0) {
+        machine->context = (char *)machine + CONTEXT_OFFSET;
+        if (context != NULL) {
+            memcpy(machine->context, context, bytes);
+        } else {
+            memset(machine->context, 0, bytes);
         }
+    } else {
+        machine->context = (void *)context;
     }
 
-    /* Null 遷移を行う. */
-    fsm_state_transit(machine, machine->current, event_null);
-
     return machine;
 }
 
 /**
- *  @details    @c machine の使用領域を解放する.
+ *  状態マシンの使用領域を解放する.
  *
- *  @param      [in,out]    machine 状態マシン.
- *  @return     成功時は, 0 が返る.
- *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  exit アクションは呼び出さない.
+ *
+ *  @param  [in,out]    machine 状態マシン.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
  */
-int fsm_term(struct fsm *machine)
+static void fsm_free(struct fsm *machine)
 {
-    if (machine == NULL) {
-        errno = EINVAL;
-        return -1;
+    for (int i = 0; i < FSM_PRIORITY_LANES; ++i) {
+        queue_release(machine->lanes[i]);
     }
-
-    fsm_change_state(machine, state_end);
+    if (machine->activity != NULL) {
+        fiber_release(&machine->activity->fiber);
+        free(machine->activity);
+    }
+    fsm_table_release(atomic_load_explicit(&machine->table, memory_order_acquire));
+    ptr_index_release(&machine->history_index);
+    free(machine->histories);
     stack_release(machine->dest_ancestors);
     stack_release(machine->src_ancestors);
     free(machine);
+}
+
+/**
+ *  状態の関係性を設定し, 状態マシン毎の履歴状態を確保する.
+ *
+ *  親子関係は状態の定義に属するため全ての状態マシンで共有し,
+ *  異なる場合のみ書き込む. 履歴状態は状態マシン毎に保持し,
+ *  既定の子状態で初期化する.
+ *
+ *  @param  [in,out]    machine 状態マシン.
+ *  @param  [in]        rels    状態の関係性.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ *  @pre    @c machine の非 NULL は呼び出し側で保証すること.
+ *  @pre    @c rels の非 NULL は呼び出し側で保証すること.
+ */
+static int fsm_bind_rels(struct fsm *machine, const struct fsm_rels *rels)
+{
+    size_t count = 0, used = 0;
+
+    while (rels[count].oneself != NULL) {
+        ++count;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    machine->histories = calloc(count, sizeof(*machine->histories));
+    if ((machine->histories == NULL) || (ptr_index_init(&machine->history_index, count) != 0)) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const struct fsm_state *oneself = rels[i].oneself;
+        const struct fsm_state *parent = rels[i].parent;
+        int slot;
+
+        if ((oneself->variable != NULL) && (oneself->variable->parent != parent)) {
+            oneself->variable->parent = parent;
+        }
+        if (parent == NULL) {
+            continue;
+        }
+        slot = history_slot(machine, parent);
+        if (slot < 0) {
+            slot = (int)used++;
+            if (ptr_index_add(&machine->history_index, parent, slot) != 0) {
+                return -1;
+            }
+        }
+        if (rels[i].is_default) {
+            machine->histories[slot] = oneself;
+        }
+    }
 
     return 0;
 }
 
 /**
- *  @details    指定イベントによる状態遷移を発生させる.
- *              現在の状態に対応する遷移がない場合は, 親にイベントを伝播させる.
+ *  @details    @c table を遷移表とし, コンテキストを持つ開始状態の状態マシンを, 生成する.
+ *              @c bytes が 0 でない場合は, コンテキストの領域を状態マシンと連続して確保し,
+ *              @c context の内容 (NULL の場合は 0) で初期化する.
+ *              @c bytes が 0 の場合は, @c context をそのままコンテキストとする.
+ *              コンテキストは開始状態からの Null 遷移より前に設定されるため,
+ *              最初の状態の entry アクションからも参照できる.
+ *              コンテキストは @ref FSM_COND_CTX, @ref FSM_ACTION_CTX で定義した
+ *              ガード条件と遷移アクションに渡され, @ref FSM_STATE_SLOT で定義した
+ *              状態の entry/do/exit アクションにはそのメンバが渡される.
  *
- *  @param      [in]    machine 状態マシン.
- *  @param      [in]    event   発生したイベント.
+ *  @param      [in]    rels    状態の関係性.
+ *  @param      [in]    table   遷移表.
+ *  @param      [in]    context コンテキストの初期値, またはコンテキスト.
+ *  @param      [in]    bytes   状態マシン内に確保するコンテキストのバイト数.
+ *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @sa         fsm_init_table
  */
-void fsm_transition(struct fsm *machine, const struct fsm_event *event)
+struct fsm *fsm_init_context(const struct fsm_rels *rels,
+                             struct fsm_table *table,
+                             const void *context,
+                             size_t bytes)
 {
-    const struct fsm_state *state;
+    struct fsm *machine;
 
-    if ((machine == NULL) || (event == NULL)) {
-        return;
+    if ((table == NULL) || (bytes > SIZE_MAX - CONTEXT_OFFSET)) {
+        errno = EINVAL;
+        return NULL;
     }
 
-    state = machine->current;
-    while ((state != NULL) && !fsm_state_transit(machine, state, event)) {
-        state = get_state_variable(state)->parent;
+    machine = fsm_alloc(table, context, bytes);
+    if (machine == NULL) {
+        return NULL;
+    }
+
+    /* 状態の関係性を設定する. */
+    if ((rels != NULL) && (fsm_bind_rels(machine, rels) != 0)) {
+        int err = errno;
+        fsm_free(machine);
+        errno = err;
+        return NULL;
     }
 
     /* Null 遷移を行う. */
+    table_enter(machine);
     fsm_state_transit(machine, machine->current, event_null);
+    table_leave(machine);
+
+    return machine;
 }
 
 /**
- *  @details    現在の状態の do アクティビティを実行する.
+ *  @details    @c machine の使用領域を解放する.
  *
- *  @param  [in]    machine 状態マシン.
+ *  @param      [in,out]    machine 状態マシン.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
  */
-void fsm_update(struct fsm *machine)
+int fsm_term(struct fsm *machine)
 {
     if (machine == NULL) {
-        return;
+        errno = EINVAL;
+        return -1;
     }
 
-    exec_if_can_be(machine);
+    fsm_change_state(machine, state_end);
+    fsm_free(machine);
+
+    return 0;
 }
 
 /**
- *  @details    指定状態の固有情報を取得する.
+ *  @details    遷移を持たない代理の状態マシンを生成する.
+ *              entry/exit アクションは呼び出さず, Null 遷移も行わない.
  *
- *  @param      [in]    state   固有情報を取得したい状態.
- *  @return     正常時は, 固有情報のポインタが返る.
+ *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
  *              失敗時は, NULL が返り, errno が適切に設定される.
  */
-void *fsm_get_state_data(const struct fsm_state *state)
+struct fsm *fsm_proxy_init(void)
 {
-    if (state == NULL) {
-        errno = EINVAL;
+    static const struct fsm_trans none[] = {
+        FSM_TRANS_TERMINATOR
+    };
+    struct fsm_table *table;
+    struct fsm *machine;
+
+    table = fsm_table_compile(none, NULL, NULL);
+    if (table == NULL) {
+        return NULL;
+    }
+    machine = fsm_alloc(table, NULL, 0);
+    fsm_table_release(table);
+
+    return machine;
+}
+
+/**
+ *  @details    代理の状態マシンの使用領域を解放する.
+ *              exit アクションは呼び出さない.
+ *
+ *  @param      [in,out]    machine 代理の状態マシン. (NULL 可)
+ */
+void fsm_proxy_release(struct fsm *machine)
+{
+    if (machine != NULL) {
+        fsm_free(machine);
+    }
+}
+
+/**
+ *  @details    代理の状態マシンの現在の状態とコンテキストを設定する.
+ *              以降のコールバックでは @ref fsm_get_current, @ref fsm_get_context,
+ *              @ref fsm_get_state_data_of が設定した内容を返す.
+ *
+ *  @param      [in,out]    machine 代理の状態マシン.
+ *  @param      [in]        current 現在の状態.
+ *  @param      [in]        context コンテキスト.
+ *  @pre        @c machine の非 NULL は呼び出し側で保証すること.
+ */
+void fsm_proxy_bind(struct fsm *machine, const struct fsm_state *current, void *context)
+{
+    machine->current = current;
+    machine->context = context;
+}
+
+/**
+ *  @details    指定イベントによる状態遷移を発生させる.
+ *              現在の状態に対応する遷移がない場合は, 親にイベントを伝播させる.
+ *
+ *  @param      [in]    machine 状態マシン.
+ *  @param      [in]    event   発生したイベント.
+ */
+void fsm_transition(struct fsm *machine, const struct fsm_event *event)
+{
+    const struct fsm_state *state;
+
+    if ((machine == NULL) || (event == NULL)) {
+        return;
+    }
+
+    FSM_NOTIFY(machine, event_received, event);
+
+    table_enter(machine);
+    state = machine->current;
+    while ((state != NULL) && !fsm_state_transit(machine, state, event)) {
+        state = get_state_variable(state)->parent;
+    }
+    if (state == NULL) {
+        FSM_NOTIFY(machine, unhandled_event, event);
+    }
+
+    /* Null 遷移を行う. */
+    fsm_state_transit(machine, machine->current, event_null);
+    table_leave(machine);
+
+    FSM_NOTIFY(machine, event_processed, event);
+}
+
+/**
+ *  @details    @c event を @c priority の優先度のキューに積む.
+ *              積んだイベントは @ref fsm_dispatch で処理する.
+ *              優先度毎のキューは初回使用時に確保する.
+ *
+ *  @param      [in,out]    machine     状態マシン.
+ *  @param      [in]        event       積むイベント.
+ *  @param      [in]        priority    イベントの優先度.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              キューが一杯の場合は, errno に ENOBUFS が設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_post(struct fsm *machine, const struct fsm_event *event, enum fsm_priority priority)
+{
+    if ((machine == NULL) || (event == NULL)
+        || ((int)priority < 0) || (priority >= FSM_PRIORITY_LANES)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (machine->lanes[priority] == NULL) {
+        machine->lanes[priority] = queue_init(sizeof(event), machine->queue_capacity);
+        if (machine->lanes[priority] == NULL) {
+            return -1;
+        }
+    }
+    if (queue_enq(machine->lanes[priority], (void *)&event) == NULL) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    machine->pending_lanes |= 1U << priority;
+
+    return 0;
+}
+
+/**
+ *  @details    積まれたイベントのうち, 最も優先度の高いものを 1 つ取り出して
+ *              @ref fsm_transition で処理する.
+ *              イベントが積まれている優先度をビット集合で保持しているため,
+ *              取り出しは積まれているイベントの数によらず定数時間で行える.
+ *
+ *  @param      [in,out]    machine 状態マシン.
+ *  @return     イベントを処理した場合は 1, 積まれたイベントがない場合は 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_dispatch(struct fsm *machine)
+{
+    const struct fsm_event *event;
+    int lane;
+
+    if (machine == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (machine->pending_lanes == 0) {
+        return 0;
+    }
+
+    lane = (int)(sizeof(unsigned) * 8) - 1 - __builtin_clz(machine->pending_lanes);
+    if (queue_deq(machine->lanes[lane], &event) == 0) {
+        machine->pending_lanes &= ~(1U << lane);
+    }
+    fsm_transition(machine, event);
+
+    return 1;
+}
+
+/**
+ *  @details    すべての優先度のキューに積まれているイベントの数を返す.
+ *
+ *  @param      [in]    machine 状態マシン.
+ *  @return     成功時は, 積まれているイベントの数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+ssize_t fsm_pending(struct fsm *machine)
+{
+    ssize_t count = 0;
+
+    if (machine == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (int i = 0; i < FSM_PRIORITY_LANES; ++i) {
+        if (machine->lanes[i] != NULL) {
+            count += queue_count(machine->lanes[i]);
+        }
+    }
+
+    return count;
+}
+
+/**
+ *  @details    優先度毎に積めるイベントの数を設定し, すべての優先度のキューを
+ *              確保する.
+ *              既定値は 256 で, 設定しない場合はキューを初回使用時に確保する.
+ *              緊急のイベントを初めて積む際の確保を避けたい場合にも使用する.
+ *              イベントが積まれている間は変更できない.
+ *
+ *  @param      [in,out]    machine     状態マシン.
+ *  @param      [in]        capacity    優先度毎に積めるイベントの数.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fsm_set_queue_capacity(struct fsm *machine, size_t capacity)
+{
+    if ((machine == NULL) || (capacity == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (machine->pending_lanes != 0) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    for (int i = 0; i < FSM_PRIORITY_LANES; ++i) {
+        queue_release(machine->lanes[i]);
+        machine->lanes[i] = NULL;
+    }
+    machine->queue_capacity = capacity;
+    for (int i = 0; i < FSM_PRIORITY_LANES; ++i) {
+        machine->lanes[i] = queue_init(sizeof(const struct fsm_event *), capacity);
+        if (machine->lanes[i] == NULL) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    @c corresps を複製した遷移表を生成する.
+ *              検索方式は遷移の数とキーの密度から自動で選ぶ.
+ *
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @param      [in]    reclaim     遷移表の解放時に呼び出すコールバック. (不要なら NULL)
+ *  @param      [in]    ctx         コールバックの最後の引数.
+ *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @sa         fsm_table_compile_as
+ */
+struct fsm_table *fsm_table_compile(const struct fsm_trans *corresps,
+                                    void (*reclaim)(struct fsm_table *, void *),
+                                    void *ctx)
+{
+    return fsm_table_compile_as(corresps, FSM_LOOKUP_AUTO, reclaim, ctx);
+}
+
+/**
+ *  @details    @c corresps を複製し, @c lookup の方式の検索索引を持つ遷移表を生成する.
+ *              生成した遷移表の参照は呼び出し側が 1 つ保持し,
+ *              @ref fsm_publish_table で状態マシンに設定すると状態マシンも参照を保持する.
+ *              すべての参照が @ref fsm_table_release で解放された時点で,
+ *              @c reclaim を呼び出した後に遷移表を解放する.
+ *
+ *              @ref FSM_LOOKUP_AUTO の場合, 小さな遷移表は線形走査,
+ *              (状態, イベント) の組の密度が高い遷移表は整列済み配列,
+ *              疎な遷移表や大きな遷移表は完全ハッシュとする.
+ *              完全ハッシュを構築できなかった場合は整列済み配列とする.
+ *
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @param      [in]    lookup      検索方式.
+ *  @param      [in]    reclaim     遷移表の解放時に呼び出すコールバック. (不要なら NULL)
+ *  @param      [in]    ctx         コールバックの最後の引数.
+ *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+struct fsm_table *fsm_table_compile_as(const struct fsm_trans *corresps,
+                                       enum fsm_lookup lookup,
+                                       void (*reclaim)(struct fsm_table *, void *),
+                                       void *ctx)
+{
+    struct fsm_table *table;
+    size_t ntrans = 0;
+
+    if ((corresps == NULL) || (lookup < FSM_LOOKUP_AUTO) || (lookup > FSM_LOOKUP_HASH)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    while (corresps[ntrans].from != NULL) {
+        ++ntrans;
+    }
+
+    table = malloc(sizeof(struct fsm_table));
+    if (table == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    table->corresps = malloc((ntrans + 1) * sizeof(struct fsm_trans));
+    if (table->corresps == NULL) {
+        free(table);
+        errno = ENOMEM;
+        return NULL;
+    }
+    memcpy(table->corresps, corresps, (ntrans + 1) * sizeof(struct fsm_trans));
+    if (lookup_build(&table->lookup, table->corresps, ntrans, lookup) != 0) {
+        free(table->corresps);
+        free(table);
+        return NULL;
+    }
+    atomic_init(&table->refs, 1);
+    table->reclaim = reclaim;
+    table->ctx = ctx;
+
+    return table;
+}
+
+/**
+ *  @details    @c table の参照を 1 つ解放する.
+ *              最後の参照の場合は, 解放時のコールバックを呼び出した後に遷移表を解放する.
+ *
+ *  @param      [in,out]    table   遷移表.
+ *  @note       スレッドセーフ.
+ */
+void fsm_table_release(struct fsm_table *table)
+{
+    if (table == NULL) {
+        return;
+    }
+
+    if (atomic_fetch_sub_explicit(&table->refs, 1, memory_order_acq_rel) == 1) {
+        if (table->reclaim != NULL) {
+            table->reclaim(table, table->ctx);
+        }
+        lookup_release(&table->lookup);
+        free(table->corresps);
+        free(table);
+    }
+}
+
+/**
+ *  @details    @c table が保持する遷移の対応表の複製を取得する.
+ *
+ *  @param      [in]    table   遷移表.
+ *  @return     成功時は, 遷移の対応表が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+const struct fsm_trans *fsm_table_corresps(const struct fsm_table *table)
+{
+    if (table == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return table->corresps;
+}
+
+/**
+ *  @details    @c table の検索方式を取得する.
+ *              生成時に @ref FSM_LOOKUP_AUTO を指定した場合は, 選ばれた方式が返る.
+ *
+ *  @param      [in]    table   遷移表.
+ *  @return     成功時は, 検索方式が返る.
+ *              失敗時は, @ref FSM_LOOKUP_AUTO が返り, errno が適切に設定される.
+ */
+enum fsm_lookup fsm_table_lookup(const struct fsm_table *table)
+{
+    if (table == NULL) {
+        errno = EINVAL;
+        return FSM_LOOKUP_AUTO;
+    }
+
+    return table->lookup.kind;
+}
+
+/**
+ *  @details    @c table が使用するメモリ量 (対応表の複製と検索索引) を取得する.
+ *
+ *  @param      [in]    table   遷移表.
+ *  @return     成功時は, メモリ量 (バイト) が返る.
+ *              失敗時は, 0 が返り, errno が適切に設定される.
+ */
+size_t fsm_table_bytes(const struct fsm_table *table)
+{
+    if (table == NULL) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    return sizeof(struct fsm_table)
+           + ((table->lookup.ntrans + 1) * sizeof(struct fsm_trans))
+           + table->lookup.bytes;
+}
+
+/**
+ *  @details    @c machine の遷移表を @c table に差し替え, 旧い遷移表の参照を解放する.
+ *              処理中の遷移は旧い遷移表で最後まで行い, 以降の遷移から新しい遷移表を用いる.
+ *              遷移を行う側はロックを取らず, 差し替える側が旧い遷移表を参照中の遷移の
+ *              終了を待つ.
+ *              @c machine の遷移中に同じスレッド (アクションなど) から呼び出した場合は,
+ *              待たずに遷移の終了時に旧い遷移表の参照を解放する.
+ *
+ *  @param      [in,out]    machine 状態マシン.
+ *  @param      [in]        table   新しい遷移表.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @note       @c machine を駆動するスレッド以外から呼び出せる.
+ *              同じ状態マシンへの差し替えを複数のスレッドから同時に行わないこと.
+ */
+int fsm_publish_table(struct fsm *machine, struct fsm_table *table)
+{
+    struct fsm_table *old;
+
+    if ((machine == NULL) || (table == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    atomic_fetch_add_explicit(&table->refs, 1, memory_order_relaxed);
+    old = atomic_exchange_explicit(&machine->table, table, memory_order_seq_cst);
+
+    for (struct fsm *m = dispatching; m != NULL; m = m->outer) {
+        if (m == machine) {
+            /* 自身の遷移中は待つと終わらないため, 遷移の終了時に解放する. */
+            if (atomic_load_explicit(&machine->hazard, memory_order_relaxed) == old) {
+                machine->deferred = old;
+            } else {
+                fsm_table_release(old);
+            }
+            return 0;
+        }
+    }
+
+    /* 旧い遷移表で処理中の遷移が終わるまで待つ. (グレース期間) */
+    while (atomic_load_explicit(&machine->hazard, memory_order_seq_cst) == old) {
+        sched_yield();
+    }
+    fsm_table_release(old);
+
+    return 0;
+}
+
+/**
+ *  @details    現在の状態の do アクティビティを実行する.
+ *              ファイバ状態の場合は, 中断した do アクティビティを再開する.
+ *
+ *  @param  [in]    machine 状態マシン.
+ */
+void fsm_update(struct fsm *machine)
+{
+    if (machine == NULL) {
+        return;
+    }
+
+    exec_if_can_be(machine);
+}
+
+/**
+ *  @details    ファイバで実行中の do アクティビティを中断し, @ref fsm_update の呼び出し元に戻る.
+ *              次の @ref fsm_update で中断した位置から再開する.
+ *              状態から出るために中断を要求されている場合は, 中断せずに true を返す.
+ *              この場合, do アクティビティは後始末をして速やかに戻ること.
+ *
+ *  @param      [in]    machine 状態マシン.
+ *  @return     do アクティビティを続ける場合は, false が返る.
+ *              中断を要求されている場合, またはファイバで実行中でない場合は, true が返る.
+ *  @warning    ファイバ状態の do アクティビティの中から呼び出すこと.
+ */
+bool fsm_yield(struct fsm *machine)
+{
+    struct fsm_activity *activity;
+
+    if ((machine == NULL) || (machine->activity == NULL) || !machine->activity->running) {
+        errno = EPERM;
+        return true;
+    }
+
+    activity = machine->activity;
+    if (activity->cancelled) {
+        return true;
+    }
+    activity->running = false;
+    fiber_yield(&activity->fiber);
+    activity->running = true;
+
+    return activity->cancelled;
+}
+
+/**
+ *  @details    指定状態の固有情報を取得する.
+ *              状態の定義に与えた固有情報 (全状態マシンで共有) のみを返す.
+ *              @ref FSM_STATE_SLOT で定義した状態の固有情報は状態マシン毎にあるため
+ *              NULL が返る. その場合は @ref fsm_get_state_data_of を用いること.
+ *
+ *  @param      [in]    state   固有情報を取得したい状態.
+ *  @return     正常時は, 固有情報のポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *  @sa         fsm_get_state_data_of
+ */
+void *fsm_get_state_data(const struct fsm_state *state)
+{
+    if (state == NULL) {
+        errno = EINVAL;
         return NULL;
     }
 
     return get_state_variable(state)->data;
 }
 
+/**
+ *  @details    @c machine における指定状態の固有情報を取得する.
+ *              @ref FSM_STATE_SLOT で定義した状態では @c machine のコンテキストの
+ *              メンバ (entry/do/exit アクションに渡されるもの) を,
+ *              それ以外の状態では @ref fsm_get_state_data と同じ固有情報を返す.
+ *
+ *  @param      [in]    machine 状態マシン.
+ *  @param      [in]    state   固有情報を取得したい状態.
+ *  @return     正常時は, 固有情報のポインタが返る.
+ *              コンテキストのない状態マシンのインスタンス状態では, NULL が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+void *fsm_get_state_data_of(const struct fsm *machine, const struct fsm_state *state)
+{
+    if ((machine == NULL) || (state == NULL)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return get_state_data(machine, state);
+}
+
+/**
+ *  @details    状態マシンのコンテキストを取得する.
+ *              状態マシン内に確保したコンテキストは @ref fsm_term まで有効となる.
+ *
+ *  @param      [in]    machine 状態マシン.
+ *  @return     正常時は, コンテキストのポインタが返る.
+ *              コンテキストがない場合は, NULL が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+void *fsm_get_context(const struct fsm *machine)
+{
+    if (machine == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return machine->context;
+}
+
 /**
  *  @details    現在の状態の状態名を指定されたバッファにコピーする.
  *              コピーする文字列は NULL 終端を保証し, 
@@ -426,66 +1428,178 @@ void fsm_current_state(struct fsm *machine, char *name, size_t len)
     name[len - 1] = '\0';
 }
 
+/**
+ *  @details    現在の状態を取得する.
+ *
+ *  @param      [in]    machine 状態マシン.
+ *  @return     成功時は, 現在の状態が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+const struct fsm_state *fsm_get_current(struct fsm *machine)
+{
+    if (machine == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return machine->current;
+}
+
+/**
+ *  状態を多分木に追加する.
+ *
+ *  親が未追加の場合は先に親を追加するため, 状態の番号の順によらず
+ *  親子関係を保った多分木が構築できる.
+ *
+ *  @param  [in,out]    tree    多分木.
+ *  @param  [in]        chart   状態遷移表の索引.
+ *  @param  [in,out]    nodes   状態の番号毎の多分木上のデータ部.
+ *  @param  [in]        id      追加する状態の番号.
+ *  @return 成功時は, 多分木上のデータ部のポインタが返る.
+ *          失敗時は, NULL が返り, errno が適切に設定される.
+ *  @pre    @c tree, @c chart および @c nodes の非 NULL は呼び出し側で保証すること.
+ */
+static void *dump_insert_state(TREE tree,
+                               const struct chart *chart,
+                               void **nodes,
+                               int id)
+{
+    void *parent = NULL;
+
+    if (nodes[id] != NULL) {
+        return nodes[id];
+    }
+
+    if (chart->parents[id] >= 0) {
+        parent = dump_insert_state(tree, chart, nodes, chart->parents[id]);
+        if (parent == NULL) {
+            return NULL;
+        }
+    }
+    nodes[id] = tree_insert_child(tree, parent, (void *)&chart->states[id]);
+
+    return nodes[id];
+}
+
 /**
  *  @details    @c machine の状態遷移を収集し, 収集した @ref TREE を @c handler
  *              に渡す.
  *              @c handler で任意フォーマットに出力すること.
  *
+ *              状態は索引を用いて収集し, 親のデータ部を直接指定して多分木に
+ *              追加するため, 状態と遷移の数に対して線形時間で処理する.
+ *              兄弟の状態は遷移表に現れた順に並ぶ.
+ *
  *  @param      [in]    machine 状態マシン.
  *  @param      [in]    handler 出力処理のハンドラ.
  */
 void fsm_dump_state_transition(struct fsm *machine, void (*handler)(TREE))
 {
-    SET states;
-    const struct fsm_state *state;
+    struct chart chart;
     TREE tree;
-    QUEUE reserve;
+    void **nodes;
 
     if ((machine == NULL) || (handler == NULL)) {
         return;
     }
 
     /* すべての状態を収集する. */
-    states = set_init(sizeof(struct fsm_state *), 30);
-    for (int i = 0; machine->corresps[i].from != NULL; ++i) {
-        const struct fsm_trans *corr = &machine->corresps[i];
-        for (state = corr->from; state != NULL; state = get_state_variable(state)->parent) {
-            set_add(states, (void *)&state);
-        }
-        for (state = corr->to; state != NULL; state = get_state_variable(state)->parent) {
-            set_add(states, (void *)&state);
-        }
+    int ret = chart_build(&chart, NULL, table_enter(machine)->corresps);
+    table_leave(machine);
+    if (ret != 0) {
+        return;
     }
 
-    /* 状態の親子関係を多分木に変換する.
-     * 収集した状態は順不同であり, 多分木に追加する際に必ず親が追加されている
-     * とは限らない.
-     * その為, 追加に失敗した要素はキューに追加しておき, リトライする.
-     */
-    tree = tree_init(sizeof(struct fsm_state *), set_count(states));
-    reserve = queue_init(sizeof(struct fsm_state *), set_count(states));
-    for (ITER it = set_iter(states); it != NULL; it = iter_next(it)) {
-        state = *(const struct fsm_state **)iter_get_payload(it);
-        const struct fsm_state **parent =
-            (get_state_variable(state)->parent != NULL) ? &get_state_variable(state)->parent : NULL;
-        if (tree_insert(tree, (void *)parent, (void *)&state) == NULL) {
-            queue_enq(reserve, (void *)&state);
-        }
+    /* 状態の親子関係を多分木に変換する. */
+    tree = tree_init(sizeof(struct fsm_state *), chart.nstates);
+    nodes = calloc(chart.nstates, sizeof(*nodes));
+    if ((tree == NULL) || (nodes == NULL)) {
+        free(nodes);
+        tree_release(tree);
+        chart_release(&chart);
+        return;
     }
-    set_release(states);
-    while (queue_count(reserve) > 0) {
-        if (queue_deq(reserve, &state) < 0) {
+    for (size_t i = 0; i < chart.nstates; ++i) {
+        if (dump_insert_state(tree, &chart, nodes, (int)i) == NULL) {
             break;
         }
-        const struct fsm_state **parent =
-            (get_state_variable(state)->parent != NULL) ? &get_state_variable(state)->parent : NULL;
-        if (tree_insert(tree, (void *)parent, (void *)&state) == NULL) {
-            queue_enq(reserve, (void *)&state);
-        }
     }
-    queue_release(reserve);
+    free(nodes);
+    chart_release(&chart);
 
     handler(tree);
 
     tree_release(tree);
 }
+
+/**
+ *  @details    @c machine に @c observer を登録する.
+ *              オブザーバは登録した順に呼び出される.
+ *              @c observer の領域は登録を解除するまで呼び出し側で保持すること.
+ *
+ *  @param      [in,out]    machine     状態マシン.
+ *  @param      [in,out]    observer    登録するオブザーバ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              OBSERVER を 0 としてビルドした場合は, errno に ENOTSUP が設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_add_observer(struct fsm *machine, struct fsm_observer *observer)
+{
+#if OBSERVER
+    struct fsm_observer **link;
+
+    if ((machine == NULL) || (observer == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (link = &machine->observers; *link != NULL; link = &(*link)->next) {
+        if (*link == observer) {
+            errno = EEXIST;
+            return -1;
+        }
+    }
+    observer->next = NULL;
+    *link = observer;
+
+    return 0;
+#else
+    errno = ((machine == NULL) || (observer == NULL)) ? EINVAL : ENOTSUP;
+    return -1;
+#endif
+}
+
+/**
+ *  @details    @c machine から @c observer の登録を解除する.
+ *
+ *  @param      [in,out]    machine     状態マシン.
+ *  @param      [in,out]    observer    登録を解除するオブザーバ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_remove_observer(struct fsm *machine, struct fsm_observer *observer)
+{
+#if OBSERVER
+    struct fsm_observer **link;
+
+    if ((machine == NULL) || (observer == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (link = &machine->observers; *link != NULL; link = &(*link)->next) {
+        if (*link == observer) {
+            *link = observer->next;
+            observer->next = NULL;
+            return 0;
+        }
+    }
+    errno = ENOENT;
+    return -1;
+#else
+    errno = ((machine == NULL) || (observer == NULL)) ? EINVAL : ENOTSUP;
+    return -1;
+#endif
+}
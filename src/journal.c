@@ -0,0 +1,776 @@
+/** @file   journal.c
+ *  @brief  イベントの記録と再生.
+ *
+ *  ログはヘッダと記録の列からなる. 値はすべてホストのバイトオーダで格納する.
+ *  ヘッダには状態遷移定義の指紋を格納し, 異なる定義での再生を拒否する.
+ *  記録はイベントの番号, 遷移後の状態の番号, 時刻, 付加データの長さ,
+ *  その時点までの状態の列のチェックサムおよび付加データからなる.
+ *  イベントと状態の番号は状態遷移表の索引による番号を用いる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "debug.h"
+#include "chart.h"
+#include "journal.h"
+
+/**
+ *  ログの識別子.
+ */
+#define JOURNAL_MAGIC "HFSMJRNL"
+
+/**
+ *  ログの形式の版.
+ */
+#define JOURNAL_VERSION (1)
+
+/**
+ *  記録時の書き込みバッファのサイズ.
+ */
+#define JOURNAL_BUFFER_BYTES (64 * 1024)
+
+/**
+ *  再生時の読み込みバッファの初期サイズ.
+ */
+#define REPLAY_BUFFER_BYTES (1024 * 1024)
+
+/**
+ *  再生時に受け付けるヘッダの最大サイズ.
+ */
+#define REPLAY_HEADER_MAX (4 * 1024)
+
+/**
+ *  索引にないイベントの番号.
+ */
+#define UNKNOWN_EVENT UINT32_MAX
+
+/**
+ *  FNV-1a の初期値 (32 ビット).
+ */
+#define FNV32_BASIS (2166136261U)
+
+/**
+ *  ログのヘッダ.
+ */
+struct journal_header {
+    char magic[8];         /**< 識別子. */
+    uint32_t version;      /**< 形式の版. */
+    uint32_t header_bytes; /**< ヘッダのサイズ. */
+    uint64_t fingerprint;  /**< 状態遷移定義の指紋. */
+};
+
+/**
+ *  ログの記録.
+ *
+ *  直後に @c payload_bytes バイトの付加データが続く.
+ */
+struct journal_record {
+    uint32_t event;         /**< イベントの番号. */
+    uint32_t state;         /**< 遷移後の状態の番号. */
+    uint64_t timestamp;     /**< 時刻 (エポックからのナノ秒). */
+    uint32_t payload_bytes; /**< 付加データのサイズ. */
+    uint32_t checksum;      /**< この記録までの状態の列のチェックサム. */
+};
+
+/**
+ *  記録器構造体.
+ */
+struct fsm_journal {
+    int fd;                         /**< ログのファイル記述子. */
+    struct chart chart;             /**< 状態遷移表の索引. */
+    uint32_t checksum;              /**< 状態の列のチェックサム. */
+    struct fsm_observer observer;   /**< 状態マシンに登録するオブザーバ. */
+    struct fsm *machine;            /**< 記録対象の状態マシン. (未登録は NULL) */
+    unsigned int depth;             /**< 処理中のイベントの入れ子の深さ. */
+    const void *payload;            /**< 次に記録する付加データ. */
+    size_t payload_bytes;           /**< 次に記録する付加データのサイズ. */
+    int err;                        /**< オブザーバ経由の記録で発生したエラー番号. */
+    size_t len;                     /**< バッファの使用量. */
+    char buf[JOURNAL_BUFFER_BYTES]; /**< 書き込みバッファ. */
+};
+
+/**
+ *  再生器の読み込みバッファ.
+ */
+struct replay_reader {
+    int fd;          /**< ログのファイル記述子. */
+    char *buf;       /**< 読み込みバッファ. */
+    size_t capacity; /**< バッファのサイズ. */
+    size_t pos;      /**< 未処理のデータの位置. */
+    size_t len;      /**< 読み込み済みのデータの終端. */
+    size_t limit;    /**< ログのファイルサイズ. */
+};
+
+/**
+ *  索引にないイベントの再生に用いるイベント.
+ *
+ *  対応する遷移はないため, 記録時と同様に Null 遷移のみが行われる.
+ */
+static const struct fsm_event unknown_event = FSM_EVENT_INITIALIZER("unknown");
+
+/**
+ *  チェックサムに状態の番号を加える.
+ *
+ *  @param  [in]    checksum    これまでのチェックサム.
+ *  @param  [in]    state       状態の番号.
+ *  @return 更新したチェックサムが返る.
+ */
+static inline uint32_t checksum_update(uint32_t checksum, uint32_t state)
+{
+    for (int i = 0; i < 4; ++i) {
+        checksum ^= (state >> (i * 8)) & 0xFF;
+        checksum *= 16777619U;
+    }
+    return checksum;
+}
+
+/**
+ *  バイト列をすべて書き込む.
+ *
+ *  @param  [in]    fd      ファイル記述子.
+ *  @param  [in]    data    バイト列.
+ *  @param  [in]    len     バイト列の長さ.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int write_all(int fd, const void *data, size_t len)
+{
+    const char *p = data;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ *  記録器のバッファをログに書き出す.
+ *
+ *  書き込みに失敗した場合は, 書き出せなかった部分をバッファに残す.
+ *
+ *  @param  [in,out]    journal 記録器.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int journal_drain(struct fsm_journal *journal)
+{
+    size_t done = 0;
+
+    while (done < journal->len) {
+        ssize_t n = write(journal->fd, &journal->buf[done], journal->len - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            int err = errno;
+            memmove(journal->buf, &journal->buf[done], journal->len - done);
+            journal->len -= done;
+            errno = err;
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    journal->len = 0;
+
+    return 0;
+}
+
+/**
+ *  記録器のバッファにバイト列を追加する.
+ *
+ *  バッファに収まらない場合は書き出してから追加し,
+ *  バッファより大きい場合は直接書き込む.
+ *
+ *  @param  [in,out]    journal 記録器.
+ *  @param  [in]        data    バイト列.
+ *  @param  [in]        len     バイト列の長さ.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int journal_append(struct fsm_journal *journal, const void *data, size_t len)
+{
+    if (journal->len + len > sizeof(journal->buf)) {
+        if (journal_drain(journal) != 0) {
+            return -1;
+        }
+        if (len > sizeof(journal->buf)) {
+            return write_all(journal->fd, data, len);
+        }
+    }
+    memcpy(&journal->buf[journal->len], data, len);
+    journal->len += len;
+
+    return 0;
+}
+
+/**
+ *  遷移後の状態とともにイベントを記録する.
+ *
+ *  @param  [in,out]    journal         記録器.
+ *  @param  [in]        machine         遷移を終えた状態マシン.
+ *  @param  [in]        event           発生したイベント.
+ *  @param  [in]        payload         付加データ. (NULL 可)
+ *  @param  [in]        payload_bytes   付加データのサイズ.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int journal_record(struct fsm_journal *journal,
+                          struct fsm *machine,
+                          const struct fsm_event *event,
+                          const void *payload,
+                          size_t payload_bytes)
+{
+    struct journal_record record;
+    struct timespec ts;
+    int event_id, state_id;
+
+    event_id = chart_event_id(&journal->chart, event);
+    state_id = chart_state_id(&journal->chart, fsm_get_current(machine));
+    journal->checksum = checksum_update(journal->checksum, (uint32_t)state_id);
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    record.event = (event_id < 0) ? UNKNOWN_EVENT : (uint32_t)event_id;
+    record.state = (uint32_t)state_id;
+    record.timestamp = ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+    record.payload_bytes = (uint32_t)payload_bytes;
+    record.checksum = journal->checksum;
+    if (journal_append(journal, &record, sizeof(record)) != 0) {
+        return -1;
+    }
+    if (payload_bytes > 0) {
+        return journal_append(journal, payload, payload_bytes);
+    }
+
+    return 0;
+}
+
+/**
+ *  イベントの受け付けを記録器に通知する.
+ *
+ *  @param  [in]        machine 状態マシン.
+ *  @param  [in]        event   受け付けたイベント.
+ *  @param  [in,out]    ctx     記録器.
+ */
+static void journal_event_received(struct fsm *machine, const struct fsm_event *event, void *ctx)
+{
+    struct fsm_journal *journal = ctx;
+
+    (void)machine;
+    (void)event;
+    ++journal->depth;
+}
+
+/**
+ *  イベントの処理の完了を記録器に通知する.
+ *
+ *  アクションの中で発生させたイベントは再生時に再び発生するため,
+ *  最も外側のイベントのみを記録する.
+ *
+ *  @param  [in]        machine 状態マシン.
+ *  @param  [in]        event   処理を終えたイベント.
+ *  @param  [in,out]    ctx     記録器.
+ */
+static void journal_event_processed(struct fsm *machine, const struct fsm_event *event, void *ctx)
+{
+    struct fsm_journal *journal = ctx;
+    const void *payload = journal->payload;
+    size_t payload_bytes = journal->payload_bytes;
+
+    if ((journal->depth == 0) || (--journal->depth > 0)) {
+        return;
+    }
+
+    journal->payload = NULL;
+    journal->payload_bytes = 0;
+    if ((journal_record(journal, machine, event, payload, payload_bytes) != 0)
+        && (journal->err == 0)) {
+        journal->err = errno;
+    }
+}
+
+/**
+ *  @details    @c path にログを作成し, 記録を開始する.
+ *              既存のファイルは切り詰める.
+ *              ログには @c rels と @c corresps から求めた指紋を格納する.
+ *
+ *  @param      [in]    path        ログのパス.
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @return     成功時は, 記録器が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+struct fsm_journal *fsm_journal_open(const char *path,
+                                     const struct fsm_rels *rels,
+                                     const struct fsm_trans *corresps)
+{
+    struct fsm_journal *journal;
+    struct journal_header header;
+    int err;
+
+    if ((path == NULL) || (corresps == NULL)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    journal = malloc(sizeof(*journal));
+    if (journal == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (chart_build(&journal->chart, rels, corresps) != 0) {
+        err = errno;
+        free(journal);
+        errno = err;
+        return NULL;
+    }
+    journal->checksum = FNV32_BASIS;
+    journal->observer = (struct fsm_observer){
+        .event_received = journal_event_received,
+        .event_processed = journal_event_processed,
+        .ctx = journal,
+    };
+    journal->machine = NULL;
+    journal->depth = 0;
+    journal->payload = NULL;
+    journal->payload_bytes = 0;
+    journal->err = 0;
+    journal->len = 0;
+
+    journal->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (journal->fd < 0) {
+        err = errno;
+        chart_release(&journal->chart);
+        free(journal);
+        errno = err;
+        return NULL;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.header_bytes = sizeof(header);
+    header.fingerprint = chart_fingerprint(&journal->chart);
+    journal_append(journal, &header, sizeof(header));
+
+    return journal;
+}
+
+/**
+ *  @details    未書き出しの記録を書き出し, 記録を終了する.
+ *              状態マシンに登録している場合は登録を解除する.
+ *
+ *  @param      [in,out]    journal 記録器.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              失敗した場合も記録器は解放される.
+ */
+int fsm_journal_close(struct fsm_journal *journal)
+{
+    int ret, err = 0;
+
+    if (journal == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (journal->machine != NULL) {
+        fsm_remove_observer(journal->machine, &journal->observer);
+    }
+    ret = fsm_journal_flush(journal);
+    if (ret != 0) {
+        err = errno;
+    }
+    if ((close(journal->fd) != 0) && (ret == 0)) {
+        ret = -1;
+        err = errno;
+    }
+    chart_release(&journal->chart);
+    free(journal);
+
+    if (ret != 0) {
+        errno = err;
+    }
+    return ret;
+}
+
+/**
+ *  @details    @c machine を記録対象として登録する.
+ *              登録後は, @ref fsm_transition を経由するすべてのイベント
+ *              (@ref fsm_dispatch, イベントループ, イベントリング, グループへの
+ *              配信を含む) が遷移後の状態とともに記録される.
+ *              アクションの中で発生させたイベントは, 再生時に再び発生するため
+ *              記録しない.
+ *              記録は状態マシンのオブザーバとして行うため,
+ *              OBSERVER を 0 としてビルドした場合は, errno に ENOTSUP が設定される.
+ *              遷移の途中で登録しないこと.
+ *
+ *  @param      [in,out]    journal 記録器.
+ *  @param      [in,out]    machine 記録対象の状態マシン.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              既に別の状態マシンを登録している場合は, errno に EBUSY が設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_journal_attach(struct fsm_journal *journal, struct fsm *machine)
+{
+    if ((journal == NULL) || (machine == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (journal->machine != NULL) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    if (fsm_add_observer(machine, &journal->observer) != 0) {
+        return -1;
+    }
+    journal->machine = machine;
+    journal->depth = 0;
+
+    return 0;
+}
+
+/**
+ *  @details    記録対象の状態マシンの登録を解除する.
+ *              以降のイベントは @ref fsm_journal_transition で発生させたもののみ
+ *              記録される.
+ *
+ *  @param      [in,out]    journal 記録器.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_journal_detach(struct fsm_journal *journal)
+{
+    if ((journal == NULL) || (journal->machine == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (fsm_remove_observer(journal->machine, &journal->observer) != 0) {
+        return -1;
+    }
+    journal->machine = NULL;
+
+    return 0;
+}
+
+/**
+ *  @details    @c machine に @c event を発生させ, 遷移後の状態とともに記録する.
+ *              @c payload はイベントに付随するアプリケーションのデータで,
+ *              再生時にハンドラへ渡される.
+ *              @c machine を @ref fsm_journal_attach で登録している場合は,
+ *              登録による記録に付加データを添え, 二重には記録しない.
+ *              記録はバッファに蓄え, バッファが一杯になった時点で書き出す.
+ *
+ *  @param      [in,out]    journal         記録器.
+ *  @param      [in,out]    machine         状態マシン.
+ *  @param      [in]        event           発生させるイベント.
+ *  @param      [in]        payload         付加データ. (NULL 可)
+ *  @param      [in]        payload_bytes   付加データのサイズ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              記録に失敗した場合も, イベントは発生済みとなる.
+ *              @c payload_bytes が @ref FSM_JOURNAL_PAYLOAD_MAX を超える場合は,
+ *              errno に EINVAL が設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_journal_transition(struct fsm_journal *journal,
+                           struct fsm *machine,
+                           const struct fsm_event *event,
+                           const void *payload,
+                           size_t payload_bytes)
+{
+    if ((journal == NULL) || (machine == NULL) || (event == NULL)
+        || ((payload == NULL) && (payload_bytes > 0)) || (payload_bytes > FSM_JOURNAL_PAYLOAD_MAX)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (journal->machine != machine) {
+        fsm_transition(machine, event);
+        return journal_record(journal, machine, event, payload, payload_bytes);
+    }
+
+    if (journal->depth == 0) {
+        journal->payload = payload;
+        journal->payload_bytes = payload_bytes;
+    }
+    fsm_transition(machine, event);
+    if (journal->err != 0) {
+        errno = journal->err;
+        journal->err = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    バッファに蓄えた記録をログに書き出す.
+ *              書き込みに失敗した場合, 書き出せなかった記録はバッファに残り,
+ *              次の書き出しで再び書き込む.
+ *              登録による記録で以前に失敗していた場合は, その失敗を返す.
+ *
+ *  @param      [in,out]    journal 記録器.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fsm_journal_flush(struct fsm_journal *journal)
+{
+    if (journal == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (journal->err != 0) {
+        errno = journal->err;
+        journal->err = 0;
+        journal_drain(journal);
+        return -1;
+    }
+
+    return journal_drain(journal);
+}
+
+/**
+ *  @details    これまでに記録した遷移後の状態の列のチェックサムを取得する.
+ *              同じログを再生した結果の @ref fsm_replay_stats::checksum と一致する.
+ *
+ *  @param      [in]    journal 記録器.
+ *  @return     チェックサムが返る.
+ */
+uint32_t fsm_journal_checksum(const struct fsm_journal *journal)
+{
+    return (journal != NULL) ? journal->checksum : 0;
+}
+
+/**
+ *  読み込みバッファに @c bytes バイトの未処理データを用意する.
+ *
+ *  @param  [in,out]    reader  読み込みバッファ.
+ *  @param  [in]        bytes   必要なバイト数.
+ *  @return 用意できた場合は 1, ファイルの終端に達した場合は 0 が返る.
+ *          ファイルサイズを超える場合は, 読み込まずに 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int replay_fill(struct replay_reader *reader, size_t bytes)
+{
+    if (bytes > reader->limit) {
+        return 0;
+    }
+    while (reader->len - reader->pos < bytes) {
+        if (reader->pos > 0) {
+            memmove(reader->buf, &reader->buf[reader->pos], reader->len - reader->pos);
+            reader->len -= reader->pos;
+            reader->pos = 0;
+        }
+        if (bytes > reader->capacity) {
+            char *buf = realloc(reader->buf, bytes);
+            if (buf == NULL) {
+                errno = ENOMEM;
+                return -1;
+            }
+            reader->buf = buf;
+            reader->capacity = bytes;
+        }
+
+        ssize_t n = read(reader->fd, &reader->buf[reader->len], reader->capacity - reader->len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            return 0;
+        }
+        reader->len += (size_t)n;
+    }
+
+    return 1;
+}
+
+/**
+ *  @details    @c path のログを読み込み, 記録されたイベントを @c machine に
+ *              順に発生させる.
+ *              @c machine は記録開始時と同じ状態 (通常は初期化直後) であること.
+ *              記録時の時刻は待ち合わせず, 可能な限り高速に再生する.
+ *
+ *              @c handler が指定されている場合は, イベントを発生させる直前に
+ *              記録時の時刻と付加データを渡して呼び出す.
+ *              アプリケーションはここで付加データを復元すること.
+ *
+ *              遷移後の状態が記録と異なった場合は, その記録の位置を
+ *              @c stats の @c diverged に設定し, 再生を中止する.
+ *
+ *  @param      [in]    path        ログのパス.
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @param      [in,out]    machine 再生先の状態マシン.
+ *  @param      [in]    handler     イベント発生前のハンドラ. (NULL 可)
+ *  @param      [in]    ctx         ハンドラの最後の引数.
+ *  @param      [out]   stats       再生結果.
+ *  @return     成功時は, 0 が返る. (乖離を検出した場合を含む)
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              ログの形式が異なる場合や, 状態遷移定義の指紋が一致しない場合は
+ *              errno に EINVAL が設定される.
+ *              ヘッダや記録のサイズが上限を超えて壊れている場合は,
+ *              読み込み領域を確保する前に errno に EBADMSG が設定される.
+ */
+int fsm_journal_replay(const char *path,
+                       const struct fsm_rels *rels,
+                       const struct fsm_trans *corresps,
+                       struct fsm *machine,
+                       void (*handler)(struct fsm *,
+                                       const struct fsm_event *,
+                                       uint64_t,
+                                       const void *,
+                                       size_t,
+                                       void *),
+                       void *ctx,
+                       struct fsm_replay_stats *stats)
+{
+    struct replay_reader reader = {.fd = -1};
+    struct journal_header header;
+    struct journal_record record;
+    struct chart chart;
+    struct stat st;
+    int ret = -1, err = 0, filled;
+
+    if ((path == NULL) || (corresps == NULL) || (machine == NULL) || (stats == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    *stats = (struct fsm_replay_stats){.records = 0, .diverged = -1,
+                                       .checksum = FNV32_BASIS, .truncated = false};
+
+    if (chart_build(&chart, rels, corresps) != 0) {
+        return -1;
+    }
+    reader.fd = open(path, O_RDONLY | O_CLOEXEC);
+    reader.capacity = REPLAY_BUFFER_BYTES;
+    reader.buf = malloc(reader.capacity);
+    if ((reader.fd < 0) || (reader.buf == NULL)) {
+        err = (reader.fd < 0) ? errno : ENOMEM;
+        goto out;
+    }
+    if (fstat(reader.fd, &st) != 0) {
+        err = errno;
+        goto out;
+    }
+    reader.limit = (size_t)st.st_size;
+
+    filled = replay_fill(&reader, sizeof(header));
+    if (filled <= 0) {
+        err = (filled == 0) ? EINVAL : errno;
+        goto out;
+    }
+    memcpy(&header, &reader.buf[reader.pos], sizeof(header));
+    if ((memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0)
+        || (header.version != JOURNAL_VERSION)
+        || (header.header_bytes < sizeof(header))
+        || (header.fingerprint != chart_fingerprint(&chart))) {
+        err = EINVAL;
+        goto out;
+    }
+    if (header.header_bytes > REPLAY_HEADER_MAX) {
+        err = EBADMSG;
+        goto out;
+    }
+    filled = replay_fill(&reader, header.header_bytes);
+    if (filled <= 0) {
+        err = (filled == 0) ? EINVAL : errno;
+        goto out;
+    }
+    reader.pos += header.header_bytes;
+
+    for (;;) {
+        const struct fsm_event *event;
+        const void *payload;
+        uint32_t state_id;
+
+        filled = replay_fill(&reader, sizeof(record));
+        if (filled == 0) {
+            stats->truncated = (reader.len > reader.pos);
+            break;
+        }
+        if (filled < 0) {
+            err = errno;
+            goto out;
+        }
+        memcpy(&record, &reader.buf[reader.pos], sizeof(record));
+        if (record.payload_bytes > FSM_JOURNAL_PAYLOAD_MAX) {
+            err = EBADMSG;
+            goto out;
+        }
+        filled = replay_fill(&reader, sizeof(record) + record.payload_bytes);
+        if (filled == 0) {
+            stats->truncated = true;
+            break;
+        }
+        if (filled < 0) {
+            err = errno;
+            goto out;
+        }
+        payload = &reader.buf[reader.pos + sizeof(record)];
+        reader.pos += sizeof(record) + record.payload_bytes;
+
+        if (record.event == UNKNOWN_EVENT) {
+            event = &unknown_event;
+        } else if (record.event < chart.nevents) {
+            event = chart.events[record.event];
+        } else {
+            err = EINVAL;
+            goto out;
+        }
+
+        if (handler != NULL) {
+            handler(machine, event, record.timestamp, payload, record.payload_bytes, ctx);
+        }
+        fsm_transition(machine, event);
+
+        state_id = (uint32_t)chart_state_id(&chart, fsm_get_current(machine));
+        stats->checksum = checksum_update(stats->checksum, state_id);
+        if ((state_id != record.state) || (stats->checksum != record.checksum)) {
+            stats->diverged = (ssize_t)stats->records;
+            break;
+        }
+        ++stats->records;
+    }
+    ret = 0;
+
+out:
+    free(reader.buf);
+    if (reader.fd >= 0) {
+        close(reader.fd);
+    }
+    chart_release(&chart);
+    if (ret != 0) {
+        errno = err;
+    }
+    return ret;
+}
@@ -0,0 +1,488 @@
+/** @file   lookup.c
+ *  @brief  遷移表の検索索引.
+ *
+ *  遷移を (起点状態, イベント) の組で整列し, 以下のいずれかの方式で
+ *  キーから整列済みの位置を引く.
+ *  - 線形: 対応表を先頭から走査する. 小さな遷移表向け.
+ *  - 整列: 異なるキーを Eytzinger 配置 (幅優先の二分木) に並べて二分探索する.
+ *    探索の経路がキャッシュラインに沿うため, 通常の二分探索より速い.
+ *  - ハッシュ: バケット毎の変位による完全ハッシュ (hash and displace) で
+ *    1 回の引き当てで位置を得る. スロットはキーの数のわずかに上とし,
+ *    キーを除いた索引のメモリ量はキーあたり約 6 バイトとなる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "debug.h"
+#include "lookup.h"
+
+/**
+ *  自動選択で線形走査とする遷移の数の上限.
+ */
+#define LOOKUP_LINEAR_MAX (16)
+
+/**
+ *  自動選択で整列を選ぶ密度の下限. (キーの数 / (起点状態の数 * イベントの数))
+ */
+#define LOOKUP_DENSE_RATIO (0.25)
+
+/**
+ *  自動選択で整列を選ぶキーの数の上限.
+ */
+#define LOOKUP_DENSE_KEYS_MAX (4096)
+
+/**
+ *  バケットあたりの平均のキーの数.
+ */
+#define LOOKUP_BUCKET_KEYS (3)
+
+/**
+ *  1 つのバケットに収めるキーの数の上限.
+ */
+#define LOOKUP_BUCKET_MAX (64)
+
+/**
+ *  1 つのバケットで試す変位の数の上限.
+ */
+#define LOOKUP_DISPLACEMENT_MAX (1U << 20)
+
+/**
+ *  完全ハッシュの構築を試みる種の数.
+ */
+#define LOOKUP_HASH_ATTEMPTS (8)
+
+/**
+ *  整列用の遷移構造体.
+ */
+struct lookup_entry {
+    struct lookup_key key;  /**< キー. */
+    uint32_t index;         /**< 対応表での番号. */
+};
+
+/**
+ *  整列用の比較関数.
+ *
+ *  キーが同じ場合は対応表での順とする.
+ *
+ *  @param  [in]    a   比較対象.
+ *  @param  [in]    b   比較対象.
+ *  @return @c a が小さい場合は負, 大きい場合は正, 等しい場合は 0 が返る.
+ */
+static int lookup_entry_compare(const void *a, const void *b)
+{
+    const struct lookup_entry *x = a, *y = b;
+
+    if (lookup_key_less(&x->key, y->key.from, y->key.event)) {
+        return -1;
+    }
+    if (lookup_key_less(&y->key, x->key.from, x->key.event)) {
+        return 1;
+    }
+
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+/**
+ *  ポインタの比較関数.
+ *
+ *  @param  [in]    a   比較対象.
+ *  @param  [in]    b   比較対象.
+ *  @return @c a が小さい場合は負, 大きい場合は正, 等しい場合は 0 が返る.
+ */
+static int lookup_pointer_compare(const void *a, const void *b)
+{
+    uintptr_t x = (uintptr_t)*(const void *const *)a;
+    uintptr_t y = (uintptr_t)*(const void *const *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ *  キーの密度から検索方式を選ぶ.
+ *
+ *  密度が高く小さな遷移表は整列済み配列がキャッシュに収まり, ハッシュの計算を
+ *  省ける分速い. 疎な遷移表や大きな遷移表はハッシュとする.
+ *
+ *  @param  [in]    entries 整列済みの遷移.
+ *  @param  [in]    ntrans  遷移の数.
+ *  @param  [in]    nkeys   キーの数.
+ *  @return 検索方式が返る.
+ */
+static enum fsm_lookup lookup_choose(const struct lookup_entry *entries,
+                                     size_t ntrans,
+                                     size_t nkeys)
+{
+    const struct fsm_event **events;
+    size_t nfroms = 0, nevents = 0;
+
+    if (ntrans <= LOOKUP_LINEAR_MAX) {
+        return FSM_LOOKUP_LINEAR;
+    }
+    if (nkeys > LOOKUP_DENSE_KEYS_MAX) {
+        return FSM_LOOKUP_HASH;
+    }
+
+    events = malloc(ntrans * sizeof(*events));
+    if (events == NULL) {
+        return FSM_LOOKUP_HASH;
+    }
+    for (size_t i = 0; i < ntrans; ++i) {
+        if ((i == 0) || (entries[i].key.from != entries[i - 1].key.from)) {
+            ++nfroms;
+        }
+        events[i] = entries[i].key.event;
+    }
+    qsort(events, ntrans, sizeof(*events), lookup_pointer_compare);
+    for (size_t i = 0; i < ntrans; ++i) {
+        if ((i == 0) || (events[i] != events[i - 1])) {
+            ++nevents;
+        }
+    }
+    free(events);
+
+    return ((double)nkeys >= LOOKUP_DENSE_RATIO * (double)nfroms * (double)nevents)
+           ? FSM_LOOKUP_SORTED : FSM_LOOKUP_HASH;
+}
+
+/**
+ *  整列済みのキーを Eytzinger 配置に並べる.
+ *
+ *  @param  [in,out]    lookup  検索索引.
+ *  @param  [in]        keys    整列済みのキー.
+ *  @param  [in]        firsts  キー毎の @c order 上の位置.
+ *  @param  [in]        i       次に配置する整列済みのキーの番号.
+ *  @param  [in]        k       配置先の番号. (1 始まり)
+ *  @return 次に配置する整列済みのキーの番号が返る.
+ */
+static size_t lookup_eytzinger(struct lookup *lookup,
+                               const struct lookup_key *keys,
+                               const uint32_t *firsts,
+                               size_t i,
+                               size_t k)
+{
+    if (k <= lookup->nkeys) {
+        i = lookup_eytzinger(lookup, keys, firsts, i, 2 * k);
+        lookup->keys[k] = keys[i];
+        lookup->firsts[k] = firsts[i];
+        ++i;
+        i = lookup_eytzinger(lookup, keys, firsts, i, 2 * k + 1);
+    }
+
+    return i;
+}
+
+/**
+ *  整列済み配列の索引を構築する.
+ *
+ *  @param  [in,out]    lookup  検索索引.
+ *  @param  [in]        keys    整列済みのキー.
+ *  @param  [in]        firsts  キー毎の @c order 上の位置.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int lookup_build_sorted(struct lookup *lookup,
+                               const struct lookup_key *keys,
+                               const uint32_t *firsts)
+{
+    lookup->keys = malloc((lookup->nkeys + 1) * sizeof(*lookup->keys));
+    lookup->firsts = malloc((lookup->nkeys + 1) * sizeof(*lookup->firsts));
+    if ((lookup->keys == NULL) || (lookup->firsts == NULL)) {
+        errno = ENOMEM;
+        return -1;
+    }
+    lookup_eytzinger(lookup, keys, firsts, 0, 1);
+    lookup->bytes += (lookup->nkeys + 1) * (sizeof(*lookup->keys) + sizeof(*lookup->firsts));
+
+    return 0;
+}
+
+/**
+ *  1 つの種で完全ハッシュの構築を試みる.
+ *
+ *  キーの多いバケットから順に, バケット内のすべてのキーが空きスロットに
+ *  重複なく収まる変位を探す.
+ *
+ *  @param  [in,out]    lookup  検索索引.
+ *  @param  [in]        keys    整列済みのキー.
+ *  @param  [in]        firsts  キー毎の @c order 上の位置.
+ *  @param  [in,out]    hashes  キー毎のハッシュ値の作業領域.
+ *  @param  [in,out]    members バケット毎に並べたキーの番号の作業領域.
+ *  @param  [in,out]    starts  バケット毎の開始位置の作業領域. (@c nbuckets + 1 個)
+ *  @param  [in,out]    queue   キーの多い順のバケットの番号の作業領域.
+ *  @return 構築できた場合は true が返る.
+ */
+static bool lookup_try_hash(struct lookup *lookup,
+                            const struct lookup_key *keys,
+                            const uint32_t *firsts,
+                            uint64_t *hashes,
+                            uint32_t *members,
+                            uint32_t *starts,
+                            uint32_t *queue)
+{
+    uint32_t nbuckets = lookup->nbuckets;
+    uint32_t sizes[LOOKUP_BUCKET_MAX + 1] = {0};
+    uint32_t candidates[LOOKUP_BUCKET_MAX];
+    uint32_t nqueue = 0;
+
+    /* キーをバケット毎に並べる. */
+    memset(starts, 0, (nbuckets + 1) * sizeof(*starts));
+    for (size_t i = 0; i < lookup->nkeys; ++i) {
+        hashes[i] = lookup_hash(lookup->seed, keys[i].from, keys[i].event);
+        ++starts[lookup_range((uint32_t)hashes[i], nbuckets) + 1];
+    }
+    for (uint32_t b = 0; b < nbuckets; ++b) {
+        if (starts[b + 1] > LOOKUP_BUCKET_MAX) {
+            return false;
+        }
+        ++sizes[starts[b + 1]];
+        starts[b + 1] += starts[b];
+    }
+    for (size_t i = 0; i < lookup->nkeys; ++i) {
+        uint32_t b = lookup_range((uint32_t)hashes[i], nbuckets);
+        members[starts[b]++] = (uint32_t)i;
+    }
+    for (uint32_t b = nbuckets; b > 0; --b) {
+        starts[b] = starts[b - 1];
+    }
+    starts[0] = 0;
+
+    /* バケットをキーの多い順に並べる. (計数ソート) */
+    for (uint32_t n = LOOKUP_BUCKET_MAX, pos = 0; n > 0; --n) {
+        uint32_t count = sizes[n];
+        sizes[n] = pos;
+        pos += count;
+    }
+    for (uint32_t b = 0; b < nbuckets; ++b) {
+        uint32_t n = starts[b + 1] - starts[b];
+        if (n > 0) {
+            queue[sizes[n]++] = b;
+            ++nqueue;
+        }
+    }
+
+    for (uint32_t s = 0; s < lookup->nslots; ++s) {
+        lookup->slots[s] = LOOKUP_EMPTY;
+    }
+    memset(lookup->displacements, 0, nbuckets * sizeof(*lookup->displacements));
+    for (uint32_t q = 0; q < nqueue; ++q) {
+        uint32_t b = queue[q];
+        uint32_t n = starts[b + 1] - starts[b];
+        uint32_t disp;
+
+        for (disp = 0; disp < LOOKUP_DISPLACEMENT_MAX; ++disp) {
+            uint32_t j;
+            for (j = 0; j < n; ++j) {
+                uint32_t slot = lookup_slot(hashes[members[starts[b] + j]], disp, lookup->nslots);
+                if (lookup->slots[slot] != LOOKUP_EMPTY) {
+                    break;
+                }
+                /* 同じバケットのキー同士の衝突は仮置きで検出する. */
+                lookup->slots[slot] = 0;
+                candidates[j] = slot;
+            }
+            for (uint32_t k = 0; k < j; ++k) {
+                lookup->slots[candidates[k]] = LOOKUP_EMPTY;
+            }
+            if (j == n) {
+                break;
+            }
+        }
+        if (disp == LOOKUP_DISPLACEMENT_MAX) {
+            return false;
+        }
+        lookup->displacements[b] = disp;
+        for (uint32_t j = 0; j < n; ++j) {
+            uint32_t key = members[starts[b] + j];
+            lookup->slots[lookup_slot(hashes[key], disp, lookup->nslots)] = firsts[key];
+        }
+    }
+
+    return true;
+}
+
+/**
+ *  完全ハッシュの索引を構築する.
+ *
+ *  @param  [in,out]    lookup  検索索引.
+ *  @param  [in]        keys    整列済みのキー.
+ *  @param  [in]        firsts  キー毎の @c order 上の位置.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ *          構築できなかった場合は, errno に EAGAIN が設定される.
+ */
+static int lookup_build_hash(struct lookup *lookup,
+                             const struct lookup_key *keys,
+                             const uint32_t *firsts)
+{
+    uint64_t *hashes;
+    uint32_t *members, *starts, *queue;
+    bool built = false;
+
+    lookup->nbuckets = (uint32_t)(lookup->nkeys / LOOKUP_BUCKET_KEYS) + 1;
+    lookup->nslots = (uint32_t)(lookup->nkeys + (lookup->nkeys / 16) + 1);
+    lookup->displacements = malloc(lookup->nbuckets * sizeof(*lookup->displacements));
+    lookup->slots = malloc(lookup->nslots * sizeof(*lookup->slots));
+    hashes = malloc(lookup->nkeys * sizeof(*hashes));
+    members = malloc(lookup->nkeys * sizeof(*members));
+    starts = malloc((lookup->nbuckets + 1) * sizeof(*starts));
+    queue = malloc(lookup->nkeys * sizeof(*queue));
+    if ((lookup->displacements != NULL) && (lookup->slots != NULL) && (hashes != NULL)
+        && (members != NULL) && (starts != NULL) && (queue != NULL)) {
+
+        for (int attempt = 0; (attempt < LOOKUP_HASH_ATTEMPTS) && !built; ++attempt) {
+            lookup->seed = lookup_mix(0x5eed0000ULL + (uint64_t)attempt);
+            built = lookup_try_hash(lookup, keys, firsts, hashes, members, starts, queue);
+        }
+        errno = built ? 0 : EAGAIN;
+    } else {
+        errno = ENOMEM;
+    }
+    free(queue);
+    free(starts);
+    free(members);
+    free(hashes);
+    if (!built) {
+        return -1;
+    }
+    lookup->bytes += (lookup->nbuckets * sizeof(*lookup->displacements))
+                   + (lookup->nslots * sizeof(*lookup->slots));
+
+    return 0;
+}
+
+/**
+ *  索引の方式毎の領域を解放する.
+ *
+ *  @param  [in,out]    lookup  検索索引.
+ */
+static void lookup_release_index(struct lookup *lookup)
+{
+    free(lookup->keys);
+    free(lookup->firsts);
+    free(lookup->displacements);
+    free(lookup->slots);
+    lookup->keys = NULL;
+    lookup->firsts = NULL;
+    lookup->displacements = NULL;
+    lookup->slots = NULL;
+}
+
+/**
+ *  @c corresps の検索索引を構築する.
+ *  @c kind が @ref FSM_LOOKUP_AUTO の場合は, 遷移の数とキーの密度から方式を選ぶ.
+ *  完全ハッシュを構築できなかった場合は整列済み配列とする.
+ *
+ *  @param  [out]   lookup      検索索引.
+ *  @param  [in]    corresps    遷移の対応表. (終端を含み, 索引より長く保持すること)
+ *  @param  [in]    ntrans      遷移の数.
+ *  @param  [in]    kind        検索方式.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int lookup_build(struct lookup *lookup,
+                 const struct fsm_trans *corresps,
+                 size_t ntrans,
+                 enum fsm_lookup kind)
+{
+    struct lookup_entry *entries;
+    struct lookup_key *keys;
+    uint32_t *firsts;
+    int ret = 0;
+
+    memset(lookup, 0, sizeof(*lookup));
+    lookup->corresps = corresps;
+    lookup->ntrans = ntrans;
+    if (ntrans >= LOOKUP_EMPTY) {
+        errno = E2BIG;
+        return -1;
+    }
+    if ((kind == FSM_LOOKUP_LINEAR) || (ntrans == 0)
+        || ((kind == FSM_LOOKUP_AUTO) && (ntrans <= LOOKUP_LINEAR_MAX))) {
+        lookup->kind = FSM_LOOKUP_LINEAR;
+        return 0;
+    }
+
+    /* 遷移をキー順に並べ, 異なるキー毎に先頭の位置を求める. */
+    entries = malloc(ntrans * sizeof(*entries));
+    lookup->order = malloc((ntrans + 1) * sizeof(*lookup->order));
+    if ((entries == NULL) || (lookup->order == NULL)) {
+        free(entries);
+        free(lookup->order);
+        errno = ENOMEM;
+        return -1;
+    }
+    for (size_t i = 0; i < ntrans; ++i) {
+        entries[i].key.from = corresps[i].from;
+        entries[i].key.event = corresps[i].event;
+        entries[i].index = (uint32_t)i;
+    }
+    qsort(entries, ntrans, sizeof(*entries), lookup_entry_compare);
+    for (size_t i = 0; i < ntrans; ++i) {
+        lookup->order[i] = entries[i].index;
+        if ((i == 0) || (entries[i].key.from != entries[i - 1].key.from)
+            || (entries[i].key.event != entries[i - 1].key.event)) {
+            ++lookup->nkeys;
+        }
+    }
+    lookup->order[ntrans] = (uint32_t)ntrans;
+    lookup->bytes = (ntrans + 1) * sizeof(*lookup->order);
+
+    keys = malloc(lookup->nkeys * sizeof(*keys));
+    firsts = malloc(lookup->nkeys * sizeof(*firsts));
+    if ((keys == NULL) || (firsts == NULL)) {
+        free(firsts);
+        free(keys);
+        free(entries);
+        free(lookup->order);
+        errno = ENOMEM;
+        return -1;
+    }
+    for (size_t i = 0, k = 0; i < ntrans; ++i) {
+        if ((i == 0) || (entries[i].key.from != entries[i - 1].key.from)
+            || (entries[i].key.event != entries[i - 1].key.event)) {
+            keys[k] = entries[i].key;
+            firsts[k] = (uint32_t)i;
+            ++k;
+        }
+    }
+
+    lookup->kind = (kind == FSM_LOOKUP_AUTO) ? lookup_choose(entries, ntrans, lookup->nkeys) : kind;
+    if (lookup->kind == FSM_LOOKUP_HASH) {
+        if (lookup_build_hash(lookup, keys, firsts) != 0) {
+            lookup_release_index(lookup);
+            lookup->kind = (errno == EAGAIN) ? FSM_LOOKUP_SORTED : lookup->kind;
+            ret = (errno == EAGAIN) ? 0 : -1;
+        }
+    }
+    if ((ret == 0) && (lookup->kind == FSM_LOOKUP_SORTED)) {
+        ret = lookup_build_sorted(lookup, keys, firsts);
+    }
+    free(firsts);
+    free(keys);
+    free(entries);
+    if (ret != 0) {
+        lookup_release(lookup);
+    }
+
+    return ret;
+}
+
+/**
+ *  検索索引を解放する.
+ *  対応表は解放しない.
+ *
+ *  @param  [in,out]    lookup  検索索引.
+ */
+void lookup_release(struct lookup *lookup)
+{
+    lookup_release_index(lookup);
+    free(lookup->order);
+    lookup->order = NULL;
+}
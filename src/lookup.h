@@ -0,0 +1,251 @@
+/** @file   lookup.h
+ *  @brief  遷移表の検索索引.
+ *
+ *  遷移を (起点状態, イベント) の組をキーとして引く索引を提供する.
+ *  同じキーの遷移は対応表での順に並べ, ガード条件の評価順を保つ.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_LOOKUP_H__
+#define __HFSM_LOOKUP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hfsm.h"
+
+/**
+ *  空きスロットの印.
+ */
+#define LOOKUP_EMPTY UINT32_MAX
+
+/**
+ *  索引のキー構造体.
+ */
+struct lookup_key {
+    const struct fsm_state *from;   /**< 起点状態. */
+    const struct fsm_event *event;  /**< イベント. */
+};
+
+/**
+ *  遷移表の検索索引構造体.
+ *
+ *  @c order はキー順 (同じキーでは対応表の順) に並べた遷移の番号で,
+ *  末尾に終端の番号を置く. 各方式はキーから @c order 上の位置を引く.
+ */
+struct lookup {
+    enum fsm_lookup kind;               /**< 検索方式. */
+    const struct fsm_trans *corresps;   /**< 遷移の対応表. */
+    size_t ntrans;                      /**< 遷移の数. */
+    uint32_t *order;                    /**< キー順の遷移の番号. (@c ntrans + 1 個) */
+    size_t nkeys;                       /**< キーの数. */
+
+    struct lookup_key *keys;            /**< Eytzinger 配置のキー. (1 始まり) */
+    uint32_t *firsts;                   /**< キー毎の @c order 上の位置. (1 始まり) */
+
+    uint64_t seed;                      /**< ハッシュの種. */
+    uint32_t *displacements;            /**< バケット毎の変位. */
+    uint32_t nbuckets;                  /**< バケットの数. */
+    uint32_t *slots;                    /**< スロット毎の @c order 上の位置. */
+    uint32_t nslots;                    /**< スロットの数. */
+
+    size_t bytes;                       /**< 索引の使用メモリ量. */
+};
+
+/**
+ *  検索索引を構築する.
+ */
+int lookup_build(struct lookup *lookup,
+                 const struct fsm_trans *corresps,
+                 size_t ntrans,
+                 enum fsm_lookup kind);
+
+/**
+ *  検索索引を解放する.
+ */
+void lookup_release(struct lookup *lookup);
+
+/**
+ *  64 ビット値を撹拌する.
+ *
+ *  @param  [in]    x   値.
+ *  @return 撹拌した値が返る.
+ */
+static inline uint64_t lookup_mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+
+    return x;
+}
+
+/**
+ *  キーのハッシュ値を求める.
+ *
+ *  @param  [in]    seed    ハッシュの種.
+ *  @param  [in]    from    起点状態.
+ *  @param  [in]    event   イベント.
+ *  @return ハッシュ値が返る.
+ */
+static inline uint64_t lookup_hash(uint64_t seed,
+                                   const struct fsm_state *from,
+                                   const struct fsm_event *event)
+{
+    uint64_t a = (uint64_t)(uintptr_t)from * 0x9e3779b97f4a7c15ULL;
+    uint64_t b = (uint64_t)(uintptr_t)event * 0xc2b2ae3d27d4eb4fULL;
+
+    return lookup_mix(a ^ ((b << 31) | (b >> 33)) ^ seed);
+}
+
+/**
+ *  ハッシュ値を [0, @c n) に写す.
+ *
+ *  @param  [in]    x   32 ビットのハッシュ値.
+ *  @param  [in]    n   範囲.
+ *  @return 写した値が返る.
+ */
+static inline uint32_t lookup_range(uint32_t x, uint32_t n)
+{
+    return (uint32_t)(((uint64_t)x * n) >> 32);
+}
+
+/**
+ *  キーのハッシュ値と変位からスロットを求める.
+ *
+ *  @param  [in]    hash    キーのハッシュ値.
+ *  @param  [in]    disp    バケットの変位.
+ *  @param  [in]    nslots  スロットの数.
+ *  @return スロットの番号が返る.
+ */
+static inline uint32_t lookup_slot(uint64_t hash, uint32_t disp, uint32_t nslots)
+{
+    return lookup_range((uint32_t)(lookup_mix(hash + disp * 0x9e3779b97f4a7c15ULL) >> 32), nslots);
+}
+
+/**
+ *  キーの大小を比較する.
+ *
+ *  @param  [in]    key     キー.
+ *  @param  [in]    from    起点状態.
+ *  @param  [in]    event   イベント.
+ *  @return @c key が小さい場合は true が返る.
+ */
+static inline bool lookup_key_less(const struct lookup_key *key,
+                                   const struct fsm_state *from,
+                                   const struct fsm_event *event)
+{
+    if ((uintptr_t)key->from != (uintptr_t)from) {
+        return (uintptr_t)key->from < (uintptr_t)from;
+    }
+
+    return (uintptr_t)key->event < (uintptr_t)event;
+}
+
+/**
+ *  @c order 上の位置の遷移を取得する.
+ *
+ *  @param  [in]    lookup  検索索引.
+ *  @param  [in]    pos     @c order 上の位置.
+ *  @param  [in]    from    起点状態.
+ *  @param  [in]    event   イベント.
+ *  @return キーが一致する場合は遷移が返り, 一致しない場合は NULL が返る.
+ */
+static inline const struct fsm_trans *lookup_at(const struct lookup *lookup,
+                                                size_t pos,
+                                                const struct fsm_state *from,
+                                                const struct fsm_event *event)
+{
+    const struct fsm_trans *corr = &lookup->corresps[lookup->order[pos]];
+
+    return ((corr->from == from) && (corr->event == event)) ? corr : NULL;
+}
+
+/**
+ *  キーに一致する最初の遷移を取得する.
+ *
+ *  @param  [in]    lookup  検索索引.
+ *  @param  [in]    from    起点状態.
+ *  @param  [in]    event   イベント.
+ *  @param  [out]   cursor  続きを取得するための位置.
+ *  @return 一致する遷移がある場合は遷移が返り, ない場合は NULL が返る.
+ */
+static inline const struct fsm_trans *lookup_first(const struct lookup *lookup,
+                                                   const struct fsm_state *from,
+                                                   const struct fsm_event *event,
+                                                   size_t *cursor)
+{
+    switch (lookup->kind) {
+    case FSM_LOOKUP_HASH: {
+        uint64_t hash = lookup_hash(lookup->seed, from, event);
+        uint32_t disp = lookup->displacements[lookup_range((uint32_t)hash, lookup->nbuckets)];
+        uint32_t pos = lookup->slots[lookup_slot(hash, disp, lookup->nslots)];
+
+        if (pos == LOOKUP_EMPTY) {
+            return NULL;
+        }
+        *cursor = pos;
+        return lookup_at(lookup, pos, from, event);
+    }
+    case FSM_LOOKUP_SORTED: {
+        size_t k = 1;
+
+        while (k <= lookup->nkeys) {
+            k = 2 * k + lookup_key_less(&lookup->keys[k], from, event);
+        }
+        k >>= __builtin_ffsll(~(long long)k);
+        if (k == 0) {
+            return NULL;
+        }
+        *cursor = lookup->firsts[k];
+        return lookup_at(lookup, *cursor, from, event);
+    }
+    default:
+        for (size_t i = 0; i < lookup->ntrans; ++i) {
+            const struct fsm_trans *corr = &lookup->corresps[i];
+            if ((corr->from == from) && (corr->event == event)) {
+                *cursor = i;
+                return corr;
+            }
+        }
+        return NULL;
+    }
+}
+
+/**
+ *  キーに一致する次の遷移を取得する.
+ *
+ *  @param  [in]        lookup  検索索引.
+ *  @param  [in]        from    起点状態.
+ *  @param  [in]        event   イベント.
+ *  @param  [in,out]    cursor  @ref lookup_first で得た位置.
+ *  @return 一致する遷移がある場合は遷移が返り, ない場合は NULL が返る.
+ */
+static inline const struct fsm_trans *lookup_next(const struct lookup *lookup,
+                                                  const struct fsm_state *from,
+                                                  const struct fsm_event *event,
+                                                  size_t *cursor)
+{
+    if (lookup->kind != FSM_LOOKUP_LINEAR) {
+        return lookup_at(lookup, ++*cursor, from, event);
+    }
+
+    for (size_t i = *cursor + 1; i < lookup->ntrans; ++i) {
+        const struct fsm_trans *corr = &lookup->corresps[i];
+        if ((corr->from == from) && (corr->event == event)) {
+            *cursor = i;
+            return corr;
+        }
+    }
+
+    return NULL;
+}
+
+#endif /* __HFSM_LOOKUP_H__ */
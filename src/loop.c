@@ -0,0 +1,664 @@
+/** @file   loop.c
+ *  @brief  epoll によるイベントループ. (Linux 専用)
+ *
+ *  登録した対応付けは epoll のユーザデータとして保持し, ファイルディスクリプタ
+ *  の番号で引ける表で管理する.
+ *  準備完了となった対応付けのイベントは状態マシンの優先度付きキューに積み,
+ *  積んだ状態マシンを記録しておき, 1 回の待ちの最後にまとめて処理する.
+ *  他のスレッドからのイベントは受信箱に積み, 受信箱が空だった場合のみ
+ *  eventfd に書き込んでループを起こす.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+#include "debug.h"
+#include "batch.h"
+#include "loop.h"
+
+/**
+ *  1 回の epoll_wait で受け取る準備完了の最大数.
+ */
+#define LOOP_EVENTS_MAX (256)
+
+/**
+ *  他のスレッドから積めるイベントの数.
+ */
+#define LOOP_INBOX_CAPACITY (1024)
+
+/**
+ *  受信箱から 1 度に取り出すイベントの数.
+ */
+#define LOOP_RECEIVE_BATCH (64)
+
+/**
+ *  対応付けの種類.
+ */
+enum loop_source_kind {
+    LOOP_SOURCE_FD,     /**< 呼び出し側のファイルディスクリプタ. */
+    LOOP_SOURCE_TIMER,  /**< timerfd. */
+    LOOP_SOURCE_SIGNAL  /**< signalfd. */
+};
+
+/**
+ *  準備完了とイベントの対応付け構造体.
+ */
+struct loop_source {
+    int fd;                         /**< 監視するファイルディスクリプタ. */
+    enum loop_source_kind kind;     /**< 対応付けの種類. */
+    struct fsm *machine;            /**< イベントを積む状態マシン. */
+    const struct fsm_event *event;  /**< 積むイベント. */
+    enum fsm_priority priority;     /**< 積むイベントの優先度. */
+    bool removed;                   /**< 準備完了の処理中に解除されたか. */
+    struct loop_source *next;       /**< 解放を待つ次の対応付け. */
+};
+
+/**
+ *  他のスレッドから積まれたイベント構造体.
+ */
+struct loop_message {
+    struct fsm *machine;            /**< イベントを積む状態マシン. */
+    const struct fsm_event *event;  /**< 積むイベント. */
+    enum fsm_priority priority;     /**< 積むイベントの優先度. */
+};
+
+/**
+ *  イベントループ構造体.
+ */
+struct fsm_loop {
+    int epfd;                       /**< epoll のファイルディスクリプタ. */
+    int wakefd;                     /**< ループを起こす eventfd. */
+
+    struct loop_source **sources;   /**< ファイルディスクリプタ毎の対応付け. */
+    size_t sources_capacity;        /**< 対応付けの表の大きさ. */
+
+    struct batch batch;             /**< イベントを積んだ状態マシン. */
+    bool dispatching;               /**< 準備完了を処理中か. */
+    struct loop_source *retired;    /**< 処理中に解除され, 解放を待つ対応付け. */
+
+    pthread_mutex_t lock;           /**< 受信箱と停止要求を保護する. */
+    QUEUE inbox;                    /**< 他のスレッドから積まれたイベント. */
+    bool wake_pending;              /**< eventfd に書き込み済みで, 未処理か. */
+    bool stopping;                  /**< 停止を要求されたか. */
+
+    struct epoll_event events[LOOP_EVENTS_MAX]; /**< 準備完了の受け取り領域. */
+};
+
+/**
+ *  受信箱のイベントを状態マシンに積む.
+ *
+ *  @param  [in,out]    loop    イベントループ.
+ *  @return 積む前に処理したイベントの数が返る.
+ */
+static int loop_receive(struct fsm_loop *loop)
+{
+    struct loop_message messages[LOOP_RECEIVE_BATCH];
+    ssize_t nmessages;
+    uint64_t value;
+    int count = 0;
+
+    if (read(loop->wakefd, &value, sizeof(value)) < 0) {
+        /* 既に読み込み済みの場合も受信箱は確認する. */
+    }
+
+    pthread_mutex_lock(&loop->lock);
+    loop->wake_pending = false;
+    do {
+        /* アクションから積まれる場合に備え, 積む間はロックを外す. */
+        nmessages = queue_deq_bulk(loop->inbox, messages, LOOP_RECEIVE_BATCH);
+        pthread_mutex_unlock(&loop->lock);
+
+        for (ssize_t i = 0; i < nmessages; ++i) {
+            count += batch_deliver(&loop->batch, messages[i].machine, messages[i].event, messages[i].priority);
+        }
+
+        pthread_mutex_lock(&loop->lock);
+    } while (nmessages == LOOP_RECEIVE_BATCH);
+    pthread_mutex_unlock(&loop->lock);
+
+    return count;
+}
+
+/**
+ *  準備完了となった対応付けのイベントを状態マシンに積む.
+ *
+ *  タイマは満了の回数に関わらず 1 回分のイベントを積む.
+ *  シグナルは受信した数だけイベントを積む.
+ *
+ *  @param  [in,out]    loop    イベントループ.
+ *  @param  [in]        source  準備完了となった対応付け.
+ *  @return 積む前に処理したイベントの数が返る.
+ */
+static int loop_ready(struct fsm_loop *loop, const struct loop_source *source)
+{
+    struct signalfd_siginfo info;
+    uint64_t expirations;
+    int count = 0;
+
+    switch (source->kind) {
+    case LOOP_SOURCE_TIMER:
+        if (read(source->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            return 0;
+        }
+        break;
+    case LOOP_SOURCE_SIGNAL:
+        while (!source->removed && (read(source->fd, &info, sizeof(info)) == sizeof(info))) {
+            count += batch_deliver(&loop->batch, source->machine, source->event, source->priority);
+        }
+        return count;
+    case LOOP_SOURCE_FD:
+    default:
+        break;
+    }
+
+    return batch_deliver(&loop->batch, source->machine, source->event, source->priority);
+}
+
+/**
+ *  対応付けを登録する.
+ *
+ *  @param  [in,out]    loop        イベントループ.
+ *  @param  [in]        fd          監視するファイルディスクリプタ.
+ *  @param  [in]        kind        対応付けの種類.
+ *  @param  [in]        machine     イベントを積む状態マシン.
+ *  @param  [in]        event       積むイベント.
+ *  @param  [in]        priority    イベントの優先度.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int loop_add_source(struct fsm_loop *loop,
+                           int fd,
+                           enum loop_source_kind kind,
+                           struct fsm *machine,
+                           const struct fsm_event *event,
+                           enum fsm_priority priority)
+{
+    struct loop_source *source;
+    struct epoll_event ev;
+
+    if ((size_t)fd >= loop->sources_capacity) {
+        size_t capacity = (loop->sources_capacity > 0) ? loop->sources_capacity : 64;
+        while (capacity <= (size_t)fd) {
+            capacity *= 2;
+        }
+        struct loop_source **sources = realloc(loop->sources, capacity * sizeof(struct loop_source *));
+        if (sources == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+        for (size_t i = loop->sources_capacity; i < capacity; ++i) {
+            sources[i] = NULL;
+        }
+        loop->sources = sources;
+        loop->sources_capacity = capacity;
+    }
+    if (loop->sources[fd] != NULL) {
+        errno = EEXIST;
+        return -1;
+    }
+
+    source = malloc(sizeof(struct loop_source));
+    if (source == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    source->fd = fd;
+    source->kind = kind;
+    source->machine = machine;
+    source->event = event;
+    source->priority = priority;
+    source->removed = false;
+    source->next = NULL;
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = source;
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        free(source);
+        return -1;
+    }
+    loop->sources[fd] = source;
+
+    return 0;
+}
+
+/**
+ *  対応付けの引数を検査する.
+ *
+ *  @param  [in]    loop        イベントループ.
+ *  @param  [in]    machine     イベントを積む状態マシン.
+ *  @param  [in]    event       積むイベント.
+ *  @param  [in]    priority    イベントの優先度.
+ *  @return 正しい場合は true が返る.
+ */
+static inline bool loop_valid_args(const struct fsm_loop *loop,
+                                   const struct fsm *machine,
+                                   const struct fsm_event *event,
+                                   enum fsm_priority priority)
+{
+    return (loop != NULL) && (machine != NULL) && (event != NULL)
+        && ((unsigned int)priority < FSM_PRIORITY_LANES);
+}
+
+/**
+ *  @details    イベントループを初期化する.
+ *
+ *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+struct fsm_loop *fsm_loop_init(void)
+{
+    struct fsm_loop *loop;
+    struct epoll_event ev;
+
+    loop = calloc(1, sizeof(struct fsm_loop));
+    if (loop == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    loop->wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    loop->inbox = queue_init(sizeof(struct loop_message), LOOP_INBOX_CAPACITY);
+    if ((loop->epfd < 0) || (loop->wakefd < 0) || (loop->inbox == NULL)) {
+        goto error;
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wakefd, &ev) != 0) {
+        goto error;
+    }
+    pthread_mutex_init(&loop->lock, NULL);
+
+    return loop;
+
+error:
+    queue_release(loop->inbox);
+    if (loop->wakefd >= 0) {
+        close(loop->wakefd);
+    }
+    if (loop->epfd >= 0) {
+        close(loop->epfd);
+    }
+    free(loop);
+    return NULL;
+}
+
+/**
+ *  @details    イベントループの使用領域を解放する.
+ *              ループが生成したタイマとシグナルのファイルディスクリプタは閉じる.
+ *              呼び出し側のファイルディスクリプタは閉じない.
+ *
+ *  @param      [in,out]    loop    イベントループ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fsm_loop_term(struct fsm_loop *loop)
+{
+    if (loop == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (size_t i = 0; i < loop->sources_capacity; ++i) {
+        if (loop->sources[i] != NULL) {
+            fsm_loop_remove(loop, (int)i);
+        }
+    }
+    free(loop->sources);
+    batch_release(&loop->batch);
+    pthread_mutex_destroy(&loop->lock);
+    queue_release(loop->inbox);
+    close(loop->wakefd);
+    close(loop->epfd);
+    free(loop);
+
+    return 0;
+}
+
+/**
+ *  @details    @c fd が読み込み可能となった際に, @c machine に @c event を積む.
+ *              読み込み可能な間はループ毎にイベントを積むため,
+ *              データの読み込みはイベントを処理するアクションで行うこと.
+ *
+ *  @param      [in,out]    loop        イベントループ.
+ *  @param      [in]        fd          監視するファイルディスクリプタ.
+ *  @param      [in]        machine     イベントを積む状態マシン.
+ *  @param      [in]        event       積むイベント.
+ *  @param      [in]        priority    イベントの優先度.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              @c fd が登録済みの場合は, errno に EEXIST が設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_loop_add_fd(struct fsm_loop *loop,
+                    int fd,
+                    struct fsm *machine,
+                    const struct fsm_event *event,
+                    enum fsm_priority priority)
+{
+    if (!loop_valid_args(loop, machine, event, priority) || (fd < 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return loop_add_source(loop, fd, LOOP_SOURCE_FD, machine, event, priority);
+}
+
+/**
+ *  @details    @c initial_ms 後に満了するタイマを生成し, 満了の際に @c machine に
+ *              @c event を積む.
+ *              @c interval_ms が 0 でない場合は, 以降その間隔で満了する.
+ *              処理が遅れて複数回満了した場合も, 積むイベントは 1 回分となる.
+ *
+ *  @param      [in,out]    loop        イベントループ.
+ *  @param      [in]        initial_ms  初回の満了までの時間 (ミリ秒).
+ *  @param      [in]        interval_ms 以降の満了の間隔 (ミリ秒).
+ *  @param      [in]        machine     イベントを積む状態マシン.
+ *  @param      [in]        event       積むイベント.
+ *  @param      [in]        priority    イベントの優先度.
+ *  @return     成功時は, 解除に用いるファイルディスクリプタが返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_loop_add_timer(struct fsm_loop *loop,
+                       unsigned int initial_ms,
+                       unsigned int interval_ms,
+                       struct fsm *machine,
+                       const struct fsm_event *event,
+                       enum fsm_priority priority)
+{
+    struct itimerspec spec;
+    int fd;
+
+    if (!loop_valid_args(loop, machine, event, priority) || (initial_ms == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd < 0) {
+        return -1;
+    }
+    spec.it_value.tv_sec = initial_ms / 1000;
+    spec.it_value.tv_nsec = (long)(initial_ms % 1000) * 1000000L;
+    spec.it_interval.tv_sec = interval_ms / 1000;
+    spec.it_interval.tv_nsec = (long)(interval_ms % 1000) * 1000000L;
+    if ((timerfd_settime(fd, 0, &spec, NULL) != 0)
+        || (loop_add_source(loop, fd, LOOP_SOURCE_TIMER, machine, event, priority) != 0)) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ *  @details    @c signo のシグナルを受信した際に, @c machine に @c event を積む.
+ *              呼び出したスレッドで @c signo をブロックする.
+ *              他のスレッドで受信されないよう, スレッドの生成前に呼び出すこと.
+ *
+ *  @param      [in,out]    loop        イベントループ.
+ *  @param      [in]        signo       シグナル番号.
+ *  @param      [in]        machine     イベントを積む状態マシン.
+ *  @param      [in]        event       積むイベント.
+ *  @param      [in]        priority    イベントの優先度.
+ *  @return     成功時は, 解除に用いるファイルディスクリプタが返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_loop_add_signal(struct fsm_loop *loop,
+                        int signo,
+                        struct fsm *machine,
+                        const struct fsm_event *event,
+                        enum fsm_priority priority)
+{
+    sigset_t mask;
+    int fd;
+
+    if (!loop_valid_args(loop, machine, event, priority)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    sigemptyset(&mask);
+    if (sigaddset(&mask, signo) != 0) {
+        return -1;
+    }
+    errno = pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    if (errno != 0) {
+        return -1;
+    }
+    fd = signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+    if (fd < 0) {
+        return -1;
+    }
+    if (loop_add_source(loop, fd, LOOP_SOURCE_SIGNAL, machine, event, priority) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ *  @details    @c fd の対応付けを解除する.
+ *              タイマとシグナルの場合は, ファイルディスクリプタを閉じる.
+ *              シグナルのブロックは解除しない.
+ *              アクションから解除した場合は, 解除した対応付けに受け取り済みの
+ *              準備完了があってもイベントは積まず, 解放は処理の後で行う.
+ *
+ *  @param      [in,out]    loop    イベントループ.
+ *  @param      [in]        fd      登録したファイルディスクリプタ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              登録されていない場合は, errno に ENOENT が設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_loop_remove(struct fsm_loop *loop, int fd)
+{
+    struct loop_source *source;
+
+    if ((loop == NULL) || (fd < 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (((size_t)fd >= loop->sources_capacity) || (loop->sources[fd] == NULL)) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    source = loop->sources[fd];
+    loop->sources[fd] = NULL;
+    epoll_ctl(loop->epfd, EPOLL_CTL_DEL, fd, NULL);
+    if (source->kind != LOOP_SOURCE_FD) {
+        close(fd);
+    }
+    if (loop->dispatching) {
+        /* 受け取り済みの準備完了が参照しているため, 処理の後で解放する. */
+        source->removed = true;
+        source->next = loop->retired;
+        loop->retired = source;
+    } else {
+        free(source);
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    @c machine に @c event を積むよう受信箱に入れ, ループを起こす.
+ *              イベントはループのスレッドで状態マシンに積み, 処理する.
+ *              受信箱が空だった場合のみ eventfd に書き込む.
+ *
+ *  @param      [in,out]    loop        イベントループ.
+ *  @param      [in]        machine     イベントを積む状態マシン.
+ *  @param      [in]        event       積むイベント.
+ *  @param      [in]        priority    イベントの優先度.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              受信箱が一杯の場合は, errno に ENOBUFS が設定される.
+ *  @note       スレッドセーフ.
+ *              受信箱にイベントが残っている間は @c machine を破棄しないこと.
+ */
+int fsm_loop_post(struct fsm_loop *loop,
+                  struct fsm *machine,
+                  const struct fsm_event *event,
+                  enum fsm_priority priority)
+{
+    struct loop_message message = {
+        .machine = machine,
+        .event = event,
+        .priority = priority
+    };
+    bool wake;
+
+    if (!loop_valid_args(loop, machine, event, priority)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&loop->lock);
+    if (queue_enq(loop->inbox, &message) == NULL) {
+        pthread_mutex_unlock(&loop->lock);
+        errno = ENOBUFS;
+        return -1;
+    }
+    wake = !loop->wake_pending;
+    loop->wake_pending = true;
+    pthread_mutex_unlock(&loop->lock);
+
+    if (wake) {
+        uint64_t value = 1;
+        if (write(loop->wakefd, &value, sizeof(value)) != sizeof(value)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    準備完了となるまで最大 @c timeout_ms 待ち, 準備完了となった
+ *              対応付けと受信箱のイベントをすべて状態マシンに積んだ後,
+ *              積んだ状態マシン毎にイベントを優先度順に処理する.
+ *
+ *  @param      [in,out]    loop        イベントループ.
+ *  @param      [in]        timeout_ms  最大の待ち時間 (ミリ秒). 負の場合は無期限.
+ *  @return     成功時は, 処理したイベントの数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_loop_run_once(struct fsm_loop *loop, int timeout_ms)
+{
+    int nready, count = 0;
+
+    if (loop == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    nready = epoll_wait(loop->epfd, loop->events, LOOP_EVENTS_MAX, timeout_ms);
+    if (nready < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+
+    loop->dispatching = true;
+    for (int i = 0; i < nready; ++i) {
+        const struct loop_source *source = loop->events[i].data.ptr;
+        if (source == NULL) {
+            count += loop_receive(loop);
+        } else if (!source->removed) {
+            count += loop_ready(loop, source);
+        }
+    }
+    count += batch_flush(&loop->batch);
+    loop->dispatching = false;
+
+    while (loop->retired != NULL) {
+        struct loop_source *source = loop->retired;
+        loop->retired = source->next;
+        free(source);
+    }
+
+    return count;
+}
+
+/**
+ *  @details    @ref fsm_loop_stop が呼ばれるまで @ref fsm_loop_run_once を繰り返す.
+ *              準備完了を待つ間はスリープする.
+ *
+ *  @param      [in,out]    loop    イベントループ.
+ *  @return     停止した場合は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    スレッドセーフではない.
+ */
+int fsm_loop_run(struct fsm_loop *loop)
+{
+    bool stopping;
+
+    if (loop == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    do {
+        if (fsm_loop_run_once(loop, -1) < 0) {
+            return -1;
+        }
+        pthread_mutex_lock(&loop->lock);
+        stopping = loop->stopping;
+        loop->stopping = false;
+        pthread_mutex_unlock(&loop->lock);
+    } while (!stopping);
+
+    return 0;
+}
+
+/**
+ *  @details    @ref fsm_loop_run に停止を要求し, ループを起こす.
+ *              停止するのは処理中の待ちが終わった後となる.
+ *
+ *  @param      [in,out]    loop    イベントループ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @note       スレッドセーフ.
+ */
+int fsm_loop_stop(struct fsm_loop *loop)
+{
+    uint64_t value = 1;
+
+    if (loop == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&loop->lock);
+    loop->stopping = true;
+    loop->wake_pending = true;
+    pthread_mutex_unlock(&loop->lock);
+
+    if (write(loop->wakefd, &value, sizeof(value)) != sizeof(value)) {
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,1013 @@
+/** @file   metrics.c
+ *  @brief  状態毎の滞在数と滞在時間の計測.
+ *
+ *  計数はスレッド毎の計数領域に対して行う. 計数領域はスレッドが初めて
+ *  計数する時点で確保して計測に連結し, 以降はスレッド局所の索引で引く.
+ *  各計数値の書き込みは所有するスレッドのみが行うため, 不可分な
+ *  読み込みと書き込み (relaxed) のみで足り, 出力時には全計数領域を合算する.
+ *  状態マシンへの組み込みにはオブザーバを用いる.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "chart.h"
+#include "metrics.h"
+
+/**
+ *  キャッシュラインのサイズ.
+ */
+#define CACHE_LINE_BYTES (64)
+
+/**
+ *  出力バッファのサイズ.
+ */
+#define METRICS_BUFFER_BYTES (512)
+
+/**
+ *  スレッド毎の計数領域の索引の初期サイズ. (2 の冪)
+ */
+#define SHARD_INDEX_INITIAL (8)
+
+/**
+ *  状態毎の計数値構造体.
+ */
+struct metrics_counter {
+    _Atomic uint64_t population;                    /**< 入状と出状の差. (2 の補数) */
+    _Atomic uint64_t entries;                       /**< 入状の回数. */
+    _Atomic uint64_t exits;                         /**< 出状の回数. */
+    _Atomic uint64_t residency_ns;                  /**< 滞在時間の合計 (ナノ秒). */
+    _Atomic uint64_t buckets[FSM_METRICS_BUCKETS];  /**< 区間毎の出状の回数. */
+};
+
+/**
+ *  スレッド毎の計数領域構造体.
+ *
+ *  他のスレッドの計数領域とキャッシュラインを共有しないよう,
+ *  キャッシュラインの境界に配置する.
+ */
+struct metrics_shard {
+    struct metrics_shard *next;         /**< 次の計数領域. */
+    pthread_t owner;                    /**< 計数するスレッド. */
+    _Atomic uint64_t transitions;       /**< 遷移の回数. */
+    struct metrics_counter counters[];  /**< 状態毎の計数値. */
+};
+
+/**
+ *  計測の対象の状態マシン構造体.
+ */
+struct metrics_attachment {
+    struct fsm_observer observer;       /**< 状態マシンに登録するオブザーバ. */
+    struct fsm_metrics *metrics;        /**< 計測. */
+    struct fsm *machine;                /**< 状態マシン. */
+    struct metrics_attachment *next;    /**< 次の対象. */
+    uint64_t entered_ns[];              /**< 状態毎の入状した時刻 (ナノ秒). */
+};
+
+/**
+ *  計測構造体.
+ */
+struct fsm_metrics {
+    uint64_t serial;                        /**< 計測の通し番号. */
+    char *name;                             /**< 出力時のラベルの値. (NULL 可) */
+    struct chart chart;                     /**< 状態遷移表の索引. */
+    size_t shard_bytes;                     /**< 計数領域のサイズ. */
+
+    pthread_mutex_t lock;                   /**< 計数領域の連結と対象を保護する. */
+    struct metrics_shard *shards;           /**< 計数領域. */
+    struct metrics_attachment *attachments; /**< 計測の対象. */
+};
+
+/**
+ *  出力器構造体.
+ */
+struct metrics_writer {
+    int (*writer)(void *, const char *, size_t); /**< 書き込み関数. */
+    void *ctx;                                   /**< 書き込み関数の引数. */
+    int error;                                   /**< 発生したエラー. */
+    size_t len;                                  /**< バッファの使用量. */
+    char buf[METRICS_BUFFER_BYTES];              /**< 出力バッファ. */
+};
+
+/**
+ *  ヒストグラムの区間の上限 (ナノ秒). (最後の区間は上限なし)
+ */
+static const uint64_t bucket_bounds_ns[FSM_METRICS_BUCKETS - 1] = {
+    1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL
+};
+
+/**
+ *  ヒストグラムの区間の上限のラベル.
+ */
+static const char *const bucket_labels[FSM_METRICS_BUCKETS] = {
+    "1e-06", "1e-05", "0.0001", "0.001", "0.01", "0.1", "1", "10", "100", "+Inf"
+};
+
+/**
+ *  計測の通し番号の払い出し元.
+ */
+static _Atomic uint64_t metrics_serial = 1;
+
+/**
+ *  計数領域の索引の要素構造体.
+ */
+struct shard_slot {
+    uint64_t serial;                /**< 計測の通し番号. (0 は空き) */
+    struct metrics_shard *shard;    /**< 計数領域. */
+};
+
+/**
+ *  このスレッドの計数領域の索引.
+ *
+ *  計測の通し番号をキーとする開番地法のハッシュ表で, 溢れる前に拡張するため
+ *  一度引いた計数領域は追い出されない.
+ *  通し番号は再利用されないため, 解放済みの計測の要素が残っても誤って引かれない.
+ */
+static _Thread_local struct {
+    struct shard_slot last;         /**< 最後に用いた計数領域. */
+    struct shard_slot *slots;       /**< ハッシュ表. (初回登録時に確保) */
+    size_t mask;                    /**< ハッシュ表のサイズ - 1. */
+    size_t count;                   /**< 登録数. */
+} shard_index;
+
+/**
+ *  スレッド終了時に索引を解放するためのキー.
+ */
+static pthread_key_t shard_index_key;
+
+/**
+ *  索引を解放するキーの初期化の制御.
+ */
+static pthread_once_t shard_index_once = PTHREAD_ONCE_INIT;
+
+/**
+ *  単調増加時計の現在値をナノ秒で取得する.
+ *
+ *  @return 現在値 (ナノ秒) が返る.
+ */
+static inline uint64_t metrics_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ *  所有するスレッドから計数値を加算する.
+ *
+ *  書き込みは所有するスレッドのみが行うため, 読み込みと書き込みを
+ *  分けても値は失われない.
+ *
+ *  @param  [in,out]    counter 計数値.
+ *  @param  [in]        value   加算する値.
+ */
+static inline void counter_add(_Atomic uint64_t *counter, uint64_t value)
+{
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+}
+
+/**
+ *  他のスレッドの計数値を読み込む.
+ *
+ *  @param  [in]    counter 計数値.
+ *  @return 計数値が返る.
+ */
+static inline uint64_t counter_read(_Atomic uint64_t *counter)
+{
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+/**
+ *  索引を解放するキーを作成する.
+ */
+static void shard_index_key_create(void)
+{
+    pthread_key_create(&shard_index_key, free);
+}
+
+/**
+ *  索引の探索位置を求める.
+ *
+ *  @param  [in]    serial  計測の通し番号.
+ *  @return 探索を始める位置が返る.
+ */
+static inline size_t shard_index_hash(uint64_t serial)
+{
+    return (size_t)((serial * 0x9E3779B97F4A7C15ULL) >> 32) & shard_index.mask;
+}
+
+/**
+ *  このスレッドの索引から計数領域を引く.
+ *
+ *  @param  [in]    serial  計測の通し番号.
+ *  @return 登録済みの場合は計数領域が, 未登録の場合は NULL が返る.
+ */
+static struct metrics_shard *shard_index_find(uint64_t serial)
+{
+    if (shard_index.slots == NULL) {
+        return NULL;
+    }
+    for (size_t i = shard_index_hash(serial); ; i = (i + 1) & shard_index.mask) {
+        if (shard_index.slots[i].serial == serial) {
+            return shard_index.slots[i].shard;
+        }
+        if (shard_index.slots[i].serial == 0) {
+            return NULL;
+        }
+    }
+}
+
+/**
+ *  このスレッドの索引に計数領域を登録する.
+ *
+ *  登録後の使用率が 3/4 を超える場合はハッシュ表を倍に拡張する.
+ *  確保に失敗した場合は登録しない. (次回も計測の計数領域の一覧から引く)
+ *
+ *  @param  [in]    serial  計測の通し番号.
+ *  @param  [in]    shard   計数領域.
+ */
+static void shard_index_add(uint64_t serial, struct metrics_shard *shard)
+{
+    if ((shard_index.slots == NULL)
+        || ((shard_index.count + 1) * 4 > (shard_index.mask + 1) * 3)) {
+        size_t capacity = (shard_index.slots == NULL) ? SHARD_INDEX_INITIAL
+                                                      : (shard_index.mask + 1) * 2;
+        struct shard_slot *old = shard_index.slots;
+        size_t old_capacity = (old == NULL) ? 0 : shard_index.mask + 1;
+        struct shard_slot *slots = calloc(capacity, sizeof(*slots));
+
+        if (slots == NULL) {
+            return;
+        }
+        pthread_once(&shard_index_once, shard_index_key_create);
+        shard_index.slots = slots;
+        shard_index.mask = capacity - 1;
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old[i].serial != 0) {
+                size_t j = shard_index_hash(old[i].serial);
+                while (slots[j].serial != 0) {
+                    j = (j + 1) & shard_index.mask;
+                }
+                slots[j] = old[i];
+            }
+        }
+        free(old);
+        pthread_setspecific(shard_index_key, slots);
+    }
+
+    size_t i = shard_index_hash(serial);
+    while (shard_index.slots[i].serial != 0) {
+        i = (i + 1) & shard_index.mask;
+    }
+    shard_index.slots[i] = (struct shard_slot){.serial = serial, .shard = shard};
+    ++shard_index.count;
+}
+
+/**
+ *  このスレッドの計数領域を取得する.
+ *
+ *  計数領域はスレッド局所の索引で引き, 索引にない場合 (計測毎に初回のみ) は
+ *  計測の計数領域の一覧から探す. 一覧にもない場合は計数領域を確保して連結する.
+ *
+ *  @param  [in,out]    metrics 計測.
+ *  @return 成功時は, 計数領域が返る.
+ *          失敗時は, NULL が返る.
+ */
+static struct metrics_shard *metrics_shard(struct fsm_metrics *metrics)
+{
+    struct metrics_shard *shard;
+    pthread_t self;
+
+    if (__builtin_expect(shard_index.last.serial == metrics->serial, 1)) {
+        return shard_index.last.shard;
+    }
+    shard = shard_index_find(metrics->serial);
+    if (shard != NULL) {
+        shard_index.last = (struct shard_slot){.serial = metrics->serial, .shard = shard};
+        return shard;
+    }
+
+    self = pthread_self();
+    pthread_mutex_lock(&metrics->lock);
+    for (shard = metrics->shards; shard != NULL; shard = shard->next) {
+        if (pthread_equal(shard->owner, self)) {
+            break;
+        }
+    }
+    if (shard == NULL) {
+        shard = aligned_alloc(CACHE_LINE_BYTES, metrics->shard_bytes);
+        if (shard != NULL) {
+            memset(shard, 0, metrics->shard_bytes);
+            shard->owner = self;
+            shard->next = metrics->shards;
+            metrics->shards = shard;
+        }
+    }
+    pthread_mutex_unlock(&metrics->lock);
+
+    if (shard != NULL) {
+        shard_index_add(metrics->serial, shard);
+        shard_index.last = (struct shard_slot){.serial = metrics->serial, .shard = shard};
+    }
+
+    return shard;
+}
+
+/**
+ *  入状を計数する.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    state   入状した状態.
+ *  @param  [in]    ctx     計測の対象.
+ */
+static void metrics_entry(struct fsm *machine, const struct fsm_state *state, void *ctx)
+{
+    struct metrics_attachment *att = ctx;
+    struct fsm_metrics *metrics = att->metrics;
+    int id = chart_state_id(&metrics->chart, state);
+    struct metrics_shard *shard;
+
+    if ((id < 0) || ((shard = metrics_shard(metrics)) == NULL)) {
+        return;
+    }
+    att->entered_ns[id] = metrics_now();
+    counter_add(&shard->counters[id].population, 1);
+    counter_add(&shard->counters[id].entries, 1);
+}
+
+/**
+ *  出状と滞在時間を計数する.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    state   出状した状態.
+ *  @param  [in]    ctx     計測の対象.
+ */
+static void metrics_exit(struct fsm *machine, const struct fsm_state *state, void *ctx)
+{
+    struct metrics_attachment *att = ctx;
+    struct fsm_metrics *metrics = att->metrics;
+    int id = chart_state_id(&metrics->chart, state);
+    struct metrics_shard *shard;
+    uint64_t residency;
+    int bucket;
+
+    if ((id < 0) || ((shard = metrics_shard(metrics)) == NULL)) {
+        return;
+    }
+    residency = metrics_now() - att->entered_ns[id];
+    for (bucket = 0; bucket < FSM_METRICS_BUCKETS - 1; ++bucket) {
+        if (residency <= bucket_bounds_ns[bucket]) {
+            break;
+        }
+    }
+    counter_add(&shard->counters[id].population, (uint64_t)-1);
+    counter_add(&shard->counters[id].exits, 1);
+    counter_add(&shard->counters[id].residency_ns, residency);
+    counter_add(&shard->counters[id].buckets[bucket], 1);
+}
+
+/**
+ *  遷移を計数する.
+ *
+ *  @param  [in]    machine 状態マシン.
+ *  @param  [in]    trans   実施する遷移.
+ *  @param  [in]    ctx     計測の対象.
+ */
+static void metrics_transition(struct fsm *machine, const struct fsm_trans *trans, void *ctx)
+{
+    struct metrics_attachment *att = ctx;
+    struct metrics_shard *shard = metrics_shard(att->metrics);
+
+    if (shard != NULL) {
+        counter_add(&shard->transitions, 1);
+    }
+}
+
+/**
+ *  現在の状態とその祖先の滞在数を増減する.
+ *
+ *  @param  [in,out]    att     計測の対象.
+ *  @param  [in]        delta   増減する値.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int metrics_adjust_population(struct metrics_attachment *att, int64_t delta)
+{
+    struct fsm_metrics *metrics = att->metrics;
+    struct metrics_shard *shard = metrics_shard(metrics);
+    uint64_t now = metrics_now();
+    int id;
+
+    if (shard == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (id = chart_state_id(&metrics->chart, fsm_get_current(att->machine));
+         id >= 0;
+         id = metrics->chart.parents[id]) {
+
+        att->entered_ns[id] = now;
+        counter_add(&shard->counters[id].population, (uint64_t)delta);
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    @c rels と @c corresps で定義される状態について計測を初期化する.
+ *              @c name を指定した場合は, 出力する系列に chart ラベルとして付加する.
+ *
+ *  @param      [in]    name        出力時のラベルの値. (NULL 可)
+ *  @param      [in]    rels        状態の関係性. (NULL 可)
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @return     成功時は, 計測が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+struct fsm_metrics *fsm_metrics_init(const char *name,
+                                     const struct fsm_rels *rels,
+                                     const struct fsm_trans *corresps)
+{
+    struct fsm_metrics *metrics;
+    size_t bytes;
+
+    if (corresps == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    metrics = calloc(1, sizeof(*metrics));
+    if (metrics == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (name != NULL) {
+        metrics->name = strdup(name);
+        if (metrics->name == NULL) {
+            free(metrics);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    if (chart_build(&metrics->chart, rels, corresps) != 0) {
+        free(metrics->name);
+        free(metrics);
+        return NULL;
+    }
+    bytes = sizeof(struct metrics_shard) + metrics->chart.nstates * sizeof(struct metrics_counter);
+    metrics->shard_bytes = (bytes + CACHE_LINE_BYTES - 1) & ~(size_t)(CACHE_LINE_BYTES - 1);
+    metrics->serial = atomic_fetch_add(&metrics_serial, 1);
+    pthread_mutex_init(&metrics->lock, NULL);
+
+    return metrics;
+}
+
+/**
+ *  @details    @c metrics を終了し, 領域を解放する.
+ *              登録中の状態マシンはすべて解除する.
+ *
+ *  @param      [in,out]    metrics 計測.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    登録中の状態マシンは, 本関数の呼び出しより前に解放しないこと.
+ */
+int fsm_metrics_term(struct fsm_metrics *metrics)
+{
+    if (metrics == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    while (metrics->attachments != NULL) {
+        fsm_metrics_detach(metrics, metrics->attachments->machine);
+    }
+    for (struct metrics_shard *shard = metrics->shards, *next; shard != NULL; shard = next) {
+        next = shard->next;
+        free(shard);
+    }
+    pthread_mutex_destroy(&metrics->lock);
+    chart_release(&metrics->chart);
+    free(metrics->name);
+    free(metrics);
+
+    return 0;
+}
+
+/**
+ *  @details    @c machine にオブザーバを登録し, 計測の対象とする.
+ *              登録時点の状態とその祖先を滞在数に加える.
+ *
+ *  @param      [in,out]    metrics 計測.
+ *  @param      [in,out]    machine 状態マシン.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              OBSERVER を 0 としてビルドした場合は, errno に ENOTSUP が設定される.
+ *  @warning    @c machine の処理と並行して呼び出さないこと.
+ */
+int fsm_metrics_attach(struct fsm_metrics *metrics, struct fsm *machine)
+{
+    struct metrics_attachment *att;
+
+    if ((metrics == NULL) || (machine == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    att = calloc(1, sizeof(*att) + metrics->chart.nstates * sizeof(uint64_t));
+    if (att == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    att->observer = (struct fsm_observer)FSM_OBSERVER_HELPER(NULL, NULL, metrics_transition,
+                                                             metrics_exit, metrics_entry,
+                                                             NULL, att);
+    att->metrics = metrics;
+    att->machine = machine;
+    if (metrics_adjust_population(att, 1) != 0) {
+        free(att);
+        return -1;
+    }
+    if (fsm_add_observer(machine, &att->observer) != 0) {
+        int err = errno;
+        metrics_adjust_population(att, -1);
+        free(att);
+        errno = err;
+        return -1;
+    }
+
+    pthread_mutex_lock(&metrics->lock);
+    att->next = metrics->attachments;
+    metrics->attachments = att;
+    pthread_mutex_unlock(&metrics->lock);
+
+    return 0;
+}
+
+/**
+ *  @details    @c machine のオブザーバの登録を解除し, 計測の対象から外す.
+ *              解除時点の状態とその祖先を滞在数から除く.
+ *
+ *  @param      [in,out]    metrics 計測.
+ *  @param      [in,out]    machine 状態マシン.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              登録されていない場合は, errno に ENOENT が設定される.
+ *  @warning    @c machine の処理と並行して呼び出さないこと.
+ */
+int fsm_metrics_detach(struct fsm_metrics *metrics, struct fsm *machine)
+{
+    struct metrics_attachment **link;
+    struct metrics_attachment *att;
+
+    if ((metrics == NULL) || (machine == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&metrics->lock);
+    for (link = &metrics->attachments; *link != NULL; link = &(*link)->next) {
+        if ((*link)->machine == machine) {
+            break;
+        }
+    }
+    att = *link;
+    if (att != NULL) {
+        *link = att->next;
+    }
+    pthread_mutex_unlock(&metrics->lock);
+    if (att == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    fsm_remove_observer(machine, &att->observer);
+    metrics_adjust_population(att, -1);
+    free(att);
+
+    return 0;
+}
+
+/**
+ *  計数値を計測値に合算する.
+ *
+ *  @param  [in,out]    values  計測値.
+ *  @param  [in]        counter 計数値.
+ */
+static void counter_merge(struct fsm_state_metrics *values, struct metrics_counter *counter)
+{
+    values->population += (int64_t)counter_read(&counter->population);
+    values->entries += counter_read(&counter->entries);
+    values->exits += counter_read(&counter->exits);
+    values->residency_ns += counter_read(&counter->residency_ns);
+    for (int b = 0; b < FSM_METRICS_BUCKETS; ++b) {
+        values->buckets[b] += counter_read(&counter->buckets[b]);
+    }
+}
+
+/**
+ *  全計数領域を合算する.
+ *
+ *  @param  [in,out]    metrics     計測.
+ *  @param  [out]       values      状態毎の計測値の格納先. (@c nstates 個)
+ *  @param  [out]       transitions 遷移の回数の格納先.
+ */
+static void metrics_collect(struct fsm_metrics *metrics,
+                            struct fsm_state_metrics *values,
+                            uint64_t *transitions)
+{
+    memset(values, 0, metrics->chart.nstates * sizeof(*values));
+    *transitions = 0;
+
+    pthread_mutex_lock(&metrics->lock);
+    for (struct metrics_shard *shard = metrics->shards; shard != NULL; shard = shard->next) {
+        *transitions += counter_read(&shard->transitions);
+        for (size_t i = 0; i < metrics->chart.nstates; ++i) {
+            counter_merge(&values[i], &shard->counters[i]);
+        }
+    }
+    pthread_mutex_unlock(&metrics->lock);
+}
+
+/**
+ *  @details    @c state の計測値を全スレッド分合算して @c values に格納する.
+ *              各計数値は個別に読み込むため, 計数中のスレッドがある場合,
+ *              計数値の間の整合は保証しない.
+ *
+ *  @param      [in,out]    metrics 計測.
+ *  @param      [in]        state   状態.
+ *  @param      [out]       values  計測値の格納先.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              @c state が定義にない場合は, errno に ENOENT が設定される.
+ *  @note       スレッドセーフ.
+ */
+int fsm_metrics_read(struct fsm_metrics *metrics,
+                     const struct fsm_state *state,
+                     struct fsm_state_metrics *values)
+{
+    int id;
+
+    if ((metrics == NULL) || (state == NULL) || (values == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    id = chart_state_id(&metrics->chart, state);
+    if (id < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    memset(values, 0, sizeof(*values));
+    pthread_mutex_lock(&metrics->lock);
+    for (struct metrics_shard *shard = metrics->shards; shard != NULL; shard = shard->next) {
+        counter_merge(values, &shard->counters[id]);
+    }
+    pthread_mutex_unlock(&metrics->lock);
+
+    return 0;
+}
+
+/**
+ *  バッファの内容を書き込み関数に渡す.
+ *
+ *  @param  [in,out]    w   出力器.
+ */
+static void metrics_flush(struct metrics_writer *w)
+{
+    if ((w->error == 0) && (w->len > 0)) {
+        errno = 0;
+        if (w->writer(w->ctx, w->buf, w->len) != 0) {
+            w->error = (errno != 0) ? errno : EIO;
+        }
+    }
+    w->len = 0;
+}
+
+/**
+ *  文字列を出力する.
+ *
+ *  @param  [in,out]    w   出力器.
+ *  @param  [in]        s   文字列.
+ */
+static void metrics_puts(struct metrics_writer *w, const char *s)
+{
+    size_t len = strlen(s);
+
+    while ((w->error == 0) && (len > 0)) {
+        size_t room = sizeof(w->buf) - w->len;
+        size_t n = (len < room) ? len : room;
+
+        memcpy(&w->buf[w->len], s, n);
+        w->len += n;
+        s += n;
+        len -= n;
+        if (w->len == sizeof(w->buf)) {
+            metrics_flush(w);
+        }
+    }
+}
+
+/**
+ *  ラベルの値をエスケープして出力する.
+ *
+ *  @param  [in,out]    w   出力器.
+ *  @param  [in]        s   ラベルの値.
+ */
+static void metrics_escaped(struct metrics_writer *w, const char *s)
+{
+    char c[2] = {0};
+
+    for (; *s != '\0'; ++s) {
+        switch (*s) {
+        case '\\':
+            metrics_puts(w, "\\\\");
+            break;
+        case '"':
+            metrics_puts(w, "\\\"");
+            break;
+        case '\n':
+            metrics_puts(w, "\\n");
+            break;
+        default:
+            c[0] = *s;
+            metrics_puts(w, c);
+            break;
+        }
+    }
+}
+
+/**
+ *  系列の名前とラベルを出力する.
+ *
+ *  @param  [in,out]    w       出力器.
+ *  @param  [in]        metrics 計測.
+ *  @param  [in]        series  系列の名前.
+ *  @param  [in]        state   state ラベルの値. (NULL 可)
+ *  @param  [in]        le      le ラベルの値. (NULL 可)
+ */
+static void metrics_series(struct metrics_writer *w,
+                           const struct fsm_metrics *metrics,
+                           const char *series,
+                           const char *state,
+                           const char *le)
+{
+    const char *sep = "{";
+
+    metrics_puts(w, series);
+    if (metrics->name != NULL) {
+        metrics_puts(w, "{chart=\"");
+        metrics_escaped(w, metrics->name);
+        metrics_puts(w, "\"");
+        sep = ",";
+    }
+    if (state != NULL) {
+        metrics_puts(w, sep);
+        metrics_puts(w, "state=\"");
+        metrics_escaped(w, state);
+        metrics_puts(w, "\"");
+        sep = ",";
+    }
+    if (le != NULL) {
+        metrics_puts(w, sep);
+        metrics_puts(w, "le=\"");
+        metrics_puts(w, le);
+        metrics_puts(w, "\"");
+        sep = ",";
+    }
+    metrics_puts(w, (sep[0] == ',') ? "} " : " ");
+}
+
+/**
+ *  数値を出力して行を終える.
+ *
+ *  @param  [in,out]    w       出力器.
+ *  @param  [in]        format  書式.
+ *  @param  [in]        ...     数値.
+ */
+static void metrics_value(struct metrics_writer *w, const char *format, ...)
+{
+    char buf[32];
+    va_list ap;
+
+    va_start(ap, format);
+    vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+    metrics_puts(w, buf);
+    metrics_puts(w, "\n");
+}
+
+/**
+ *  @details    @c metrics の計測値を Prometheus のテキスト形式で出力する.
+ *              出力する系列は以下の通り. 階層のある状態では, 子の状態に
+ *              滞在している状態マシンは祖先の状態にも滞在しているものとする.
+ *              - fsm_state_population (gauge): 状態に滞在している状態マシンの数.
+ *              - fsm_state_entries_total (counter): 入状の回数.
+ *              - fsm_state_exits_total (counter): 出状の回数.
+ *              - fsm_state_residency_seconds (histogram): 出状までの滞在時間.
+ *              - fsm_transitions_total (counter): 遷移の回数.
+ *
+ *  @param      [in,out]    metrics 計測.
+ *  @param      [in]        writer  書き込み関数. 成功時に 0 を返すこと.
+ *  @param      [in]        ctx     書き込み関数の第 1 引数.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @note       スレッドセーフ.
+ */
+int fsm_metrics_export(struct fsm_metrics *metrics,
+                       int (*writer)(void *, const char *, size_t),
+                       void *ctx)
+{
+    struct metrics_writer w = {.writer = writer, .ctx = ctx, .error = 0, .len = 0};
+    const struct chart *chart;
+    struct fsm_state_metrics *values;
+    uint64_t transitions;
+
+    if ((metrics == NULL) || (writer == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    chart = &metrics->chart;
+    values = malloc(chart->nstates * sizeof(*values));
+    if (values == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    metrics_collect(metrics, values, &transitions);
+
+    metrics_puts(&w, "# HELP fsm_state_population Machines currently in the state.\n"
+                     "# TYPE fsm_state_population gauge\n");
+    for (size_t i = 0; i < chart->nstates; ++i) {
+        metrics_series(&w, metrics, "fsm_state_population", chart->states[i]->name, NULL);
+        metrics_value(&w, "%" PRId64, values[i].population);
+    }
+    metrics_puts(&w, "# HELP fsm_state_entries_total Entries into the state.\n"
+                     "# TYPE fsm_state_entries_total counter\n");
+    for (size_t i = 0; i < chart->nstates; ++i) {
+        metrics_series(&w, metrics, "fsm_state_entries_total", chart->states[i]->name, NULL);
+        metrics_value(&w, "%" PRIu64, values[i].entries);
+    }
+    metrics_puts(&w, "# HELP fsm_state_exits_total Exits from the state.\n"
+                     "# TYPE fsm_state_exits_total counter\n");
+    for (size_t i = 0; i < chart->nstates; ++i) {
+        metrics_series(&w, metrics, "fsm_state_exits_total", chart->states[i]->name, NULL);
+        metrics_value(&w, "%" PRIu64, values[i].exits);
+    }
+    metrics_puts(&w, "# HELP fsm_state_residency_seconds Time spent in the state until exit.\n"
+                     "# TYPE fsm_state_residency_seconds histogram\n");
+    for (size_t i = 0; i < chart->nstates; ++i) {
+        uint64_t cumulative = 0;
+        for (int b = 0; b < FSM_METRICS_BUCKETS; ++b) {
+            cumulative += values[i].buckets[b];
+            metrics_series(&w, metrics, "fsm_state_residency_seconds_bucket",
+                           chart->states[i]->name, bucket_labels[b]);
+            metrics_value(&w, "%" PRIu64, cumulative);
+        }
+        metrics_series(&w, metrics, "fsm_state_residency_seconds_sum", chart->states[i]->name, NULL);
+        metrics_value(&w, "%.9f", (double)values[i].residency_ns / 1e9);
+        metrics_series(&w, metrics, "fsm_state_residency_seconds_count", chart->states[i]->name, NULL);
+        metrics_value(&w, "%" PRIu64, cumulative);
+    }
+    metrics_puts(&w, "# HELP fsm_transitions_total Transitions taken.\n"
+                     "# TYPE fsm_transitions_total counter\n");
+    metrics_series(&w, metrics, "fsm_transitions_total", NULL, NULL);
+    metrics_value(&w, "%" PRIu64, transitions);
+
+    metrics_flush(&w);
+    free(values);
+    if (w.error != 0) {
+        errno = w.error;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  ファイルディスクリプタへの書き込み関数.
+ *
+ *  @param  [in]    ctx ファイルディスクリプタへのポインタ.
+ *  @param  [in]    buf 書き込むバイト列.
+ *  @param  [in]    len バイト列の長さ.
+ *  @return 成功時は, 0 が返る.
+ *          失敗時は, -1 が返り, errno が適切に設定される.
+ */
+static int metrics_fd_writer(void *ctx, const char *buf, size_t len)
+{
+    int fd = *(int *)ctx;
+
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+/**
+ *  @details    @c metrics の計測値を Prometheus のテキスト形式で @c fd に出力する.
+ *              ファイルのほか, 受け付けたソケットにも用いることができる.
+ *
+ *  @param      [in,out]    metrics 計測.
+ *  @param      [in]        fd      出力先のファイルディスクリプタ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @note       スレッドセーフ.
+ *  @sa         fsm_metrics_export
+ */
+int fsm_metrics_export_to_fd(struct fsm_metrics *metrics, int fd)
+{
+    if (fd < 0) {
+        errno = EBADF;
+        return -1;
+    }
+
+    return fsm_metrics_export(metrics, metrics_fd_writer, &fd);
+}
+
+/**
+ *  @details    @c metrics の計測値を Prometheus のテキスト形式で @c path に出力する.
+ *              一時ファイルに書き込んでから置き換えるため, 読み込み側が
+ *              書きかけの内容を読むことはない.
+ *
+ *  @param      [in,out]    metrics 計測.
+ *  @param      [in]        path    出力先のファイルのパス.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @note       スレッドセーフ. (同じ @c path への同時の出力を除く)
+ *  @sa         fsm_metrics_export
+ */
+int fsm_metrics_export_to_path(struct fsm_metrics *metrics, const char *path)
+{
+    char *tmp;
+    int fd;
+    int ret;
+    int err;
+
+    if ((metrics == NULL) || (path == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    tmp = malloc(strlen(path) + sizeof(".tmp"));
+    if (tmp == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    strcpy(tmp, path);
+    strcat(tmp, ".tmp");
+
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        err = errno;
+        free(tmp);
+        errno = err;
+        return -1;
+    }
+    ret = fsm_metrics_export_to_fd(metrics, fd);
+    err = errno;
+    if (close(fd) != 0) {
+        if (ret == 0) {
+            err = errno;
+            ret = -1;
+        }
+    }
+    if ((ret == 0) && (rename(tmp, path) != 0)) {
+        err = errno;
+        ret = -1;
+    }
+    if (ret != 0) {
+        unlink(tmp);
+        errno = err;
+    }
+    free(tmp);
+
+    return ret;
+}
@@ -0,0 +1,34 @@
+/** @file   proxy.h
+ *  @brief  状態マシンを持たないインスタンスの代理となる状態マシン.
+ *
+ *  フリートのように状態の番号とコンテキストのみを持つインスタンスで,
+ *  コールバックへ渡す状態マシンの代わりとして用いる.
+ *  代理の状態マシンは遷移を持たず, インスタンス毎に現在の状態とコンテキストを差し替える.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __HFSM_PROXY_H__
+#define __HFSM_PROXY_H__
+
+#include "hfsm.h"
+
+/**
+ *  代理の状態マシンを生成する.
+ */
+struct fsm *fsm_proxy_init(void);
+
+/**
+ *  代理の状態マシンの使用領域を解放する.
+ */
+void fsm_proxy_release(struct fsm *machine);
+
+/**
+ *  代理の状態マシンの現在の状態とコンテキストを設定する.
+ */
+void fsm_proxy_bind(struct fsm *machine, const struct fsm_state *current, void *context);
+
+#endif /* __HFSM_PROXY_H__ */
@@ -0,0 +1,703 @@
+/** @file   ring.c
+ *  @brief  共有メモリによるプロセス間のイベントリング.
+ *
+ *  共有メモリはヘッダと固定長 (64 バイト) の枠の配列からなる.
+ *  枠の受け渡しは, 枠毎の通番で所有者を表す有界 MPSC キュー (Vyukov 方式)
+ *  で行うため, 生成側同士は書き込み位置の CAS のみで競合し,
+ *  受け取り側はロックなしで読み出せる.
+ *  付加データは枠に直接書き込み, 受け取り側は枠を指したままハンドラに渡すため,
+ *  コピーは発生しない.
+ *  受け取り側が待機する場合は待機中の印を立てて futex で眠り,
+ *  生成側は印が立っている場合のみ futex で起こす.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ *  @copyright  Copyright (c) 2018 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "debug.h"
+#include "batch.h"
+#include "chart.h"
+#include "ring.h"
+
+/**
+ *  共有メモリの識別子.
+ */
+#define RING_MAGIC "HFSMRING"
+
+/**
+ *  共有メモリの形式の版.
+ */
+#define RING_VERSION (1)
+
+/**
+ *  無効な記録を表すイベントの番号.
+ */
+#define RING_DISCARDED UINT32_MAX
+
+/**
+ *  キャッシュラインの大きさ.
+ */
+#define CACHE_LINE_BYTES (64)
+
+/**
+ *  記録の枠構造体.
+ *
+ *  @c seq が枠の位置と一致する場合は生成側が, 位置 + 1 と一致する場合は
+ *  受け取り側が所有する.
+ */
+struct ring_slot {
+    _Atomic uint64_t seq;                        /**< 枠の通番. */
+    uint32_t machine;                            /**< 状態マシンの番号. */
+    uint32_t event;                              /**< イベントの番号. */
+    uint8_t priority;                            /**< イベントの優先度. */
+    uint8_t payload_bytes;                       /**< 付加データの長さ. */
+    uint8_t reserved[6];                         /**< 予約. */
+    unsigned char payload[FSM_RING_PAYLOAD_MAX]; /**< 付加データ. */
+};
+
+_Static_assert(sizeof(struct ring_slot) == CACHE_LINE_BYTES, "ring slot must fill a cache line");
+
+/**
+ *  共有メモリのヘッダ構造体.
+ *
+ *  生成側と受け取り側が更新する値は, 別のキャッシュラインに置く.
+ */
+struct ring_header {
+    char magic[8];                                            /**< 識別子. */
+    uint32_t version;                                         /**< 形式の版. */
+    uint32_t slot_bytes;                                      /**< 枠の大きさ. */
+    uint64_t capacity;                                        /**< 枠の数. (2 のべき乗) */
+    uint64_t fingerprint;                                     /**< 状態遷移定義の指紋. */
+
+    _Alignas(CACHE_LINE_BYTES) _Atomic uint64_t tail;         /**< 次に予約する位置. */
+    _Alignas(CACHE_LINE_BYTES) _Atomic uint64_t head;         /**< 次に読み出す位置. */
+    _Alignas(CACHE_LINE_BYTES) _Atomic uint32_t wake_seq;     /**< futex で待つ値. */
+    _Atomic uint32_t waiting;                                 /**< 受け取り側が待機中か. */
+};
+
+/**
+ *  イベントリング構造体.
+ */
+struct fsm_ring {
+    int fd;                        /**< 共有メモリのファイルディスクリプタ. */
+    char *name;                    /**< 生成した名前付き共有メモリの名前. (それ以外は NULL) */
+
+    struct ring_header *header;    /**< 共有メモリのヘッダ. */
+    struct ring_slot *slots;       /**< 記録の枠の配列. */
+    size_t map_bytes;              /**< 共有メモリの大きさ. */
+    uint64_t mask;                 /**< 枠の数 - 1. */
+
+    struct chart chart;            /**< 状態遷移表の索引. */
+
+    struct batch batch;            /**< イベントを積んだ状態マシン. */
+};
+
+/**
+ *  futex を呼び出す.
+ *
+ *  共有メモリ上の値を待つため, プロセス内専用 (PRIVATE) の操作は用いない.
+ *  FUTEX_WAIT_BITSET では, 待ち時間は CLOCK_MONOTONIC の絶対時刻となる.
+ *
+ *  @param  [in]    addr    待つ値のアドレス.
+ *  @param  [in]    op      操作.
+ *  @param  [in]    val     操作の値.
+ *  @param  [in]    timeout 待ち時間. (NULL は無期限)
+ *  @return システムコールの戻り値が返る.
+ */
+static inline long ring_futex(_Atomic uint32_t *addr, int op, uint32_t val,
+                              const struct timespec *timeout)
+{
+    return syscall(SYS_futex, addr, op, val, timeout, NULL, FUTEX_BITSET_MATCH_ANY);
+}
+
+/**
+ *  共有メモリの大きさを求める.
+ *
+ *  @param  [in]    capacity    枠の数.
+ *  @return 共有メモリの大きさが返る.
+ */
+static inline size_t ring_map_bytes(uint64_t capacity)
+{
+    return sizeof(struct ring_header) + (size_t)capacity * sizeof(struct ring_slot);
+}
+
+/**
+ *  読み出せる記録があるかを調べる.
+ *
+ *  @param  [in]    ring    イベントリング.
+ *  @return 読み出せる記録がある場合は true が返る.
+ */
+static inline bool ring_ready(const struct fsm_ring *ring)
+{
+    uint64_t head = atomic_load_explicit(&ring->header->head, memory_order_relaxed);
+    const struct ring_slot *slot = &ring->slots[head & ring->mask];
+
+    return atomic_load_explicit(&slot->seq, memory_order_acquire) == head + 1;
+}
+
+/**
+ *  共有メモリを割り当て, 状態遷移表の索引を構築する.
+ *
+ *  @param  [in]    fd          共有メモリのファイルディスクリプタ.
+ *  @param  [in]    map_bytes   共有メモリの大きさ.
+ *  @param  [in]    rels        状態の関係性.
+ *  @param  [in]    corresps    状態遷移の対応表.
+ *  @return 成功時は, 確保および初期化されたオブジェクトのポインタが返る.
+ *          失敗時は, NULL が返り, errno が適切に設定される.
+ */
+static struct fsm_ring *ring_map(int fd,
+                                 size_t map_bytes,
+                                 const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps)
+{
+    struct fsm_ring *ring;
+    int err;
+
+    ring = calloc(1, sizeof(struct fsm_ring));
+    if (ring == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (chart_build(&ring->chart, rels, corresps) != 0) {
+        free(ring);
+        return NULL;
+    }
+    ring->header = mmap(NULL, map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ring->header == MAP_FAILED) {
+        err = errno;
+        chart_release(&ring->chart);
+        free(ring);
+        errno = err;
+        return NULL;
+    }
+    ring->fd = fd;
+    ring->slots = (struct ring_slot *)(ring->header + 1);
+    ring->map_bytes = map_bytes;
+
+    return ring;
+}
+
+/**
+ *  共有メモリの割り当てを解除し, 使用領域を解放する.
+ *
+ *  @param  [in,out]    ring    イベントリング.
+ */
+static void ring_unmap(struct fsm_ring *ring)
+{
+    munmap(ring->header, ring->map_bytes);
+    chart_release(&ring->chart);
+    batch_release(&ring->batch);
+    free(ring->name);
+    free(ring);
+}
+
+/**
+ *  @details    @c capacity 個の記録を格納できるイベントリングを生成する.
+ *              @c name が NULL の場合は名前のない共有メモリ (memfd) に生成し,
+ *              @ref fsm_ring_fd のファイルディスクリプタを子プロセスへの継承や
+ *              SCM_RIGHTS で渡して共有する.
+ *              @c name を指定した場合は POSIX 共有メモリ (shm_open) に生成し,
+ *              @ref fsm_ring_attach で接続する. 名前は切断時に削除する.
+ *              @c capacity は 2 のべき乗に切り上げる.
+ *
+ *  @param      [in]    name        共有メモリの名前. ("/" で始まる名前または NULL)
+ *  @param      [in]    capacity    格納できる記録の数.
+ *  @param      [in]    rels        状態の関係性.
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+struct fsm_ring *fsm_ring_create(const char *name,
+                                 size_t capacity,
+                                 const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps)
+{
+    struct fsm_ring *ring;
+    struct ring_header *header;
+    uint64_t slots = 2;
+    int fd, err;
+
+    if ((capacity == 0) || (capacity > (SIZE_MAX / 2 / sizeof(struct ring_slot))) || (corresps == NULL)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+
+    if (name == NULL) {
+        fd = memfd_create("hfsm_ring", MFD_CLOEXEC);
+    } else {
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    }
+    if (fd < 0) {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)ring_map_bytes(slots)) != 0) {
+        goto error;
+    }
+    ring = ring_map(fd, ring_map_bytes(slots), rels, corresps);
+    if (ring == NULL) {
+        goto error;
+    }
+    if (name != NULL) {
+        ring->name = strdup(name);
+        if (ring->name == NULL) {
+            ring_unmap(ring);
+            errno = ENOMEM;
+            goto error;
+        }
+    }
+
+    header = ring->header;
+    header->version = RING_VERSION;
+    header->slot_bytes = sizeof(struct ring_slot);
+    header->capacity = slots;
+    header->fingerprint = chart_fingerprint(&ring->chart);
+    atomic_init(&header->tail, 0);
+    atomic_init(&header->head, 0);
+    atomic_init(&header->wake_seq, 0);
+    atomic_init(&header->waiting, 0);
+    for (uint64_t i = 0; i < slots; ++i) {
+        atomic_init(&ring->slots[i].seq, i);
+    }
+    ring->mask = slots - 1;
+    /* 識別子は初期化の完了後に書き込み, 接続側は識別子で完了を確認する. */
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, RING_MAGIC, sizeof(header->magic));
+
+    return ring;
+
+error:
+    err = errno;
+    if (name != NULL) {
+        shm_unlink(name);
+    }
+    close(fd);
+    errno = err;
+    return NULL;
+}
+
+/**
+ *  @details    @ref fsm_ring_create で生成した名前付きのイベントリングに接続する.
+ *
+ *  @param      [in]    name        共有メモリの名前.
+ *  @param      [in]    rels        状態の関係性.
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ */
+struct fsm_ring *fsm_ring_attach(const char *name,
+                                 const struct fsm_rels *rels,
+                                 const struct fsm_trans *corresps)
+{
+    struct fsm_ring *ring;
+    int fd, err;
+
+    if (name == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    ring = fsm_ring_attach_fd(fd, rels, corresps);
+    err = errno;
+    close(fd);
+    errno = err;
+
+    return ring;
+}
+
+/**
+ *  @details    共有メモリのファイルディスクリプタでイベントリングに接続する.
+ *              @c fd は複製して保持するため, 呼び出し側で閉じてよい.
+ *              状態遷移定義が生成側と異なる場合は接続しない.
+ *
+ *  @param      [in]    fd          共有メモリのファイルディスクリプタ.
+ *  @param      [in]    rels        状態の関係性.
+ *  @param      [in]    corresps    状態遷移の対応表.
+ *  @return     成功時は, 確保および初期化されたオブジェクトのポインタが返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *              状態遷移定義または共有メモリの形式が異なる場合は, errno に EINVAL が設定される.
+ */
+struct fsm_ring *fsm_ring_attach_fd(int fd,
+                                    const struct fsm_rels *rels,
+                                    const struct fsm_trans *corresps)
+{
+    struct fsm_ring *ring;
+    struct ring_header *header;
+    struct stat st;
+    int dupfd;
+
+    if ((fd < 0) || (corresps == NULL)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0) {
+        return NULL;
+    }
+    if ((size_t)st.st_size < ring_map_bytes(2)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    dupfd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dupfd < 0) {
+        return NULL;
+    }
+    ring = ring_map(dupfd, (size_t)st.st_size, rels, corresps);
+    if (ring == NULL) {
+        int err = errno;
+        close(dupfd);
+        errno = err;
+        return NULL;
+    }
+
+    header = ring->header;
+    if ((memcmp(header->magic, RING_MAGIC, sizeof(header->magic)) != 0)
+        || (header->version != RING_VERSION)
+        || (header->slot_bytes != sizeof(struct ring_slot))
+        || (header->capacity < 2)
+        || ((header->capacity & (header->capacity - 1)) != 0)
+        || (ring_map_bytes(header->capacity) != ring->map_bytes)
+        || (header->fingerprint != chart_fingerprint(&ring->chart))) {
+        ring_unmap(ring);
+        close(dupfd);
+        errno = EINVAL;
+        return NULL;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    ring->mask = header->capacity - 1;
+
+    return ring;
+}
+
+/**
+ *  @details    イベントリングから切断し, 使用領域を解放する.
+ *              名前付きで生成した場合は, 名前を削除する.
+ *
+ *  @param      [in,out]    ring    イベントリング.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fsm_ring_close(struct fsm_ring *ring)
+{
+    if (ring == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (ring->name != NULL) {
+        shm_unlink(ring->name);
+    }
+    close(ring->fd);
+    ring_unmap(ring);
+
+    return 0;
+}
+
+/**
+ *  @details    イベントリングの共有メモリのファイルディスクリプタを取得する.
+ *
+ *  @param      [in]    ring    イベントリング.
+ *  @return     成功時は, ファイルディスクリプタが返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ */
+int fsm_ring_fd(const struct fsm_ring *ring)
+{
+    if (ring == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return ring->fd;
+}
+
+/**
+ *  @details    記録の枠を 1 つ予約し, 付加データの書き込み先を返す.
+ *              付加データを書き込んだ後に @ref fsm_ring_commit で公開すること.
+ *              受け取り側は記録を順に読み出すため, 公開するまで以降の記録も
+ *              読み出されない.
+ *
+ *  @param      [in,out]    ring        イベントリング.
+ *  @param      [in]        machine_id  受け取り側の状態マシンの番号.
+ *  @param      [in]        event       イベント.
+ *  @param      [in]        priority    イベントの優先度.
+ *  @return     成功時は, 付加データの書き込み先 (@ref FSM_RING_PAYLOAD_MAX バイト) が返る.
+ *              失敗時は, NULL が返り, errno が適切に設定される.
+ *              空きがない場合は, errno に ENOBUFS が設定される.
+ *  @note       複数のスレッドおよびプロセスから呼び出せる.
+ */
+void *fsm_ring_reserve(struct fsm_ring *ring,
+                       uint32_t machine_id,
+                       const struct fsm_event *event,
+                       enum fsm_priority priority)
+{
+    struct ring_slot *slot;
+    uint64_t pos;
+    int id;
+
+    if ((ring == NULL) || (event == NULL) || ((unsigned int)priority >= FSM_PRIORITY_LANES)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    id = chart_event_id(&ring->chart, event);
+    if (id < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    pos = atomic_load_explicit(&ring->header->tail, memory_order_relaxed);
+    for (;;) {
+        slot = &ring->slots[pos & ring->mask];
+        int64_t diff = (int64_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->header->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            errno = ENOBUFS;
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&ring->header->tail, memory_order_relaxed);
+        }
+    }
+
+    slot->machine = machine_id;
+    slot->event = (uint32_t)id;
+    slot->priority = (uint8_t)priority;
+    slot->payload_bytes = 0;
+
+    return slot->payload;
+}
+
+/**
+ *  @details    @ref fsm_ring_reserve で予約した記録を公開する.
+ *              受け取り側が待機している場合は, futex で起こす.
+ *              @c payload_bytes が大きすぎる場合も, 後続の記録が滞らないよう
+ *              無効な記録として公開する.
+ *
+ *  @param      [in,out]    ring            イベントリング.
+ *  @param      [in]        payload         @ref fsm_ring_reserve が返した書き込み先.
+ *  @param      [in]        payload_bytes   書き込んだ付加データの長さ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @note       複数のスレッドおよびプロセスから呼び出せる.
+ */
+int fsm_ring_commit(struct fsm_ring *ring, void *payload, size_t payload_bytes)
+{
+    struct ring_slot *slot;
+    struct ring_header *header;
+    int ret = 0;
+
+    if ((ring == NULL) || (payload == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    slot = (struct ring_slot *)((char *)payload - offsetof(struct ring_slot, payload));
+    header = ring->header;
+    if (payload_bytes > FSM_RING_PAYLOAD_MAX) {
+        slot->event = RING_DISCARDED;
+        payload_bytes = 0;
+        ret = -1;
+    }
+    slot->payload_bytes = (uint8_t)payload_bytes;
+
+    uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_release);
+
+    /* 受け取り側の待機中の印の設定と順序付け, 起こし漏れを防ぐ. */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&header->waiting, memory_order_relaxed) != 0) {
+        atomic_fetch_add_explicit(&header->wake_seq, 1, memory_order_release);
+        ring_futex(&header->wake_seq, FUTEX_WAKE, 1, NULL);
+    }
+
+    if (ret != 0) {
+        errno = EINVAL;
+    }
+    return ret;
+}
+
+/**
+ *  @details    イベントを付加データとともに送る.
+ *              @ref fsm_ring_reserve と @ref fsm_ring_commit をまとめて行う.
+ *
+ *  @param      [in,out]    ring            イベントリング.
+ *  @param      [in]        machine_id      受け取り側の状態マシンの番号.
+ *  @param      [in]        event           イベント.
+ *  @param      [in]        priority        イベントの優先度.
+ *  @param      [in]        payload         付加データ. (なしは NULL)
+ *  @param      [in]        payload_bytes   付加データの長さ.
+ *  @return     成功時は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              空きがない場合は, errno に ENOBUFS が設定される.
+ *  @note       複数のスレッドおよびプロセスから呼び出せる.
+ */
+int fsm_ring_send(struct fsm_ring *ring,
+                  uint32_t machine_id,
+                  const struct fsm_event *event,
+                  enum fsm_priority priority,
+                  const void *payload,
+                  size_t payload_bytes)
+{
+    void *dest;
+
+    if ((payload_bytes > FSM_RING_PAYLOAD_MAX) || ((payload == NULL) && (payload_bytes > 0))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    dest = fsm_ring_reserve(ring, machine_id, event, priority);
+    if (dest == NULL) {
+        return -1;
+    }
+    if (payload_bytes > 0) {
+        memcpy(dest, payload, payload_bytes);
+    }
+
+    return fsm_ring_commit(ring, dest, payload_bytes);
+}
+
+/**
+ *  @details    読み出せる記録が届くまで最大 @c timeout_ms 待つ.
+ *              記録が届いている場合はすぐに戻る.
+ *              期限は呼び出し時に一度だけ求めるため, シグナルによる中断や
+ *              記録を伴わない起床の後に待ち直しても, 待ち時間は延びない.
+ *
+ *  @param      [in,out]    ring        イベントリング.
+ *  @param      [in]        timeout_ms  最大の待ち時間 (ミリ秒). 負の場合は無期限.
+ *  @return     記録が届いた場合は, 0 が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *              時間内に届かなかった場合は, errno に ETIMEDOUT が設定される.
+ *  @warning    受け取り側の 1 つのスレッドからのみ呼び出すこと.
+ */
+int fsm_ring_wait(struct fsm_ring *ring, int timeout_ms)
+{
+    struct ring_header *header;
+    struct timespec deadline;
+
+    if (ring == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    header = ring->header;
+
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    while (!ring_ready(ring)) {
+        uint32_t seq = atomic_load_explicit(&header->wake_seq, memory_order_acquire);
+        atomic_store_explicit(&header->waiting, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (ring_ready(ring)) {
+            break;
+        }
+        long ret = ring_futex(&header->wake_seq, FUTEX_WAIT_BITSET, seq, (timeout_ms < 0) ? NULL : &deadline);
+        if ((ret != 0) && (errno == ETIMEDOUT)) {
+            atomic_store_explicit(&header->waiting, 0, memory_order_relaxed);
+            return ring_ready(ring) ? 0 : -1;
+        }
+    }
+    atomic_store_explicit(&header->waiting, 0, memory_order_relaxed);
+
+    return 0;
+}
+
+/**
+ *  @details    届いた記録を最大 @c max 件読み出し, @c machines の番号に対応する
+ *              状態マシンに積んだ後, 積んだ状態マシン毎に優先度順に処理する.
+ *              @c handler が設定されている場合は, 積む前に共有メモリ上の付加データを
+ *              指したまま呼び出す. 付加データは @c handler の中でのみ参照できる.
+ *              番号に対応する状態マシンがない記録, および番号, 優先度,
+ *              付加データの長さが範囲外の記録は読み捨てる.
+ *              共有メモリは他のプロセスが書き込むため, すべて信用せずに確かめる.
+ *
+ *  @param      [in,out]    ring        イベントリング.
+ *  @param      [in]        machines    番号で引く状態マシンの配列.
+ *  @param      [in]        nmachines   状態マシンの数.
+ *  @param      [in]        max         読み出す記録の最大数.
+ *  @param      [in]        handler     付加データを受け取るハンドラ. (不要なら NULL)
+ *  @param      [in]        ctx         ハンドラの最後の引数.
+ *  @return     成功時は, 読み出した記録の数が返る.
+ *              失敗時は, -1 が返り, errno が適切に設定される.
+ *  @warning    受け取り側の 1 つのスレッドからのみ呼び出すこと.
+ */
+ssize_t fsm_ring_drain(struct fsm_ring *ring,
+                       struct fsm *const *machines,
+                       size_t nmachines,
+                       size_t max,
+                       void (*handler)(struct fsm *, const struct fsm_event *,
+                                       const void *, size_t, void *),
+                       void *ctx)
+{
+    struct ring_header *header;
+    uint64_t head;
+    ssize_t count = 0;
+
+    if ((ring == NULL) || ((machines == NULL) && (nmachines > 0))) {
+        errno = EINVAL;
+        return -1;
+    }
+    header = ring->header;
+
+    head = atomic_load_explicit(&header->head, memory_order_relaxed);
+    while ((size_t)count < max) {
+        struct ring_slot *slot = &ring->slots[head & ring->mask];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != head + 1) {
+            break;
+        }
+
+        if ((slot->machine < nmachines) && (machines[slot->machine] != NULL)
+            && (slot->event < ring->chart.nevents) && (slot->priority < FSM_PRIORITY_LANES)
+            && (slot->payload_bytes <= FSM_RING_PAYLOAD_MAX)) {
+            struct fsm *machine = machines[slot->machine];
+            const struct fsm_event *event = ring->chart.events[slot->event];
+            if (handler != NULL) {
+                handler(machine, event, slot->payload, slot->payload_bytes, ctx);
+            }
+            batch_deliver(&ring->batch, machine, event, (enum fsm_priority)slot->priority);
+        }
+
+        /* 枠を生成側に返す. */
+        atomic_store_explicit(&slot->seq, head + ring->mask + 1, memory_order_release);
+        ++head;
+        ++count;
+    }
+    atomic_store_explicit(&header->head, head, memory_order_relaxed);
+
+    batch_flush(&ring->batch);
+
+    return count;
+}
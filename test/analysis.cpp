@@ -0,0 +1,200 @@
+/** @file   analysis.cpp
+ *  @brief  状態遷移定義の解析のテスト.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ */
+#include <cstdlib>
+
+#include <catch.hpp>
+
+extern "C" {
+#include "debug.h"
+#include "collections.h"
+#include "hfsm.h"
+#include "analysis.h"
+}
+
+FSM_STATE(state_analysis_a, NULL, NULL, NULL, NULL);
+FSM_STATE(state_analysis_b, NULL, NULL, NULL, NULL);
+FSM_STATE(state_analysis_c, NULL, NULL, NULL, NULL);
+FSM_STATE(state_analysis_d, NULL, NULL, NULL, NULL);
+FSM_STATE(state_analysis_p, NULL, NULL, NULL, NULL);
+FSM_STATE(state_analysis_p1, NULL, NULL, NULL, NULL);
+FSM_STATE(state_analysis_p2, NULL, NULL, NULL, NULL);
+FSM_STATE(state_analysis_q, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_analysis_1);
+FSM_EVENT(event_analysis_2);
+
+FSM_COND(cond_analysis, (struct fsm *machine))
+{
+    return false;
+}
+
+/**
+ *  リストにポインタが含まれるかを調べる.
+ *
+ *  @param  [in]    list    リスト.
+ *  @param  [in]    ptr     ポインタ.
+ *  @return 含まれる場合は true が返る.
+ */
+static bool list_contains(LIST list, const void *ptr)
+{
+    for (ITER iter = list_iter(list); iter != NULL; iter = iter_next(iter)) {
+        if (*(const void **)iter_get_payload(iter) == ptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SCENARIO("到達可能性を解析できること", "[analysis][reach]") {
+    GIVEN("到達不能な状態とデッドロックする状態を含む定義を行う") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_analysis_a),
+            FSM_TRANS_HELPER(state_analysis_a, event_analysis_1, NULL, NULL, state_analysis_b),
+            FSM_TRANS_HELPER(state_analysis_b, event_analysis_1, NULL, NULL, state_analysis_a),
+            FSM_TRANS_HELPER(state_analysis_c, event_analysis_1, NULL, NULL, state_analysis_a),
+            FSM_TRANS_HELPER(state_analysis_a, event_analysis_2, NULL, NULL, state_analysis_d),
+            FSM_TRANS_HELPER(state_analysis_a, event_analysis_1, NULL, NULL, state_analysis_c),
+            FSM_TRANS_TERMINATOR
+        };
+
+        WHEN("解析する") {
+            struct fsm_analysis *analysis = fsm_analyze(NULL, corresps, 2, 0);
+            REQUIRE(analysis != NULL);
+
+            THEN("到達可能な構成の数が 3 であること") {
+                REQUIRE(fsm_analysis_configs(analysis) == 3);
+                REQUIRE(fsm_analysis_truncated(analysis) == false);
+            }
+
+            THEN("到達不能な状態が検出されること") {
+                REQUIRE(list_count(fsm_analysis_unreachable_states(analysis)) == 1);
+                REQUIRE(list_contains(fsm_analysis_unreachable_states(analysis), state_analysis_c));
+            }
+
+            THEN("発火しない遷移が検出されること") {
+                REQUIRE(list_count(fsm_analysis_dead_transitions(analysis)) == 2);
+                REQUIRE(list_contains(fsm_analysis_dead_transitions(analysis), &corresps[3]));
+                REQUIRE(list_contains(fsm_analysis_dead_transitions(analysis), &corresps[5]));
+            }
+
+            THEN("デッドロックする状態が検出されること") {
+                REQUIRE(list_count(fsm_analysis_deadlock_states(analysis)) == 1);
+                REQUIRE(list_contains(fsm_analysis_deadlock_states(analysis), state_analysis_d));
+            }
+
+            fsm_analysis_release(analysis);
+        }
+    }
+
+    GIVEN("ガード条件付きの Null 遷移を含む定義を行う") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, cond_analysis, NULL, state_analysis_a),
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_analysis_b),
+            FSM_TRANS_HELPER(state_analysis_a, event_analysis_1, NULL, NULL, state_end),
+            FSM_TRANS_HELPER(state_analysis_b, event_analysis_1, NULL, NULL, state_end),
+            FSM_TRANS_TERMINATOR
+        };
+
+        WHEN("解析する") {
+            struct fsm_analysis *analysis = fsm_analyze(NULL, corresps, 1, 0);
+            REQUIRE(analysis != NULL);
+
+            THEN("ガード条件の成否の両方が辿られること") {
+                REQUIRE(list_count(fsm_analysis_unreachable_states(analysis)) == 0);
+                REQUIRE(list_count(fsm_analysis_dead_transitions(analysis)) == 0);
+            }
+
+            THEN("終了状態はデッドロックとしないこと") {
+                REQUIRE(list_count(fsm_analysis_deadlock_states(analysis)) == 0);
+            }
+
+            fsm_analysis_release(analysis);
+        }
+    }
+}
+
+SCENARIO("履歴状態を区別して構成を列挙できること", "[analysis][history]") {
+    GIVEN("履歴状態を持つコンポジット状態の定義を行う") {
+        const struct fsm_rels rels[] = {
+            FSM_RELS_HELPER(state_analysis_p1, state_analysis_p, true),
+            FSM_RELS_HELPER(state_analysis_p2, state_analysis_p, false),
+            FSM_RELS_TERMINATOR
+        };
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_analysis_p),
+            FSM_TRANS_HELPER(state_analysis_p1, event_analysis_1, NULL, NULL, state_analysis_p2),
+            FSM_TRANS_HELPER(state_analysis_p, event_analysis_2, NULL, NULL, state_analysis_q),
+            FSM_TRANS_HELPER(state_analysis_q, event_analysis_2, NULL, NULL, state_analysis_p),
+            FSM_TRANS_TERMINATOR
+        };
+
+        WHEN("解析する") {
+            struct fsm_analysis *analysis = fsm_analyze(rels, corresps, 2, 0);
+            REQUIRE(analysis != NULL);
+
+            THEN("履歴状態の違いが別の構成として数えられること") {
+                REQUIRE(fsm_analysis_configs(analysis) == 5);
+                REQUIRE(list_count(fsm_analysis_unreachable_states(analysis)) == 0);
+            }
+
+            fsm_analysis_release(analysis);
+        }
+
+        WHEN("構成の上限を指定して解析する") {
+            struct fsm_analysis *analysis = fsm_analyze(rels, corresps, 2, 2);
+            REQUIRE(analysis != NULL);
+
+            THEN("上限で探索が打ち切られること") {
+                REQUIRE(fsm_analysis_configs(analysis) == 2);
+                REQUIRE(fsm_analysis_truncated(analysis) == true);
+            }
+
+            fsm_analysis_release(analysis);
+        }
+    }
+}
+
+SCENARIO("大規模な定義を解析できること", "[analysis][large]") {
+    GIVEN("20000 の状態が環状に遷移する定義を行う") {
+        const size_t n = 20000;
+        struct fsm_state *states =
+            (struct fsm_state *)calloc(n, sizeof(struct fsm_state));
+        struct fsm_trans *corresps =
+            (struct fsm_trans *)calloc((n * 2) + 2, sizeof(struct fsm_trans));
+        for (size_t i = 0; i < n; ++i) {
+            states[i].name = "generated";
+        }
+        corresps[0].from = state_start;
+        corresps[0].event = event_null;
+        corresps[0].to = &states[0];
+        for (size_t i = 0; i < n; ++i) {
+            corresps[(i * 2) + 1].from = &states[i];
+            corresps[(i * 2) + 1].event = event_analysis_1;
+            corresps[(i * 2) + 1].to = &states[(i + 1) % n];
+            corresps[(i * 2) + 2].from = &states[i];
+            corresps[(i * 2) + 2].event = event_analysis_2;
+            corresps[(i * 2) + 2].to = &states[(i * 7) % n];
+        }
+
+        WHEN("4 スレッドで解析する") {
+            struct fsm_analysis *analysis = fsm_analyze(NULL, corresps, 4, 0);
+            REQUIRE(analysis != NULL);
+
+            THEN("すべての状態に到達すること") {
+                REQUIRE(fsm_analysis_configs(analysis) == (ssize_t)n);
+                REQUIRE(list_count(fsm_analysis_unreachable_states(analysis)) == 0);
+                REQUIRE(list_count(fsm_analysis_dead_transitions(analysis)) == 0);
+                REQUIRE(list_count(fsm_analysis_deadlock_states(analysis)) == 0);
+            }
+
+            fsm_analysis_release(analysis);
+        }
+
+        free(corresps);
+        free(states);
+    }
+}
@@ -4,6 +4,18 @@
  *  @author t-kenji <protect.2501@gmail.com>
  *  @date   2018-03-18 新規作成.
  */
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <catch.hpp>
 
 extern "C" {
@@ -25,6 +37,155 @@ SCENARIO("リストが初期化できること", "[list][init]") {
     }
 }
 
+SCENARIO("リストの容量が自動で拡張できること", "[list][growth]") {
+    GIVEN("リストを容量 2 で初期化し, 上限 8 まで拡張するよう設定しておく") {
+        LIST list = list_init(sizeof(int), 2);
+        REQUIRE(list != NULL);
+        REQUIRE(list_set_growth(list, 8) == 0);
+
+        WHEN("要素を 8 つ追加する") {
+            int *payloads[8];
+            for (int i = 0; i < 8; ++i) {
+                payloads[i] = (int *)list_add(list, &i);
+                REQUIRE(payloads[i] != NULL);
+            }
+
+            THEN("追加済みの要素が移動しないこと") {
+                for (int i = 0; i < 8; ++i) {
+                    REQUIRE(*payloads[i] == i);
+                }
+                REQUIRE(list_count(list) == 8);
+            }
+
+            THEN("9 つ目の追加に失敗すること") {
+                int a = 0x55;
+                REQUIRE(list_add(list, &a) == NULL);
+            }
+
+            THEN("上限を容量未満にできないこと") {
+                REQUIRE(list_set_growth(list, 4) == -1);
+            }
+
+            THEN("使用中の拡張分は解放されないこと") {
+                REQUIRE(list_shrink(list) == 8);
+            }
+
+            THEN("全要素を削除すると初期の容量まで縮小できること") {
+                ITER iter;
+                while ((iter = list_iter(list)) != NULL) {
+                    REQUIRE(list_remove(list, iter) == 0);
+                }
+                REQUIRE(list_shrink(list) == 2);
+
+                for (int i = 0; i < 8; ++i) {
+                    REQUIRE(list_add(list, &i) != NULL);
+                }
+                int expected = 0;
+                for (iter = list_iter(list); iter != NULL; iter = iter_next(iter)) {
+                    REQUIRE(*(int *)iter_get_payload(iter) == expected);
+                    ++expected;
+                }
+                REQUIRE(expected == 8);
+            }
+        }
+
+        list_release(list);
+    }
+
+    GIVEN("リストを容量 2 で初期化しておく") {
+        LIST list = list_init(sizeof(int), 2);
+        REQUIRE(list != NULL);
+
+        WHEN("要素を 3 つ追加する") {
+            int a = 0;
+            REQUIRE(list_add(list, &a) != NULL);
+            REQUIRE(list_add(list, &a) != NULL);
+
+            THEN("既定では拡張せず 3 つ目の追加に失敗すること") {
+                REQUIRE(list_add(list, &a) == NULL);
+            }
+        }
+
+        list_release(list);
+    }
+}
+
+SCENARIO("スタックに要素を積めること", "[stack][push]") {
+    GIVEN("スタックを容量 5 で初期化しておく") {
+        STACK stack = stack_init(sizeof(int), 5);
+        REQUIRE(stack != NULL);
+
+        WHEN("要素を積まない") {
+            THEN("スタックの深さが 0 であること") {
+                REQUIRE(stack_count(stack) == 0);
+                REQUIRE(stack_iter(stack) == NULL);
+            }
+        }
+
+        WHEN("要素を 6 つ積む") {
+            for (int i = 0; i < 5; ++i) {
+                REQUIRE(stack_push(stack, &i) != NULL);
+            }
+
+            THEN("6 つ目を積むのに失敗すること") {
+                int a = 0x55;
+                REQUIRE(stack_push(stack, &a) == NULL);
+                REQUIRE(stack_count(stack) == 5);
+            }
+        }
+
+        stack_release(stack);
+    }
+}
+
+SCENARIO("スタックから要素を取り出せること", "[stack][pop]") {
+    GIVEN("スタックを容量 5 で初期化しておく") {
+        STACK stack = stack_init(sizeof(int), 5);
+        REQUIRE(stack != NULL);
+
+        WHEN("要素を積まない") {
+            THEN("要素が取り出せないこと") {
+                int a = -1;
+                REQUIRE(stack_pop(stack, &a) == -1);
+            }
+        }
+
+        WHEN("要素を 5 つ積む") {
+            for (int i = 0; i < 5; ++i) {
+                REQUIRE(stack_push(stack, &i) != NULL);
+            }
+
+            THEN("反復子で積んだ逆順に辿れること") {
+                int expected = 4;
+                for (ITER iter = stack_iter(stack); iter != NULL; iter = iter_next(iter)) {
+                    REQUIRE(*(int *)iter_get_payload(iter) == expected);
+                    --expected;
+                }
+                REQUIRE(expected == -1);
+            }
+
+            THEN("積んだ逆順に要素が取り出せること") {
+                for (int i = 0; i < 5; ++i) {
+                    int b = -1;
+                    REQUIRE(stack_pop(stack, &b) == (4 - i));
+                    REQUIRE(b == (4 - i));
+                }
+            }
+
+            THEN("消去すると空になり, 再び積めること") {
+                int a = 0x55, b = 0;
+                REQUIRE(stack_clear(stack) == 0);
+                REQUIRE(stack_count(stack) == 0);
+                REQUIRE(stack_push(stack, &a) != NULL);
+                REQUIRE(stack_pop(stack, &b) == 0);
+                REQUIRE(b == 0x55);
+            }
+        }
+
+        stack_release(stack);
+    }
+}
+
 SCENARIO("キューが初期化できること", "[queue][init]") {
     GIVEN("特になし") {
         WHEN("キューを容量 0 で初期化する") {
@@ -200,6 +361,236 @@ SCENARIO("キューから要素を取り出せること", "[queue][deq]") {
     }
 }
 
+SCENARIO("キューに要素をまとめて出し入れできること", "[queue][bulk]") {
+    GIVEN("キューを容量 5 で初期化しておく") {
+        QUEUE que = queue_init(sizeof(int), 5);
+        REQUIRE(que != NULL);
+
+        WHEN("要素を 7 つまとめて追加する") {
+            int a[7] = {0, 1, 2, 3, 4, 5, 6};
+
+            THEN("容量の 5 つまで追加されること") {
+                REQUIRE(queue_enq_bulk(que, a, 7) == 5);
+                REQUIRE(queue_count(que) == 5);
+                REQUIRE(queue_enq_bulk(que, a, 1) == 0);
+            }
+        }
+
+        WHEN("リングの末尾を跨いで出し入れする") {
+            int a[5] = {10, 11, 12, 13, 14};
+            int b[5] = {};
+            int c = 0;
+
+            /* 先頭を進めておき, 次の追加が末尾で折り返すようにする. */
+            for (int i = 0; i < 3; ++i) {
+                REQUIRE(queue_enq(que, &i) != NULL);
+                REQUIRE(queue_deq(que, &c) == 0);
+            }
+            REQUIRE(queue_enq_bulk(que, a, 5) == 5);
+
+            THEN("反復子で追加順に辿れること") {
+                int expected = 10;
+                for (ITER iter = queue_iter(que); iter != NULL; iter = iter_next(iter)) {
+                    REQUIRE(*(int *)iter_get_payload(iter) == expected);
+                    ++expected;
+                }
+                REQUIRE(expected == 15);
+            }
+
+            THEN("配列に追加順にコピーできること") {
+                void *array = NULL;
+                size_t count = 0;
+                REQUIRE(queue_to_array(que, &array, &count) == 0);
+                REQUIRE(count == 5);
+                for (int i = 0; i < 5; ++i) {
+                    REQUIRE(((int *)array)[i] == 10 + i);
+                }
+                free(array);
+            }
+
+            THEN("追加順にまとめて取り出せること") {
+                REQUIRE(queue_deq_bulk(que, b, 2) == 2);
+                REQUIRE(b[0] == 10);
+                REQUIRE(b[1] == 11);
+                REQUIRE(queue_deq_bulk(que, b, 5) == 3);
+                REQUIRE(b[0] == 12);
+                REQUIRE(b[2] == 14);
+                REQUIRE(queue_deq_bulk(que, b, 5) == 0);
+                REQUIRE(queue_count(que) == 0);
+            }
+        }
+
+        queue_release(que);
+    }
+
+    GIVEN("キューを容量 4 で初期化し, 満杯にしておく") {
+        QUEUE que = queue_init(sizeof(int), 4);
+        int a[4] = {20, 21, 22, 23};
+        int c = 0;
+        REQUIRE(queue_enq(que, &c) != NULL);
+        REQUIRE(queue_deq(que, &c) == 0);
+        REQUIRE(queue_enq_bulk(que, a, 4) == 4);
+
+        WHEN("反復子で辿る") {
+            int expected = 20;
+            for (ITER iter = queue_iter(que); iter != NULL; iter = iter_next(iter)) {
+                REQUIRE(*(int *)iter_get_payload(iter) == expected);
+                ++expected;
+            }
+
+            THEN("全ての要素を 1 度ずつ辿ること") {
+                REQUIRE(expected == 24);
+            }
+        }
+
+        queue_release(que);
+    }
+}
+
+/**
+ *  キー部分のみを比較する要素.
+ */
+struct keyed {
+    int key;    /**< キー. */
+    int value;  /**< 値. */
+};
+
+static size_t keyed_hash(const void *payload, size_t bytes)
+{
+    (void)bytes;
+    return (size_t)((const struct keyed *)payload)->key * 2654435761u;
+}
+
+static bool keyed_equal(const void *a, const void *b, size_t bytes)
+{
+    (void)bytes;
+    return ((const struct keyed *)a)->key == ((const struct keyed *)b)->key;
+}
+
+SCENARIO("セットに要素を追加, 削除できること", "[set][add]") {
+    GIVEN("セットを容量 5 で初期化しておく") {
+        SET set = set_init(sizeof(int), 5);
+        REQUIRE(set != NULL);
+
+        WHEN("同じ要素を 2 回追加する") {
+            int a = 0x55;
+            void *p = set_add(set, &a);
+            REQUIRE(p != NULL);
+
+            THEN("2 回目は同じデータ部が返り, 要素数が 1 であること") {
+                REQUIRE(set_add(set, &a) == p);
+                REQUIRE(set_count(set) == 1);
+                REQUIRE(set_contains(set, &a));
+            }
+        }
+
+        WHEN("要素を 5 つ追加する") {
+            for (int i = 0; i < 5; ++i) {
+                REQUIRE(set_add(set, &i) != NULL);
+            }
+
+            THEN("6 つ目の追加に失敗すること") {
+                int a = 0x55;
+                REQUIRE(set_add(set, &a) == NULL);
+                REQUIRE(set_count(set) == 5);
+            }
+
+            THEN("反復子で追加順に辿れること") {
+                int expected = 0;
+                for (ITER iter = set_iter(set); iter != NULL; iter = iter_next(iter)) {
+                    REQUIRE(*(int *)iter_get_payload(iter) == expected);
+                    ++expected;
+                }
+                REQUIRE(expected == 5);
+            }
+
+            THEN("削除した要素のみ含まれなくなること") {
+                int a = 1;
+                REQUIRE(set_remove(set, &a) == 0);
+                REQUIRE(set_remove(set, &a) == -1);
+                REQUIRE(set_count(set) == 4);
+                REQUIRE_FALSE(set_contains(set, &a));
+                for (int i = 0; i < 5; ++i) {
+                    REQUIRE(set_contains(set, &i) == (i != 1));
+                }
+
+                int count = 0;
+                for (ITER iter = set_iter(set); iter != NULL; iter = iter_next(iter)) {
+                    REQUIRE(*(int *)iter_get_payload(iter) != 1);
+                    ++count;
+                }
+                REQUIRE(count == 4);
+
+                REQUIRE(set_add(set, &a) != NULL);
+                REQUIRE(set_count(set) == 5);
+            }
+
+            THEN("消去すると空になること") {
+                int a = 0;
+                REQUIRE(set_clear(set) == 0);
+                REQUIRE(set_count(set) == 0);
+                REQUIRE(set_iter(set) == NULL);
+                REQUIRE_FALSE(set_contains(set, &a));
+            }
+        }
+
+        set_release(set);
+    }
+
+    GIVEN("キーのみを比較するセットを初期化しておく") {
+        SET set = set_init_custom(sizeof(struct keyed), 5, keyed_hash, keyed_equal);
+        REQUIRE(set != NULL);
+
+        WHEN("キーが同じで値が異なる要素を追加する") {
+            struct keyed a = {1, 100}, b = {1, 200};
+            REQUIRE(set_add(set, &a) != NULL);
+            void *p = set_add(set, &b);
+
+            THEN("最初に追加した要素が返ること") {
+                REQUIRE(p != NULL);
+                REQUIRE(((struct keyed *)p)->value == 100);
+                REQUIRE(set_count(set) == 1);
+            }
+        }
+
+        set_release(set);
+    }
+
+    GIVEN("セットを容量 1000 で初期化しておく") {
+        SET set = set_init(sizeof(int), 1000);
+        std::set<int> expected;
+        std::mt19937 rng(43);
+        REQUIRE(set != NULL);
+
+        WHEN("追加と削除を無作為に繰り返す") {
+            for (int i = 0; i < 20000; ++i) {
+                int a = (int)(rng() % 1200);
+                if ((rng() % 3 != 0) && (expected.size() < 1000)) {
+                    REQUIRE(set_add(set, &a) != NULL);
+                    expected.insert(a);
+                } else {
+                    REQUIRE((set_remove(set, &a) == 0) == (expected.erase(a) == 1));
+                }
+            }
+
+            THEN("std::set と同じ要素を持つこと") {
+                REQUIRE(set_count(set) == (ssize_t)expected.size());
+                size_t count = 0;
+                for (ITER iter = set_iter(set); iter != NULL; iter = iter_next(iter)) {
+                    REQUIRE(expected.count(*(int *)iter_get_payload(iter)) == 1);
+                    ++count;
+                }
+                REQUIRE(count == expected.size());
+                for (int a = 0; a < 1200; ++a) {
+                    REQUIRE(set_contains(set, &a) == (expected.count(a) == 1));
+                }
+            }
+        }
+
+        set_release(set);
+    }
+}
+
 SCENARIO("ツリーが初期化できること", "[tree][init]") {
     GIVEN("特になし") {
         WHEN("ツリーを容量 5 で初期化する") {
@@ -264,6 +655,141 @@ SCENARIO("ツリーに要素が追加できること", "[tree][add]") {
     }
 }
 
+SCENARIO("ツリーの要素をデータ部で探せること", "[tree][find]") {
+    GIVEN("ツリーを容量 5 で初期化し, 要素を階層的に追加しておく") {
+        TREE tree = tree_init(sizeof(int), 5);
+        int a = 0, b;
+        REQUIRE(tree_insert(tree, NULL, &a) != NULL);
+        a = 1; b = 0;
+        REQUIRE(tree_insert(tree, &b, &a) != NULL);
+        a = 2; b = 1;
+        REQUIRE(tree_insert(tree, &b, &a) != NULL);
+
+        WHEN("追加済みの要素を探す") {
+            b = 2;
+            int *found = (int *)tree_find(tree, &b);
+
+            THEN("ツリー上のデータ部が返ること") {
+                REQUIRE(found != NULL);
+                REQUIRE(*found == 2);
+                REQUIRE(found != &b);
+            }
+        }
+
+        WHEN("追加していない要素を探す") {
+            b = 9;
+
+            THEN("見つからないこと") {
+                REQUIRE(tree_find(tree, &b) == NULL);
+                REQUIRE(tree_insert(tree, &b, &a) == NULL);
+                REQUIRE(tree_count(tree) == 3);
+            }
+        }
+
+        WHEN("同じデータ部の要素を追加し, その子を追加する") {
+            a = 1; b = 2;
+            int *dup = (int *)tree_insert(tree, &b, &a);
+            REQUIRE(dup != NULL);
+            a = 3; b = 1;
+            REQUIRE(tree_insert(tree, &b, &a) != NULL);
+
+            THEN("最初に追加した要素の子となること") {
+                b = 1;
+                REQUIRE(tree_find(tree, &b) != dup);
+                TREE_ITER iter = tree_iter_get(tree);
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 0);
+                iter = tree_iter_next(iter);
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 1);
+                REQUIRE(tree_iter_get_age(iter) == 2);
+                iter = tree_iter_next(iter);
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 2);
+                iter = tree_iter_next(iter);
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 1);
+                REQUIRE(tree_iter_get_age(iter) == 4);
+                iter = tree_iter_next(iter);
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 3);
+                REQUIRE(tree_iter_get_age(iter) == 3);
+                tree_iter_release(iter);
+            }
+        }
+
+        WHEN("消去する") {
+            REQUIRE(tree_clear(tree) == 0);
+
+            THEN("要素が見つからなくなること") {
+                b = 1;
+                REQUIRE(tree_find(tree, &b) == NULL);
+            }
+        }
+
+        tree_release(tree);
+    }
+
+    GIVEN("ツリーを容量 100000 で初期化しておく") {
+        TREE tree = tree_init(sizeof(int), 100000);
+        REQUIRE(tree != NULL);
+
+        WHEN("根に 99999 個並べた末尾の要素の子を追加する") {
+            for (int i = 0; i < 99999; ++i) {
+                REQUIRE(tree_insert(tree, NULL, &i) != NULL);
+            }
+            int a = 100000, b = 99998;
+            int *child = (int *)tree_insert(tree, &b, &a);
+
+            THEN("追加できること") {
+                REQUIRE(child != NULL);
+                REQUIRE(tree_find(tree, &a) == child);
+                REQUIRE(tree_count(tree) == 100000);
+            }
+        }
+
+        tree_release(tree);
+    }
+}
+
+SCENARIO("ツリーの容量が自動で拡張できること", "[tree][growth]") {
+    GIVEN("ツリーを容量 1 で初期化し, 上限なしで拡張するよう設定しておく") {
+        TREE tree = tree_init(sizeof(int), 1);
+        REQUIRE(tree != NULL);
+        REQUIRE(tree_set_growth(tree, SIZE_MAX) == 0);
+
+        WHEN("要素を階層的に 100 個追加する") {
+            int *payloads[100];
+            int a = 0;
+            payloads[0] = (int *)tree_insert(tree, NULL, &a);
+            REQUIRE(payloads[0] != NULL);
+            for (a = 1; a < 100; ++a) {
+                payloads[a] = (int *)tree_insert_child(tree, payloads[(a - 1) / 2], &a);
+                REQUIRE(payloads[a] != NULL);
+            }
+
+            THEN("追加済みの要素が移動しないこと") {
+                REQUIRE(tree_count(tree) == 100);
+                for (int i = 0; i < 100; ++i) {
+                    REQUIRE(*payloads[i] == i);
+                }
+            }
+
+            THEN("反復子で全要素を辿れること") {
+                int count = 0;
+                for (TREE_ITER iter = tree_iter_get(tree); iter != NULL; iter = tree_iter_next(iter)) {
+                    ++count;
+                }
+                REQUIRE(count == 100);
+            }
+
+            THEN("消去すると初期の容量まで縮小できること") {
+                REQUIRE(tree_clear(tree) == 0);
+                REQUIRE(tree_shrink(tree) == 1);
+                REQUIRE(tree_insert(tree, NULL, &a) != NULL);
+                REQUIRE(tree_count(tree) == 1);
+            }
+        }
+
+        tree_release(tree);
+    }
+}
+
 SCENARIO("ツリーを反復子で処理できること", "[tree][iterator]") {
     GIVEN("ツリーを容量 5 で初期化しておく") {
         TREE tree = tree_init(sizeof(int), 5);
@@ -358,6 +884,926 @@ SCENARIO("ツリーを反復子で処理できること", "[tree][iterator]") {
             }
         }
 
+        WHEN("要素を親の位置を指定して階層的に 5 つ追加する") {
+            int a = 0;
+            void *n0, *n1, *n2;
+            n0 = tree_insert_child(tree, NULL, &a);
+            REQUIRE(n0 != NULL);
+            a = 1;
+            n1 = tree_insert_child(tree, n0, &a);
+            REQUIRE(n1 != NULL);
+            a = 2;
+            n2 = tree_insert_child(tree, n0, &a);
+            REQUIRE(n2 != NULL);
+            a = 3;
+            REQUIRE(tree_insert_child(tree, n2, &a) != NULL);
+            a = 4;
+            REQUIRE(tree_insert_child(tree, n1, &a) != NULL);
+
+            THEN("容量を超えて追加できないこと") {
+                a = 5;
+                REQUIRE(tree_insert_child(tree, n0, &a) == NULL);
+                REQUIRE(tree_count(tree) == 5);
+            }
+
+            THEN("反復子でツリーに沿った順に値が取得できること") {
+                TREE_ITER iter = tree_iter_get(tree);
+                REQUIRE(iter != NULL);
+
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 0);
+                REQUIRE(tree_iter_get_age(iter) == 1);
+                iter = tree_iter_next(iter);
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 1);
+                REQUIRE(tree_iter_get_age(iter) == 2);
+                iter = tree_iter_next(iter);
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 4);
+                REQUIRE(tree_iter_get_age(iter) == 3);
+                iter = tree_iter_next(iter);
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 2);
+                REQUIRE(tree_iter_get_age(iter) == 2);
+                iter = tree_iter_next(iter);
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 3);
+                REQUIRE(tree_iter_get_age(iter) == 3);
+
+                tree_iter_release(iter);
+            }
+        }
+
         tree_release(tree);
     }
 }
+
+static int record_visit(void *payload, int age, void *ctx)
+{
+    auto visited = static_cast<std::vector<std::pair<int, int>> *>(ctx);
+    visited->emplace_back(*(int *)payload, age);
+    return 0;
+}
+
+static int stop_visit(void *payload, int age, void *ctx)
+{
+    (void)age;
+    ++*(int *)ctx;
+    return (*(int *)payload == 4) ? 4 : 0;
+}
+
+SCENARIO("ツリーを走査関数で処理できること", "[tree][walk]") {
+    GIVEN("ツリーを容量 5 で初期化しておく") {
+        TREE tree = tree_init(sizeof(int), 5);
+
+        WHEN("要素を階層的に 5 つ追加する") {
+            int a = 0, b;
+            tree_insert(tree, NULL, &a);
+            a = 1; b = 0;
+            tree_insert(tree, &b, &a);
+            a = 2; b = 0;
+            tree_insert(tree, &b, &a);
+            a = 3; b = 2;
+            tree_insert(tree, &b, &a);
+            a = 4; b = 1;
+            tree_insert(tree, &b, &a);
+
+            THEN("反復子と同じ順に値と世代が渡されること") {
+                std::vector<std::pair<int, int>> visited;
+                REQUIRE(tree_walk(tree, record_visit, &visited) == 0);
+
+                std::vector<std::pair<int, int>> expected;
+                for (TREE_ITER iter = tree_iter_get(tree); iter != NULL; iter = tree_iter_next(iter)) {
+                    expected.emplace_back(*(int *)tree_iter_get_payload(iter), tree_iter_get_age(iter));
+                }
+                REQUIRE(visited == expected);
+                REQUIRE(visited == std::vector<std::pair<int, int>>{{0, 1}, {1, 2}, {4, 3}, {2, 2}, {3, 3}});
+            }
+
+            THEN("走査関数が 0 以外を返すと打ち切られること") {
+                int calls = 0;
+                REQUIRE(tree_walk(tree, stop_visit, &calls) == 4);
+                REQUIRE(calls == 3);
+            }
+
+            THEN("最後の要素の次は NULL となること") {
+                TREE_ITER iter = tree_iter_get(tree);
+                for (int i = 0; i < 4; ++i) {
+                    iter = tree_iter_next(iter);
+                }
+                REQUIRE(*(int *)tree_iter_get_payload(iter) == 3);
+                errno = 0;
+                REQUIRE(tree_iter_next(iter) == NULL);
+                REQUIRE(errno == ENOENT);
+            }
+        }
+
+        WHEN("要素がない") {
+            THEN("走査関数が呼ばれないこと") {
+                std::vector<std::pair<int, int>> visited;
+                REQUIRE(tree_iter_get(tree) == NULL);
+                REQUIRE(tree_walk(tree, record_visit, &visited) == 0);
+                REQUIRE(visited.empty());
+            }
+        }
+
+        WHEN("引数が不正") {
+            THEN("失敗すること") {
+                errno = 0;
+                REQUIRE(tree_walk(NULL, record_visit, NULL) == -1);
+                REQUIRE(errno == EINVAL);
+                REQUIRE(tree_walk(tree, NULL, NULL) == -1);
+            }
+        }
+
+        tree_release(tree);
+    }
+
+    GIVEN("深さ 100000 の一本道のツリー") {
+        const int depth = 100000;
+        TREE tree = tree_init(sizeof(int), depth);
+        void *parent = NULL;
+        for (int i = 0; i < depth; ++i) {
+            parent = tree_insert_child(tree, parent, &i);
+        }
+        REQUIRE(tree_count(tree) == depth);
+
+        THEN("すべての要素を深さ順に辿れること") {
+            std::vector<std::pair<int, int>> visited;
+            REQUIRE(tree_walk(tree, record_visit, &visited) == 0);
+            REQUIRE(visited.size() == (size_t)depth);
+            bool ordered = true;
+            for (int i = 0; i < depth; ++i) {
+                ordered = ordered && (visited[i].first == i) && (visited[i].second == i + 1);
+            }
+            REQUIRE(ordered);
+        }
+
+        tree_release(tree);
+    }
+}
+
+static std::vector<int> walk_payloads(TREE tree, void *top, enum tree_order order)
+{
+    std::vector<std::pair<int, int>> visited;
+    std::vector<int> payloads;
+    REQUIRE(tree_walk_subtree(tree, top, order, record_visit, &visited) == 0);
+    for (auto &v : visited) {
+        payloads.push_back(v.first);
+    }
+    return payloads;
+}
+
+/**
+ *  入れ子の幅優先の走査の状態.
+ */
+struct nested_walk {
+    TREE tree;                  /**< 辿るツリー. */
+    std::vector<int> outer;     /**< 外側の走査で辿った要素. */
+    bool matched;               /**< 内側の走査がすべて部分木の頂点から始まったか. */
+};
+
+static int nested_visit(void *payload, int age, void *ctx)
+{
+    auto nested = static_cast<struct nested_walk *>(ctx);
+    std::vector<std::pair<int, int>> inner;
+    (void)age;
+    nested->outer.push_back(*(int *)payload);
+    nested->matched = nested->matched
+                      && (tree_walk_subtree(nested->tree, payload, TREE_LEVEL_ORDER, record_visit, &inner) == 0)
+                      && (inner.front().first == *(int *)payload);
+    return 0;
+}
+
+SCENARIO("ツリーを順序と部分木を指定して辿れること", "[tree][walk]") {
+    GIVEN("ツリーを容量 8 で初期化しておく") {
+        TREE tree = tree_init(sizeof(int), 8);
+
+        WHEN("要素を階層的に 7 つ追加する") {
+            /*
+             * 0 ┬ 1 ┬ 3
+             *   │   └ 4 ─ 6
+             *   └ 2 ─ 5
+             */
+            const int rels[][2] = {{1, 0}, {2, 0}, {3, 1}, {4, 1}, {5, 2}, {6, 4}};
+            int a = 0;
+            tree_insert(tree, NULL, &a);
+            for (auto &r : rels) {
+                a = r[0];
+                int b = r[1];
+                REQUIRE(tree_insert(tree, &b, &a) != NULL);
+            }
+
+            THEN("行きがけ順に辿れること") {
+                REQUIRE(walk_payloads(tree, NULL, TREE_PRE_ORDER) == std::vector<int>{0, 1, 3, 4, 6, 2, 5});
+            }
+
+            THEN("帰りがけ順に辿れること") {
+                REQUIRE(walk_payloads(tree, NULL, TREE_POST_ORDER) == std::vector<int>{3, 6, 4, 1, 5, 2, 0});
+            }
+
+            THEN("幅優先で辿れること") {
+                std::vector<std::pair<int, int>> visited;
+                REQUIRE(tree_walk_subtree(tree, NULL, TREE_LEVEL_ORDER, record_visit, &visited) == 0);
+                REQUIRE(visited == std::vector<std::pair<int, int>>{
+                    {0, 1}, {1, 2}, {2, 2}, {3, 3}, {4, 3}, {5, 3}, {6, 4}});
+            }
+
+            THEN("部分木のみを辿れること") {
+                int key = 1;
+                void *top = tree_find(tree, &key);
+                REQUIRE(top != NULL);
+                REQUIRE(walk_payloads(tree, top, TREE_PRE_ORDER) == std::vector<int>{1, 3, 4, 6});
+                REQUIRE(walk_payloads(tree, top, TREE_POST_ORDER) == std::vector<int>{3, 6, 4, 1});
+                REQUIRE(walk_payloads(tree, top, TREE_LEVEL_ORDER) == std::vector<int>{1, 3, 4, 6});
+
+                key = 5;
+                top = tree_find(tree, &key);
+                REQUIRE(walk_payloads(tree, top, TREE_PRE_ORDER) == std::vector<int>{5});
+                REQUIRE(walk_payloads(tree, top, TREE_POST_ORDER) == std::vector<int>{5});
+                REQUIRE(walk_payloads(tree, top, TREE_LEVEL_ORDER) == std::vector<int>{5});
+            }
+
+            THEN("幅優先の走査を入れ子にできること") {
+                struct nested_walk nested = {tree, {}, true};
+                REQUIRE(tree_walk_subtree(tree, NULL, TREE_LEVEL_ORDER, nested_visit, &nested) == 0);
+                REQUIRE(nested.outer == std::vector<int>{0, 1, 2, 3, 4, 5, 6});
+                REQUIRE(nested.matched);
+            }
+
+            THEN("走査関数が 0 以外を返すと打ち切られること") {
+                int calls = 0;
+                REQUIRE(tree_walk_subtree(tree, NULL, TREE_POST_ORDER, stop_visit, &calls) == 4);
+                REQUIRE(calls == 3);
+                calls = 0;
+                REQUIRE(tree_walk_subtree(tree, NULL, TREE_LEVEL_ORDER, stop_visit, &calls) == 4);
+                REQUIRE(calls == 5);
+            }
+
+            THEN("不正な順を指定すると失敗すること") {
+                errno = 0;
+                REQUIRE(tree_walk_subtree(tree, NULL, (enum tree_order)-1, record_visit, NULL) == -1);
+                REQUIRE(errno == EINVAL);
+            }
+        }
+
+        WHEN("要素がない") {
+            THEN("走査関数が呼ばれないこと") {
+                REQUIRE(walk_payloads(tree, NULL, TREE_PRE_ORDER).empty());
+                REQUIRE(walk_payloads(tree, NULL, TREE_POST_ORDER).empty());
+                REQUIRE(walk_payloads(tree, NULL, TREE_LEVEL_ORDER).empty());
+            }
+        }
+
+        tree_release(tree);
+    }
+
+    GIVEN("200000 要素の無作為な形のツリー") {
+        const int count = 200000;
+        TREE tree = tree_init(sizeof(int), count);
+        std::vector<std::vector<int>> children(count);
+        std::vector<int> depth(count);
+        std::mt19937 rng(47);
+
+        bool inserted = true;
+        for (int i = 0; i < count; ++i) {
+            if (i == 0) {
+                inserted = inserted && (tree_insert(tree, NULL, &i) != NULL);
+                depth[i] = 1;
+            } else {
+                int parent = std::uniform_int_distribution<int>(std::max(0, i - 16), i - 1)(rng);
+                inserted = inserted && (tree_insert(tree, &parent, &i) != NULL);
+                children[parent].push_back(i);
+                depth[i] = depth[parent] + 1;
+            }
+        }
+        REQUIRE(inserted);
+
+        THEN("帰りがけ順では子がすべて親より先に渡されること") {
+            std::vector<int> order = walk_payloads(tree, NULL, TREE_POST_ORDER);
+            REQUIRE(order.size() == (size_t)count);
+            std::vector<int> position(count);
+            for (int i = 0; i < count; ++i) {
+                position[order[i]] = i;
+            }
+            bool ordered = true;
+            for (int i = 0; i < count; ++i) {
+                for (int c : children[i]) {
+                    ordered = ordered && (position[c] < position[i]);
+                }
+            }
+            REQUIRE(ordered);
+            REQUIRE(order.back() == 0);
+        }
+
+        THEN("幅優先では世代が減らないこと") {
+            std::vector<std::pair<int, int>> visited;
+            REQUIRE(tree_walk_subtree(tree, NULL, TREE_LEVEL_ORDER, record_visit, &visited) == 0);
+            REQUIRE(visited.size() == (size_t)count);
+            bool ordered = true;
+            for (int i = 0; i < count; ++i) {
+                ordered = ordered && (visited[i].second == depth[visited[i].first]);
+                ordered = ordered && ((i == 0) || (visited[i - 1].second <= visited[i].second));
+            }
+            REQUIRE(ordered);
+        }
+
+        tree_release(tree);
+    }
+}
+
+SCENARIO("展開リストが初期化できること", "[ulist][init]") {
+    GIVEN("特になし") {
+        WHEN("展開リストを容量 100 で初期化する") {
+            ULIST list = ulist_init(sizeof(int), 100);
+
+            THEN("展開リストオブジェクトが返ること") {
+                REQUIRE(list != NULL);
+                REQUIRE(ulist_count(list) == 0);
+            }
+
+            ulist_release(list);
+        }
+
+        WHEN("データ部のサイズか容量に 0 を指定する") {
+            THEN("失敗すること") {
+                errno = 0;
+                REQUIRE(ulist_init(0, 100) == NULL);
+                REQUIRE(errno == EINVAL);
+                REQUIRE(ulist_init(sizeof(int), 0) == NULL);
+            }
+        }
+    }
+}
+
+SCENARIO("展開リストに位置を指定して要素を追加, 削除できること", "[ulist][insert]") {
+    GIVEN("展開リストを容量 5 で初期化しておく") {
+        ULIST list = ulist_init(sizeof(int), 5);
+
+        WHEN("末尾と先頭と中間に要素を追加する") {
+            int a;
+            a = 1; REQUIRE(*(int *)ulist_add(list, &a) == 1);
+            a = 3; REQUIRE(*(int *)ulist_add(list, &a) == 3);
+            a = 0; REQUIRE(*(int *)ulist_insert(list, 0, &a) == 0);
+            a = 2; REQUIRE(*(int *)ulist_insert(list, 2, &a) == 2);
+            a = 4; REQUIRE(*(int *)ulist_insert(list, 4, &a) == 4);
+
+            THEN("位置の順に値が取得できること") {
+                REQUIRE(ulist_count(list) == 5);
+                for (int i = 0; i < 5; ++i) {
+                    REQUIRE(*(int *)ulist_get(list, i) == i);
+                }
+            }
+
+            THEN("容量を超えて追加できないこと") {
+                a = 5;
+                errno = 0;
+                REQUIRE(ulist_add(list, &a) == NULL);
+                REQUIRE(errno == ENOMEM);
+            }
+
+            THEN("要素を削除すると後ろの要素が詰められること") {
+                REQUIRE(ulist_remove(list, 2) == 0);
+                REQUIRE(ulist_remove(list, 0) == 0);
+                REQUIRE(ulist_count(list) == 3);
+                REQUIRE(*(int *)ulist_get(list, 0) == 1);
+                REQUIRE(*(int *)ulist_get(list, 1) == 3);
+                REQUIRE(*(int *)ulist_get(list, 2) == 4);
+            }
+
+            THEN("範囲外の位置は失敗すること") {
+                errno = 0;
+                REQUIRE(ulist_get(list, 5) == NULL);
+                REQUIRE(errno == EINVAL);
+                REQUIRE(ulist_remove(list, 5) == -1);
+                REQUIRE(ulist_insert(list, 6, &a) == NULL);
+            }
+
+            THEN("消去すると空になること") {
+                REQUIRE(ulist_clear(list) == 0);
+                REQUIRE(ulist_count(list) == 0);
+                REQUIRE(ulist_get(list, 0) == NULL);
+            }
+        }
+
+        ulist_release(list);
+    }
+}
+
+static int sum_ulist(void *payload, void *ctx)
+{
+    *(long *)ctx += *(int *)payload;
+    return 0;
+}
+
+SCENARIO("展開リストが無作為な操作で配列と一致すること", "[ulist][random]") {
+    GIVEN("展開リストを容量 10000 で初期化しておく") {
+        const size_t capacity = 10000;
+        ULIST list = ulist_init(sizeof(int), capacity);
+        std::vector<int> expected;
+        std::mt19937 rng(48);
+
+        WHEN("挿入と削除を無作為な位置に繰り返す") {
+            bool matched = true;
+            for (int n = 0; n < 40000; ++n) {
+                bool insert = (expected.size() < capacity) &&
+                              (expected.empty() || (rng() % 3 != 0));
+                if (insert) {
+                    size_t pos = rng() % (expected.size() + 1);
+                    int value = n;
+                    void *p = ulist_insert(list, pos, &value);
+                    matched = matched && (p != NULL) && (*(int *)p == value);
+                    expected.insert(expected.begin() + pos, value);
+                } else {
+                    size_t pos = rng() % expected.size();
+                    matched = matched && (ulist_remove(list, pos) == 0);
+                    expected.erase(expected.begin() + pos);
+                }
+            }
+            REQUIRE(matched);
+
+            THEN("位置毎の値が配列と一致すること") {
+                REQUIRE(ulist_count(list) == (ssize_t)expected.size());
+                std::vector<int> actual;
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    actual.push_back(*(int *)ulist_get(list, i));
+                }
+                REQUIRE(actual == expected);
+            }
+
+            THEN("走査で全要素を辿れること") {
+                long sum = 0;
+                long expected_sum = 0;
+                for (int v : expected) {
+                    expected_sum += v;
+                }
+                REQUIRE(ulist_walk(list, sum_ulist, &sum) == 0);
+                REQUIRE(sum == expected_sum);
+            }
+        }
+
+        WHEN("満杯まで先頭に追加する") {
+            bool added = true;
+            for (size_t i = 0; i < capacity; ++i) {
+                int value = (int)i;
+                added = added && (ulist_insert(list, 0, &value) != NULL);
+            }
+            REQUIRE(added);
+
+            THEN("逆順に取得できること") {
+                bool ordered = true;
+                for (size_t i = 0; i < capacity; ++i) {
+                    ordered = ordered && (*(int *)ulist_get(list, i) == (int)(capacity - 1 - i));
+                }
+                REQUIRE(ordered);
+            }
+        }
+
+        ulist_release(list);
+    }
+}
+
+SCENARIO("並行キューに要素を出し入れできること", "[cqueue][enq]") {
+    for (auto mode : {CQUEUE_SPSC, CQUEUE_MPMC}) {
+        GIVEN(std::string("並行キューを容量 4 で初期化しておく (") + ((mode == CQUEUE_SPSC) ? "SPSC" : "MPMC") + ")") {
+            CQUEUE que = cqueue_init(sizeof(int), 4, mode);
+            REQUIRE(que != NULL);
+
+            WHEN("容量まで積める") {
+                for (int i = 0; i < 4; ++i) {
+                    REQUIRE(cqueue_enq(que, &i) == 0);
+                }
+
+                THEN("それ以上は積めないこと") {
+                    int a = 4;
+                    errno = 0;
+                    REQUIRE(cqueue_enq(que, &a) == -1);
+                    REQUIRE(errno == ENOMEM);
+                    REQUIRE(cqueue_count(que) == 4);
+                }
+
+                THEN("積めた順に取り出せること") {
+                    int a;
+                    for (int i = 0; i < 4; ++i) {
+                        REQUIRE(cqueue_deq(que, &a) == 0);
+                        REQUIRE(a == i);
+                    }
+                    errno = 0;
+                    REQUIRE(cqueue_deq(que, &a) == -1);
+                    REQUIRE(errno == EAGAIN);
+                    REQUIRE(cqueue_count(que) == 0);
+                }
+            }
+
+            WHEN("折り返しをまたいでまとめて出し入れする") {
+                int in[6] = {0, 1, 2, 3, 4, 5};
+                int out[6] = {};
+                REQUIRE(cqueue_enq_bulk(que, in, 3) == 3);
+                REQUIRE(cqueue_deq_bulk(que, out, 2) == 2);
+                REQUIRE(cqueue_enq_bulk(que, &in[3], 3) == 3);
+
+                THEN("空きの分だけ積めて, 積めた順に取り出せること") {
+                    REQUIRE(cqueue_enq_bulk(que, in, 6) == 0);
+                    REQUIRE(cqueue_deq_bulk(que, &out[2], 6) == 4);
+                    REQUIRE(std::vector<int>(out, out + 6) == std::vector<int>{0, 1, 2, 3, 4, 5});
+                }
+            }
+
+            cqueue_release(que);
+        }
+    }
+
+    GIVEN("特になし") {
+        WHEN("不正な引数で初期化する") {
+            THEN("失敗すること") {
+                errno = 0;
+                REQUIRE(cqueue_init(0, 4, CQUEUE_SPSC) == NULL);
+                REQUIRE(errno == EINVAL);
+                REQUIRE(cqueue_init(sizeof(int), 0, CQUEUE_MPMC) == NULL);
+                REQUIRE(cqueue_init(sizeof(int), 4, (enum cqueue_mode)2) == NULL);
+            }
+
+            THEN("要素の合計サイズが桁溢れすると失敗すること") {
+                errno = 0;
+                REQUIRE(cqueue_init(SIZE_MAX - 4, 1, CQUEUE_MPMC) == NULL);
+                REQUIRE(errno == EINVAL);
+                errno = 0;
+                REQUIRE(cqueue_init((size_t)1 << 40, (size_t)1 << 30, CQUEUE_SPSC) == NULL);
+                REQUIRE(errno == EINVAL);
+                errno = 0;
+                REQUIRE(cqueue_init(1, SIZE_MAX, CQUEUE_SPSC) == NULL);
+                REQUIRE(errno == EINVAL);
+            }
+        }
+    }
+}
+
+/**
+ *  並行キューの負荷試験で受け渡す要素.
+ */
+struct cqueue_item {
+    uint32_t producer;
+    uint32_t seq;
+};
+
+SCENARIO("並行キューを複数のスレッドから使えること", "[cqueue][stress]") {
+    const uint32_t per_producer = 50000;
+
+    GIVEN("単一生産者/単一消費者の並行キュー") {
+        CQUEUE que = cqueue_init(sizeof(cqueue_item), 64, CQUEUE_SPSC);
+
+        WHEN("1 スレッドが積め, 別の 1 スレッドが取り出す") {
+            bool ordered = true;
+            std::thread consumer([&]() {
+                cqueue_item items[16];
+                uint32_t expected = 0;
+                while (expected < per_producer) {
+                    ssize_t n = cqueue_deq_bulk(que, items, (expected % 3 == 0) ? 16 : 1);
+                    if (n == 0) {
+                        std::this_thread::yield();
+                    }
+                    for (ssize_t i = 0; i < n; ++i) {
+                        ordered = ordered && (items[i].seq == expected++);
+                    }
+                }
+            });
+            for (uint32_t i = 0; i < per_producer; ++i) {
+                cqueue_item item = {0, i};
+                while (cqueue_enq(que, &item) != 0) {
+                    std::this_thread::yield();
+                }
+            }
+            consumer.join();
+
+            THEN("積めた順にすべて取り出せること") {
+                REQUIRE(ordered);
+                REQUIRE(cqueue_count(que) == 0);
+            }
+        }
+
+        cqueue_release(que);
+    }
+
+    GIVEN("複数生産者/複数消費者の並行キュー") {
+        const uint32_t producers = 4;
+        const uint32_t consumers = 4;
+        CQUEUE que = cqueue_init(sizeof(cqueue_item), 256, CQUEUE_MPMC);
+
+        WHEN("4 スレッドが積め, 別の 4 スレッドが取り出す") {
+            std::vector<std::vector<uint32_t>> received(producers * consumers);
+            std::vector<std::thread> threads;
+            std::atomic<uint32_t> remaining(producers * per_producer);
+
+            for (uint32_t c = 0; c < consumers; ++c) {
+                threads.emplace_back([&, c]() {
+                    cqueue_item item;
+                    while (remaining.load() > 0) {
+                        if (cqueue_deq(que, &item) == 0) {
+                            received[(c * producers) + item.producer].push_back(item.seq);
+                            --remaining;
+                        } else {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            }
+            for (uint32_t p = 0; p < producers; ++p) {
+                threads.emplace_back([&, p]() {
+                    for (uint32_t i = 0; i < per_producer; ++i) {
+                        cqueue_item item = {p, i};
+                        while (cqueue_enq(que, &item) != 0) {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            }
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+
+            THEN("すべての要素を 1 度ずつ, 生産者毎には積めた順に取り出せること") {
+                bool ordered = true;
+                std::vector<uint32_t> seen(producers, 0);
+                for (uint32_t c = 0; c < consumers; ++c) {
+                    for (uint32_t p = 0; p < producers; ++p) {
+                        const std::vector<uint32_t> &seqs = received[(c * producers) + p];
+                        for (size_t i = 1; i < seqs.size(); ++i) {
+                            ordered = ordered && (seqs[i - 1] < seqs[i]);
+                        }
+                        seen[p] += (uint32_t)seqs.size();
+                    }
+                }
+                REQUIRE(ordered);
+                REQUIRE(seen == std::vector<uint32_t>(producers, per_producer));
+
+                std::vector<uint64_t> sums(producers, 0);
+                for (uint32_t c = 0; c < consumers; ++c) {
+                    for (uint32_t p = 0; p < producers; ++p) {
+                        for (uint32_t seq : received[(c * producers) + p]) {
+                            sums[p] += seq;
+                        }
+                    }
+                }
+                REQUIRE(sums == std::vector<uint64_t>(producers, (uint64_t)per_producer * (per_producer - 1) / 2));
+                REQUIRE(cqueue_count(que) == 0);
+            }
+        }
+
+        cqueue_release(que);
+    }
+}
+
+static int collect_map(const void *key, void *value, void *ctx)
+{
+    auto entries = static_cast<std::map<int, long> *>(ctx);
+    (*entries)[*(const int *)key] = *(long *)value;
+    return 0;
+}
+
+SCENARIO("マップにキーと値を対応付けられること", "[map][put]") {
+    GIVEN("マップを容量 4 で初期化しておく") {
+        MAP map = map_init(sizeof(int), sizeof(long), 4);
+        REQUIRE(map != NULL);
+
+        WHEN("キーと値を 3 つ追加する") {
+            for (int k = 1; k <= 3; ++k) {
+                long v = k * 10;
+                REQUIRE(*(long *)map_put(map, &k, &v) == v);
+            }
+
+            THEN("キーで値を取得できること") {
+                REQUIRE(map_count(map) == 3);
+                for (int k = 1; k <= 3; ++k) {
+                    REQUIRE(*(long *)map_get(map, &k) == k * 10);
+                }
+                int k = 4;
+                errno = 0;
+                REQUIRE(map_get(map, &k) == NULL);
+                REQUIRE(errno == ENOENT);
+            }
+
+            THEN("同じキーは値が上書きされること") {
+                int k = 2;
+                long v = 200;
+                REQUIRE(*(long *)map_put(map, &k, &v) == 200);
+                REQUIRE(map_count(map) == 3);
+                REQUIRE(*(long *)map_get(map, &k) == 200);
+            }
+
+            THEN("容量を超えて追加できないこと") {
+                int k = 4;
+                long v = 40;
+                REQUIRE(map_put(map, &k, &v) != NULL);
+                k = 5;
+                errno = 0;
+                REQUIRE(map_put(map, &k, &v) == NULL);
+                REQUIRE(errno == ENOMEM);
+            }
+
+            THEN("キーを削除できること") {
+                int k = 1;
+                REQUIRE(map_remove(map, &k) == 0);
+                REQUIRE(map_get(map, &k) == NULL);
+                errno = 0;
+                REQUIRE(map_remove(map, &k) == -1);
+                REQUIRE(errno == ENOENT);
+                k = 3;
+                REQUIRE(*(long *)map_get(map, &k) == 30);
+                REQUIRE(map_count(map) == 2);
+            }
+
+            THEN("走査ですべてのキーと値を辿れること") {
+                std::map<int, long> entries;
+                REQUIRE(map_walk(map, collect_map, &entries) == 0);
+                REQUIRE(entries == std::map<int, long>{{1, 10}, {2, 20}, {3, 30}});
+            }
+
+            THEN("消去すると空になること") {
+                REQUIRE(map_clear(map) == 0);
+                REQUIRE(map_count(map) == 0);
+                int k = 1;
+                REQUIRE(map_get(map, &k) == NULL);
+            }
+        }
+
+        map_release(map);
+    }
+
+    GIVEN("キーが 3 バイトで値が 8 バイトのマップ") {
+        MAP map = map_init(3, sizeof(uint64_t), 8);
+
+        THEN("値が 8 バイト境界に置かれること") {
+            const char key[3] = {'a', 'b', 'c'};
+            uint64_t v = 1;
+            void *value = map_put(map, key, &v);
+            REQUIRE(value != NULL);
+            REQUIRE(((uintptr_t)value % alignof(uint64_t)) == 0);
+            REQUIRE(map_get(map, key) == value);
+        }
+
+        map_release(map);
+    }
+
+    GIVEN("特になし") {
+        THEN("不正な引数で初期化すると失敗すること") {
+            errno = 0;
+            REQUIRE(map_init(0, sizeof(int), 4) == NULL);
+            REQUIRE(errno == EINVAL);
+            REQUIRE(map_init(sizeof(int), 0, 4) == NULL);
+            REQUIRE(map_init(sizeof(int), sizeof(int), 0) == NULL);
+        }
+
+        THEN("キーと値を合わせたサイズが桁溢れすると失敗すること") {
+            errno = 0;
+            REQUIRE(map_init(SIZE_MAX / 2, SIZE_MAX / 2, 1) == NULL);
+            REQUIRE(errno == EINVAL);
+            errno = 0;
+            REQUIRE(map_init(1, SIZE_MAX - 8, 1) == NULL);
+            REQUIRE(errno == EINVAL);
+        }
+    }
+}
+
+SCENARIO("マップが無作為な操作で std::map と一致すること", "[map][random]") {
+    GIVEN("マップを容量 2000 で初期化しておく") {
+        const size_t capacity = 2000;
+        MAP map = map_init(sizeof(int), sizeof(long), capacity);
+        std::map<int, long> expected;
+        std::mt19937 rng(50);
+
+        WHEN("追加, 上書き, 削除を無作為に繰り返す") {
+            bool matched = true;
+            for (int n = 0; n < 50000; ++n) {
+                int key = (int)(rng() % 4000);
+                long value = n;
+                if ((rng() % 3) != 0) {
+                    if ((expected.size() < capacity) || (expected.count(key) > 0)) {
+                        void *p = map_put(map, &key, &value);
+                        matched = matched && (p != NULL) && (*(long *)p == value);
+                        expected[key] = value;
+                    }
+                } else {
+                    int ret = map_remove(map, &key);
+                    matched = matched && (ret == ((expected.erase(key) > 0) ? 0 : -1));
+                }
+            }
+            REQUIRE(matched);
+
+            THEN("すべてのキーの値が一致すること") {
+                REQUIRE(map_count(map) == (ssize_t)expected.size());
+                std::map<int, long> entries;
+                REQUIRE(map_walk(map, collect_map, &entries) == 0);
+                REQUIRE(entries == expected);
+                bool found = true;
+                for (int key = 0; key < 4000; ++key) {
+                    long *value = (long *)map_get(map, &key);
+                    auto it = expected.find(key);
+                    found = found && ((it == expected.end()) ? (value == NULL) : ((value != NULL) && (*value == it->second)));
+                }
+                REQUIRE(found);
+            }
+        }
+
+        map_release(map);
+    }
+}
+
+SCENARIO("並行マップを複数のスレッドから使えること", "[cmap][stress]") {
+    GIVEN("並行マップを容量 20000 で初期化しておく") {
+        const int writers = 4;
+        const int per_writer = 5000;
+        CMAP cmap = cmap_init(sizeof(int), sizeof(long), writers * per_writer);
+        REQUIRE(cmap != NULL);
+
+        WHEN("単一のスレッドで操作する") {
+            int k = 7;
+            long v = 70;
+            REQUIRE(cmap_put(cmap, &k, &v) == 0);
+            v = 0;
+            REQUIRE(cmap_get(cmap, &k, &v) == 0);
+            REQUIRE(v == 70);
+            REQUIRE(cmap_count(cmap) == 1);
+            REQUIRE(cmap_remove(cmap, &k) == 0);
+            errno = 0;
+            REQUIRE(cmap_get(cmap, &k, &v) == -1);
+            REQUIRE(errno == ENOENT);
+        }
+
+        WHEN("4 スレッドが書き込み, 別の 4 スレッドが読み込む") {
+            std::atomic<bool> done(false);
+            std::atomic<int> inconsistent(0);
+            std::atomic<int> failed(0);
+            std::vector<std::thread> threads;
+
+            for (int r = 0; r < 4; ++r) {
+                threads.emplace_back([&, r]() {
+                    std::mt19937 rng(r);
+                    while (!done.load()) {
+                        int key = (int)(rng() % (writers * per_writer));
+                        long value;
+                        if ((cmap_get(cmap, &key, &value) == 0) && (value != (long)key * 3) && (value != (long)key * 2)) {
+                            ++inconsistent;
+                        }
+                        std::this_thread::yield();
+                    }
+                });
+            }
+            std::vector<std::thread> writer_threads;
+            for (int w = 0; w < writers; ++w) {
+                writer_threads.emplace_back([&, w]() {
+                    for (int i = 0; i < per_writer; ++i) {
+                        int key = (w * per_writer) + i;
+                        long value = (long)key * 2;
+                        if (cmap_put(cmap, &key, &value) != 0) {
+                            ++failed;
+                        }
+                        value = (long)key * 3;
+                        if (cmap_put(cmap, &key, &value) != 0) {
+                            ++failed;
+                        }
+                        if (((key % 4) == 0) && (cmap_remove(cmap, &key) != 0)) {
+                            ++failed;
+                        }
+                    }
+                });
+            }
+            for (std::thread &thread : writer_threads) {
+                thread.join();
+            }
+            done = true;
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+
+            THEN("読み込んだ値が常に書き込んだ値のいずれかであり, 最後の状態が一致すること") {
+                REQUIRE(failed.load() == 0);
+                REQUIRE(inconsistent.load() == 0);
+                REQUIRE(cmap_count(cmap) == (writers * per_writer) * 3 / 4);
+                bool matched = true;
+                for (int key = 0; key < writers * per_writer; ++key) {
+                    long value = 0;
+                    int ret = cmap_get(cmap, &key, &value);
+                    matched = matched && (((key % 4) == 0) ? (ret == -1) : ((ret == 0) && (value == (long)key * 3)));
+                }
+                REQUIRE(matched);
+            }
+        }
+
+        cmap_release(cmap);
+    }
+
+    GIVEN("並行マップを容量 16 で初期化しておく") {
+        CMAP cmap = cmap_init(sizeof(int), sizeof(long), 16);
+        REQUIRE(cmap != NULL);
+
+        WHEN("容量までキーを追加する") {
+            bool added = true;
+            for (int key = 0; key < 16; ++key) {
+                long value = key;
+                added = added && (cmap_put(cmap, &key, &value) == 0);
+            }
+
+            THEN("すべてのキーを格納できること") {
+                REQUIRE(added);
+                REQUIRE(cmap_count(cmap) == 16);
+            }
+        }
+
+        cmap_release(cmap);
+    }
+}
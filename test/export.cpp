@@ -0,0 +1,167 @@
+/** @file   export.cpp
+ *  @brief  状態遷移定義のグラフ出力のテスト.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ */
+#include <cstdio>
+#include <cerrno>
+#include <string>
+
+#include <catch.hpp>
+
+extern "C" {
+#include "debug.h"
+#include "hfsm.h"
+#include "export.h"
+}
+
+FSM_STATE(state_export_a, NULL, NULL, NULL, NULL);
+FSM_STATE(state_export_a1, NULL, NULL, NULL, NULL);
+FSM_STATE(state_export_a2, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_export_1);
+FSM_EVENT(event_export_2);
+
+FSM_COND(cond_export, (struct fsm *machine))
+{
+    return true;
+}
+
+FSM_ACTION(action_export, (struct fsm *machine))
+{
+}
+
+/**
+ *  文字列に追記する書き込み関数.
+ */
+static int append_writer(void *ctx, const char *buf, size_t len)
+{
+    static_cast<std::string *>(ctx)->append(buf, len);
+    return 0;
+}
+
+/**
+ *  常に失敗する書き込み関数.
+ */
+static int failing_writer(void *ctx, const char *buf, size_t len)
+{
+    errno = ENOSPC;
+    return -1;
+}
+
+/**
+ *  文字列が含まれるかを調べる.
+ */
+static bool contains(const std::string &text, const std::string &part)
+{
+    return text.find(part) != std::string::npos;
+}
+
+SCENARIO("状態遷移定義をグラフとして出力できること", "[export]") {
+    GIVEN("階層, ガード条件, 遷移アクションおよび内部遷移を含む定義を行う") {
+        const struct fsm_rels rels[] = {
+            FSM_RELS_HELPER(state_export_a1, state_export_a, true),
+            FSM_RELS_HELPER(state_export_a2, state_export_a, false),
+            FSM_RELS_TERMINATOR
+        };
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_export_a1),
+            FSM_TRANS_HELPER(state_export_a1, event_export_1, cond_export, action_export, state_export_a2),
+            FSM_TRANS_HELPER(state_export_a, event_export_2, NULL, action_export, NULL),
+            FSM_TRANS_HELPER(state_export_a2, event_export_1, NULL, NULL, state_end),
+            FSM_TRANS_TERMINATOR
+        };
+        std::string text;
+
+        WHEN("DOT 形式で出力する") {
+            REQUIRE(fsm_export_dot(rels, corresps, append_writer, &text) == 0);
+
+            THEN("状態, 階層および遷移が出力されること") {
+                REQUIRE(text.compare(0, 15, "digraph hfsm {\n") == 0);
+                REQUIRE(contains(text, "s0 [label=\"start\"];"));
+                REQUIRE(contains(text, "s2 [label=\"state_export_a\"];"));
+                REQUIRE(contains(text, "s2 -> s1 [style=\"dotted,bold\", arrowhead=none];"));
+                REQUIRE(contains(text, "s2 -> s3 [style=dotted, arrowhead=none];"));
+                REQUIRE(contains(text, "s1 -> s3 [label=\"event_export_1 [cond_export] / action_export\"];"));
+                REQUIRE(contains(text, "s3 -> s4 [label=\"event_export_1\"];"));
+            }
+
+            THEN("内部遷移が破線の自己ループで出力されること") {
+                REQUIRE(contains(text, "s2 -> s2 [label=\"event_export_2 / action_export\", style=dashed];"));
+            }
+        }
+
+        WHEN("JSON 形式で出力する") {
+            REQUIRE(fsm_export_json(rels, corresps, append_writer, &text) == 0);
+
+            THEN("状態, 階層および遷移が出力されること") {
+                REQUIRE(contains(text, "{\"id\": 0, \"name\": \"start\", \"parent\": null, \"default\": null}"));
+                REQUIRE(contains(text, "{\"id\": 1, \"name\": \"state_export_a1\", \"parent\": 2, \"default\": null}"));
+                REQUIRE(contains(text, "{\"id\": 2, \"name\": \"state_export_a\", \"parent\": null, \"default\": 1}"));
+                REQUIRE(contains(text, "{\"from\": 1, \"event\": \"event_export_1\", \"cond\": \"cond_export\", "
+                                       "\"action\": \"action_export\", \"to\": 3}"));
+                REQUIRE(contains(text, "{\"from\": 2, \"event\": \"event_export_2\", \"cond\": null, "
+                                       "\"action\": \"action_export\", \"to\": null}"));
+                REQUIRE(text.compare(text.size() - 7, 7, "\n  ]\n}\n") == 0);
+            }
+        }
+
+        WHEN("ファイルに出力する") {
+            FILE *fp = tmpfile();
+            REQUIRE(fp != NULL);
+            REQUIRE(fsm_export_dot_to_file(rels, corresps, fp) == 0);
+            REQUIRE(fsm_export_dot(rels, corresps, append_writer, &text) == 0);
+
+            THEN("書き込み関数と同じ内容が出力されること") {
+                std::string written(text.size() + 1, '\0');
+                rewind(fp);
+                REQUIRE(fread(&written[0], 1, written.size(), fp) == text.size());
+                written.resize(text.size());
+                REQUIRE(written == text);
+            }
+
+            fclose(fp);
+        }
+
+        WHEN("書き込みに失敗する関数に出力する") {
+            errno = 0;
+            int ret = fsm_export_json(rels, corresps, failing_writer, NULL);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == ENOSPC);
+            }
+        }
+    }
+
+    GIVEN("長い状態名とエスケープが必要な状態名を含む定義を行う") {
+        std::string long_name(2000, 'x');
+        struct fsm_state quoted = FSM_STATE_INITIALIZER("say \"hi\"\\\n");
+        struct fsm_state longer = FSM_STATE_INITIALIZER(long_name.c_str());
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, &quoted),
+            FSM_TRANS_HELPER(&quoted, event_export_1, NULL, NULL, &longer),
+            FSM_TRANS_TERMINATOR
+        };
+        std::string text;
+
+        WHEN("DOT 形式で出力する") {
+            REQUIRE(fsm_export_dot(NULL, corresps, append_writer, &text) == 0);
+
+            THEN("切り詰められずにエスケープされること") {
+                REQUIRE(contains(text, "s1 [label=\"say \\\"hi\\\"\\\\\\n\"];"));
+                REQUIRE(contains(text, "s2 [label=\"" + long_name + "\"];"));
+            }
+        }
+
+        WHEN("JSON 形式で出力する") {
+            REQUIRE(fsm_export_json(NULL, corresps, append_writer, &text) == 0);
+
+            THEN("切り詰められずにエスケープされること") {
+                REQUIRE(contains(text, "\"name\": \"say \\\"hi\\\"\\\\\\n\""));
+                REQUIRE(contains(text, "\"name\": \"" + long_name + "\""));
+            }
+        }
+    }
+}
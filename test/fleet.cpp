@@ -0,0 +1,260 @@
+/** @file   fleet.cpp
+ *  @brief  フリートのテスト.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ */
+#include <cerrno>
+#include <random>
+#include <vector>
+
+#include <catch.hpp>
+
+extern "C" {
+#include "debug.h"
+#include "hfsm.h"
+#include "fleet.h"
+}
+
+/**
+ *  インスタンス毎のコンテキスト.
+ */
+struct fleet_counter {
+    int ticks;      /**< 遷移アクションの回数. */
+    int entries;    /**< 高速状態に入った回数. */
+};
+
+static void fleet_count_entry(struct fsm *machine, void *data, bool cmpl)
+{
+    ++*(int *)data;
+}
+
+FSM_STATE(state_fleet_idle, NULL, NULL, NULL, NULL);
+FSM_STATE(state_fleet_run, NULL, NULL, NULL, NULL);
+FSM_STATE(state_fleet_run_slow, NULL, NULL, NULL, NULL);
+FSM_STATE_SLOT(state_fleet_run_fast, struct fleet_counter, entries, fleet_count_entry, NULL, NULL);
+FSM_STATE(state_fleet_done, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_fleet_go);
+FSM_EVENT(event_fleet_toggle);
+FSM_EVENT(event_fleet_stop);
+FSM_EVENT(event_fleet_tick);
+FSM_EVENT(event_fleet_unknown);
+
+FSM_COND_CTX(cond_fleet_even, (struct fsm *machine, void *ctx))
+{
+    return ((struct fleet_counter *)ctx)->ticks % 2 == 0;
+}
+
+FSM_ACTION_CTX(action_fleet_tick, (struct fsm *machine, void *ctx))
+{
+    ++((struct fleet_counter *)ctx)->ticks;
+}
+
+/**
+ *  状態マシンからコンテキストを参照する entry アクション.
+ */
+static void fleet_count_machine_entry(struct fsm *machine, void *data, bool cmpl)
+{
+    ++((struct fleet_counter *)fsm_get_context(machine))->entries;
+}
+
+FSM_STATE(state_fleet_ctx_idle, NULL, NULL, NULL, NULL);
+FSM_STATE(state_fleet_ctx_busy, NULL, fleet_count_machine_entry, NULL, NULL);
+
+FSM_COND(cond_fleet_ctx_idle, (struct fsm *machine))
+{
+    return fsm_get_current(machine) == state_fleet_ctx_idle;
+}
+
+FSM_ACTION(action_fleet_ctx_tick, (struct fsm *machine))
+{
+    ++((struct fleet_counter *)fsm_get_context(machine))->ticks;
+}
+
+SCENARIO("フリートの各インスタンスが状態マシンと同じ遷移をすること", "[fleet]") {
+    const struct fsm_rels rels[] = {
+        FSM_RELS_HELPER(state_fleet_run_slow, state_fleet_run, true),
+        FSM_RELS_HELPER(state_fleet_run_fast, state_fleet_run, false),
+        FSM_RELS_TERMINATOR
+    };
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_fleet_idle),
+        FSM_TRANS_HELPER(state_fleet_idle, event_fleet_go, NULL, NULL, state_fleet_run_slow),
+        FSM_TRANS_HELPER(state_fleet_idle, event_fleet_tick, NULL, action_fleet_tick, NULL),
+        FSM_TRANS_HELPER(state_fleet_run_slow, event_fleet_toggle, NULL, NULL, state_fleet_run_fast),
+        FSM_TRANS_HELPER(state_fleet_run_fast, event_fleet_toggle, cond_fleet_even, action_fleet_tick, state_fleet_run_slow),
+        FSM_TRANS_HELPER(state_fleet_run, event_fleet_stop, NULL, NULL, state_fleet_done),
+        FSM_TRANS_HELPER(state_fleet_done, event_null, NULL, NULL, state_fleet_idle),
+        FSM_TRANS_TERMINATOR
+    };
+    const struct fsm_event *events[] = {
+        event_fleet_go, event_fleet_toggle, event_fleet_stop, event_fleet_tick, event_fleet_unknown
+    };
+    const size_t count = 1003;
+    const struct fleet_counter initial = {0, 0};
+    std::vector<enum fsm_fleet_kernel> kernels = {FSM_FLEET_SCALAR};
+    {
+        struct fsm_fleet *probe = fsm_fleet_init(rels, corresps, 1, NULL, 0);
+        REQUIRE(probe != NULL);
+        if (fsm_fleet_set_kernel(probe, FSM_FLEET_AVX2) == 0) {
+            kernels.push_back(FSM_FLEET_AVX2);
+        }
+        fsm_fleet_term(probe);
+    }
+
+    for (enum fsm_fleet_kernel kernel : kernels) {
+        GIVEN("同じ定義のフリートと状態マシン群 (方式 " + std::to_string(kernel) + ")") {
+            struct fsm_fleet *fleet = fsm_fleet_init(rels, corresps, count, &initial, sizeof(initial));
+            REQUIRE(fleet != NULL);
+            REQUIRE(fsm_fleet_set_kernel(fleet, kernel) == 0);
+            struct fsm_table *table = fsm_table_compile(corresps, NULL, NULL);
+            REQUIRE(table != NULL);
+            std::vector<struct fsm *> machines;
+            for (size_t i = 0; i < count; ++i) {
+                machines.push_back(fsm_init_context(rels, table, &initial, sizeof(initial)));
+                REQUIRE(machines.back() != NULL);
+            }
+            fsm_table_release(table);
+            std::vector<int32_t> ids;
+            for (const struct fsm_event *event : events) {
+                ids.push_back(fsm_fleet_event_id(fleet, event));
+            }
+
+            WHEN("初期化する") {
+                THEN("全インスタンスが Null 遷移後の状態となること") {
+                    for (size_t i = 0; i < count; ++i) {
+                        REQUIRE(fsm_fleet_get_current(fleet, i) == state_fleet_idle);
+                    }
+                    REQUIRE(ids[4] == -1);
+                }
+            }
+
+            WHEN("インスタンス毎に異なるイベントを繰り返し与える") {
+                std::mt19937 rng(1);
+                std::uniform_int_distribution<size_t> pick(0, 4);
+                std::vector<int32_t> round(count);
+                bool same = true;
+                for (int r = 0; r < 200 && same; ++r) {
+                    for (size_t i = 0; i < count; ++i) {
+                        size_t k = pick(rng);
+                        round[i] = ids[k];
+                        fsm_transition(machines[i], events[k]);
+                    }
+                    REQUIRE(fsm_fleet_dispatch_each(fleet, round.data()) == 0);
+                    for (size_t i = 0; i < count; ++i) {
+                        same = same && (fsm_fleet_get_current(fleet, i) == fsm_get_current(machines[i]));
+                    }
+                }
+
+                THEN("状態とコンテキストが状態マシンと一致すること") {
+                    REQUIRE(same);
+                    for (size_t i = 0; i < count; ++i) {
+                        struct fleet_counter *lhs = (struct fleet_counter *)fsm_fleet_get_context(fleet, i);
+                        struct fleet_counter *rhs = (struct fleet_counter *)fsm_get_context(machines[i]);
+                        REQUIRE(lhs->ticks == rhs->ticks);
+                        REQUIRE(lhs->entries == rhs->entries);
+                    }
+                }
+            }
+
+            WHEN("全インスタンスに同じイベントを与える") {
+                fsm_fleet_dispatch(fleet, event_fleet_tick);
+                fsm_fleet_dispatch(fleet, event_fleet_go);
+                fsm_fleet_dispatch(fleet, event_fleet_toggle);
+                fsm_fleet_dispatch(fleet, event_fleet_unknown);
+                fsm_fleet_dispatch(fleet, event_fleet_toggle);
+
+                THEN("ガード条件と遷移アクションがインスタンス毎に処理されること") {
+                    for (size_t i = 0; i < count; ++i) {
+                        struct fleet_counter *counter = (struct fleet_counter *)fsm_fleet_get_context(fleet, i);
+                        REQUIRE(fsm_fleet_get_current(fleet, i) == state_fleet_run_fast);
+                        REQUIRE(counter->ticks == 1);
+                        REQUIRE(counter->entries == 1);
+                    }
+                }
+            }
+
+            WHEN("子状態から親状態の遷移と Null 遷移を経る") {
+                fsm_fleet_dispatch(fleet, event_fleet_go);
+                fsm_fleet_dispatch(fleet, event_fleet_stop);
+
+                THEN("元の状態に戻ること") {
+                    REQUIRE(fsm_fleet_get_current(fleet, 0) == state_fleet_idle);
+                    REQUIRE(fsm_fleet_get_current(fleet, count - 1) == state_fleet_idle);
+                }
+            }
+
+            for (struct fsm *machine : machines) {
+                fsm_term(machine);
+            }
+            fsm_fleet_term(fleet);
+        }
+    }
+
+    GIVEN("子を持つ状態への遷移を含む定義") {
+        const struct fsm_trans composite[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_fleet_idle),
+            FSM_TRANS_HELPER(state_fleet_idle, event_fleet_go, NULL, NULL, state_fleet_run),
+            FSM_TRANS_TERMINATOR
+        };
+
+        WHEN("フリートを初期化する") {
+            errno = 0;
+            struct fsm_fleet *fleet = fsm_fleet_init(rels, composite, 10, NULL, 0);
+
+            THEN("扱えないためエラーとなること") {
+                REQUIRE(fleet == NULL);
+                REQUIRE(errno == ENOTSUP);
+            }
+        }
+
+        WHEN("インスタンスの数を 0 とする") {
+            errno = 0;
+            struct fsm_fleet *fleet = fsm_fleet_init(rels, corresps, 0, NULL, 0);
+
+            THEN("エラーとなること") {
+                REQUIRE(fleet == NULL);
+                REQUIRE(errno == EINVAL);
+            }
+        }
+    }
+}
+
+SCENARIO("フリートのコールバックが状態マシンからインスタンスのコンテキストを参照できること", "[fleet]") {
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_fleet_ctx_idle),
+        FSM_TRANS_HELPER(state_fleet_ctx_idle, event_fleet_go, cond_fleet_ctx_idle, action_fleet_ctx_tick, state_fleet_ctx_busy),
+        FSM_TRANS_HELPER(state_fleet_ctx_busy, event_fleet_stop, NULL, action_fleet_ctx_tick, state_fleet_ctx_idle),
+        FSM_TRANS_TERMINATOR
+    };
+    const size_t count = 37;
+
+    GIVEN("コンテキストを持つフリート") {
+        struct fsm_fleet *fleet = fsm_fleet_init(NULL, corresps, count, NULL, sizeof(struct fleet_counter));
+        REQUIRE(fleet != NULL);
+
+        WHEN("インスタンス毎に異なる回数だけイベントを与える") {
+            std::vector<int32_t> round(count);
+            int32_t go = fsm_fleet_event_id(fleet, event_fleet_go);
+            int32_t stop = fsm_fleet_event_id(fleet, event_fleet_stop);
+            for (size_t r = 0; r < count; ++r) {
+                for (size_t i = 0; i < count; ++i) {
+                    round[i] = (r < i) ? ((r % 2 == 0) ? go : stop) : -1;
+                }
+                REQUIRE(fsm_fleet_dispatch_each(fleet, round.data()) == 0);
+            }
+
+            THEN("各インスタンスのコンテキストがそれぞれの回数を数えていること") {
+                for (size_t i = 0; i < count; ++i) {
+                    struct fleet_counter *counter = (struct fleet_counter *)fsm_fleet_get_context(fleet, i);
+                    REQUIRE(counter->ticks == (int)i);
+                    REQUIRE(counter->entries == (int)(i + 1) / 2);
+                    REQUIRE(fsm_fleet_get_current(fleet, i) == ((i % 2 == 0) ? state_fleet_ctx_idle : state_fleet_ctx_busy));
+                }
+            }
+        }
+
+        fsm_fleet_term(fleet);
+    }
+}
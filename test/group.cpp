@@ -0,0 +1,145 @@
+/** @file   group.cpp
+ *  @brief  状態マシンのグループへの一斉配信のテスト.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ */
+#include <cerrno>
+#include <vector>
+
+#include <catch.hpp>
+
+extern "C" {
+#include "debug.h"
+#include "hfsm.h"
+#include "group.h"
+}
+
+#if OBSERVER
+FSM_STATE(state_group_idle, NULL, NULL, NULL, NULL);
+FSM_STATE(state_group_active, NULL, NULL, NULL, NULL);
+FSM_STATE(state_group_active_1, NULL, NULL, NULL, NULL);
+FSM_STATE(state_group_done, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_group_start);
+FSM_EVENT(event_group_step);
+FSM_EVENT(event_group_shutdown);
+FSM_EVENT(event_group_unknown);
+
+static int group_steps = 0;
+FSM_ACTION(action_group_step, (struct fsm *machine))
+{
+    ++group_steps;
+}
+
+SCENARIO("イベントを処理できる状態マシンにのみ一斉配信されること", "[group]") {
+    const struct fsm_rels rels[] = {
+        FSM_RELS_HELPER(state_group_active_1, state_group_active, true),
+        FSM_RELS_TERMINATOR
+    };
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_group_idle),
+        FSM_TRANS_HELPER(state_group_idle, event_group_start, NULL, NULL, state_group_active_1),
+        FSM_TRANS_HELPER(state_group_active_1, event_group_step, NULL, action_group_step, NULL),
+        FSM_TRANS_HELPER(state_group_active, event_group_shutdown, NULL, NULL, state_group_done),
+        FSM_TRANS_TERMINATOR
+    };
+
+    GIVEN("10 の状態マシンが参加したグループ") {
+        struct fsm_group *group = fsm_group_init(rels, corresps);
+        std::vector<struct fsm *> machines;
+        REQUIRE(group != NULL);
+        for (int i = 0; i < 10; ++i) {
+            machines.push_back(fsm_init(rels, corresps));
+            REQUIRE(machines.back() != NULL);
+            REQUIRE(fsm_group_join(group, machines.back()) == 0);
+        }
+        group_steps = 0;
+
+        WHEN("参加した時点で購読者を数える") {
+            THEN("現在の状態で処理できるイベントのみ購読していること") {
+                REQUIRE(fsm_group_subscribers(group, event_group_start) == 10);
+                REQUIRE(fsm_group_subscribers(group, event_group_step) == 0);
+                REQUIRE(fsm_group_subscribers(group, event_group_shutdown) == 0);
+                REQUIRE(fsm_group_subscribers(group, event_group_unknown) == 0);
+            }
+        }
+
+        WHEN("一部の状態マシンを個別に遷移させる") {
+            for (int i = 0; i < 3; ++i) {
+                fsm_transition(machines[i], event_group_start);
+            }
+
+            THEN("遷移先とその祖先で処理できるイベントに購読が移ること") {
+                REQUIRE(fsm_group_subscribers(group, event_group_start) == 7);
+                REQUIRE(fsm_group_subscribers(group, event_group_step) == 3);
+                REQUIRE(fsm_group_subscribers(group, event_group_shutdown) == 3);
+            }
+        }
+
+        WHEN("処理できる状態マシンが一部のイベントを一斉配信する") {
+            for (int i = 0; i < 3; ++i) {
+                fsm_transition(machines[i], event_group_start);
+            }
+            ssize_t steps = fsm_group_broadcast(group, event_group_step);
+            ssize_t shutdowns = fsm_group_broadcast(group, event_group_shutdown);
+
+            THEN("処理できる状態マシンにのみ配信されること") {
+                REQUIRE(steps == 3);
+                REQUIRE(group_steps == 3);
+                REQUIRE(shutdowns == 3);
+                for (int i = 0; i < 10; ++i) {
+                    REQUIRE(fsm_get_current(machines[i])
+                            == ((i < 3) ? state_group_done : state_group_idle));
+                }
+                REQUIRE(fsm_group_subscribers(group, event_group_shutdown) == 0);
+                REQUIRE(fsm_group_subscribers(group, event_group_start) == 7);
+            }
+        }
+
+        WHEN("配信で状態が変わる") {
+            ssize_t starts = fsm_group_broadcast(group, event_group_start);
+            ssize_t again = fsm_group_broadcast(group, event_group_start);
+            ssize_t steps = fsm_group_broadcast(group, event_group_step);
+
+            THEN("次の配信では新しい状態の購読が用いられること") {
+                REQUIRE(starts == 10);
+                REQUIRE(again == 0);
+                REQUIRE(steps == 10);
+                REQUIRE(group_steps == 10);
+            }
+        }
+
+        WHEN("状態マシンをグループから外す") {
+            REQUIRE(fsm_group_leave(group, machines[0]) == 0);
+            fsm_transition(machines[1], event_group_start);
+            REQUIRE(fsm_group_leave(group, machines[1]) == 0);
+
+            THEN("購読から除かれること") {
+                REQUIRE(fsm_group_subscribers(group, event_group_start) == 8);
+                REQUIRE(fsm_group_subscribers(group, event_group_step) == 0);
+                REQUIRE(fsm_group_broadcast(group, event_group_start) == 8);
+                REQUIRE(fsm_get_current(machines[0]) == state_group_idle);
+                errno = 0;
+                REQUIRE(fsm_group_leave(group, machines[0]) == -1);
+                REQUIRE(errno == ENOENT);
+            }
+        }
+
+        WHEN("同じ状態マシンを再度参加させる") {
+            errno = 0;
+            int ret = fsm_group_join(group, machines[0]);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == EEXIST);
+            }
+        }
+
+        fsm_group_term(group);
+        for (struct fsm *machine : machines) {
+            fsm_term(machine);
+        }
+    }
+}
+#endif
@@ -5,6 +5,13 @@
  *  @date   2018-03-18 新規作成.
  */
 #include <cstdio>
+#include <cerrno>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <catch.hpp>
 
@@ -434,3 +441,877 @@ SCENARIO("状態遷移の定義をダンプする", "[fsm][dump]") {
         fsm_term(machine);
     }
 }
+
+/**
+ *  オブザーバの呼び出し記録.
+ */
+static void record(void *ctx, const std::string &what)
+{
+    static_cast<std::vector<std::string> *>(ctx)->push_back(what);
+}
+
+static void observe_event(struct fsm *machine, const struct fsm_event *event, void *ctx)
+{
+    record(ctx, std::string("event:") + event->name);
+}
+
+static void observe_guard(struct fsm *machine, const struct fsm_trans *trans, bool passed, void *ctx)
+{
+    record(ctx, std::string("guard:") + trans->cond->name + (passed ? ":true" : ":false"));
+}
+
+static void observe_trans(struct fsm *machine, const struct fsm_trans *trans, void *ctx)
+{
+    record(ctx, std::string("trans:") + trans->from->name + ":" + trans->event->name);
+}
+
+static void observe_exit(struct fsm *machine, const struct fsm_state *state, void *ctx)
+{
+    record(ctx, std::string("exit:") + state->name);
+}
+
+static void observe_entry(struct fsm *machine, const struct fsm_state *state, void *ctx)
+{
+    record(ctx, std::string("entry:") + state->name);
+}
+
+static void observe_unhandled(struct fsm *machine, const struct fsm_event *event, void *ctx)
+{
+    record(ctx, std::string("unhandled:") + event->name);
+}
+
+SCENARIO("オブザーバに処理が通知されること", "[fsm][observer]") {
+    GIVEN("ガード条件, 内部遷移を含む定義を行う") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_root_with_no_handler),
+            FSM_TRANS_HELPER(state_root_with_no_handler, event_1, cond_only_cond, NULL, state_root_with_no_handler2),
+            FSM_TRANS_HELPER(state_root_with_no_handler, event_1, NULL, NULL, state_root_with_no_handler3),
+            FSM_TRANS_HELPER(state_root_with_no_handler3, event_2, NULL, action_only_action, NULL),
+            FSM_TRANS_TERMINATOR
+        };
+        std::vector<std::string> records;
+        struct fsm_observer observer = FSM_OBSERVER_HELPER(observe_event,
+                                                           observe_guard,
+                                                           observe_trans,
+                                                           observe_exit,
+                                                           observe_entry,
+                                                           observe_unhandled,
+                                                           &records);
+        struct fsm *machine = fsm_init(NULL, corresps);
+        REQUIRE(machine != NULL);
+
+#if OBSERVER
+        REQUIRE(fsm_add_observer(machine, &observer) == 0);
+
+        WHEN("ガード条件を満たさない遷移の後に別の遷移を行う") {
+            cond_only_param = false;
+            fsm_transition(machine, event_1);
+
+            THEN("ガード条件の評価, 遷移, 出状および入状が順に通知されること") {
+                REQUIRE(records.size() == 5);
+                REQUIRE(records[0] == "event:event_1");
+                REQUIRE(records[1] == "guard:cond_only_cond:false");
+                REQUIRE(records[2] == "trans:state_root_with_no_handler:event_1");
+                REQUIRE(records[3] == "exit:state_root_with_no_handler");
+                REQUIRE(records[4] == "entry:state_root_with_no_handler3");
+            }
+        }
+
+        WHEN("内部遷移と対応のないイベントを発生させる") {
+            cond_only_param = false;
+            fsm_transition(machine, event_1);
+            records.clear();
+            fsm_transition(machine, event_2);
+            fsm_transition(machine, event_3);
+
+            THEN("内部遷移では出状および入状が通知されないこと") {
+                REQUIRE(records.size() == 4);
+                REQUIRE(records[0] == "event:event_2");
+                REQUIRE(records[1] == "trans:state_root_with_no_handler3:event_2");
+            }
+
+            THEN("対応のないイベントが通知されること") {
+                REQUIRE(records[2] == "event:event_3");
+                REQUIRE(records[3] == "unhandled:event_3");
+            }
+        }
+
+        WHEN("オブザーバの登録を解除する") {
+            REQUIRE(fsm_remove_observer(machine, &observer) == 0);
+            fsm_transition(machine, event_3);
+
+            THEN("通知されないこと") {
+                REQUIRE(records.empty());
+            }
+
+            THEN("再度の解除はエラーとなること") {
+                errno = 0;
+                REQUIRE(fsm_remove_observer(machine, &observer) == -1);
+                REQUIRE(errno == ENOENT);
+            }
+        }
+
+        WHEN("同じオブザーバを再度登録する") {
+            errno = 0;
+            int ret = fsm_add_observer(machine, &observer);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == EEXIST);
+            }
+        }
+
+        fsm_remove_observer(machine, &observer);
+#else
+        WHEN("オブザーバを登録する") {
+            errno = 0;
+            int ret = fsm_add_observer(machine, &observer);
+
+            THEN("未対応のエラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == ENOTSUP);
+            }
+        }
+#endif
+
+        fsm_term(machine);
+    }
+}
+
+/**
+ *  優先度付きキューの処理順の記録.
+ */
+static std::vector<int> dispatched;
+
+FSM_ACTION(action_record_1, (struct fsm *machine))
+{
+    dispatched.push_back(1);
+}
+
+FSM_ACTION(action_record_2, (struct fsm *machine))
+{
+    dispatched.push_back(2);
+}
+
+FSM_ACTION(action_record_3, (struct fsm *machine))
+{
+    dispatched.push_back(3);
+}
+
+SCENARIO("優先度の高いイベントから処理されること", "[fsm][priority]") {
+    GIVEN("イベント毎に処理を記録する内部遷移を定義する") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_root_with_no_handler5),
+            FSM_TRANS_HELPER(state_root_with_no_handler5, event_1, NULL, action_record_1, NULL),
+            FSM_TRANS_HELPER(state_root_with_no_handler5, event_2, NULL, action_record_2, NULL),
+            FSM_TRANS_HELPER(state_root_with_no_handler5, event_3, NULL, action_record_3, NULL),
+            FSM_TRANS_TERMINATOR
+        };
+        struct fsm *machine = fsm_init(NULL, corresps);
+        REQUIRE(machine != NULL);
+        dispatched.clear();
+
+        WHEN("異なる優先度でイベントを積む") {
+            REQUIRE(fsm_post(machine, event_1, FSM_PRIORITY_LOW) == 0);
+            REQUIRE(fsm_post(machine, event_2, FSM_PRIORITY_LOW) == 0);
+            REQUIRE(fsm_post(machine, event_2, FSM_PRIORITY_NORMAL) == 0);
+            REQUIRE(fsm_post(machine, event_3, FSM_PRIORITY_URGENT) == 0);
+
+            THEN("積まれたイベントの数が 4 であること") {
+                REQUIRE(fsm_pending(machine) == 4);
+            }
+
+            THEN("優先度の高い順, 同じ優先度は積んだ順に処理されること") {
+                while (fsm_dispatch(machine) > 0) {
+                }
+                REQUIRE(dispatched.size() == 4);
+                REQUIRE(dispatched[0] == 3);
+                REQUIRE(dispatched[1] == 2);
+                REQUIRE(dispatched[2] == 1);
+                REQUIRE(dispatched[3] == 2);
+                REQUIRE(fsm_pending(machine) == 0);
+            }
+
+            THEN("処理の途中で積んだ緊急のイベントが先に処理されること") {
+                REQUIRE(fsm_dispatch(machine) == 1);
+                REQUIRE(fsm_post(machine, event_3, FSM_PRIORITY_URGENT) == 0);
+                REQUIRE(fsm_dispatch(machine) == 1);
+                REQUIRE(dispatched.size() == 2);
+                REQUIRE(dispatched[0] == 3);
+                REQUIRE(dispatched[1] == 3);
+            }
+
+            THEN("イベントが積まれている間は容量を変更できないこと") {
+                errno = 0;
+                REQUIRE(fsm_set_queue_capacity(machine, 8) == -1);
+                REQUIRE(errno == EBUSY);
+            }
+        }
+
+        WHEN("容量を超えてイベントを積む") {
+            REQUIRE(fsm_set_queue_capacity(machine, 2) == 0);
+            REQUIRE(fsm_post(machine, event_1, FSM_PRIORITY_LOW) == 0);
+            REQUIRE(fsm_post(machine, event_1, FSM_PRIORITY_LOW) == 0);
+            errno = 0;
+            int ret = fsm_post(machine, event_1, FSM_PRIORITY_LOW);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == ENOBUFS);
+            }
+
+            THEN("他の優先度には積めること") {
+                REQUIRE(fsm_post(machine, event_3, FSM_PRIORITY_HIGH) == 0);
+            }
+        }
+
+        WHEN("範囲外の優先度でイベントを積む") {
+            errno = 0;
+            int ret = fsm_post(machine, event_1, FSM_PRIORITY_LANES);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == EINVAL);
+            }
+        }
+
+        WHEN("イベントを積まずに処理する") {
+            THEN("何も処理されないこと") {
+                REQUIRE(fsm_dispatch(machine) == 0);
+                REQUIRE(dispatched.empty());
+            }
+        }
+
+        fsm_term(machine);
+    }
+}
+
+/**
+ *  ファイバの do アクティビティの実行記録.
+ */
+static struct {
+    int steps;
+    int transit_at;
+    bool completed;
+    bool cancelled;
+    std::vector<std::string> order;
+} activity_log;
+
+static void activity_exec(struct fsm *machine, void *data)
+{
+    activity_log.order.push_back("start");
+    for (int i = 0; i < 3; ++i) {
+        ++activity_log.steps;
+        if (activity_log.steps == activity_log.transit_at) {
+            fsm_transition(machine, event_2);
+        }
+        if (fsm_yield(machine)) {
+            activity_log.cancelled = true;
+            activity_log.order.push_back("cancel");
+            return;
+        }
+    }
+    activity_log.completed = true;
+}
+
+static void activity_exit(struct fsm *machine, void *data, bool cmpl)
+{
+    activity_log.order.push_back("exit");
+}
+FSM_FIBER_STATE(state_fiber, NULL, NULL, activity_exec, activity_exit);
+
+SCENARIO("do アクティビティをファイバで中断, 再開できること", "[fsm][fiber]") {
+    GIVEN("ファイバ状態を持つ状態マシン") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_fiber),
+            FSM_TRANS_HELPER(state_fiber, event_1, NULL, NULL, state_root_with_no_handler),
+            FSM_TRANS_HELPER(state_fiber, event_2, NULL, NULL, state_root_with_no_handler),
+            FSM_TRANS_HELPER(state_root_with_no_handler, event_1, NULL, NULL, state_fiber),
+            FSM_TRANS_TERMINATOR
+        };
+        activity_log.steps = 0;
+        activity_log.transit_at = 0;
+        activity_log.completed = false;
+        activity_log.cancelled = false;
+        activity_log.order.clear();
+        struct fsm *machine = fsm_init(NULL, corresps);
+        REQUIRE(machine != NULL);
+
+        WHEN("状態を更新する") {
+            THEN("更新毎に 1 ステップずつ進み, 終了後は再開されないこと") {
+                fsm_update(machine);
+                REQUIRE(activity_log.steps == 1);
+                fsm_update(machine);
+                fsm_update(machine);
+                REQUIRE(activity_log.steps == 3);
+                REQUIRE(activity_log.completed == false);
+                fsm_update(machine);
+                REQUIRE(activity_log.completed == true);
+                fsm_update(machine);
+                REQUIRE(activity_log.steps == 3);
+                REQUIRE(activity_log.order == std::vector<std::string>{"start"});
+            }
+        }
+
+        WHEN("do アクティビティの途中で状態から出る") {
+            fsm_update(machine);
+            fsm_update(machine);
+            fsm_transition(machine, event_1);
+
+            THEN("exit アクションの前に do アクティビティが中断されること") {
+                REQUIRE(activity_log.cancelled == true);
+                REQUIRE(activity_log.steps == 2);
+                REQUIRE(activity_log.order == std::vector<std::string>{"start", "cancel", "exit"});
+            }
+
+            THEN("状態に戻ると do アクティビティが最初から開始されること") {
+                fsm_transition(machine, event_1);
+                fsm_update(machine);
+                REQUIRE(activity_log.steps == 3);
+                REQUIRE(activity_log.order == std::vector<std::string>{"start", "cancel", "exit", "start"});
+            }
+        }
+
+        WHEN("do アクティビティの中で状態遷移する") {
+            activity_log.transit_at = 2;
+            fsm_update(machine);
+            fsm_update(machine);
+
+            THEN("遷移後に do アクティビティが中断されること") {
+                REQUIRE(fsm_get_current(machine) == state_root_with_no_handler);
+                REQUIRE(activity_log.cancelled == true);
+                REQUIRE(activity_log.order == std::vector<std::string>{"start", "exit", "cancel"});
+            }
+        }
+
+        WHEN("do アクティビティの途中で状態マシンを破棄する") {
+            fsm_update(machine);
+            fsm_term(machine);
+            machine = NULL;
+
+            THEN("do アクティビティが中断されること") {
+                REQUIRE(activity_log.cancelled == true);
+                REQUIRE(activity_log.order == std::vector<std::string>{"start", "cancel", "exit"});
+            }
+        }
+
+        WHEN("ファイバの外で中断する") {
+            errno = 0;
+            bool ret = fsm_yield(machine);
+
+            THEN("中断が要求されているものとして扱われること") {
+                REQUIRE(ret == true);
+                REQUIRE(errno == EPERM);
+            }
+        }
+
+        fsm_term(machine);
+    }
+
+    GIVEN("同じ定義の状態マシンを多数") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_fiber),
+            FSM_TRANS_TERMINATOR
+        };
+        const size_t count = 1000;
+        std::vector<struct fsm *> machines;
+        activity_log.steps = 0;
+        activity_log.transit_at = 0;
+        activity_log.cancelled = false;
+        for (size_t i = 0; i < count; ++i) {
+            machines.push_back(fsm_init(NULL, corresps));
+            REQUIRE(machines.back() != NULL);
+        }
+
+        WHEN("1 つのスレッドで順に更新する") {
+            for (int round = 0; round < 2; ++round) {
+                for (struct fsm *machine : machines) {
+                    fsm_update(machine);
+                }
+            }
+
+            THEN("それぞれの do アクティビティが独立して進むこと") {
+                REQUIRE(activity_log.steps == (int)(count * 2));
+                REQUIRE(activity_log.cancelled == false);
+            }
+        }
+
+        for (struct fsm *machine : machines) {
+            fsm_term(machine);
+        }
+    }
+}
+
+/**
+ *  解放された遷移表の数.
+ */
+static int reclaimed_tables;
+
+static void count_reclaimed(struct fsm_table *table, void *ctx)
+{
+    ++reclaimed_tables;
+}
+
+/**
+ *  アクションの中で差し替える遷移表.
+ */
+static struct fsm_table *table_to_publish;
+
+/**
+ *  他のスレッドでの差し替えが完了したか.
+ */
+static std::atomic<bool> table_published;
+static std::thread table_publisher;
+
+FSM_ACTION(action_publish_inline, (struct fsm *machine))
+{
+    dispatched.push_back(10);
+    fsm_publish_table(machine, table_to_publish);
+}
+
+FSM_ACTION(action_publish_remote, (struct fsm *machine))
+{
+    table_published = false;
+    table_publisher = std::thread([machine]() {
+        fsm_publish_table(machine, table_to_publish);
+        table_published = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    dispatched.push_back(table_published ? 21 : 20);
+}
+
+SCENARIO("遷移表を動作中に差し替えられること", "[fsm][table]") {
+    GIVEN("同じイベントに異なるアクションを割り当てた 2 つの遷移表") {
+        const struct fsm_trans corresps_a[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_root_with_no_handler5),
+            FSM_TRANS_HELPER(state_root_with_no_handler5, event_1, NULL, action_record_1, NULL),
+            FSM_TRANS_HELPER(state_root_with_no_handler5, event_2, NULL, action_publish_inline, NULL),
+            FSM_TRANS_HELPER(state_root_with_no_handler5, event_3, NULL, action_publish_remote, NULL),
+            FSM_TRANS_TERMINATOR
+        };
+        const struct fsm_trans corresps_b[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_root_with_no_handler5),
+            FSM_TRANS_HELPER(state_root_with_no_handler5, event_1, NULL, action_record_2, NULL),
+            FSM_TRANS_TERMINATOR
+        };
+        dispatched.clear();
+        reclaimed_tables = 0;
+        struct fsm *machine = fsm_init(NULL, corresps_a);
+        struct fsm_table *table_b = fsm_table_compile(corresps_b, count_reclaimed, NULL);
+        REQUIRE(machine != NULL);
+        REQUIRE(table_b != NULL);
+        table_to_publish = table_b;
+
+        WHEN("遷移表を差し替える") {
+            fsm_transition(machine, event_1);
+            REQUIRE(fsm_publish_table(machine, table_b) == 0);
+            fsm_transition(machine, event_1);
+
+            THEN("以降の遷移で新しい遷移表が用いられること") {
+                REQUIRE(dispatched == std::vector<int>{1, 2});
+                REQUIRE(fsm_table_corresps(table_b)[1].action == action_record_2);
+            }
+
+            THEN("すべての参照が解放された時点で遷移表が解放されること") {
+                fsm_table_release(table_b);
+                REQUIRE(reclaimed_tables == 0);
+                fsm_term(machine);
+                machine = NULL;
+                REQUIRE(reclaimed_tables == 1);
+                table_b = NULL;
+            }
+        }
+
+        WHEN("アクションの中で遷移表を差し替える") {
+            fsm_transition(machine, event_2);
+            fsm_transition(machine, event_1);
+
+            THEN("処理中の遷移を終えた後に新しい遷移表が用いられること") {
+                REQUIRE(dispatched == std::vector<int>{10, 2});
+            }
+        }
+
+        WHEN("遷移中に他のスレッドから遷移表を差し替える") {
+            fsm_transition(machine, event_3);
+            table_publisher.join();
+            fsm_transition(machine, event_1);
+
+            THEN("差し替えは処理中の遷移の終了を待つこと") {
+                REQUIRE(dispatched == std::vector<int>{20, 2});
+                REQUIRE(table_published == true);
+            }
+        }
+
+        WHEN("遷移表の元の対応表を破棄する") {
+            struct fsm_trans *temporary = new struct fsm_trans[2]{
+                FSM_TRANS_HELPER(state_root_with_no_handler5, event_1, NULL, action_record_3, NULL),
+                FSM_TRANS_TERMINATOR
+            };
+            struct fsm_table *table_c = fsm_table_compile(temporary, NULL, NULL);
+            delete[] temporary;
+            REQUIRE(fsm_publish_table(machine, table_c) == 0);
+            fsm_table_release(table_c);
+            fsm_transition(machine, event_1);
+
+            THEN("複製した遷移表で遷移すること") {
+                REQUIRE(dispatched == std::vector<int>{3});
+            }
+        }
+
+        fsm_table_release(table_b);
+        fsm_term(machine);
+    }
+}
+
+FSM_COND(cond_lookup_never, (struct fsm *machine))
+{
+    return false;
+}
+
+SCENARIO("遷移表の検索方式によらず同じ遷移となること", "[fsm][table][lookup]") {
+    GIVEN("多数の状態とイベントからなる疎な遷移表") {
+        const int nstates = 2000;
+        const int nevents = 500;
+        std::vector<struct fsm_state_variable> variables(nstates);
+        std::vector<struct fsm_state> states;
+        std::vector<struct fsm_event> events(nevents);
+        std::vector<struct fsm_trans> corresps;
+        std::mt19937 rng(2501);
+
+        states.reserve(nstates);
+        for (int i = 0; i < nstates; ++i) {
+            states.push_back(FSM_STATE_HELPER("lookup", &variables[i], NULL, NULL, NULL));
+        }
+        for (int i = 0; i < nevents; ++i) {
+            events[i].name = "lookup";
+        }
+        corresps.push_back(FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, &states[0]));
+        for (int i = 0; i < nstates; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                struct fsm_state *to = (j == 0) ? NULL : &states[rng() % nstates];
+                corresps.push_back(FSM_TRANS_HELPER(&states[i], &events[rng() % nevents], NULL, NULL, to));
+            }
+        }
+        /* 同じ状態とイベントの遷移を前後に加え, 評価順を確認する. */
+        for (int i = 0; i < nstates; i += 10) {
+            const struct fsm_trans &base = corresps[1 + (i * 8) + 1];
+            corresps.insert(corresps.begin() + 1,
+                            FSM_TRANS_HELPER(base.from, base.event, cond_lookup_never, NULL, &states[0]));
+            corresps.push_back(FSM_TRANS_HELPER(base.from, base.event, NULL, NULL, &states[1]));
+        }
+        corresps.push_back(FSM_TRANS_TERMINATOR);
+
+        struct fsm_table *linear = fsm_table_compile_as(corresps.data(), FSM_LOOKUP_LINEAR, NULL, NULL);
+        struct fsm_table *sorted = fsm_table_compile_as(corresps.data(), FSM_LOOKUP_SORTED, NULL, NULL);
+        struct fsm_table *hash = fsm_table_compile_as(corresps.data(), FSM_LOOKUP_HASH, NULL, NULL);
+        struct fsm_table *automatic = fsm_table_compile(corresps.data(), NULL, NULL);
+        REQUIRE(linear != NULL);
+        REQUIRE(sorted != NULL);
+        REQUIRE(hash != NULL);
+        REQUIRE(automatic != NULL);
+
+        WHEN("生成した遷移表の検索方式を確認する") {
+            THEN("指定した方式となり, 自動選択では完全ハッシュとなること") {
+                REQUIRE(fsm_table_lookup(linear) == FSM_LOOKUP_LINEAR);
+                REQUIRE(fsm_table_lookup(sorted) == FSM_LOOKUP_SORTED);
+                REQUIRE(fsm_table_lookup(hash) == FSM_LOOKUP_HASH);
+                REQUIRE(fsm_table_lookup(automatic) == FSM_LOOKUP_HASH);
+                REQUIRE(fsm_table_bytes(linear) < fsm_table_bytes(hash));
+            }
+        }
+
+        WHEN("同じイベントの列で遷移させる") {
+            struct fsm *machines[] = {
+                fsm_init_table(NULL, linear),
+                fsm_init_table(NULL, sorted),
+                fsm_init_table(NULL, hash)
+            };
+            bool same = true;
+            for (int i = 0; (i < 20000) && same; ++i) {
+                const struct fsm_event *event = &events[rng() % nevents];
+                for (struct fsm *machine : machines) {
+                    fsm_transition(machine, event);
+                }
+                same = (fsm_get_current(machines[0]) == fsm_get_current(machines[1]))
+                       && (fsm_get_current(machines[0]) == fsm_get_current(machines[2]));
+            }
+
+            THEN("すべての状態マシンが同じ状態となること") {
+                REQUIRE(same);
+            }
+
+            for (struct fsm *machine : machines) {
+                fsm_term(machine);
+            }
+        }
+
+        fsm_table_release(automatic);
+        fsm_table_release(hash);
+        fsm_table_release(sorted);
+        fsm_table_release(linear);
+    }
+
+    GIVEN("小さな遷移表と密な遷移表") {
+        const int nstates = 20;
+        const int nevents = 10;
+        std::vector<struct fsm_state_variable> variables(nstates);
+        std::vector<struct fsm_state> states;
+        std::vector<struct fsm_event> events(nevents);
+        std::vector<struct fsm_trans> dense;
+        const struct fsm_trans small[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_root_with_no_handler5),
+            FSM_TRANS_HELPER(state_root_with_no_handler5, event_1, NULL, action_record_1, NULL),
+            FSM_TRANS_TERMINATOR
+        };
+
+        states.reserve(nstates);
+        for (int i = 0; i < nstates; ++i) {
+            states.push_back(FSM_STATE_HELPER("dense", &variables[i], NULL, NULL, NULL));
+        }
+        for (int i = 0; i < nevents; ++i) {
+            events[i].name = "dense";
+        }
+        for (int i = 0; i < nstates; ++i) {
+            for (int j = 0; j < nevents; ++j) {
+                dense.push_back(FSM_TRANS_HELPER(&states[i], &events[j], NULL, NULL,
+                                                 &states[(i + j) % nstates]));
+            }
+        }
+        dense.push_back(FSM_TRANS_TERMINATOR);
+
+        WHEN("自動で検索方式を選ぶ") {
+            struct fsm_table *small_table = fsm_table_compile(small, NULL, NULL);
+            struct fsm_table *dense_table = fsm_table_compile(dense.data(), NULL, NULL);
+
+            THEN("小さな遷移表は線形走査, 密な遷移表は整列済み配列となること") {
+                REQUIRE(fsm_table_lookup(small_table) == FSM_LOOKUP_LINEAR);
+                REQUIRE(fsm_table_lookup(dense_table) == FSM_LOOKUP_SORTED);
+            }
+
+            fsm_table_release(dense_table);
+            fsm_table_release(small_table);
+        }
+
+        WHEN("不正な検索方式を指定する") {
+            errno = 0;
+            struct fsm_table *table = fsm_table_compile_as(small, (enum fsm_lookup)10, NULL, NULL);
+
+            THEN("エラーとなること") {
+                REQUIRE(table == NULL);
+                REQUIRE(errno == EINVAL);
+            }
+        }
+    }
+}
+
+/**
+ *  コンテキストのテストで用いる状態マシン毎の情報.
+ */
+struct counter_context {
+    int limit;      /**< 上限. */
+    int count;      /**< 計数値. */
+    int entries;    /**< 計数状態に入った回数. */
+    int exits;      /**< 計数状態から出た回数. */
+};
+
+static void count_slot(struct fsm *machine, void *data, bool cmpl)
+{
+    ++*(int *)data;
+}
+
+FSM_STATE_SLOT(state_counting, struct counter_context, entries, count_slot, NULL, NULL);
+FSM_STATE_SLOT(state_counted, struct counter_context, exits, NULL, NULL, count_slot);
+
+FSM_COND_CTX(cond_below_limit, (struct fsm *machine, void *ctx))
+{
+    struct counter_context *counter = (struct counter_context *)ctx;
+    return counter->count < counter->limit;
+}
+
+FSM_ACTION_CTX(action_count_up, (struct fsm *machine, void *ctx))
+{
+    ++((struct counter_context *)ctx)->count;
+}
+
+SCENARIO("状態マシン毎のコンテキストがアクションに渡されること", "[fsm][context]") {
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_counting),
+        FSM_TRANS_HELPER(state_counting, event_1, cond_below_limit, action_count_up, NULL),
+        FSM_TRANS_HELPER(state_counting, event_2, NULL, NULL, state_counted),
+        FSM_TRANS_HELPER(state_counted, event_1, NULL, NULL, state_counting),
+        FSM_TRANS_TERMINATOR
+    };
+
+    GIVEN("遷移表を共有し, 上限の異なるコンテキストを持つ 2 つの状態マシン") {
+        struct fsm_table *table = fsm_table_compile(corresps, NULL, NULL);
+        REQUIRE(table != NULL);
+        const struct counter_context defaults[] = {{1, 0, 0, 0}, {3, 0, 0, 0}};
+        struct fsm *machines[] = {
+            fsm_init_context(NULL, table, &defaults[0], sizeof(struct counter_context)),
+            fsm_init_context(NULL, table, &defaults[1], sizeof(struct counter_context))
+        };
+        fsm_table_release(table);
+        REQUIRE(machines[0] != NULL);
+        REQUIRE(machines[1] != NULL);
+        struct counter_context *counters[] = {
+            (struct counter_context *)fsm_get_context(machines[0]),
+            (struct counter_context *)fsm_get_context(machines[1])
+        };
+
+        WHEN("初期化する") {
+            THEN("コンテキストは初期値の複製で, 最初の状態の entry アクションにメンバが渡されること") {
+                REQUIRE(counters[0] != &defaults[0]);
+                REQUIRE(counters[0]->limit == 1);
+                REQUIRE(counters[1]->limit == 3);
+                REQUIRE(counters[0]->entries == 1);
+                REQUIRE(counters[1]->entries == 1);
+                REQUIRE(defaults[0].entries == 0);
+            }
+        }
+
+        WHEN("同じイベントを繰り返し与える") {
+            for (int i = 0; i < 5; ++i) {
+                fsm_transition(machines[0], event_1);
+                fsm_transition(machines[1], event_1);
+            }
+
+            THEN("ガード条件と遷移アクションがそれぞれのコンテキストで動作すること") {
+                REQUIRE(counters[0]->count == 1);
+                REQUIRE(counters[1]->count == 3);
+            }
+        }
+
+        WHEN("片方だけ状態を往復させる") {
+            fsm_transition(machines[1], event_2);
+            fsm_transition(machines[1], event_1);
+            fsm_transition(machines[1], event_2);
+            fsm_transition(machines[1], event_1);
+
+            THEN("entry/exit アクションにその状態マシンのメンバが渡されること") {
+                REQUIRE(counters[0]->entries == 1);
+                REQUIRE(counters[0]->exits == 0);
+                REQUIRE(counters[1]->entries == 3);
+                REQUIRE(counters[1]->exits == 2);
+            }
+        }
+
+        WHEN("インスタンス状態の固有情報を取得する") {
+            THEN("状態マシン毎のメンバが返ること") {
+                REQUIRE(fsm_get_state_data_of(machines[0], state_counting) == &counters[0]->entries);
+                REQUIRE(fsm_get_state_data_of(machines[1], state_counting) == &counters[1]->entries);
+                REQUIRE(fsm_get_state_data_of(machines[1], state_counted) == &counters[1]->exits);
+            }
+
+            THEN("状態マシンを指定しない場合は NULL が返ること") {
+                REQUIRE(fsm_get_state_data(state_counting) == NULL);
+            }
+        }
+
+        fsm_term(machines[1]);
+        fsm_term(machines[0]);
+    }
+
+    GIVEN("外部のコンテキスト") {
+        struct counter_context counter = {2, 0, 0, 0};
+        struct fsm_table *table = fsm_table_compile(corresps, NULL, NULL);
+        REQUIRE(table != NULL);
+        struct fsm *machine = fsm_init_context(NULL, table, &counter, 0);
+        fsm_table_release(table);
+        REQUIRE(machine != NULL);
+
+        WHEN("イベントを与える") {
+            fsm_transition(machine, event_1);
+
+            THEN("外部のコンテキストが直接更新されること") {
+                REQUIRE(fsm_get_context(machine) == &counter);
+                REQUIRE(counter.entries == 1);
+                REQUIRE(counter.count == 1);
+            }
+        }
+
+        fsm_term(machine);
+    }
+
+    GIVEN("コンテキストを持たない状態マシン") {
+        const struct fsm_trans plain[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_root_with_no_handler),
+            FSM_TRANS_TERMINATOR
+        };
+        struct fsm *machine = fsm_init(NULL, plain);
+        REQUIRE(machine != NULL);
+
+        WHEN("コンテキストを取得する") {
+            void *ctx = fsm_get_context(machine);
+
+            THEN("NULL となること") {
+                REQUIRE(ctx == NULL);
+            }
+        }
+
+        WHEN("状態の固有情報を取得する") {
+            THEN("インスタンス状態では NULL が, それ以外では定義の固有情報が返ること") {
+                REQUIRE(fsm_get_state_data_of(machine, state_counting) == NULL);
+                REQUIRE(fsm_get_state_data_of(machine, state_root_with_no_handler)
+                        == fsm_get_state_data(state_root_with_no_handler));
+                errno = 0;
+                REQUIRE(fsm_get_state_data_of(NULL, state_counting) == NULL);
+                REQUIRE(errno == EINVAL);
+            }
+        }
+
+        fsm_term(machine);
+    }
+}
+
+FSM_STATE(state_history_parent, NULL, NULL, NULL, NULL);
+FSM_STATE(state_history_first, NULL, NULL, NULL, NULL);
+FSM_STATE(state_history_second, NULL, NULL, NULL, NULL);
+FSM_STATE(state_history_outside, NULL, NULL, NULL, NULL);
+
+SCENARIO("履歴状態が状態マシン毎に保持されること", "[fsm][history]") {
+    const struct fsm_rels rels[] = {
+        FSM_RELS_HELPER(state_history_first, state_history_parent, true),
+        FSM_RELS_HELPER(state_history_second, state_history_parent, false),
+        FSM_RELS_TERMINATOR
+    };
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_history_parent),
+        FSM_TRANS_HELPER(state_history_first, event_1, NULL, NULL, state_history_second),
+        FSM_TRANS_HELPER(state_history_parent, event_2, NULL, NULL, state_history_outside),
+        FSM_TRANS_HELPER(state_history_outside, event_3, NULL, NULL, state_history_parent),
+        FSM_TRANS_TERMINATOR
+    };
+
+    GIVEN("子を持つ状態のある遷移表を共有する 2 つの状態マシン") {
+        struct fsm_table *table = fsm_table_compile(corresps, NULL, NULL);
+        REQUIRE(table != NULL);
+        struct fsm *machines[] = {
+            fsm_init_table(rels, table),
+            fsm_init_table(rels, table)
+        };
+        REQUIRE(machines[0] != NULL);
+        REQUIRE(machines[1] != NULL);
+
+        WHEN("異なる子状態から親状態を出て, 戻る") {
+            fsm_transition(machines[0], event_1);
+            fsm_transition(machines[0], event_2);
+            fsm_transition(machines[1], event_2);
+            struct fsm *late = fsm_init_table(rels, table);
+            REQUIRE(late != NULL);
+            fsm_transition(machines[0], event_3);
+            fsm_transition(machines[1], event_3);
+
+            THEN("それぞれ自身が出た子状態に戻ること") {
+                REQUIRE(fsm_get_current(machines[0]) == state_history_second);
+                REQUIRE(fsm_get_current(machines[1]) == state_history_first);
+                REQUIRE(fsm_get_current(late) == state_history_first);
+            }
+
+            fsm_term(late);
+        }
+
+        fsm_term(machines[1]);
+        fsm_term(machines[0]);
+        fsm_table_release(table);
+    }
+}
@@ -0,0 +1,331 @@
+/** @file   journal.cpp
+ *  @brief  イベントの記録と再生のテスト.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ */
+#include <cstdlib>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <catch.hpp>
+
+extern "C" {
+#include "debug.h"
+#include "hfsm.h"
+#include "journal.h"
+}
+
+FSM_STATE(state_journal_1, NULL, NULL, NULL, NULL);
+FSM_STATE(state_journal_2, NULL, NULL, NULL, NULL);
+FSM_STATE(state_journal_3, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_journal_1);
+FSM_EVENT(event_journal_2);
+FSM_EVENT(event_journal_unknown);
+
+static bool cond_journal_param = true;
+FSM_COND(cond_journal, (struct fsm *machine))
+{
+    return cond_journal_param;
+}
+
+/**
+ *  再生時に渡された付加データを記録するハンドラ.
+ */
+static void capture_payload(struct fsm *machine,
+                            const struct fsm_event *event,
+                            uint64_t timestamp,
+                            const void *payload,
+                            size_t payload_bytes,
+                            void *ctx)
+{
+    std::vector<std::string> *payloads = static_cast<std::vector<std::string> *>(ctx);
+    payloads->push_back(std::string(static_cast<const char *>(payload), payload_bytes));
+}
+
+SCENARIO("イベントを記録して再生できること", "[journal]") {
+    GIVEN("ガード条件で遷移先が変わる定義でイベントを記録しておく") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_journal_1),
+            FSM_TRANS_HELPER(state_journal_1, event_journal_1, cond_journal, NULL, state_journal_2),
+            FSM_TRANS_HELPER(state_journal_1, event_journal_1, NULL, NULL, state_journal_3),
+            FSM_TRANS_HELPER(state_journal_2, event_journal_2, NULL, NULL, state_journal_1),
+            FSM_TRANS_HELPER(state_journal_3, event_journal_2, NULL, NULL, state_journal_1),
+            FSM_TRANS_TERMINATOR
+        };
+        char path[] = "/tmp/hfsm_journal_XXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE(fd >= 0);
+        close(fd);
+
+        std::string large(100 * 1024, 'L');
+        cond_journal_param = true;
+        struct fsm *machine = fsm_init(NULL, corresps);
+        struct fsm_journal *journal = fsm_journal_open(path, NULL, corresps);
+        REQUIRE(machine != NULL);
+        REQUIRE(journal != NULL);
+        REQUIRE(fsm_journal_transition(journal, machine, event_journal_1, "a", 1) == 0);
+        REQUIRE(fsm_journal_transition(journal, machine, event_journal_2, NULL, 0) == 0);
+        REQUIRE(fsm_journal_transition(journal, machine, event_journal_unknown, NULL, 0) == 0);
+        REQUIRE(fsm_journal_transition(journal, machine, event_journal_1, large.data(), large.size()) == 0);
+        REQUIRE(fsm_get_current(machine) == state_journal_2);
+        uint32_t checksum = fsm_journal_checksum(journal);
+        REQUIRE(fsm_journal_close(journal) == 0);
+        fsm_term(machine);
+
+        WHEN("同じ条件で再生する") {
+            std::vector<std::string> payloads;
+            struct fsm_replay_stats stats;
+            machine = fsm_init(NULL, corresps);
+            int ret = fsm_journal_replay(path, NULL, corresps, machine,
+                                         capture_payload, &payloads, &stats);
+
+            THEN("すべての記録が乖離なく再生されること") {
+                REQUIRE(ret == 0);
+                REQUIRE(stats.records == 4);
+                REQUIRE(stats.diverged == -1);
+                REQUIRE(stats.truncated == false);
+                REQUIRE(stats.checksum == checksum);
+                REQUIRE(fsm_get_current(machine) == state_journal_2);
+            }
+
+            THEN("付加データが記録時のまま渡されること") {
+                REQUIRE(payloads.size() == 4);
+                REQUIRE(payloads[0] == "a");
+                REQUIRE(payloads[1].empty());
+                REQUIRE(payloads[3] == large);
+            }
+
+            fsm_term(machine);
+        }
+
+        WHEN("ガード条件の結果が異なる状態で再生する") {
+            struct fsm_replay_stats stats;
+            cond_journal_param = false;
+            machine = fsm_init(NULL, corresps);
+            int ret = fsm_journal_replay(path, NULL, corresps, machine, NULL, NULL, &stats);
+
+            THEN("最初の記録で乖離が検出されること") {
+                REQUIRE(ret == 0);
+                REQUIRE(stats.records == 0);
+                REQUIRE(stats.diverged == 0);
+            }
+
+            fsm_term(machine);
+            cond_journal_param = true;
+        }
+
+        WHEN("末尾が途中で切れたログを再生する") {
+            struct fsm_replay_stats stats;
+            REQUIRE(truncate(path, 24 + (24 + 1) + 24 + 24 + 24 + 10) == 0);
+            machine = fsm_init(NULL, corresps);
+            int ret = fsm_journal_replay(path, NULL, corresps, machine, NULL, NULL, &stats);
+
+            THEN("完全な記録のみが再生されること") {
+                REQUIRE(ret == 0);
+                REQUIRE(stats.records == 3);
+                REQUIRE(stats.diverged == -1);
+                REQUIRE(stats.truncated == true);
+            }
+
+            fsm_term(machine);
+        }
+
+        WHEN("ヘッダのサイズが壊れたログを再生する") {
+            struct fsm_replay_stats stats;
+            uint32_t header_bytes = UINT32_MAX;
+            int wfd = open(path, O_WRONLY);
+            REQUIRE(wfd >= 0);
+            REQUIRE(pwrite(wfd, &header_bytes, sizeof(header_bytes), 12) == sizeof(header_bytes));
+            close(wfd);
+            machine = fsm_init(NULL, corresps);
+            errno = 0;
+            int ret = fsm_journal_replay(path, NULL, corresps, machine, NULL, NULL, &stats);
+
+            THEN("確保する前にエラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == EBADMSG);
+                REQUIRE(stats.records == 0);
+            }
+
+            fsm_term(machine);
+        }
+
+        WHEN("付加データのサイズが壊れたログを再生する") {
+            struct fsm_replay_stats stats;
+            uint32_t payload_bytes = UINT32_MAX;
+            int wfd = open(path, O_WRONLY);
+            REQUIRE(wfd >= 0);
+            REQUIRE(pwrite(wfd, &payload_bytes, sizeof(payload_bytes), 24 + (24 + 1) + 16) == sizeof(payload_bytes));
+            close(wfd);
+            machine = fsm_init(NULL, corresps);
+            errno = 0;
+            int ret = fsm_journal_replay(path, NULL, corresps, machine, NULL, NULL, &stats);
+
+            THEN("壊れた記録の前まで再生してエラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == EBADMSG);
+                REQUIRE(stats.records == 1);
+            }
+
+            fsm_term(machine);
+        }
+
+        WHEN("付加データのサイズがログより大きい記録を再生する") {
+            struct fsm_replay_stats stats;
+            uint32_t payload_bytes = FSM_JOURNAL_PAYLOAD_MAX;
+            int wfd = open(path, O_WRONLY);
+            REQUIRE(wfd >= 0);
+            REQUIRE(pwrite(wfd, &payload_bytes, sizeof(payload_bytes), 24 + (24 + 1) + 16) == sizeof(payload_bytes));
+            close(wfd);
+            machine = fsm_init(NULL, corresps);
+            int ret = fsm_journal_replay(path, NULL, corresps, machine, NULL, NULL, &stats);
+
+            THEN("途中で切れたログとして扱われること") {
+                REQUIRE(ret == 0);
+                REQUIRE(stats.records == 1);
+                REQUIRE(stats.truncated == true);
+            }
+
+            fsm_term(machine);
+        }
+
+        WHEN("上限を超える付加データを記録する") {
+            machine = fsm_init(NULL, corresps);
+            journal = fsm_journal_open(path, NULL, corresps);
+            REQUIRE(journal != NULL);
+            errno = 0;
+            int ret = fsm_journal_transition(journal, machine, event_journal_1,
+                                             large.data(), (size_t)FSM_JOURNAL_PAYLOAD_MAX + 1);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == EINVAL);
+            }
+
+            fsm_journal_close(journal);
+            fsm_term(machine);
+        }
+
+        WHEN("異なる定義で再生する") {
+            const struct fsm_trans others[] = {
+                FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_journal_1),
+                FSM_TRANS_HELPER(state_journal_1, event_journal_1, NULL, NULL, state_journal_3),
+                FSM_TRANS_TERMINATOR
+            };
+            struct fsm_replay_stats stats;
+            machine = fsm_init(NULL, others);
+            errno = 0;
+            int ret = fsm_journal_replay(path, NULL, others, machine, NULL, NULL, &stats);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == EINVAL);
+            }
+
+            fsm_term(machine);
+        }
+
+        unlink(path);
+    }
+}
+
+SCENARIO("書き出しに失敗した記録が失われないこと", "[journal]") {
+    GIVEN("書き込みが常に失敗するログに記録する") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_journal_1),
+            FSM_TRANS_HELPER(state_journal_1, event_journal_1, NULL, NULL, state_journal_2),
+            FSM_TRANS_TERMINATOR
+        };
+        struct fsm *machine = fsm_init(NULL, corresps);
+        struct fsm_journal *journal = fsm_journal_open("/dev/full", NULL, corresps);
+        REQUIRE(machine != NULL);
+        REQUIRE(journal != NULL);
+        REQUIRE(fsm_journal_transition(journal, machine, event_journal_1, "a", 1) == 0);
+
+        WHEN("繰り返し書き出す") {
+            errno = 0;
+            int first = fsm_journal_flush(journal);
+            int first_errno = errno;
+            errno = 0;
+            int second = fsm_journal_flush(journal);
+            int second_errno = errno;
+
+            THEN("書き出せなかった記録が残り, 毎回失敗すること") {
+                REQUIRE(first == -1);
+                REQUIRE(first_errno == ENOSPC);
+                REQUIRE(second == -1);
+                REQUIRE(second_errno == ENOSPC);
+            }
+        }
+
+        REQUIRE(fsm_journal_close(journal) == -1);
+        fsm_term(machine);
+    }
+}
+
+#if OBSERVER
+SCENARIO("登録した状態マシンのイベントをすべて記録できること", "[journal]") {
+    GIVEN("記録対象として状態マシンを登録する") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_journal_1),
+            FSM_TRANS_HELPER(state_journal_1, event_journal_1, NULL, NULL, state_journal_2),
+            FSM_TRANS_HELPER(state_journal_2, event_journal_2, NULL, NULL, state_journal_1),
+            FSM_TRANS_TERMINATOR
+        };
+        char path[] = "/tmp/hfsm_journal_XXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE(fd >= 0);
+        close(fd);
+
+        struct fsm *machine = fsm_init(NULL, corresps);
+        struct fsm_journal *journal = fsm_journal_open(path, NULL, corresps);
+        REQUIRE(machine != NULL);
+        REQUIRE(journal != NULL);
+        REQUIRE(fsm_journal_attach(journal, machine) == 0);
+
+        WHEN("直接の遷移, キュー経由の遷移, 付加データ付きの遷移を混ぜて発生させる") {
+            errno = 0;
+            REQUIRE(fsm_journal_attach(journal, machine) == -1);
+            REQUIRE(errno == EBUSY);
+
+            fsm_transition(machine, event_journal_1);
+            REQUIRE(fsm_post(machine, event_journal_2, FSM_PRIORITY_NORMAL) == 0);
+            REQUIRE(fsm_dispatch(machine) == 1);
+            REQUIRE(fsm_journal_transition(journal, machine, event_journal_1, "p", 1) == 0);
+            REQUIRE(fsm_journal_detach(journal) == 0);
+            fsm_transition(machine, event_journal_2);
+            fsm_transition(machine, event_journal_1);
+            uint32_t checksum = fsm_journal_checksum(journal);
+            REQUIRE(fsm_journal_close(journal) == 0);
+            fsm_term(machine);
+
+            std::vector<std::string> payloads;
+            struct fsm_replay_stats stats;
+            machine = fsm_init(NULL, corresps);
+            int ret = fsm_journal_replay(path, NULL, corresps, machine,
+                                         capture_payload, &payloads, &stats);
+
+            THEN("登録中のイベントのみが一度ずつ記録されること") {
+                REQUIRE(ret == 0);
+                REQUIRE(stats.records == 3);
+                REQUIRE(stats.diverged == -1);
+                REQUIRE(stats.checksum == checksum);
+                REQUIRE(fsm_get_current(machine) == state_journal_2);
+                REQUIRE(payloads.size() == 3);
+                REQUIRE(payloads[0].empty());
+                REQUIRE(payloads[1].empty());
+                REQUIRE(payloads[2] == "p");
+            }
+
+            fsm_term(machine);
+        }
+
+        unlink(path);
+    }
+}
+#endif
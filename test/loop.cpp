@@ -0,0 +1,286 @@
+/** @file   loop.cpp
+ *  @brief  イベントループのテスト.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ */
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <catch.hpp>
+
+extern "C" {
+#include "debug.h"
+#include "hfsm.h"
+#include "loop.h"
+}
+
+FSM_STATE(state_loop_idle, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_loop_readable);
+FSM_EVENT(event_loop_tick);
+FSM_EVENT(event_loop_signal);
+FSM_EVENT(event_loop_low);
+FSM_EVENT(event_loop_urgent);
+
+/**
+ *  処理したイベントの記録.
+ */
+static std::vector<int> loop_handled;
+
+/**
+ *  読み込み可能となった eventfd.
+ */
+static int loop_readable_fd = -1;
+
+FSM_ACTION(action_loop_readable, (struct fsm *machine))
+{
+    uint64_t value;
+    if (read(loop_readable_fd, &value, sizeof(value)) == sizeof(value)) {
+        loop_handled.push_back(1);
+    }
+}
+
+FSM_ACTION(action_loop_tick, (struct fsm *machine))
+{
+    loop_handled.push_back(2);
+}
+
+FSM_ACTION(action_loop_signal, (struct fsm *machine))
+{
+    loop_handled.push_back(3);
+}
+
+FSM_ACTION(action_loop_low, (struct fsm *machine))
+{
+    loop_handled.push_back(4);
+}
+
+FSM_ACTION(action_loop_urgent, (struct fsm *machine))
+{
+    loop_handled.push_back(5);
+}
+
+/**
+ *  アクションから解除するイベントループ.
+ */
+static struct fsm_loop *loop_removing = NULL;
+
+/**
+ *  アクションから解除するファイルディスクリプタ.
+ */
+static std::vector<int> loop_removed_fds;
+
+FSM_ACTION(action_loop_remove_all, (struct fsm *machine))
+{
+    loop_handled.push_back(6);
+    for (int fd : loop_removed_fds) {
+        fsm_loop_remove(loop_removing, fd);
+    }
+}
+
+SCENARIO("準備完了をイベントとして処理できること", "[loop]") {
+    GIVEN("イベントループと状態マシン") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_loop_idle),
+            FSM_TRANS_HELPER(state_loop_idle, event_loop_readable, NULL, action_loop_readable, NULL),
+            FSM_TRANS_HELPER(state_loop_idle, event_loop_tick, NULL, action_loop_tick, NULL),
+            FSM_TRANS_HELPER(state_loop_idle, event_loop_signal, NULL, action_loop_signal, NULL),
+            FSM_TRANS_HELPER(state_loop_idle, event_loop_low, NULL, action_loop_low, NULL),
+            FSM_TRANS_HELPER(state_loop_idle, event_loop_urgent, NULL, action_loop_urgent, NULL),
+            FSM_TRANS_TERMINATOR
+        };
+        loop_handled.clear();
+        struct fsm_loop *loop = fsm_loop_init();
+        struct fsm *machine = fsm_init(NULL, corresps);
+        REQUIRE(loop != NULL);
+        REQUIRE(machine != NULL);
+
+        WHEN("ファイルディスクリプタを登録する") {
+            loop_readable_fd = eventfd(0, EFD_NONBLOCK);
+            REQUIRE(fsm_loop_add_fd(loop, loop_readable_fd, machine,
+                                    event_loop_readable, FSM_PRIORITY_NORMAL) == 0);
+
+            THEN("読み込み可能になるとイベントが処理されること") {
+                REQUIRE(fsm_loop_run_once(loop, 0) == 0);
+                uint64_t value = 1;
+                REQUIRE(write(loop_readable_fd, &value, sizeof(value)) == sizeof(value));
+                REQUIRE(fsm_loop_run_once(loop, 1000) == 1);
+                REQUIRE(loop_handled == std::vector<int>{1});
+            }
+
+            THEN("同じファイルディスクリプタは登録できないこと") {
+                errno = 0;
+                REQUIRE(fsm_loop_add_fd(loop, loop_readable_fd, machine,
+                                        event_loop_readable, FSM_PRIORITY_NORMAL) == -1);
+                REQUIRE(errno == EEXIST);
+            }
+
+            THEN("解除後はイベントが処理されないこと") {
+                REQUIRE(fsm_loop_remove(loop, loop_readable_fd) == 0);
+                uint64_t value = 1;
+                REQUIRE(write(loop_readable_fd, &value, sizeof(value)) == sizeof(value));
+                REQUIRE(fsm_loop_run_once(loop, 0) == 0);
+                errno = 0;
+                REQUIRE(fsm_loop_remove(loop, loop_readable_fd) == -1);
+                REQUIRE(errno == ENOENT);
+            }
+
+            fsm_loop_term(loop);
+            close(loop_readable_fd);
+            loop = NULL;
+        }
+
+        WHEN("タイマを登録する") {
+            int fd = fsm_loop_add_timer(loop, 10, 0, machine, event_loop_tick, FSM_PRIORITY_NORMAL);
+
+            THEN("満了するとイベントが処理されること") {
+                REQUIRE(fd >= 0);
+                REQUIRE(fsm_loop_run_once(loop, 1000) == 1);
+                REQUIRE(loop_handled == std::vector<int>{2});
+                REQUIRE(fsm_loop_run_once(loop, 20) == 0);
+            }
+        }
+
+        WHEN("シグナルを登録する") {
+            int fd = fsm_loop_add_signal(loop, SIGUSR1, machine, event_loop_signal, FSM_PRIORITY_HIGH);
+            REQUIRE(fd >= 0);
+            raise(SIGUSR1);
+
+            THEN("受信するとイベントが処理されること") {
+                REQUIRE(fsm_loop_run_once(loop, 1000) == 1);
+                REQUIRE(loop_handled == std::vector<int>{3});
+            }
+        }
+
+        WHEN("他のスレッドからイベントを積む") {
+            std::thread poster([&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                fsm_loop_post(loop, machine, event_loop_low, FSM_PRIORITY_LOW);
+                fsm_loop_post(loop, machine, event_loop_urgent, FSM_PRIORITY_URGENT);
+            });
+            poster.join();
+
+            THEN("待機中のループが起こされ, 優先度順に処理されること") {
+                REQUIRE(fsm_loop_run_once(loop, 1000) == 2);
+                REQUIRE(loop_handled == std::vector<int>{5, 4});
+            }
+        }
+
+        WHEN("他のスレッドから停止を要求する") {
+            std::thread stopper([&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                fsm_loop_post(loop, machine, event_loop_tick, FSM_PRIORITY_NORMAL);
+                fsm_loop_stop(loop);
+            });
+            int ret = fsm_loop_run(loop);
+            stopper.join();
+
+            THEN("ループが終了すること") {
+                REQUIRE(ret == 0);
+                REQUIRE(loop_handled == std::vector<int>{2});
+            }
+        }
+
+        WHEN("不正な引数で登録する") {
+            errno = 0;
+            int ret = fsm_loop_add_fd(loop, 0, machine, event_loop_tick, FSM_PRIORITY_LANES);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == EINVAL);
+            }
+        }
+
+        fsm_loop_term(loop);
+        fsm_term(machine);
+    }
+
+    GIVEN("多数の状態マシン") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_loop_idle),
+            FSM_TRANS_HELPER(state_loop_idle, event_loop_tick, NULL, action_loop_tick, NULL),
+            FSM_TRANS_TERMINATOR
+        };
+        const int count = 1000;
+        std::vector<struct fsm *> machines;
+        loop_handled.clear();
+        struct fsm_loop *loop = fsm_loop_init();
+        REQUIRE(loop != NULL);
+        for (int i = 0; i < count; ++i) {
+            machines.push_back(fsm_init(NULL, corresps));
+            REQUIRE(fsm_loop_add_timer(loop, 1, 0, machines.back(),
+                                       event_loop_tick, FSM_PRIORITY_NORMAL) >= 0);
+        }
+
+        WHEN("1 つのループで待つ") {
+            int handled = 0;
+            while (handled < count) {
+                int ret = fsm_loop_run_once(loop, 1000);
+                if (ret <= 0) {
+                    break;
+                }
+                handled += ret;
+            }
+
+            THEN("すべての状態マシンのイベントが処理されること") {
+                REQUIRE(handled == count);
+                REQUIRE(loop_handled.size() == (size_t)count);
+            }
+        }
+
+        fsm_loop_term(loop);
+        for (struct fsm *machine : machines) {
+            fsm_term(machine);
+        }
+    }
+}
+
+SCENARIO("アクションから対応付けを解除できること", "[loop]") {
+    GIVEN("キューの小さい状態マシンと, 読み込み可能な複数のファイルディスクリプタ") {
+        const struct fsm_trans corresps[] = {
+            FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_loop_idle),
+            FSM_TRANS_HELPER(state_loop_idle, event_loop_readable, NULL, action_loop_remove_all, NULL),
+            FSM_TRANS_TERMINATOR
+        };
+        loop_handled.clear();
+        loop_removed_fds.clear();
+        loop_removing = fsm_loop_init();
+        struct fsm *machine = fsm_init(NULL, corresps);
+        REQUIRE(loop_removing != NULL);
+        REQUIRE(machine != NULL);
+        REQUIRE(fsm_set_queue_capacity(machine, 1) == 0);
+        for (int i = 0; i < 3; ++i) {
+            int fd = eventfd(1, EFD_NONBLOCK);
+            REQUIRE(fd >= 0);
+            REQUIRE(fsm_loop_add_fd(loop_removing, fd, machine,
+                                    event_loop_readable, FSM_PRIORITY_NORMAL) == 0);
+            loop_removed_fds.push_back(fd);
+        }
+
+        WHEN("キューが一杯で積む前に処理したアクションがすべて解除する") {
+            int ret = fsm_loop_run_once(loop_removing, 1000);
+
+            THEN("解除後の準備完了はイベントとして積まれないこと") {
+                REQUIRE(ret == 2);
+                REQUIRE(loop_handled == std::vector<int>{6, 6});
+                REQUIRE(fsm_loop_run_once(loop_removing, 0) == 0);
+                errno = 0;
+                REQUIRE(fsm_loop_remove(loop_removing, loop_removed_fds[0]) == -1);
+                REQUIRE(errno == ENOENT);
+            }
+        }
+
+        fsm_loop_term(loop_removing);
+        loop_removing = NULL;
+        for (int fd : loop_removed_fds) {
+            close(fd);
+        }
+        fsm_term(machine);
+    }
+}
@@ -0,0 +1,234 @@
+/** @file   metrics.cpp
+ *  @brief  状態毎の計測のテスト.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ */
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include <catch.hpp>
+
+extern "C" {
+#include "debug.h"
+#include "hfsm.h"
+#include "metrics.h"
+}
+
+#if OBSERVER
+FSM_STATE(state_metrics_idle, NULL, NULL, NULL, NULL);
+FSM_STATE(state_metrics_busy, NULL, NULL, NULL, NULL);
+FSM_STATE(state_metrics_busy_1, NULL, NULL, NULL, NULL);
+FSM_STATE(state_metrics_unknown, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_metrics_start);
+FSM_EVENT(event_metrics_stop);
+
+/**
+ *  出力を文字列に追記する書き込み関数.
+ */
+static int append_metrics(void *ctx, const char *buf, size_t len)
+{
+    static_cast<std::string *>(ctx)->append(buf, len);
+    return 0;
+}
+
+SCENARIO("状態毎の滞在数と滞在時間を計測できること", "[metrics]") {
+    const struct fsm_rels rels[] = {
+        FSM_RELS_HELPER(state_metrics_busy_1, state_metrics_busy, true),
+        FSM_RELS_TERMINATOR
+    };
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_metrics_idle),
+        FSM_TRANS_HELPER(state_metrics_idle, event_metrics_start, NULL, NULL, state_metrics_busy_1),
+        FSM_TRANS_HELPER(state_metrics_busy, event_metrics_stop, NULL, NULL, state_metrics_idle),
+        FSM_TRANS_TERMINATOR
+    };
+
+    GIVEN("計測に登録した 2 つの状態マシン") {
+        struct fsm_metrics *metrics = fsm_metrics_init("test", rels, corresps);
+        struct fsm *machines[] = {fsm_init(rels, corresps), fsm_init(rels, corresps)};
+        struct fsm_state_metrics values;
+        REQUIRE(metrics != NULL);
+        for (struct fsm *machine : machines) {
+            REQUIRE(machine != NULL);
+            REQUIRE(fsm_metrics_attach(metrics, machine) == 0);
+        }
+
+        WHEN("何も遷移しない") {
+            THEN("登録時点の状態に滞在していること") {
+                REQUIRE(fsm_metrics_read(metrics, state_metrics_idle, &values) == 0);
+                REQUIRE(values.population == 2);
+                REQUIRE(values.entries == 0);
+            }
+        }
+
+        WHEN("片方を子状態に遷移させる") {
+            fsm_transition(machines[0], event_metrics_start);
+
+            THEN("子状態とその祖先に滞在していること") {
+                REQUIRE(fsm_metrics_read(metrics, state_metrics_idle, &values) == 0);
+                REQUIRE(values.population == 1);
+                REQUIRE(values.exits == 1);
+                REQUIRE(fsm_metrics_read(metrics, state_metrics_busy, &values) == 0);
+                REQUIRE(values.population == 1);
+                REQUIRE(values.entries == 1);
+                REQUIRE(fsm_metrics_read(metrics, state_metrics_busy_1, &values) == 0);
+                REQUIRE(values.population == 1);
+            }
+        }
+
+        WHEN("滞在してから戻る") {
+            fsm_transition(machines[0], event_metrics_start);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            fsm_transition(machines[0], event_metrics_stop);
+
+            THEN("滞在時間がヒストグラムに計数されること") {
+                REQUIRE(fsm_metrics_read(metrics, state_metrics_busy, &values) == 0);
+                REQUIRE(values.population == 0);
+                REQUIRE(values.exits == 1);
+                REQUIRE(values.residency_ns >= 20 * 1000 * 1000);
+                REQUIRE(values.buckets[5] == 1);
+            }
+        }
+
+        WHEN("複数のスレッドで遷移させる") {
+            const int rounds = 1000;
+            std::vector<std::thread> threads;
+            for (struct fsm *machine : machines) {
+                threads.emplace_back([machine, rounds]() {
+                    for (int i = 0; i < rounds; ++i) {
+                        fsm_transition(machine, event_metrics_start);
+                        fsm_transition(machine, event_metrics_stop);
+                    }
+                });
+            }
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+
+            THEN("すべてのスレッドの計数が合算されること") {
+                REQUIRE(fsm_metrics_read(metrics, state_metrics_busy_1, &values) == 0);
+                REQUIRE(values.entries == 2 * rounds);
+                REQUIRE(values.exits == 2 * rounds);
+                REQUIRE(fsm_metrics_read(metrics, state_metrics_idle, &values) == 0);
+                REQUIRE(values.population == 2);
+            }
+        }
+
+        WHEN("Prometheus の形式で出力する") {
+            fsm_transition(machines[0], event_metrics_start);
+            std::string text;
+            REQUIRE(fsm_metrics_export(metrics, append_metrics, &text) == 0);
+
+            THEN("滞在数, 回数およびヒストグラムが出力されること") {
+                REQUIRE(text.find("# TYPE fsm_state_population gauge\n") != std::string::npos);
+                REQUIRE(text.find("fsm_state_population{chart=\"test\",state=\"state_metrics_idle\"} 1\n")
+                        != std::string::npos);
+                REQUIRE(text.find("fsm_state_entries_total{chart=\"test\",state=\"state_metrics_busy\"} 1\n")
+                        != std::string::npos);
+                REQUIRE(text.find("fsm_state_residency_seconds_bucket{chart=\"test\",state=\"state_metrics_idle\",le=\"+Inf\"} 1\n")
+                        != std::string::npos);
+                REQUIRE(text.find("fsm_state_residency_seconds_count{chart=\"test\",state=\"state_metrics_idle\"} 1\n")
+                        != std::string::npos);
+                REQUIRE(text.find("fsm_transitions_total{chart=\"test\"} 1\n") != std::string::npos);
+            }
+        }
+
+        WHEN("ファイルに出力する") {
+            std::string path = "/tmp/hfsm_test_metrics_" + std::to_string(getpid()) + ".prom";
+            int ret = fsm_metrics_export_to_path(metrics, path.c_str());
+
+            THEN("ファイルが作成されること") {
+                REQUIRE(ret == 0);
+                REQUIRE(access(path.c_str(), R_OK) == 0);
+                REQUIRE(access((path + ".tmp").c_str(), F_OK) != 0);
+            }
+            unlink(path.c_str());
+        }
+
+        WHEN("片方を解除する") {
+            REQUIRE(fsm_metrics_detach(metrics, machines[1]) == 0);
+            fsm_transition(machines[1], event_metrics_start);
+
+            THEN("滞在数から除かれ, 以降は計数されないこと") {
+                REQUIRE(fsm_metrics_read(metrics, state_metrics_idle, &values) == 0);
+                REQUIRE(values.population == 1);
+                REQUIRE(values.exits == 0);
+                errno = 0;
+                REQUIRE(fsm_metrics_detach(metrics, machines[1]) == -1);
+                REQUIRE(errno == ENOENT);
+            }
+        }
+
+        WHEN("定義にない状態を読み込む") {
+            errno = 0;
+            int ret = fsm_metrics_read(metrics, state_metrics_unknown, &values);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == ENOENT);
+            }
+        }
+
+        fsm_metrics_term(metrics);
+        for (struct fsm *machine : machines) {
+            fsm_term(machine);
+        }
+    }
+}
+
+SCENARIO("1 つのスレッドで複数の計測を交互に計数できること", "[metrics]") {
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_metrics_idle),
+        FSM_TRANS_HELPER(state_metrics_idle, event_metrics_start, NULL, NULL, state_metrics_busy),
+        FSM_TRANS_HELPER(state_metrics_busy, event_metrics_stop, NULL, NULL, state_metrics_idle),
+        FSM_TRANS_TERMINATOR
+    };
+
+    GIVEN("それぞれ別の計測に登録した 20 個の状態マシン") {
+        const int count = 20;
+        std::vector<struct fsm_metrics *> metrics;
+        std::vector<struct fsm *> machines;
+        for (int i = 0; i < count; ++i) {
+            metrics.push_back(fsm_metrics_init(NULL, NULL, corresps));
+            machines.push_back(fsm_init(NULL, corresps));
+            REQUIRE(metrics.back() != NULL);
+            REQUIRE(machines.back() != NULL);
+            REQUIRE(fsm_metrics_attach(metrics.back(), machines.back()) == 0);
+        }
+
+        WHEN("別のスレッドで状態マシンを順に遷移させる") {
+            const int rounds = 100;
+            std::thread thread([&machines, rounds]() {
+                for (int i = 0; i < rounds; ++i) {
+                    for (struct fsm *machine : machines) {
+                        fsm_transition(machine, event_metrics_start);
+                        fsm_transition(machine, event_metrics_stop);
+                    }
+                }
+            });
+            thread.join();
+
+            THEN("それぞれの計測に計数されること") {
+                bool counted = true;
+                for (struct fsm_metrics *m : metrics) {
+                    struct fsm_state_metrics values;
+                    counted = counted && (fsm_metrics_read(m, state_metrics_busy, &values) == 0)
+                              && (values.entries == rounds) && (values.exits == rounds);
+                }
+                REQUIRE(counted);
+            }
+        }
+
+        for (int i = 0; i < count; ++i) {
+            fsm_metrics_term(metrics[i]);
+            fsm_term(machines[i]);
+        }
+    }
+}
+#endif
@@ -0,0 +1,294 @@
+/** @file   ring.cpp
+ *  @brief  共有メモリによるイベントリングのテスト.
+ *
+ *  @author t-kenji <protect.2501@gmail.com>
+ *  @date   2026-10-18 新規作成.
+ */
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <catch.hpp>
+
+extern "C" {
+#include "debug.h"
+#include "hfsm.h"
+#include "ring.h"
+}
+
+FSM_STATE(state_ring_idle, NULL, NULL, NULL, NULL);
+
+FSM_EVENT(event_ring_low);
+FSM_EVENT(event_ring_urgent);
+FSM_EVENT(event_ring_unknown);
+
+/**
+ *  処理したイベントの記録.
+ */
+static std::vector<int> ring_handled;
+
+/**
+ *  待ちを中断するだけのシグナルハンドラ.
+ */
+static void ring_interrupt(int signo)
+{
+}
+
+FSM_ACTION(action_ring_low, (struct fsm *machine))
+{
+    ring_handled.push_back(1);
+}
+
+FSM_ACTION(action_ring_urgent, (struct fsm *machine))
+{
+    ring_handled.push_back(2);
+}
+
+/**
+ *  付加データを文字列として記録するハンドラ.
+ */
+static void capture_ring_payload(struct fsm *machine,
+                                 const struct fsm_event *event,
+                                 const void *payload,
+                                 size_t payload_bytes,
+                                 void *ctx)
+{
+    std::vector<std::string> *payloads = static_cast<std::vector<std::string> *>(ctx);
+    payloads->push_back(std::string(static_cast<const char *>(payload), payload_bytes));
+}
+
+SCENARIO("共有メモリのリングでイベントを受け渡せること", "[ring]") {
+    const struct fsm_trans corresps[] = {
+        FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_ring_idle),
+        FSM_TRANS_HELPER(state_ring_idle, event_ring_low, NULL, action_ring_low, NULL),
+        FSM_TRANS_HELPER(state_ring_idle, event_ring_urgent, NULL, action_ring_urgent, NULL),
+        FSM_TRANS_TERMINATOR
+    };
+
+    GIVEN("名前のないリングと状態マシン") {
+        ring_handled.clear();
+        struct fsm_ring *ring = fsm_ring_create(NULL, 4, NULL, corresps);
+        struct fsm *machine = fsm_init(NULL, corresps);
+        struct fsm *machines[] = {machine};
+        REQUIRE(ring != NULL);
+        REQUIRE(machine != NULL);
+
+        WHEN("付加データ付きのイベントを送る") {
+            std::vector<std::string> payloads;
+            REQUIRE(fsm_ring_send(ring, 0, event_ring_low, FSM_PRIORITY_LOW, "abc", 3) == 0);
+            char *dest = static_cast<char *>(fsm_ring_reserve(ring, 0, event_ring_urgent, FSM_PRIORITY_URGENT));
+            REQUIRE(dest != NULL);
+            memcpy(dest, "xy", 2);
+            REQUIRE(fsm_ring_commit(ring, dest, 2) == 0);
+            ssize_t count = fsm_ring_drain(ring, machines, 1, SIZE_MAX, capture_ring_payload, &payloads);
+
+            THEN("届いた順に付加データが渡されること") {
+                REQUIRE(count == 2);
+                REQUIRE(payloads == std::vector<std::string>{"abc", "xy"});
+            }
+
+            THEN("まとめて積まれたイベントが優先度順に処理されること") {
+                REQUIRE(ring_handled == std::vector<int>{2, 1});
+            }
+        }
+
+        WHEN("容量を超えて送る") {
+            for (int i = 0; i < 4; ++i) {
+                REQUIRE(fsm_ring_send(ring, 0, event_ring_low, FSM_PRIORITY_LOW, NULL, 0) == 0);
+            }
+            errno = 0;
+            int ret = fsm_ring_send(ring, 0, event_ring_low, FSM_PRIORITY_LOW, NULL, 0);
+
+            THEN("エラーとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == ENOBUFS);
+            }
+
+            THEN("読み出した後は再び送れること") {
+                REQUIRE(fsm_ring_drain(ring, machines, 1, 2, NULL, NULL) == 2);
+                REQUIRE(fsm_ring_send(ring, 0, event_ring_low, FSM_PRIORITY_LOW, NULL, 0) == 0);
+                REQUIRE(fsm_ring_drain(ring, machines, 1, SIZE_MAX, NULL, NULL) == 3);
+                REQUIRE(ring_handled.size() == 5);
+            }
+        }
+
+        WHEN("不正なイベントを送る") {
+            char large[FSM_RING_PAYLOAD_MAX + 1] = {};
+
+            THEN("エラーとなること") {
+                errno = 0;
+                REQUIRE(fsm_ring_send(ring, 0, event_ring_unknown, FSM_PRIORITY_LOW, NULL, 0) == -1);
+                REQUIRE(errno == EINVAL);
+                errno = 0;
+                REQUIRE(fsm_ring_send(ring, 0, event_ring_low, FSM_PRIORITY_LOW, large, sizeof(large)) == -1);
+                REQUIRE(errno == EINVAL);
+                errno = 0;
+                REQUIRE(fsm_ring_send(ring, 0, event_ring_low, FSM_PRIORITY_LANES, NULL, 0) == -1);
+                REQUIRE(errno == EINVAL);
+            }
+        }
+
+        WHEN("対応する状態マシンのない番号に送る") {
+            REQUIRE(fsm_ring_send(ring, 1, event_ring_low, FSM_PRIORITY_LOW, NULL, 0) == 0);
+            ssize_t count = fsm_ring_drain(ring, machines, 1, SIZE_MAX, NULL, NULL);
+
+            THEN("読み捨てられること") {
+                REQUIRE(count == 1);
+                REQUIRE(ring_handled.empty());
+            }
+        }
+
+        WHEN("共有メモリ上の付加データの長さが書き換えられる") {
+            std::vector<std::string> payloads;
+            unsigned char *dest = static_cast<unsigned char *>(
+                fsm_ring_reserve(ring, 0, event_ring_low, FSM_PRIORITY_LOW));
+            REQUIRE(dest != NULL);
+            REQUIRE(fsm_ring_commit(ring, dest, 1) == 0);
+            /* 枠は seq(8), machine(4), event(4), priority(1), payload_bytes(1), reserved(6),
+             * payload の順に並ぶため, 長さは付加データの 7 バイト前にある. */
+            dest[-7] = 255;
+            ssize_t count = fsm_ring_drain(ring, machines, 1, SIZE_MAX, capture_ring_payload, &payloads);
+
+            THEN("ハンドラを呼ばずに読み捨てられること") {
+                REQUIRE(count == 1);
+                REQUIRE(payloads.empty());
+                REQUIRE(ring_handled.empty());
+            }
+        }
+
+        WHEN("何も届いていない状態で待つ") {
+            errno = 0;
+            int ret = fsm_ring_wait(ring, 10);
+
+            THEN("時間切れとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(errno == ETIMEDOUT);
+            }
+        }
+
+        WHEN("シグナルで繰り返し中断されながら待つ") {
+            struct sigaction action, saved;
+            std::memset(&action, 0, sizeof(action));
+            action.sa_handler = ring_interrupt;
+            sigemptyset(&action.sa_mask);
+            REQUIRE(sigaction(SIGUSR2, &action, &saved) == 0);
+            std::atomic<bool> waiting(true);
+            pthread_t waiter = pthread_self();
+            std::thread interrupter([&waiting, waiter] {
+                for (int i = 0; (i < 100) && waiting.load(); ++i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    pthread_kill(waiter, SIGUSR2);
+                }
+            });
+            auto start = std::chrono::steady_clock::now();
+            errno = 0;
+            int ret = fsm_ring_wait(ring, 100);
+            int err = errno;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            waiting = false;
+            interrupter.join();
+            sigaction(SIGUSR2, &saved, NULL);
+
+            THEN("待ち時間が延びずに時間切れとなること") {
+                REQUIRE(ret == -1);
+                REQUIRE(err == ETIMEDOUT);
+                REQUIRE(elapsed < std::chrono::milliseconds(1000));
+            }
+        }
+
+        WHEN("異なる定義で接続する") {
+            const struct fsm_trans others[] = {
+                FSM_TRANS_HELPER(state_start, event_null, NULL, NULL, state_ring_idle),
+                FSM_TRANS_HELPER(state_ring_idle, event_ring_low, NULL, action_ring_low, NULL),
+                FSM_TRANS_TERMINATOR
+            };
+            errno = 0;
+            struct fsm_ring *other = fsm_ring_attach_fd(fsm_ring_fd(ring), NULL, others);
+
+            THEN("エラーとなること") {
+                REQUIRE(other == NULL);
+                REQUIRE(errno == EINVAL);
+            }
+        }
+
+        WHEN("子プロセスから送る") {
+            const int events = 1000;
+            pid_t pid = fork();
+            if (pid == 0) {
+                struct fsm_ring *child = fsm_ring_attach_fd(fsm_ring_fd(ring), NULL, corresps);
+                int sent = 0;
+                while ((child != NULL) && (sent < events)) {
+                    if (fsm_ring_send(child, 0, event_ring_low, FSM_PRIORITY_LOW, &sent, sizeof(sent)) == 0) {
+                        ++sent;
+                    }
+                }
+                _exit((child != NULL) ? 0 : 1);
+            }
+            REQUIRE(pid > 0);
+
+            ssize_t received = 0;
+            while (received < events) {
+                if (fsm_ring_wait(ring, 1000) != 0) {
+                    break;
+                }
+                received += fsm_ring_drain(ring, machines, 1, SIZE_MAX, NULL, NULL);
+            }
+            int status;
+            waitpid(pid, &status, 0);
+
+            THEN("すべてのイベントが届き, 処理されること") {
+                REQUIRE(WIFEXITED(status));
+                REQUIRE(WEXITSTATUS(status) == 0);
+                REQUIRE(received == events);
+                REQUIRE(ring_handled.size() == (size_t)events);
+            }
+        }
+
+        fsm_term(machine);
+        fsm_ring_close(ring);
+    }
+
+    GIVEN("名前付きのリング") {
+        std::string name = "/hfsm_test_ring_" + std::to_string(getpid());
+        struct fsm_ring *ring = fsm_ring_create(name.c_str(), 16, NULL, corresps);
+        REQUIRE(ring != NULL);
+
+        WHEN("名前で接続して送る") {
+            ring_handled.clear();
+            struct fsm *machine = fsm_init(NULL, corresps);
+            struct fsm *machines[] = {machine};
+            struct fsm_ring *producer = fsm_ring_attach(name.c_str(), NULL, corresps);
+            REQUIRE(producer != NULL);
+            REQUIRE(fsm_ring_send(producer, 0, event_ring_urgent, FSM_PRIORITY_URGENT, NULL, 0) == 0);
+
+            THEN("生成側で受け取れること") {
+                REQUIRE(fsm_ring_wait(ring, 0) == 0);
+                REQUIRE(fsm_ring_drain(ring, machines, 1, SIZE_MAX, NULL, NULL) == 1);
+                REQUIRE(ring_handled == std::vector<int>{2});
+            }
+
+            fsm_ring_close(producer);
+            fsm_term(machine);
+        }
+
+        WHEN("同じ名前で生成する") {
+            errno = 0;
+            struct fsm_ring *other = fsm_ring_create(name.c_str(), 16, NULL, corresps);
+
+            THEN("エラーとなること") {
+                REQUIRE(other == NULL);
+                REQUIRE(errno == EEXIST);
+            }
+        }
+
+        fsm_ring_close(ring);
+    }
+}